@@ -300,6 +300,8 @@
 #include <stdlib.h>
 #include "utils/defs.h"
 #include "utils/utilities.h"
+#include "utils/pval_file.h"
+#include "utils/shard.h"
 #include "utils/externs.h"
 #include "utils/debug.h"
 
@@ -339,8 +341,12 @@ main(int argc, char *argv[])
 	/*
 	 * Run test suite iterations if needed
 	 */
-	if (run_state.runMode != MODE_ASSESS_ONLY) {
-		invokeTestSuite(&run_state);
+	if (run_state.runMode == MODE_ITERATE_AND_ASSESS || run_state.runMode == MODE_ITERATE_ONLY) {
+		if (run_state.shardWorkersFlag == true) {
+			launchShards(&run_state);
+		} else {
+			invokeTestSuite(&run_state);
+		}
 
 		/*
 		 * Print p-values and stats of each test in separate files (if needed)
@@ -364,10 +370,17 @@ main(int argc, char *argv[])
 		read_from_p_val_file(&run_state);
 	}
 
+	/*
+	 * If only merging, merge the data from given files into a single file
+	 */
+	else if (run_state.runMode == MODE_MERGE_ONLY) {
+		merge_p_val_files(&run_state);
+	}
+
 	/*
 	 * Perform metrics processing for each test and write final result to file
 	 */
-	if (run_state.runMode != MODE_ITERATE_ONLY) {
+	if (run_state.runMode == MODE_ITERATE_AND_ASSESS || run_state.runMode == MODE_ASSESS_ONLY) {
 		metrics(&run_state);
 	}
 
@@ -394,6 +407,12 @@ main(int argc, char *argv[])
 				    "sts in '-m a' mode and passing that file's directory as an argument with the '-d' flag.");
 	}
 
+	else if (run_state.runMode == MODE_MERGE_ONLY) {
+		msg("A binary file (with extension .pvalues) merging the given binary files has been generated.\n"
+				    "You can merge it again with other merged files by executing sts in '-m m' mode, or assess it "
+				    "by executing sts in '-m a' mode, passing its directory as an argument with the '-d' flag.");
+	}
+
 	// All Done!!! -- Jessica Noll, Age 2
 	exit(0);
 }
@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/debug.h"
 
 
@@ -62,7 +65,9 @@ static const enum test test_num = TEST_APEN;	// This test number
 static double compute_phi(struct thread_state *thread_state, long int blocksize);
 static bool ApproximateEntropy_print_stat(FILE * stream, struct state *state, struct ApproximateEntropy_private_stats *stat,
 					  double p_value);
-static bool ApproximateEntropy_print_p_value(FILE * stream, double p_value);
+static bool ApproximateEntropy_print_p_value(FILE * stream, struct state *state, double p_value);
+static void ApproximateEntropy_print(struct thread_state *thread_state,
+				     struct ApproximateEntropy_private_stats *stat, double p_value);
 static void ApproximateEntropy_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
 
 
@@ -148,10 +153,6 @@ ApproximateEntropy_init(struct state *state)
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct ApproximateEntropy_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double),
 						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
 
@@ -225,7 +226,7 @@ ApproximateEntropy_iterate(struct thread_state *thread_state)
 	/*
 	 * Step 7: compute the test p-value
 	 */
-	p_value = cephes_igamc((double) ((long int) 1 << (m - 1)), stat.chi_squared / 2.0);
+	p_value = pvalue_igamc((double) ((long int) 1 << (m - 1)), stat.chi_squared / 2.0);
 
 	/*
 	 * Lock mutex before making changes to the shared state
@@ -262,9 +263,6 @@ ApproximateEntropy_iterate(struct thread_state *thread_state)
 	/*
 	 * Record values computed during this iteration
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
-	}
 	append_value(state->p_val[test_num], &p_value);
 
 	/*
@@ -274,6 +272,13 @@ ApproximateEntropy_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		ApproximateEntropy_print(thread_state, &stat, p_value);
+	}
+
 	return;
 }
 
@@ -423,6 +428,7 @@ static bool
 ApproximateEntropy_print_stat(FILE * stream, struct state *state, struct ApproximateEntropy_private_stats *stat, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -478,24 +484,24 @@ ApproximateEntropy_print_stat(FILE * stream, struct state *state, struct Approxi
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(c) Chi^2               = %f\n", stat->chi_squared);
+	io_ret = fprintf(stream, "\t\t(c) Chi^2               = %s\n", formatDouble(value, state, stat->chi_squared, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(d) Phi(m)              = %f\n", stat->phi[0]);
+	io_ret = fprintf(stream, "\t\t(d) Phi(m)              = %s\n", formatDouble(value, state, stat->phi[0], 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(e) Phi(m+1)            = %f\n", stat->phi[1]);
+	io_ret = fprintf(stream, "\t\t(e) Phi(m+1)            = %s\n", formatDouble(value, state, stat->phi[1], 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(f) ApEn                = %f\n", stat->ApEn);
+	io_ret = fprintf(stream, "\t\t(f) ApEn                = %s\n", formatDouble(value, state, stat->ApEn, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
 	if (state->legacy_output == true) {
-		io_ret = fprintf(stream, "\t\t(g) Log(2)              = %f\n", state->c.log2);
+		io_ret = fprintf(stream, "\t\t(g) Log(2)              = %s\n", formatDouble(value, state, state->c.log2, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -505,7 +511,7 @@ ApproximateEntropy_print_stat(FILE * stream, struct state *state, struct Approxi
 		return false;
 	}
 	if (stat->success == true) {
-		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -515,7 +521,7 @@ ApproximateEntropy_print_stat(FILE * stream, struct state *state, struct Approxi
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -541,9 +547,10 @@ ApproximateEntropy_print_stat(FILE * stream, struct state *state, struct Approxi
  *      false --> an I/O error occurred
  */
 static bool
-ApproximateEntropy_print_p_value(FILE * stream, double p_value)
+ApproximateEntropy_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -551,6 +558,9 @@ ApproximateEntropy_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(13, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(13, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -561,7 +571,7 @@ ApproximateEntropy_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -575,209 +585,65 @@ ApproximateEntropy_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * ApproximateEntropy_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * ApproximateEntropy_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value         // p_value iteration test result(s)
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-ApproximateEntropy_print(struct state *state)
+static void
+ApproximateEntropy_print(struct thread_state *thread_state, struct ApproximateEntropy_private_stats *stat, double p_value)
 {
-	struct ApproximateEntropy_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(14, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(14, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(14, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(14, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(14, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(14, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(14, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
-	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
-
-	/*
-	 * Open results.txt file
+	 * Begin the row of this iteration
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print stat to stats.txt
 	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct ApproximateEntropy_private_stats, i);
-
-		/*
-		 * Get p_value for this iteration
-		 */
-		p_value = get_value(state->p_val[test_num], double, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = ApproximateEntropy_print_stat(stats, state, stat, p_value);
-		if (ok == false) {
-			errp(14, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = ApproximateEntropy_print_p_value(results, p_value);
-		if (ok == false) {
-			errp(14, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = ApproximateEntropy_print_stat(buffer->stats, state, stat, p_value);
+	if (ok == false) {
+		errp(14, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_value to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(14, __func__, "error flushing to: %s", stats_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(14, __func__, "error closing: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = ApproximateEntropy_print_p_value(buffer->results, state, p_value);
+	if (ok == false) {
+		errp(14, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(14, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(14, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(14, __func__, "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ,
-				     j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = ApproximateEntropy_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(14, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(14, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(14, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -843,7 +709,7 @@ ApproximateEntropy_metric_print(struct state *state, long int sampleCount, long
 		for (i = 0; i < state->tp.uniformity_bins; ++i) {
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);	// Uniformity threshold level
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);	// Uniformity threshold level
 	}
 
 	/*
@@ -950,9 +816,8 @@ ApproximateEntropy_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -971,73 +836,28 @@ ApproximateEntropy_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(16, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(16, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1058,12 +878,6 @@ ApproximateEntropy_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1096,11 +910,6 @@ ApproximateEntropy_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -28,6 +28,7 @@
 
 // Exit codes: 40 thru 49
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
@@ -36,13 +37,21 @@
 #include <complex.h>
 #include "../utils/externs.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/debug.h"
+#include "../utils/stat_fncs.h"
 
 #if defined(LEGACY_FFT)
 #include "../utils/dfft.h"
+#include "../utils/rfft.h"
 #else /* LEGACY_FFT */
 #include <fftw3.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #endif /* LEGACY_FFT */
 
 
@@ -68,7 +77,56 @@ static const enum test test_num = TEST_DFT;	// This test number
  * Static variables declarations
  */
 static double sqrtn4_095_005;			// Square root of (n / 4.0 * 0.95 * 0.05)
-static double sqrt_log20_n;			// Square root of ln(20) * n
+static double log20_n;				// ln(20) * n, the square of the 95 % peak height threshold T
+static long int batch;				// Number of bitstreams transformed together
+static long int fft_threads;			// Number of threads working on a single transform
+#if defined(LEGACY_FFT)
+static long int legacy_ways;			// Number of sub-transforms of the split legacy FFT, 1 ==> not split
+static long int legacy_workers;			// Number of threads working on each split transform, with the caller
+static struct real_fft *real_fft = NULL;	// Tables of the built-in real FFT, NULL ==> use dfft
+static long legacy_ifac[WORK_ARRAY_LEN + 1];	// dfft factorization of n / legacy_ways, shared by all threads
+static double complex *legacy_twiddle = NULL;	// exp(-2 * pi * i * j / n) for j in [0, n / legacy_ways / 2]
+static double complex legacy_root[MAX_LEGACY_FFT_WAYS];	// exp(-2 * pi * i * q / legacy_ways)
+static long int legacy_reverse[MAX_LEGACY_FFT_WAYS];	// Bit reversal of each sub-transform index
+static struct legacy_fft_pool *legacy_pool = NULL;	// Helper threads of each thread, started on first use
+#else /* LEGACY_FFT */
+static pthread_mutex_t fftw_planner_mutex = PTHREAD_MUTEX_INITIALIZER;	// FFTW planner is not thread-safe
+static bool fftw_threads_ready = false;		// true ==> fftw_init_threads() was called
+#endif /* LEGACY_FFT */
+
+
+#if defined(LEGACY_FFT)
+/*
+ * Work of one thread of the split legacy FFT
+ */
+struct legacy_fft_work {
+	double *X;		// Sequence to transform, replaced by its transform in the dfft layout
+	double *sub;		// The ways decimated sub-sequences of length n / ways, one after another
+	double *wsave;		// The ways work arrays of length 2 * n / ways, one after another
+	long int n;		// Length of X
+	long int worker;	// Index of this thread among the workers, 0 is the calling thread
+	struct legacy_fft_pool *pool;	// Pool of this thread
+};
+
+/*
+ * Helper threads that work on the split legacy FFT transforms of one thread
+ *
+ * The helpers are created on the first transform, as the -K workers are forked after init(),
+ * and wait for each phase of each transform until the test is destroyed.
+ */
+struct legacy_fft_pool {
+	pthread_t thread[MAX_LEGACY_FFT_WAYS];			// Helper threads, thread[0] is not used
+	struct legacy_fft_work work[MAX_LEGACY_FFT_WAYS];	// Work of the caller (work[0]) and of each helper
+	pthread_mutex_t mutex;		// Lock of the fields below
+	pthread_cond_t start;		// Signaled when a phase is started, or when closing
+	pthread_cond_t done;		// Signaled when the last helper is done with the current phase
+	void *(*phase)(void *);		// Function of the current phase
+	long int phases;		// Number of phases started so far
+	long int busy;			// Number of helpers still working on the current phase
+	bool closing;			// true ==> the helpers must exit
+	bool started;			// true ==> the helpers were created
+};
+#endif /* LEGACY_FFT */
 
 
 /*
@@ -76,8 +134,25 @@ static double sqrt_log20_n;			// Square root of ln(20) * n
  */
 static bool DiscreteFourierTransform_print_stat(FILE * stream, struct state *state,
 						struct DiscreteFourierTransform_private_stats *stat, double p_value);
-static bool DiscreteFourierTransform_print_p_value(FILE * stream, double p_value);
+static bool DiscreteFourierTransform_print_p_value(FILE * stream, struct state *state, double p_value);
+static void DiscreteFourierTransform_print(struct thread_state *thread_state,
+					   struct DiscreteFourierTransform_private_stats *stat, double p_value, long int iteration);
+static void DiscreteFourierTransform_batch(struct thread_state *thread_state);
+#if defined(LEGACY_FFT)
+static void DiscreteFourierTransform_legacy_parallel(struct legacy_fft_pool *pool, double *X, double *sub, double *wsave,
+						    long int n);
+static void DiscreteFourierTransform_legacy_run(struct legacy_fft_pool *pool, void *(*phase)(void *));
+static void *DiscreteFourierTransform_legacy_helper(void *work);
+static void *DiscreteFourierTransform_legacy_sub(void *work);
+static void *DiscreteFourierTransform_legacy_combine(void *work);
+static void DiscreteFourierTransform_legacy_store(double *X, long int n, long int k, double complex value);
+#endif /* LEGACY_FFT */
 static void DiscreteFourierTransform_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
+#if !defined(LEGACY_FFT)
+static char *DiscreteFourierTransform_wisdom_file(struct state *state);
+static void DiscreteFourierTransform_save_wisdom(char *wisdom_file);
+static fftw_plan DiscreteFourierTransform_plan(struct state *state, long int thread, unsigned int flags);
+#endif /* LEGACY_FFT */
 
 
 /*
@@ -94,7 +169,6 @@ void
 DiscreteFourierTransform_init(struct state *state)
 {
 	long int n;		// Length of a single bit stream
-	long int i;
 
 	/*
 	 * Check preconditions (firewall)
@@ -139,7 +213,160 @@ DiscreteFourierTransform_init(struct state *state)
 	 * Compute constants needed for the test
 	 */
 	sqrtn4_095_005 = sqrt((double) state->tp.n / 4.0 * 0.95 * 0.05);
-	sqrt_log20_n = sqrt(log(20.0) * (double) state->tp.n);	// 2.995732274 * n
+	log20_n = log(20.0) * (double) state->tp.n;	// 2.995732274 * n
+
+	/*
+	 * Set up the transforms, unless -K workers will each set up their own after the fork
+	 *
+	 * The parent process of -K workers transforms nothing.  Each worker gets its share of the
+	 * thread budget, and must not inherit FFTW threads or plans made for the whole budget.
+	 */
+	if (state->shardWorkersFlag == false) {
+		DiscreteFourierTransform_setup(state);
+	}
+
+	/*
+	 * Allocate dynamic arrays
+	 */
+	state->p_val[test_num] = create_dyn_array(sizeof(double),
+						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
+
+	/*
+	 * Determine format of data*.txt filenames based on state->partitionCount[test_num]
+	 * NOTE: If we are not partitioning the p_values, no data*.txt filenames are needed
+	 */
+	state->datatxt_fmt[test_num] = data_filename_format(state->partitionCount[test_num]);
+	dbg(DBG_HIGH, "%s[%d] will form data*.txt filenames with the following format: %s",
+	    state->testNames[test_num], test_num, state->datatxt_fmt[test_num]);
+
+	return;
+}
+
+
+/*
+ * DiscreteFourierTransform_setup - set up the transforms of the Discrete Fourier Transform test
+ *
+ * given:
+ *      state           // run state to test under
+ *
+ * The bitstreams of each batch, the threads of each transform, the per-thread arrays and
+ * the FFT plans all depend on state->tp.numOfBitStreams, state->numberOfThreads and
+ * state->threadBudget.  This function is called by init(), or by each -K worker once it
+ * knows its own share of them (see runWorker()).
+ *
+ * NOTE: The initialize function must be called first.
+ */
+void
+DiscreteFourierTransform_setup(struct state *state)
+{
+	long int n;		// Length of a single bit stream
+	long int i;
+#if defined(LEGACY_FFT)
+	static const double tpi = 6.28318530717958647692528676655900577;
+	long int j;
+#else /* LEGACY_FFT */
+	char *wisdom_file;	// FFTW wisdom file for this bitcount
+	bool wisdom_loaded;	// true ==> wisdom_file held wisdom we could import
+	bool wisdom_learned;	// true ==> the planner measured a problem that the wisdom lacked
+	fftw_plan plan;		// Plan of the current thread
+#endif /* LEGACY_FFT */
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(40, __func__, "state arg is NULL");
+	}
+	if (state->testVector[test_num] != true) {
+		dbg(DBG_LOW, "setup function[%d] %s called when test vector was false", test_num, __func__);
+		return;
+	}
+	if (state->fft_X != NULL) {
+		err(40, __func__, "transforms of %s[%d] are already set up", state->testNames[test_num], test_num);
+	}
+
+	/*
+	 * Collect parameters from state
+	 */
+	n = state->tp.n;
+
+	/*
+	 * Determine how many bitstreams each thread transforms together
+	 * NOTE: There is no point in batching more bitstreams than we have
+	 */
+	batch = MIN(state->dftBatch, state->tp.numOfBitStreams);
+	if (batch < 1) {
+		batch = 1;
+	}
+	dbg(DBG_MED, "%s[%d] will transform %ld bitstream(s) at a time", state->testNames[test_num], test_num, batch);
+
+	/*
+	 * Split the threads between iteration level and FFT level parallelism
+	 *
+	 * Only so many transforms can be under way at once: one per batch of bitstreams, and no more
+	 * than there are threads.  The threads left idle by fewer iterations (such as -i 1 on a huge
+	 * bitcount) help with each transform instead.  Small transforms are not worth splitting.
+	 */
+	fft_threads = (state->tp.numOfBitStreams + batch - 1) / batch;
+	fft_threads = MAX(MIN(fft_threads, state->numberOfThreads), 1);
+	fft_threads = MAX(state->threadBudget / fft_threads, 1);
+	if (n < MIN_LENGTH_PARALLEL_FFT) {
+		fft_threads = 1;
+	}
+#if defined(LEGACY_FFT)
+	/*
+	 * The split legacy FFT transforms a power of 2 number of decimated sub-sequences of even length,
+	 * and then combines them with radix 2 butterflies.  The split only depends on n, so that the
+	 * p-values do not depend on how many threads share the sub-transforms and the butterflies.
+	 */
+	legacy_ways = 1;
+	if (n >= MIN_LENGTH_PARALLEL_FFT) {
+		while (legacy_ways * 2 <= MAX_LEGACY_FFT_WAYS && n % (legacy_ways * 4) == 0) {
+			legacy_ways *= 2;
+		}
+	}
+	legacy_workers = MIN(fft_threads, legacy_ways);
+	fft_threads = legacy_workers;
+
+	/*
+	 * Power of 2 lengths are transformed by the built-in real FFT, whose twiddle factors are computed
+	 * here once for all threads.  Other lengths fall back on the FFTPACK port in dfft.c.
+	 */
+	if (isRealFFTLength(n / legacy_ways) == true) {
+		real_fft = createRealFFT(n / legacy_ways);
+		dbg(DBG_MED, "%s[%d] will use the built-in real FFT of length %ld", state->testNames[test_num], test_num,
+		    n / legacy_ways);
+	}
+
+	/*
+	 * Compute the twiddle factors of the butterflies once for all threads
+	 */
+	if (legacy_ways > 1) {
+		legacy_twiddle = malloc((size_t) (n / legacy_ways / 2 + 1) * sizeof(legacy_twiddle[0]));
+		if (legacy_twiddle == NULL) {
+			errp(40, __func__, "cannot malloc of %ld elements of %ld bytes each for legacy_twiddle",
+			     n / legacy_ways / 2 + 1, sizeof(legacy_twiddle[0]));
+		}
+		for (i = 0; i <= n / legacy_ways / 2; i++) {
+			legacy_twiddle[i] = cos(-tpi * (double) i / (double) n) + sin(-tpi * (double) i / (double) n) * I;
+		}
+		for (i = 0; i < legacy_ways; i++) {
+			legacy_root[i] = cos(-tpi * (double) i / (double) legacy_ways) +
+			    sin(-tpi * (double) i / (double) legacy_ways) * I;
+			for (legacy_reverse[i] = 0, j = 1; j < legacy_ways; j *= 2) {
+				legacy_reverse[i] = legacy_reverse[i] * 2 + ((i & j) != 0);
+			}
+		}
+	}
+	if (legacy_workers > 1) {
+		legacy_pool = calloc((size_t) state->numberOfThreads, sizeof(legacy_pool[0]));
+		if (legacy_pool == NULL) {
+			errp(40, __func__, "cannot calloc for legacy_pool: %ld elements of %ld bytes each", state->numberOfThreads,
+			     sizeof(legacy_pool[0]));
+		}
+	}
+#endif /* LEGACY_FFT */
+	dbg(DBG_MED, "%s[%d] will use %ld thread(s) for each transform", state->testNames[test_num], test_num, fft_threads);
 
 	/*
 	 * Allocate arrays that will be used by the DFT libraries, for each thread
@@ -155,6 +382,11 @@ DiscreteFourierTransform_init(struct state *state)
 		errp(40, __func__, "cannot malloc for fft_wsave: %ld elements of %ld bytes each", state->numberOfThreads,
 		     sizeof(*state->fft_wsave));
 	}
+	state->fft_sub = calloc((size_t) state->numberOfThreads, sizeof(*state->fft_sub));
+	if (state->fft_sub == NULL) {
+		errp(40, __func__, "cannot calloc for fft_sub: %ld elements of %ld bytes each", state->numberOfThreads,
+		     sizeof(*state->fft_sub));
+	}
 #else /* LEGACY_FFT */
 	state->fftw_out = malloc((size_t) state->numberOfThreads * sizeof(*state->fftw_out));
 	if (state->fftw_out == NULL) {
@@ -167,17 +399,66 @@ DiscreteFourierTransform_init(struct state *state)
 		     sizeof(*state->fftw_p));
 	}
 #endif /* LEGACY_FFT */
-	state->fft_m = malloc((size_t) state->numberOfThreads * sizeof(*state->fft_m));
-	if (state->fft_m == NULL) {
-		errp(40, __func__, "cannot malloc for fft_m: %ld elements of %ld bytes each", state->numberOfThreads,
-		     sizeof(*state->fft_m));
+	state->fft_fill = calloc((size_t) state->numberOfThreads, sizeof(state->fft_fill[0]));
+	if (state->fft_fill == NULL) {
+		errp(40, __func__, "cannot calloc for fft_fill: %ld elements of %ld bytes each", state->numberOfThreads,
+		     sizeof(state->fft_fill[0]));
+	}
+	state->fft_iteration = malloc((size_t) state->numberOfThreads * sizeof(*state->fft_iteration));
+	if (state->fft_iteration == NULL) {
+		errp(40, __func__, "cannot malloc for fft_iteration: %ld elements of %ld bytes each", state->numberOfThreads,
+		     sizeof(*state->fft_iteration));
+	}
+
+#if !defined(LEGACY_FFT)
+	/*
+	 * Import the FFTW wisdom saved by a previous run with the same bitcount
+	 *
+	 * With wisdom for n at hand, planning with FFTW_MEASURE costs next to nothing, so every run
+	 * (and every -m i job sharing the same wisdom file) gets measured plans without paying for them.
+	 * Without it, the first plan below is measured and the remaining per-thread plans reuse the
+	 * wisdom it left in memory.  The wisdom file is saved again whenever that happened.
+	 *
+	 * The FFTW planner is not thread-safe, so all calls into it are serialized by fftw_planner_mutex.
+	 */
+	wisdom_file = DiscreteFourierTransform_wisdom_file(state);
+	pthread_mutex_lock(&fftw_planner_mutex);
+	wisdom_loaded = (fftw_import_wisdom_from_filename(wisdom_file) != 0);
+	wisdom_learned = false;
+	if (wisdom_loaded == true) {
+		dbg(DBG_MED, "%s[%d] imported FFTW wisdom from: %s", state->testNames[test_num], test_num, wisdom_file);
+	} else {
+		dbg(DBG_MED, "%s[%d] found no FFTW wisdom in: %s", state->testNames[test_num], test_num, wisdom_file);
+	}
+
+	/*
+	 * Have the FFTW planner spread each transform over fft_threads threads
+	 */
+	if (fft_threads > 1) {
+		if (fftw_threads_ready == false) {
+			if (fftw_init_threads() == 0) {
+				warn(__func__, "cannot initialize FFTW threads, each transform will use a single thread");
+				fft_threads = 1;
+			} else {
+				fftw_threads_ready = true;
+			}
+		}
+	}
+	if (fftw_threads_ready == true) {
+		fftw_plan_with_nthreads((int) fft_threads);
 	}
+#endif /* LEGACY_FFT */
 
 	for (i = 0; i < state->numberOfThreads; i++) {
-		state->fft_X[i] = calloc((size_t) state->tp.n, sizeof(state->fft_X[i][0]));
+		state->fft_X[i] = calloc((size_t) (n * batch), sizeof(state->fft_X[i][0]));
 		if (state->fft_X[i] == NULL) {
 			errp(40, __func__, "cannot calloc of %ld elements of %ld bytes each for state->fft_X[%ld]",
-			     n, sizeof(state->fft_X[i][0]), i);
+			     n * batch, sizeof(state->fft_X[i][0]), i);
+		}
+		state->fft_iteration[i] = calloc((size_t) batch, sizeof(state->fft_iteration[i][0]));
+		if (state->fft_iteration[i] == NULL) {
+			errp(40, __func__, "cannot calloc of %ld elements of %ld bytes each for state->fft_iteration[%ld]",
+			     batch, sizeof(state->fft_iteration[i][0]), i);
 		}
 #if defined(LEGACY_FFT)
 		state->fft_wsave[i] = calloc((size_t) 2 * state->tp.n, sizeof(state->fft_wsave[i][0]));
@@ -185,38 +466,55 @@ DiscreteFourierTransform_init(struct state *state)
 			errp(40, __func__, "cannot calloc of %ld elements of %ld bytes each for state->fft_wsave[%ld]",
 			     2 * n, sizeof(state->fft_wsave[i][0]), i);
 		}
+		if (real_fft == NULL) {
+			for (j = 0; j < legacy_ways; j++) {	// twiddles of each sub-transform, once per thread
+				__ogg_fdrffti(n / legacy_ways, state->fft_wsave[i] + j * 2 * (n / legacy_ways), legacy_ifac);
+			}
+		}
+		if (legacy_ways > 1) {
+			state->fft_sub[i] = malloc((size_t) n * sizeof(state->fft_sub[i][0]));
+			if (state->fft_sub[i] == NULL) {
+				errp(40, __func__, "cannot malloc of %ld elements of %ld bytes each for state->fft_sub[%ld]",
+				     n, sizeof(state->fft_sub[i][0]), i);
+			}
+		}
 #else /* LEGACY_FFT */
-		state->fftw_out[i] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (n / 2 + 1));
+		state->fftw_out[i] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (n / 2 + 1) * batch);
 		if (state->fftw_out[i] == NULL) {
 			errp(40, __func__, "cannot fftw_malloc of %ld elements of %ld bytes each for state->fftw_out[%ld]",
-			     n / 2 + 1, sizeof(fftw_complex), i);
+			     (n / 2 + 1) * batch, sizeof(fftw_complex), i);
 		}
-		state->fftw_p[i] = fftw_plan_dft_r2c_1d((int) n, state->fft_X[i], state->fftw_out[i], FFTW_ESTIMATE);
-#endif /* LEGACY_FFT */
-		state->fft_m[i] = calloc((size_t) (n / 2 + 1), sizeof(state->fft_m[i][0]));
-		if (state->fft_m[i] == NULL) {
-			errp(40, __func__, "cannot calloc of %ld elements of %ld bytes each for state->fft_m[%ld]",
-			     n / 2 + 1, sizeof(state->fft_m[i][0]), i);
+
+		/*
+		 * The first plan is tried from the wisdom alone: when the wisdom lacks this problem (another
+		 * bitcount under -W, another -B batch or another number of threads), it is measured and the
+		 * wisdom it adds is saved below.
+		 */
+		plan = NULL;
+		if (i == 0) {
+			plan = DiscreteFourierTransform_plan(state, i, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+			wisdom_learned = (plan == NULL);
 		}
+		if (plan == NULL) {
+			plan = DiscreteFourierTransform_plan(state, i, FFTW_MEASURE);
+		}
+		state->fftw_p[i] = plan;
+		if (state->fftw_p[i] == NULL) {
+			err(40, __func__, "cannot create FFTW plan of size %ld for state->fftw_p[%ld]", n, i);
+		}
+#endif /* LEGACY_FFT */
 	}
 
+#if !defined(LEGACY_FFT)
 	/*
-	 * Allocate dynamic arrays
+	 * Save the wisdom we just gathered so that later runs can skip the measuring
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct DiscreteFourierTransform_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
+	if (wisdom_learned == true) {
+		DiscreteFourierTransform_save_wisdom(wisdom_file);
 	}
-	state->p_val[test_num] = create_dyn_array(sizeof(double),
-						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
-
-	/*
-	 * Determine format of data*.txt filenames based on state->partitionCount[test_num]
-	 * NOTE: If we are not partitioning the p_values, no data*.txt filenames are needed
-	 */
-	state->datatxt_fmt[test_num] = data_filename_format(state->partitionCount[test_num]);
-	dbg(DBG_HIGH, "%s[%d] will form data*.txt filenames with the following format: %s",
-	    state->testNames[test_num], test_num, state->datatxt_fmt[test_num]);
+	pthread_mutex_unlock(&fftw_planner_mutex);
+	free(wisdom_file);
+#endif /* LEGACY_FFT */
 
 	return;
 }
@@ -230,24 +528,21 @@ DiscreteFourierTransform_init(struct state *state)
  *
  * This function is called for each and every iteration noted in state->tp.numOfBitStreams.
  *
+ * The bit stream is converted into the next row of the batch of this thread.  Once the batch
+ * is full, all of its rows are transformed together and their results are recorded.
+ *
  * NOTE: The initialize function must be called first.
  */
 void
 DiscreteFourierTransform_iterate(struct thread_state *thread_state)
 {
-	struct DiscreteFourierTransform_private_stats stat;	// Stats for this iteration
 	long int n;			// Length of a single bit stream
-	double p_value;			// p_value iteration test result(s)
 	double *X = NULL;		// Adjusted sequence with +1 and -1 bits
-	double *m = NULL;		// Magnitude of the DFT
+	WORD64 *packed;			// Bit stream packed 64 bits per word
+	long int fill;			// Number of bit streams already in the batch of this thread
+	long int full;			// Number of full 64 bit words in the bit stream
+	long int w;
 	long int i;
-#if defined(LEGACY_FFT)
-	double *wsave = NULL;		// Work array used by __ogg_fdrffti() and __ogg_fdrfftf()
-	long ifac[WORK_ARRAY_LEN + 1];	// work array used by __ogg_fdrffti() and __ogg_fdrfftf()
-#else /* LEGACY_FFT */
-	fftw_complex *out;		// Output of the DFT
-	fftw_plan p;			// Information on the fastest way to compute the DFT on this machine
-#endif /* LEGACY_FFT */
 
 	/*
 	 * Check preconditions (firewall)
@@ -263,11 +558,11 @@ DiscreteFourierTransform_iterate(struct thread_state *thread_state)
 		dbg(DBG_LOW, "iterate function[%d] %s called when test vector was false", test_num, __func__);
 		return;
 	}
-	if (state->epsilon == NULL) {
-		err(41, __func__, "state->epsilon is NULL");
+	if (state->packed_epsilon == NULL) {
+		err(41, __func__, "state->packed_epsilon is NULL");
 	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(41, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->packed_epsilon[thread_state->thread_id] == NULL) {
+		err(41, __func__, "state->packed_epsilon[%ld] is NULL", thread_state->thread_id);
 	}
 	if (state->fft_X == NULL) {
 		err(41, __func__, "state->fft_X is NULL");
@@ -275,11 +570,145 @@ DiscreteFourierTransform_iterate(struct thread_state *thread_state)
 	if (state->fft_X[thread_state->thread_id] == NULL) {
 		err(41, __func__, "state->fft_X[%ld] is NULL", thread_state->thread_id);
 	}
-	if (state->fft_m == NULL) {
-		err(41, __func__, "state->fft_m is NULL");
+	if (state->fft_fill == NULL) {
+		err(41, __func__, "state->fft_fill is NULL");
+	}
+	if (state->fft_iteration == NULL) {
+		err(41, __func__, "state->fft_iteration is NULL");
+	}
+	if (state->fft_iteration[thread_state->thread_id] == NULL) {
+		err(41, __func__, "state->fft_iteration[%ld] is NULL", thread_state->thread_id);
+	}
+
+	/*
+	 * Collect parameters from state
+	 */
+	n = state->tp.n;
+	fill = state->fft_fill[thread_state->thread_id];
+	if (fill < 0 || fill >= batch) {
+		err(41, __func__, "state->fft_fill[%ld]: %ld must be in the range [0-%ld)", thread_state->thread_id, fill,
+		    batch);
+	}
+	X = state->fft_X[thread_state->thread_id] + fill * n;
+	packed = state->packed_epsilon[thread_state->thread_id];
+
+	/*
+	 * Step 1: initialize X for this iteration
+	 *
+	 * Each bit b of the packed bit stream becomes 2 * b - 1.  The inner loop over the 64 bits
+	 * of a word has no branch, so that the compiler can vectorize it.
+	 */
+	full = n / BITS_N_WORD64;
+	for (w = 0; w < full; w++) {
+		WORD64 word = packed[w];
+		double *x = X + w * BITS_N_WORD64;
+		int k;
+
+		for (k = 0; k < BITS_N_WORD64; k++) {
+			x[k] = (double) ((int) ((word >> k) & 1) * 2 - 1);
+		}
+	}
+	for (i = full * BITS_N_WORD64; i < n; i++) {
+		X[i] = (double) ((int) ((packed[full] >> (i - full * BITS_N_WORD64)) & 1) * 2 - 1);
+	}
+
+	/*
+	 * Add this bit stream to the batch, and process the batch once it is full
+	 */
+	state->fft_iteration[thread_state->thread_id][fill] = thread_state->iteration_being_done;
+	state->fft_fill[thread_state->thread_id] = fill + 1;
+	if (fill + 1 == batch) {
+		DiscreteFourierTransform_batch(thread_state);
+	}
+
+	return;
+}
+
+
+/*
+ * DiscreteFourierTransform_flush - process the bit streams left in the batch of a thread
+ *
+ * given:
+ *      thread_state    // state of the thread that has no more bit streams to iterate on
+ *
+ * This function is called once by each thread after its last iteration.
+ *
+ * NOTE: The initialize function must be called first.
+ */
+void
+DiscreteFourierTransform_flush(struct thread_state *thread_state)
+{
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (thread_state == NULL) {
+		err(41, __func__, "thread_state arg is NULL");
+	}
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(41, __func__, "state arg is NULL");
+	}
+	if (state->testVector[test_num] != true) {
+		dbg(DBG_LOW, "flush function[%d] %s called when test vector was false", test_num, __func__);
+		return;
+	}
+	if (state->fft_fill == NULL) {
+		err(41, __func__, "state->fft_fill is NULL");
+	}
+
+	/*
+	 * Process a partially filled batch
+	 */
+	if (state->fft_fill[thread_state->thread_id] > 0) {
+		DiscreteFourierTransform_batch(thread_state);
+	}
+
+	return;
+}
+
+
+/*
+ * DiscreteFourierTransform_batch - transform the batch of a thread and record the result of each bit stream
+ *
+ * given:
+ *      thread_state    // state of the thread whose batch holds state->fft_fill[thread_id] bit streams
+ *
+ * NOTE: The initialize function must be called first.
+ */
+static void
+DiscreteFourierTransform_batch(struct thread_state *thread_state)
+{
+	struct DiscreteFourierTransform_private_stats stat;	// Stats for this iteration
+	long int n;			// Length of a single bit stream
+	double p_value;			// p_value iteration test result(s)
+	long int N_1;			// Number of peaks below T of the bit stream being evaluated
+	long int fill;			// Number of bit streams in the batch
+	long int iteration;		// Iteration number of the bit stream being recorded
+	long int r;			// Row of the batch
+	long int i;
+#if defined(LEGACY_FFT)
+	double *wsave = NULL;		// Work array used by __ogg_fdrfftf() or computeRealFFT()
+	struct legacy_fft_pool *pool;	// Helper threads of this thread, NULL ==> none
+#else /* LEGACY_FFT */
+	fftw_complex *out;		// Output of the DFT
+	fftw_plan p;			// Information on the fastest way to compute the DFT on this machine
+#endif /* LEGACY_FFT */
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (thread_state == NULL) {
+		err(41, __func__, "thread_state arg is NULL");
+	}
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(41, __func__, "state arg is NULL");
+	}
+	if (state->fft_X == NULL) {
+		err(41, __func__, "state->fft_X is NULL");
 	}
-	if (state->fft_m[thread_state->thread_id] == NULL) {
-		err(41, __func__, "state->fft_m[%ld] is NULL", thread_state->thread_id);
+	if (state->fft_X[thread_state->thread_id] == NULL) {
+		err(41, __func__, "state->fft_X[%ld] is NULL", thread_state->thread_id);
 	}
 	if (state->cSetup != true) {
 		err(41, __func__, "test constants not setup prior to calling %s for %s[%d]",
@@ -311,30 +740,19 @@ DiscreteFourierTransform_iterate(struct thread_state *thread_state)
 	 * Collect parameters from state
 	 */
 	n = state->tp.n;
-	X = state->fft_X[thread_state->thread_id];
+	fill = state->fft_fill[thread_state->thread_id];
+	if (fill < 1 || fill > batch) {
+		err(41, __func__, "state->fft_fill[%ld]: %ld must be in the range [1-%ld]", thread_state->thread_id, fill,
+		    batch);
+	}
 #if defined(LEGACY_FFT)
 	wsave = state->fft_wsave[thread_state->thread_id];
 #else /* LEGACY_FFT */
-	out = state->fftw_out[thread_state->thread_id];
 	p = state->fftw_p[thread_state->thread_id];
 #endif /* LEGACY_FFT */
-	m = state->fft_m[thread_state->thread_id];
-
-	/*
-	 * Step 1: initialize X for this iteration
-	 */
-	for (i = 0; i < n; i++) {
-		if ((int) state->epsilon[thread_state->thread_id][i] == 1) {
-			X[i] = 1;
-		} else if ((int) state->epsilon[thread_state->thread_id][i] == 0) {
-			X[i] = -1;
-		} else {
-			err(41, __func__, "found a bit different than 1 or 0 in the sequence");
-		}
-	}
 
 	/*
-	 * Step 2: apply discrete Fourier transform on X.
+	 * Step 2: apply discrete Fourier transform on each X of the batch.
 	 *
 	 * Because the input array are purely real numbers (X is an array of +1 and -1),
 	 * the DFT output satisfies the "Hermitian" redundancy.
@@ -343,129 +761,139 @@ DiscreteFourierTransform_iterate(struct thread_state *thread_state)
 	 */
 #if defined(LEGACY_FFT)
 	/*
-	 * The dfft (legacy option) does the transform in-place.
+	 * The dfft or built-in real FFT (legacy option) does the transform in-place, one row at a time.
 	 * As a consequence, the values of X will be replaces with frequencies.
 	 *
 	 * After the function returns, X will look like (saying that values followed by I are the imaginary parts):
 	 * 	[a, b, bI, c, cI, ..., l, lI] when n is odd
 	 *	[a, b, bI, c, cI, ..., l, lI, m] when n is even
 	 */
-	__ogg_fdrffti(n, wsave, ifac);
-	__ogg_fdrfftf(n, X, wsave, ifac);
-#else /* LEGACY_FFT */
-	/*
+	for (r = 0; r < fill; r++) {
+		if (legacy_ways > 1) {
+			pool = (legacy_pool == NULL) ? NULL : &legacy_pool[thread_state->thread_id];
+			DiscreteFourierTransform_legacy_parallel(pool, state->fft_X[thread_state->thread_id] + r * n,
+								 state->fft_sub[thread_state->thread_id], wsave, n);
+		} else if (real_fft != NULL) {
+			computeRealFFT(real_fft, state->fft_X[thread_state->thread_id] + r * n, wsave);
+		} else {
+			__ogg_fdrfftf(n, state->fft_X[thread_state->thread_id] + r * n, wsave, legacy_ifac);
+		}
+	}
+#else /* LEGACY_FFT */
+	/*
 	 * The fftw library does the transform out-of-place.
-	 * As a consequence, the computed complex frequencies will be saved in the out array
-	 * of size n / 2 + 1.
+	 * As a consequence, the computed complex frequencies will be saved in the out array,
+	 * n / 2 + 1 of them for each row.
+	 *
+	 * The plan always transforms all the rows of the batch.  When a final batch is only partially
+	 * filled, the rows past fill still hold earlier bit streams whose transforms are ignored.
 	 */
 	fftw_execute(p);
 #endif /* LEGACY_FFT */
 
-#if defined(LEGACY_FFT)
 	/*
-	 * Step 3a: compute modulus (absolute value) of the first element of the DFT output.
-	 * This first element is always real, and has no imaginary part.
+	 * Evaluate each bit stream of the batch in the order it was added
 	 */
-	m[0] = fabs(X[0]);
+	for (r = 0; r < fill; r++) {
+		iteration = state->fft_iteration[thread_state->thread_id][r];
 
-	/*
-	 * Step 3b: compute the modulus of the following n/2 elements of the DFT output.
-	 * These elements are always complex, so we have to consider both real and imaginary value.
-	 */
-	long int j;
-	for (i = 0, j = 1; i < n - 1; i += 2, j++) {
-		m[j] = sqrt((X[i] * X[i]) + (X[i + 1] * X[i + 1]));
-	}
+		/*
+		 * Step 3: compute the modulus (absolute value) of the first n / 2 elements of the DFT output
+		 * Step 5: compute N0
+		 * Step 6: compute N1
+		 *
+		 * NOTE: Step 4 is skipped because T has already been computed.
+		 *
+		 * A modulus is below T when its square is below T * T, so the squared moduli are compared
+		 * against ln(20) * n in a single pass: no sqrt and no array of moduli is needed.
+		 */
+		stat.N_0 = (double) 0.95 * n / 2.0;
+		N_1 = 0;
+#if defined(LEGACY_FFT)
+		double *X = state->fft_X[thread_state->thread_id] + r * n;	// Transformed row of the batch
 
-	/*
-	 * Step 3c: if n is even, consider the remaining additional element at the end of the DFT output.
-	 * This last element is always real, and has no imaginary part.
-	 */
-	if ((n % 2) == 0) {
-		m[i+1] = fabs(X[n-1]);
-	}
+		/*
+		 * The first element is always real, and has no imaginary part.
+		 * The following elements are taken, as always, from the (X[0], X[1]), (X[2], X[3]), ... pairs.
+		 */
+		N_1 += (X[0] * X[0] < log20_n);
+		for (i = 0; i < n / 2 - 1; i++) {
+			N_1 += ((X[2 * i] * X[2 * i]) + (X[2 * i + 1] * X[2 * i + 1]) < log20_n);
+		}
 #else /* LEGACY_FFT */
-	/*
-	 * Step 3: compute modulus (absolute value) of the first (n / 2 + 1) elements (in our case
-	 * all the ones that we have) of the DFT output.
-	 */
-	for (i = 0; i < n / 2 + 1; i++) {
-		m[i] = cabs(out[i]);
-	}
+		out = state->fftw_out[thread_state->thread_id] + r * (n / 2 + 1);
+		for (i = 0; i < n / 2; i++) {
+			N_1 += ((creal(out[i]) * creal(out[i])) + (cimag(out[i]) * cimag(out[i])) < log20_n);
+		}
 #endif /* LEGACY_FFT */
+		stat.N_1 = N_1;
 
-	/*
-	 * Step 5: compute N0
-	 * NOTE: Step 4 is skipped because T has already been computed
-	 */
-	stat.N_0 = (double) 0.95 * n / 2.0;
+		/*
+		 * Step 7: compute the test statistic
+		 */
+		stat.d = (stat.N_1 - stat.N_0) / sqrtn4_095_005;
 
-	/*
-	 * Step 6: compute N1
-	 */
-	stat.N_1 = 0;
-	for (i = 0; i < n / 2; i++) {
-		if (m[i] < sqrt_log20_n) {
-			stat.N_1++;
-		}
-	}
+		/*
+		 * Step 8: compute the test P-value
+		 */
+		p_value = erfc(fabs(stat.d) / state->c.sqrt2);
 
-	/*
-	 * Step 7: compute the test statistic
-	 */
-	stat.d = (stat.N_1 - stat.N_0) / sqrtn4_095_005;
+		/*
+		 * Lock mutex before making changes to the shared state
+		 */
+		if (thread_state->mutex != NULL) {
+			pthread_mutex_lock(thread_state->mutex);
+		}
 
-	/*
-	 * Step 8: compute the test P-value
-	 */
-	p_value = erfc(fabs(stat.d) / state->c.sqrt2);
+		/*
+		 * Record success or failure for this iteration
+		 */
+		state->count[test_num]++;	// Count this iteration
+		state->valid[test_num]++;	// Count this valid iteration
+		if (isNegative(p_value)) {
+			state->failure[test_num]++;	// Bogus p_value < 0.0 treated as a failure
+			stat.success = false;		// FAILURE
+			warn(__func__, "iteration %ld of test %s[%d] produced bogus p_value: %f < 0.0\n",
+			     iteration + 1, state->testNames[test_num], test_num, p_value);
+		} else if (isGreaterThanOne(p_value)) {
+			state->failure[test_num]++;	// Bogus p_value > 1.0 treated as a failure
+			stat.success = false;		// FAILURE
+			warn(__func__, "iteration %ld of test %s[%d] produced bogus p_value: %f > 1.0\n",
+			     iteration + 1, state->testNames[test_num], test_num, p_value);
+		} else if (p_value < state->tp.alpha) {
+			state->valid_p_val[test_num]++;	// Valid p_value in [0.0, 1.0] range
+			state->failure[test_num]++;	// Valid p_value but too low is a failure
+			stat.success = false;		// FAILURE
+		} else {
+			state->valid_p_val[test_num]++;	// Valid p_value in [0.0, 1.0] range
+			state->success[test_num]++;	// Valid p_value not too low is a success
+			stat.success = true;		// SUCCESS
+		}
 
-	/*
-	 * Lock mutex before making changes to the shared state
-	 */
-	if (thread_state->mutex != NULL) {
-		pthread_mutex_lock(thread_state->mutex);
-	}
+		/*
+		 * Record values computed during this iteration
+		 */
+		append_value(state->p_val[test_num], &p_value);
 
-	/*
-	 * Record success or failure for this iteration
-	 */
-	state->count[test_num]++;	// Count this iteration
-	state->valid[test_num]++;	// Count this valid iteration
-	if (isNegative(p_value)) {
-		state->failure[test_num]++;	// Bogus p_value < 0.0 treated as a failure
-		stat.success = false;		// FAILURE
-		warn(__func__, "iteration %ld of test %s[%d] produced bogus p_value: %f < 0.0\n",
-		     thread_state->iteration_being_done + 1, state->testNames[test_num], test_num, p_value);
-	} else if (isGreaterThanOne(p_value)) {
-		state->failure[test_num]++;	// Bogus p_value > 1.0 treated as a failure
-		stat.success = false;		// FAILURE
-		warn(__func__, "iteration %ld of test %s[%d] produced bogus p_value: %f > 1.0\n",
-		     thread_state->iteration_being_done + 1, state->testNames[test_num], test_num, p_value);
-	} else if (p_value < state->tp.alpha) {
-		state->valid_p_val[test_num]++;	// Valid p_value in [0.0, 1.0] range
-		state->failure[test_num]++;	// Valid p_value but too low is a failure
-		stat.success = false;		// FAILURE
-	} else {
-		state->valid_p_val[test_num]++;	// Valid p_value in [0.0, 1.0] range
-		state->success[test_num]++;	// Valid p_value not too low is a success
-		stat.success = true;		// SUCCESS
-	}
+		/*
+		 * Unlock mutex after making changes to the shared state
+		 */
+		if (thread_state->mutex != NULL) {
+			pthread_mutex_unlock(thread_state->mutex);
+		}
 
-	/*
-	 * Record values computed during this iteration
-	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
+		/*
+		 * Print the stats.txt and results.txt lines of this iteration (if needed)
+		 */
+		if (state->resultstxtFlag == true) {
+			DiscreteFourierTransform_print(thread_state, &stat, p_value, iteration);
+		}
 	}
-	append_value(state->p_val[test_num], &p_value);
 
 	/*
-	 * Unlock mutex after making changes to the shared state
+	 * The batch of this thread is now empty
 	 */
-	if (thread_state->mutex != NULL) {
-		pthread_mutex_unlock(thread_state->mutex);
-	}
+	state->fft_fill[thread_state->thread_id] = 0;
 
 	return;
 }
@@ -489,6 +917,7 @@ DiscreteFourierTransform_print_stat(FILE * stream, struct state *state, struct D
 				    double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -532,7 +961,8 @@ DiscreteFourierTransform_print_stat(FILE * stream, struct state *state, struct D
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(a) Percentile = %f\n", (double) stat->N_1 / (state->tp.n / 2) * 100.0);
+	io_ret = fprintf(stream, "\t\t(a) Percentile = %s\n",
+			 formatDouble(value, state, (double) stat->N_1 / (state->tp.n / 2) * 100.0, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
@@ -540,11 +970,11 @@ DiscreteFourierTransform_print_stat(FILE * stream, struct state *state, struct D
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(c) N_0        = %f\n", stat->N_0);
+	io_ret = fprintf(stream, "\t\t(c) N_0        = %s\n", formatDouble(value, state, stat->N_0, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(d) d          = %f\n", stat->d);
+	io_ret = fprintf(stream, "\t\t(d) d          = %s\n", formatDouble(value, state, stat->d, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
@@ -553,7 +983,7 @@ DiscreteFourierTransform_print_stat(FILE * stream, struct state *state, struct D
 		return false;
 	}
 	if (stat->success == true) {
-		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -563,7 +993,7 @@ DiscreteFourierTransform_print_stat(FILE * stream, struct state *state, struct D
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -589,9 +1019,10 @@ DiscreteFourierTransform_print_stat(FILE * stream, struct state *state, struct D
  *      false --> an I/O error occurred
  */
 static bool
-DiscreteFourierTransform_print_p_value(FILE * stream, double p_value)
+DiscreteFourierTransform_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -599,6 +1030,9 @@ DiscreteFourierTransform_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(43, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(43, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -609,7 +1043,7 @@ DiscreteFourierTransform_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -623,213 +1057,67 @@ DiscreteFourierTransform_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * DiscreteFourierTransform_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * DiscreteFourierTransform_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value         // p_value iteration test result(s)
+ *      iteration       // iteration of the bit stream, which may not be the one of thread_state when batched
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-DiscreteFourierTransform_print(struct state *state)
+static void
+DiscreteFourierTransform_print(struct thread_state *thread_state,
+			       struct DiscreteFourierTransform_private_stats *stat, double p_value, long int iteration)
 {
-	struct DiscreteFourierTransform_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(44, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(44, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(44, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(44, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(44, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(44, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(44, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
-	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
-
-	/*
-	 * Open results.txt file
+	 * Begin the row of this iteration
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, iteration);
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print stat to stats.txt
 	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct DiscreteFourierTransform_private_stats, i);
-
-		/*
-		 * Get p_value for this iteration
-		 */
-		p_value = get_value(state->p_val[test_num], double, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = DiscreteFourierTransform_print_stat(stats, state, stat, p_value);
-		if (ok == false) {
-			errp(44, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = DiscreteFourierTransform_print_p_value(results, p_value);
-		if (ok == false) {
-			errp(44, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = DiscreteFourierTransform_print_stat(buffer->stats, state, stat, p_value);
+	if (ok == false) {
+		errp(44, __func__, "error in writing iteration %ld to stats.txt", iteration + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_value to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(44, __func__, "error flushing to: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = DiscreteFourierTransform_print_p_value(buffer->results, state, p_value);
+	if (ok == false) {
+		errp(44, __func__, "error in writing iteration %ld to results.txt", iteration + 1);
 	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(44, __func__, "error closing: %s", stats_txt);
-	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(44, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(44, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-
-		/*
-		 * For each data file
-		 */
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(44, __func__, "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ,
-				     j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = DiscreteFourierTransform_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(44, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(44, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(44, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -897,7 +1185,7 @@ DiscreteFourierTransform_metric_print(struct state *state, long int sampleCount,
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1004,9 +1292,8 @@ DiscreteFourierTransform_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1025,73 +1312,28 @@ DiscreteFourierTransform_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(46, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(46, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1112,12 +1354,6 @@ DiscreteFourierTransform_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1135,6 +1371,9 @@ void
 DiscreteFourierTransform_destroy(struct state *state)
 {
 	long int i;
+#if defined(LEGACY_FFT)
+	long int j;
+#endif /* LEGACY_FFT */
 
 	/*
 	 * Check preconditions (firewall)
@@ -1150,11 +1389,6 @@ DiscreteFourierTransform_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -1173,32 +1407,76 @@ DiscreteFourierTransform_destroy(struct state *state)
 		state->subDir[test_num] = NULL;
 	}
 
-
-	for (i = 0; i < state->numberOfThreads; i++) {
-		if (state->fft_X[i] != NULL) {
-			free(state->fft_X[i]);
-			state->fft_X[i] = NULL;
-		}
 #if defined(LEGACY_FFT)
-		if (state->fft_wsave[i] != NULL) {
-			free(state->fft_wsave[i]);
-			state->fft_wsave[i] = NULL;
-		}
-#else /* LEGACY_FFT */
-		if (state->fftw_out[i] != NULL) {
-			fftw_free(state->fftw_out[i]);
-			state->fftw_out[i] = NULL;
-		}
-		if (state->fftw_p[i] != NULL) {
-			fftw_destroy_plan(state->fftw_p[i]);
-			state->fftw_p[i] = NULL;
+	/*
+	 * Stop the helper threads of the split legacy FFT
+	 */
+	if (legacy_pool != NULL) {
+		for (i = 0; i < state->numberOfThreads; i++) {
+			if (legacy_pool[i].started == true) {
+				pthread_mutex_lock(&legacy_pool[i].mutex);
+				legacy_pool[i].closing = true;
+				pthread_cond_broadcast(&legacy_pool[i].start);
+				pthread_mutex_unlock(&legacy_pool[i].mutex);
+				for (j = 1; j < legacy_workers; j++) {
+					if (pthread_join(legacy_pool[i].thread[j], NULL) != 0) {
+						errp(47, __func__, "error on pthread_join()");
+					}
+				}
+				pthread_cond_destroy(&legacy_pool[i].done);
+				pthread_cond_destroy(&legacy_pool[i].start);
+				pthread_mutex_destroy(&legacy_pool[i].mutex);
+			}
 		}
+		free(legacy_pool);
+		legacy_pool = NULL;
+	}
 #endif /* LEGACY_FFT */
-		if (state->fft_m[i] != NULL) {
-			free(state->fft_m[i]);
-			state->fft_m[i] = NULL;
+
+	/*
+	 * Free the per-thread arrays, if the transforms were set up in this process (see init())
+	 */
+	if (state->fft_X != NULL) {
+		for (i = 0; i < state->numberOfThreads; i++) {
+			if (state->fft_X[i] != NULL) {
+				free(state->fft_X[i]);
+				state->fft_X[i] = NULL;
+			}
+	#if defined(LEGACY_FFT)
+			if (state->fft_wsave[i] != NULL) {
+				free(state->fft_wsave[i]);
+				state->fft_wsave[i] = NULL;
+			}
+			if (state->fft_sub[i] != NULL) {
+				free(state->fft_sub[i]);
+				state->fft_sub[i] = NULL;
+			}
+	#else /* LEGACY_FFT */
+			if (state->fftw_out[i] != NULL) {
+				fftw_free(state->fftw_out[i]);
+				state->fftw_out[i] = NULL;
+			}
+			if (state->fftw_p[i] != NULL) {
+				pthread_mutex_lock(&fftw_planner_mutex);
+				fftw_destroy_plan(state->fftw_p[i]);
+				pthread_mutex_unlock(&fftw_planner_mutex);
+				state->fftw_p[i] = NULL;
+			}
+	#endif /* LEGACY_FFT */
+			if (state->fft_iteration[i] != NULL) {
+				free(state->fft_iteration[i]);
+				state->fft_iteration[i] = NULL;
+			}
 		}
 	}
+	if (state->fft_iteration != NULL) {
+		free(state->fft_iteration);
+		state->fft_iteration = NULL;
+	}
+	if (state->fft_fill != NULL) {
+		free(state->fft_fill);
+		state->fft_fill = NULL;
+	}
 
 	if (state->fft_X != NULL) {
 		free(state->fft_X);
@@ -1209,6 +1487,16 @@ DiscreteFourierTransform_destroy(struct state *state)
 		free(state->fft_wsave);
 		state->fft_wsave = NULL;
 	}
+	if (state->fft_sub != NULL) {
+		free(state->fft_sub);
+		state->fft_sub = NULL;
+	}
+	destroyRealFFT(real_fft);
+	real_fft = NULL;
+	if (legacy_twiddle != NULL) {
+		free(legacy_twiddle);
+		legacy_twiddle = NULL;
+	}
 #else /* LEGACY_FFT */
 	if (state->fftw_out != NULL) {
 		free(state->fftw_out);
@@ -1218,11 +1506,501 @@ DiscreteFourierTransform_destroy(struct state *state)
 		free(state->fftw_p);
 		state->fftw_p = NULL;
 	}
+	if (fftw_threads_ready == true) {
+		pthread_mutex_lock(&fftw_planner_mutex);
+		fftw_cleanup_threads();
+		pthread_mutex_unlock(&fftw_planner_mutex);
+		fftw_threads_ready = false;
+	}
 #endif /* LEGACY_FFT */
-	if (state->fft_m != NULL) {
-		free(state->fft_m);
-		state->fft_m = NULL;
+
+	return;
+}
+
+
+#if !defined(LEGACY_FFT)
+/*
+ * DiscreteFourierTransform_wisdom_file - determine the FFTW wisdom file for this run
+ *
+ * given:
+ *      state           // run state to test under
+ *
+ * returns:
+ *      malloced path of the FFTW wisdom file
+ *
+ * The wisdom file is -W wisdomFile if given.  Otherwise it is keyed by bitcount and lives under
+ * $XDG_CACHE_HOME/sts when XDG_CACHE_HOME is set (and that directory exists or may be created),
+ * or under workDir otherwise.
+ */
+static char *
+DiscreteFourierTransform_wisdom_file(struct state *state)
+{
+	char filename[BUFSIZ + 1];	// fftw-wisdom.__bitcount__
+	char *cache_home;		// $XDG_CACHE_HOME or NULL
+	char *cache_dir;		// $XDG_CACHE_HOME/sts
+	char *wisdom_file;		// Path of the FFTW wisdom file
+	struct stat statbuf;		// Status of the cache directory
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(48, __func__, "state arg is NULL");
+	}
+
+	/*
+	 * Use -W wisdomFile if it was given
+	 */
+	if (state->wisdomFlag == true && state->wisdomFile != NULL) {
+		wisdom_file = strdup(state->wisdomFile);
+		if (wisdom_file == NULL) {
+			errp(48, __func__, "strdup of %lu bytes for wisdom file failed", strlen(state->wisdomFile));
+		}
+		return wisdom_file;
+	}
+
+	/*
+	 * Form the filename, keyed by bitcount
+	 */
+	snprintf(filename, BUFSIZ, "fftw-wisdom.%ld", state->tp.n);
+	filename[BUFSIZ] = '\0';	// paranoia
+
+	/*
+	 * Prefer the user cache directory, falling back to workDir
+	 */
+	cache_home = getenv("XDG_CACHE_HOME");
+	if (cache_home != NULL && cache_home[0] != '\0') {
+		cache_dir = filePathName(cache_home, "sts");
+		if (state->subDirs == true) {
+			makePath(cache_dir);
+		}
+		if (stat(cache_dir, &statbuf) == 0 && S_ISDIR(statbuf.st_mode)) {
+			wisdom_file = filePathName(cache_dir, filename);
+			free(cache_dir);
+			return wisdom_file;
+		}
+		free(cache_dir);
+	}
+	return filePathName(state->workDir, filename);
+}
+
+
+/*
+ * DiscreteFourierTransform_plan - plan the transforms of the batch of one thread
+ *
+ * given:
+ *      state           // run state to test under
+ *      thread          // thread whose state->fft_X and state->fftw_out are transformed
+ *      flags           // FFTW planner flags
+ *
+ * returns:
+ *      FFTW plan, or NULL ==> no plan could be made (such as with FFTW_WISDOM_ONLY and no wisdom)
+ *
+ * NOTE: The caller must hold fftw_planner_mutex.
+ */
+static fftw_plan
+DiscreteFourierTransform_plan(struct state *state, long int thread, unsigned int flags)
+{
+	int rank_n;		// Length of a single bit stream, as an FFTW rank
+
+	rank_n = (int) state->tp.n;
+	if (batch == 1) {
+		return fftw_plan_dft_r2c_1d(rank_n, state->fft_X[thread], state->fftw_out[thread], flags);
 	}
 
+	/*
+	 * One plan transforms all the rows of the batch: row r of fft_X starts at r * n
+	 * and its transform is stored starting at r * (n / 2 + 1) in fftw_out
+	 */
+	return fftw_plan_many_dft_r2c(1, &rank_n, (int) batch, state->fft_X[thread], NULL, 1, rank_n,
+				      state->fftw_out[thread], NULL, 1, rank_n / 2 + 1, flags);
+}
+
+
+/*
+ * DiscreteFourierTransform_save_wisdom - save the FFTW wisdom gathered so far
+ *
+ * given:
+ *      wisdom_file     // path of the FFTW wisdom file
+ *
+ * The wisdom is written to a temporary file that is then renamed into place, so that concurrent
+ * jobs sharing the same wisdom file never import a partially written one.  Failing to save the
+ * wisdom only costs planning time in later runs, so it is not fatal.
+ *
+ * NOTE: The caller must hold fftw_planner_mutex.
+ */
+static void
+DiscreteFourierTransform_save_wisdom(char *wisdom_file)
+{
+	char *tmp_file;		// Temporary file to write the wisdom into
+	size_t len;		// Length of tmp_file
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (wisdom_file == NULL) {
+		err(49, __func__, "wisdom_file arg is NULL");
+	}
+
+	/*
+	 * Form the temporary filename
+	 */
+	len = strlen(wisdom_file) + 1 + BITS_N_LONGINT + 4 + 1;
+	tmp_file = malloc(len + 1);	// +1 for later paranoia
+	if (tmp_file == NULL) {
+		errp(49, __func__, "cannot malloc of %lu bytes for tmp_file", len + 1);
+	}
+	snprintf(tmp_file, len, "%s.%ld.tmp", wisdom_file, (long int) getpid());
+	tmp_file[len] = '\0';	// paranoia
+
+	/*
+	 * Write and move into place
+	 */
+	if (fftw_export_wisdom_to_filename(tmp_file) == 0) {
+		warn(__func__, "cannot write FFTW wisdom to: %s", tmp_file);
+		(void) unlink(tmp_file);
+	} else if (rename(tmp_file, wisdom_file) != 0) {
+		warn(__func__, "cannot rename %s to %s: %s", tmp_file, wisdom_file, strerror(errno));
+		(void) unlink(tmp_file);
+	} else {
+		dbg(DBG_MED, "saved FFTW wisdom in: %s", wisdom_file);
+	}
+	free(tmp_file);
+
 	return;
 }
+#endif /* LEGACY_FFT */
+
+
+#if defined(LEGACY_FFT)
+/*
+ * DiscreteFourierTransform_legacy_parallel - transform one sequence with the split legacy FFT
+ *
+ * given:
+ *      pool            // helper threads of the calling thread, or NULL ==> transform in the calling thread
+ *      X               // sequence of length n, replaced by its transform in the same layout as __ogg_fdrfftf()
+ *      sub             // work array of n doubles
+ *      wsave           // work array of 2 * n doubles, whose sub-transform twiddles were set by init()
+ *      n               // length of X, a multiple of 2 * legacy_ways
+ *
+ * X is split into the legacy_ways decimated sub-sequences x_p[m] = X[m * legacy_ways + p] of length
+ * N = n / legacy_ways, and each of them is transformed into S_p.  Then for each j in [0, N / 2], the
+ * frequencies X[j + q * N] for q in [0, legacy_ways) are the transform of length legacy_ways of
+ *
+ *      y_p = exp(-2 * pi * i * p * j / n) * S_p[j]
+ *
+ * computed with radix 2 butterflies, and the other frequencies follow from X[n - k] = conj(X[k]).
+ * The result equals that of a single __ogg_fdrfftf() on X, up to floating point rounding, and does
+ * not depend on the number of workers.
+ */
+static void
+DiscreteFourierTransform_legacy_parallel(struct legacy_fft_pool *pool, double *X, double *sub, double *wsave, long int n)
+{
+	struct legacy_fft_work work;	// Work of the calling thread without helpers
+	long int k;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (X == NULL) {
+		err(41, __func__, "X arg is NULL");
+	}
+	if (sub == NULL) {
+		err(41, __func__, "sub arg is NULL");
+	}
+	if (wsave == NULL) {
+		err(41, __func__, "wsave arg is NULL");
+	}
+	if (legacy_ways < 2 || legacy_ways > MAX_LEGACY_FFT_WAYS || n % (2 * legacy_ways) != 0) {
+		err(41, __func__, "legacy_ways: %ld must be in the range [2-%d] and divide n / 2: %ld", legacy_ways,
+		    MAX_LEGACY_FFT_WAYS, n / 2);
+	}
+	if (legacy_twiddle == NULL) {
+		err(41, __func__, "legacy_twiddle is NULL");
+	}
+
+	/*
+	 * Without helpers, the calling thread does both phases alone
+	 */
+	if (pool == NULL) {
+		work.X = X;
+		work.sub = sub;
+		work.wsave = wsave;
+		work.n = n;
+		work.worker = 0;
+		work.pool = NULL;
+		(void) DiscreteFourierTransform_legacy_sub(&work);
+		(void) DiscreteFourierTransform_legacy_combine(&work);
+		return;
+	}
+
+	/*
+	 * Start the helpers on the first transform
+	 */
+	if (pool->started == false) {
+		pthread_mutex_init(&pool->mutex, NULL);
+		pthread_cond_init(&pool->start, NULL);
+		pthread_cond_init(&pool->done, NULL);
+		pool->phases = 0;
+		pool->busy = 0;
+		pool->closing = false;
+		for (k = 0; k < legacy_workers; k++) {
+			pool->work[k].worker = k;
+			pool->work[k].pool = pool;
+		}
+		for (k = 1; k < legacy_workers; k++) {
+			if (pthread_create(&pool->thread[k], NULL, DiscreteFourierTransform_legacy_helper, &pool->work[k]) != 0) {
+				errp(41, __func__, "error on pthread_create()");
+			}
+		}
+		pool->started = true;
+	}
+
+	/*
+	 * Hand this sequence to every worker, then transform the sub-sequences and combine them
+	 */
+	pthread_mutex_lock(&pool->mutex);
+	for (k = 0; k < legacy_workers; k++) {
+		pool->work[k].X = X;
+		pool->work[k].sub = sub;
+		pool->work[k].wsave = wsave;
+		pool->work[k].n = n;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	DiscreteFourierTransform_legacy_run(pool, DiscreteFourierTransform_legacy_sub);
+	DiscreteFourierTransform_legacy_run(pool, DiscreteFourierTransform_legacy_combine);
+
+	return;
+}
+
+
+/*
+ * DiscreteFourierTransform_legacy_run - run one phase of a split legacy FFT on the calling thread and its helpers
+ *
+ * given:
+ *      pool            // started helper threads of the calling thread
+ *      phase           // DiscreteFourierTransform_legacy_sub or DiscreteFourierTransform_legacy_combine
+ *
+ * The calling thread does the share of worker 0, and returns once every helper is done with its own.
+ */
+static void
+DiscreteFourierTransform_legacy_run(struct legacy_fft_pool *pool, void *(*phase)(void *))
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->phase = phase;
+	pool->busy = legacy_workers - 1;
+	pool->phases++;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->mutex);
+
+	(void) phase(&pool->work[0]);
+
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->busy > 0) {
+		pthread_cond_wait(&pool->done, &pool->mutex);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return;
+}
+
+
+/*
+ * DiscreteFourierTransform_legacy_helper - do the share of one helper in each phase until closing
+ *
+ * given:
+ *      work            // pointer to the struct legacy_fft_work of this helper
+ *
+ * returns:
+ *      NULL
+ */
+static void *
+DiscreteFourierTransform_legacy_helper(void *work)
+{
+	struct legacy_fft_work *w = (struct legacy_fft_work *) work;
+	struct legacy_fft_pool *pool = w->pool;
+	void *(*phase)(void *);		// Function of the phase to do
+	long int phases;		// Number of phases seen so far
+
+	phases = 0;	// The helpers are created before the first phase
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while (pool->phases == phases && pool->closing == false) {
+			pthread_cond_wait(&pool->start, &pool->mutex);
+		}
+		if (pool->closing == true) {
+			break;
+		}
+		phases = pool->phases;
+		phase = pool->phase;
+		pthread_mutex_unlock(&pool->mutex);
+
+		(void) phase(w);
+
+		pthread_mutex_lock(&pool->mutex);
+		pool->busy--;
+		if (pool->busy == 0) {
+			pthread_cond_signal(&pool->done);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+
+/*
+ * DiscreteFourierTransform_legacy_sub - transform the decimated sub-sequences of one worker (1st phase)
+ *
+ * given:
+ *      work            // pointer to the struct legacy_fft_work of this worker
+ *
+ * returns:
+ *      NULL
+ *
+ * Worker w transforms the sub-sequences w, w + legacy_workers, ...
+ */
+static void *
+DiscreteFourierTransform_legacy_sub(void *work)
+{
+	struct legacy_fft_work *w = (struct legacy_fft_work *) work;
+	double *x;			// Decimated sub-sequence being transformed
+	double *wsave;			// Work array of this sub-sequence
+	long int N;			// Length of the sub-sequence
+	long int workers;		// Number of workers sharing the transform
+	long int p;
+	long int m;
+
+	N = w->n / legacy_ways;
+	workers = (w->pool == NULL) ? 1 : legacy_workers;
+	for (p = w->worker; p < legacy_ways; p += workers) {
+
+		/*
+		 * Gather x_p[m] = X[m * ways + p]
+		 */
+		x = w->sub + p * N;
+		wsave = w->wsave + p * 2 * N;
+		for (m = 0; m < N; m++) {
+			x[m] = w->X[m * legacy_ways + p];
+		}
+
+		/*
+		 * Transform it in-place
+		 */
+		if (real_fft != NULL) {
+			computeRealFFT(real_fft, x, wsave);
+		} else {
+			__ogg_fdrfftf(N, x, wsave, legacy_ifac);
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ * DiscreteFourierTransform_legacy_combine - combine the sub-transforms for a slice of frequencies (2nd phase)
+ *
+ * given:
+ *      work            // pointer to the struct legacy_fft_work of this worker
+ *
+ * returns:
+ *      NULL
+ *
+ * Worker w combines its slice of j in [0, N / 2] into the frequencies j + q * N and n - j - q * N.
+ */
+static void *
+DiscreteFourierTransform_legacy_combine(void *work)
+{
+	struct legacy_fft_work *w = (struct legacy_fft_work *) work;
+	double complex y[MAX_LEGACY_FFT_WAYS];	// Twiddled S_p[j] in bit reversed order, then X[j + q * N]
+	double complex power;		// exp(-2 * pi * i * p * j / n)
+	double complex bin;		// Frequency j of sub-transform p
+	double complex t;		// Twiddled odd input of a butterfly
+	const double *s;		// Sub-transform p, in the __ogg_fdrfftf() layout
+	long int N;			// Length of each sub-sequence
+	long int workers;		// Number of workers sharing the transform
+	long int lo;			// First j of this slice
+	long int hi;			// j after the last one of this slice
+	long int size;			// Length of the transforms merged by the current butterflies
+	long int b;			// First element of the current butterflies
+	long int j;			// Frequency of the sub-transforms
+	long int k;			// Frequency of X
+	long int m;
+	long int p;
+	long int q;
+
+	N = w->n / legacy_ways;
+	workers = (w->pool == NULL) ? 1 : legacy_workers;
+	lo = (N / 2 + 1) * w->worker / workers;
+	hi = (N / 2 + 1) * (w->worker + 1) / workers;
+	for (j = lo; j < hi; j++) {
+
+		/*
+		 * Fetch and twiddle S_p[j], as j <= N / 2 needs no Hermitian symmetry
+		 */
+		power = 1.0;
+		for (p = 0; p < legacy_ways; p++) {
+			s = w->sub + p * N;
+			if (j == 0) {
+				bin = s[0];
+			} else if (j == N / 2) {
+				bin = s[N - 1];
+			} else {
+				bin = s[2 * j - 1] + s[2 * j] * I;
+			}
+			y[legacy_reverse[p]] = power * bin;
+			power *= legacy_twiddle[j];
+		}
+
+		/*
+		 * Transform y with radix 2 butterflies, into y[q] = X[j + q * N]
+		 */
+		for (size = 2; size <= legacy_ways; size *= 2) {
+			for (b = 0; b < legacy_ways; b += size) {
+				for (m = 0; m < size / 2; m++) {
+					t = legacy_root[m * (legacy_ways / size)] * y[b + m + size / 2];
+					y[b + m + size / 2] = y[b + m] - t;
+					y[b + m] += t;
+				}
+			}
+		}
+
+		/*
+		 * Store the non-redundant frequencies X[k] and X[n - k] = conj(X[k])
+		 */
+		for (q = 0; q < legacy_ways; q++) {
+			k = j + q * N;
+			DiscreteFourierTransform_legacy_store(w->X, w->n, k, y[q]);
+			DiscreteFourierTransform_legacy_store(w->X, w->n, w->n - k, conj(y[q]));
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ * DiscreteFourierTransform_legacy_store - store frequency k of X in the __ogg_fdrfftf() layout
+ *
+ * given:
+ *      X               // transform of length n
+ *      n               // length of X
+ *      k               // frequency to store, ignored unless in [0, n / 2]
+ *      value           // X[k]
+ */
+static void
+DiscreteFourierTransform_legacy_store(double *X, long int n, long int k, double complex value)
+{
+	if (k == 0) {
+		X[0] = creal(value);
+	} else if (k == n / 2) {
+		X[n - 1] = creal(value);
+	} else if (k < n / 2) {
+		X[2 * k - 1] = creal(value);
+		X[2 * k] = cimag(value);
+	}
+
+	return;
+}
+#endif /* LEGACY_FFT */
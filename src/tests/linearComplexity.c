@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/debug.h"
 
 
@@ -67,7 +70,8 @@ static const double pi_term[K_LINEARCOMPLEXITY + 1] = { 0.01047, 0.03125, 0.1250
  */
 static bool LinearComplexity_print_stat(FILE * stream, struct state *state, struct LinearComplexity_private_stats *stat,
 					double p_value);
-static bool LinearComplexity_print_p_value(FILE * stream, double p_value);
+static bool LinearComplexity_print_p_value(FILE * stream, struct state *state, double p_value);
+static void LinearComplexity_print(struct thread_state *thread_state, struct LinearComplexity_private_stats *stat, double p_value);
 static void LinearComplexity_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
 
 
@@ -147,6 +151,9 @@ LinearComplexity_init(struct state *state)
 
 	/*
 	 * Allocate special Linear Feedback Shift Register arrays for each thread
+	 *
+	 * Each array holds LANES_LINEARCOMPLEXITY blocks side by side: bit l of word k is the k-th element of the l-th block.
+	 * The b, c and t arrays have one extra word so that multiplying by x never writes past their end.
 	 */
 	state->linear_b = malloc((size_t) state->numberOfThreads * sizeof(*state->linear_b));
 	if (state->linear_b == NULL) {
@@ -159,35 +166,41 @@ LinearComplexity_init(struct state *state)
 		     sizeof(*state->linear_c));
 	}
 	state->linear_t = malloc((size_t) state->numberOfThreads * sizeof(*state->linear_t));
-	if (state->linear_b == NULL) {
+	if (state->linear_t == NULL) {
 		errp(100, __func__, "cannot malloc for linear_t: %ld elements of %lu bytes each", state->numberOfThreads,
 		     sizeof(*state->linear_t));
 	}
+	state->linear_s = malloc((size_t) state->numberOfThreads * sizeof(*state->linear_s));
+	if (state->linear_s == NULL) {
+		errp(100, __func__, "cannot malloc for linear_s: %ld elements of %lu bytes each", state->numberOfThreads,
+		     sizeof(*state->linear_s));
+	}
 	for (i = 0; i < state->numberOfThreads; i++) {
-		state->linear_b[i] = malloc(state->tp.linearComplexitySequenceLength * sizeof(state->linear_b[i][0]));
+		state->linear_b[i] = malloc((state->tp.linearComplexitySequenceLength + 1) * sizeof(state->linear_b[i][0]));
 		if (state->linear_b[i] == NULL) {
 			errp(100, __func__, "cannot malloc of %ld elements of %ld bytes each for state->linear_b[%ld]",
-			     state->tp.linearComplexitySequenceLength, sizeof(state->linear_b[i][0]), i);
+			     state->tp.linearComplexitySequenceLength + 1, sizeof(state->linear_b[i][0]), i);
 		}
-		state->linear_c[i] = malloc(state->tp.linearComplexitySequenceLength * sizeof(state->linear_c[i][0]));
+		state->linear_c[i] = malloc((state->tp.linearComplexitySequenceLength + 1) * sizeof(state->linear_c[i][0]));
 		if (state->linear_c[i] == NULL) {
 			errp(100, __func__, "cannot malloc of %ld elements of %ld bytes each for state->linear_c[%ld]",
-			     state->tp.linearComplexitySequenceLength, sizeof(state->linear_c[i][0]), i);
+			     state->tp.linearComplexitySequenceLength + 1, sizeof(state->linear_c[i][0]), i);
 		}
-		state->linear_t[i] = malloc(state->tp.linearComplexitySequenceLength * sizeof(state->linear_t[i][0]));
+		state->linear_t[i] = malloc((state->tp.linearComplexitySequenceLength + 1) * sizeof(state->linear_t[i][0]));
 		if (state->linear_t[i] == NULL) {
 			errp(100, __func__, "cannot malloc of %ld elements of %ld bytes each for state->linear_t[%ld]",
-			     state->tp.linearComplexitySequenceLength, sizeof(state->linear_t[i][0]), i);
+			     state->tp.linearComplexitySequenceLength + 1, sizeof(state->linear_t[i][0]), i);
+		}
+		state->linear_s[i] = malloc(state->tp.linearComplexitySequenceLength * sizeof(state->linear_s[i][0]));
+		if (state->linear_s[i] == NULL) {
+			errp(100, __func__, "cannot malloc of %ld elements of %ld bytes each for state->linear_s[%ld]",
+			     state->tp.linearComplexitySequenceLength, sizeof(state->linear_s[i][0]), i);
 		}
 	}
 
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct LinearComplexity_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double),
 						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
 
@@ -220,9 +233,19 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 	long int M;		// Length of each block to be tested
 	long int n;		// Length of a single bit stream
 	long int N;		// Number of independent M-bit blocks the bit stream is partitioned into
-	long int d;		// Discrepancy for LFSR algorithm
-	long int L;		// Length of the minimal LFSR for the stream
-	long int m;		// Number of iterations since L was updated to 1 for the LFSR algorithm
+	long int L[LANES_LINEARCOMPLEXITY];	// Length of the minimal LFSR for the stream of each block lane
+	long int L_max;		// Largest L among the block lanes
+	long int lanes;		// Number of block lanes in use in the current group of blocks
+	long int deg;		// Bound on the degree of the c and b polynomials
+	WORD64 *b;		// Bit-sliced LFSR array b, already multiplied by x^(j-m)
+	WORD64 *c;		// Bit-sliced LFSR array c
+	WORD64 *t;		// Bit-sliced LFSR array t, next value of b
+	WORD64 *s;		// Bit-sliced blocks of the bit stream
+	WORD64 *swap;		// Used to exchange b and t
+	WORD64 d;		// Discrepancy for LFSR algorithm (one bit per block lane)
+	WORD64 u;		// Block lanes for which L, m and b are updated
+	WORD64 word;		// Current word of b
+	BitSequence *epsilon;	// Bit stream of this thread
 	double mean;		// Theoretical mean under an assumption of randomness
 	double T;		// Value used to identify the class v to increment
 	double p_value;		// p_value iteration test result(s)
@@ -230,6 +253,7 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 	long int i;
 	long int j;
 	long int k;
+	long int l;
 
 	/*
 	 * Check preconditions (firewall)
@@ -269,6 +293,12 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 	if (state->linear_t[thread_state->thread_id] == NULL) {
 		err(101, __func__, "state->linear_t[%ld] is NULL", thread_state->thread_id);
 	}
+	if (state->linear_s == NULL) {
+		err(101, __func__, "state->linear_s is NULL");
+	}
+	if (state->linear_s[thread_state->thread_id] == NULL) {
+		err(101, __func__, "state->linear_s[%ld] is NULL", thread_state->thread_id);
+	}
 
 	/*
 	 * Collect parameters from state
@@ -276,33 +306,66 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 	M = state->tp.linearComplexitySequenceLength;
 	n = state->tp.n;
 	N = n / M;
+	epsilon = state->epsilon[thread_state->thread_id];
+	b = state->linear_b[thread_state->thread_id];
+	c = state->linear_c[thread_state->thread_id];
+	t = state->linear_t[thread_state->thread_id];
+	s = state->linear_s[thread_state->thread_id];
 
 	/*
 	 * Zeroize the v counters
 	 */
 	memset(stat.v, 0, sizeof(stat.v));
 
+	/*
+	 * Step 3: calculate the theoretical mean
+	 * NOTE: the conditional operator is checking if (M + 1) is even or odd
+	 */
+	mean = (M / 2.0)
+	       + (((M + 1) % 2) ? 10 : 8) / 36.0
+	       - (M / 3.0 + 2.0 / 9.0) / (double ) (1 << M);
+
 	/*
 	 * Step 1: partition the sequence into N independent blocks
 	 *
 	 * Step 2: for each block, we will determine the linear complexity using the version of the Berlekamp-Massey
 	 * algorithm specialized for the binary finite field F2. Explanation of the sub-steps: https://goo.gl/Um0YUr
+	 *
+	 * The blocks are independent, so we run the algorithm on LANES_LINEARCOMPLEXITY of them at once.
+	 * The arrays are bit-sliced: bit l of each word belongs to block i + l, so one XOR or AND
+	 * performs the same operation on every block of the group. The data dependent branch on d
+	 * becomes a mask of the block lanes for which d is 1.
+	 *
+	 * Instead of shifting b by j - m positions when updating c, we keep b multiplied by x^(j-m):
+	 * each step multiplies it by x once more, or restarts it from x times the old c when m becomes j.
 	 */
-	for (i = 0; i < N; i++) {
+	for (i = 0; i < N; i += LANES_LINEARCOMPLEXITY) {
+		lanes = MIN(LANES_LINEARCOMPLEXITY, N - i);
 
 		/*
-		 * Sub-step 2: Zeroize the two arrays b and c and set b[0] and c[0] to 1
+		 * Transpose the blocks of this group into bit-sliced words
 		 */
-		memset(state->linear_b[thread_state->thread_id], 0, M * sizeof(state->linear_b[thread_state->thread_id][0]));
-		memset(state->linear_c[thread_state->thread_id], 0, M * sizeof(state->linear_c[thread_state->thread_id][0]));
-		state->linear_c[thread_state->thread_id][0] = 1;
-		state->linear_b[thread_state->thread_id][0] = 1;
+		memset(s, 0, M * sizeof(s[0]));
+		for (l = 0; l < lanes; l++) {
+			for (j = 0; j < M; j++) {
+				s[j] |= (WORD64) epsilon[(i + l) * M + j] << l;
+			}
+		}
 
 		/*
+		 * Sub-step 2: Zeroize the two arrays b and c and set c[0] to 1 and b to x (i.e., x^(j-m) with j = 0, m = -1)
+		 *
 		 * Sub-step 3: initialize L and m to their initial values
 		 */
-		L = 0;
-		m = -1;
+		memset(b, 0, (M + 1) * sizeof(b[0]));
+		memset(c, 0, (M + 1) * sizeof(c[0]));
+		memset(t, 0, (M + 1) * sizeof(t[0]));
+		c[0] = ~(WORD64) 0;
+		if (M > 1) {
+			b[1] = ~(WORD64) 0;
+		}
+		memset(L, 0, sizeof(L));
+		L_max = 0;
 
 		/*
 		 * NOTE: j is the N of the algorithm instructions
@@ -312,68 +375,78 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 
 			/*
 			 * Sub-step 4a: set the discrepancy
+			 *
+			 * NOTE: c[k] is 0 in every lane where k > L, so we can stop at the largest L.
 			 */
-			d = (int) state->epsilon[thread_state->thread_id][i * M + j];
-			for (k = 1; k <= L; k++) {
-				d += state->linear_c[thread_state->thread_id][k] *
-						state->epsilon[thread_state->thread_id][i * M + j - k];
+			d = s[j];
+			for (k = 1; k <= L_max; k++) {
+				d ^= c[k] & s[j - k];
 			}
 
-			d = d % 2;
-			if (d == 1) {
+			/*
+			 * The degree of both c and b is at most j + 1 at this point
+			 */
+			deg = MIN(j + 1, M - 1);
+			if (d == 0) {
 
 				/*
-				 * Sub-step 4b: let t be a copy of c
+				 * No block of the group has a discrepancy, c is unchanged and b is multiplied by x
 				 */
-				memcpy(state->linear_t[thread_state->thread_id], state->linear_c[thread_state->thread_id],
-				       M * sizeof(state->linear_t[thread_state->thread_id][0]));
+				for (k = deg + 1; k > 0; k--) {
+					t[k] = b[k - 1];
+				}
+			} else {
 
 				/*
-				 * Sub-step 4c: update c array
+				 * Find the lanes in which L, m and b will be updated by sub-step 4d
 				 */
-				for (k = j - m; k < M; k++) {
-					state->linear_c[thread_state->thread_id][k] =
-							(BitSequence) ((state->linear_c[thread_state->thread_id][k] +
-									state->linear_b[thread_state->thread_id][k - j + m]) % 2);
+				u = 0;
+				for (l = 0; l < lanes; l++) {
+					if (((d >> l) & 1) != 0 && L[l] <= j / 2) {
+						L[l] = j + 1 - L[l];
+						L_max = MAX(L_max, L[l]);
+						u |= (WORD64) 1 << l;
+					}
 				}
 
 				/*
-				 * Sub-step 4d: update L, M and b
+				 * Sub-step 4b: let t be a copy of c (in the u lanes, in the others it is a copy of b)
+				 *
+				 * Sub-step 4c: update c array (in the d lanes)
 				 */
-				if (L <= j / 2) {
-					L = j + 1 - L;
-					m = j;
-					memcpy(state->linear_b[thread_state->thread_id], state->linear_t[thread_state->thread_id],
-					       M * sizeof(state->linear_b[thread_state->thread_id][0]));
+				for (k = 0; k <= deg; k++) {
+					word = b[k];
+					t[k + 1] = (c[k] & u) | (word & ~u);
+					c[k] ^= word & d;
 				}
 			}
-		}
 
-		/*
-		 * Step 3: calculate the theoretical mean
-		 * NOTE: the conditional operator is checking if (M + 1) is even or odd
-		 */
-		mean = (M / 2.0)
-		       + (((M + 1) % 2) ? 10 : 8) / 36.0
-		       - (M / 3.0 + 2.0 / 9.0) / (double ) (1 << M);
+			/*
+			 * Sub-step 4d: the new b is t multiplied by x
+			 */
+			t[0] = 0;
+			swap = b;
+			b = t;
+			t = swap;
+		}
 
 		/*
-		 * Step 4: calculate a value of T
+		 * Step 4: calculate a value of T for each block of the group
 		 * NOTE: the conditional operator is checking if M is even or odd
-		 */
-		T = ((M % 2) ? (mean - L) : (L - mean)) + 2.0 / 9.0;
-
-		/*
+		 *
 		 * Step 5: record the T value in v
 		 * This code computes the classes dynamically, depending on K.
 		 */
 		class = (double) (K_LINEARCOMPLEXITY - 1) / 2.0;
-		if (T <= - class) {
-			stat.v[0]++;
-		} else if (T > class) {
-			stat.v[K_LINEARCOMPLEXITY]++;
-		} else {
-			stat.v[(int) ceil(T + class)]++;
+		for (l = 0; l < lanes; l++) {
+			T = ((M % 2) ? (mean - L[l]) : (L[l] - mean)) + 2.0 / 9.0;
+			if (T <= - class) {
+				stat.v[0]++;
+			} else if (T > class) {
+				stat.v[K_LINEARCOMPLEXITY]++;
+			} else {
+				stat.v[(int) ceil(T + class)]++;
+			}
 		}
 	}
 
@@ -388,7 +461,7 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 	/*
 	 * Step 7: compute the test P-value
 	 */
-	p_value = cephes_igamc(K_LINEARCOMPLEXITY / 2.0, stat.chi2 / 2.0);
+	p_value = pvalue_igamc(K_LINEARCOMPLEXITY / 2.0, stat.chi2 / 2.0);
 
 	/*
 	 * Lock mutex before making changes to the shared state
@@ -425,9 +498,6 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 	/*
 	 * Record values computed during this iteration
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
-	}
 	append_value(state->p_val[test_num], &p_value);
 
 	/*
@@ -437,6 +507,13 @@ LinearComplexity_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		LinearComplexity_print(thread_state, &stat, p_value);
+	}
+
 	return;
 }
 
@@ -458,6 +535,7 @@ static bool
 LinearComplexity_print_stat(FILE * stream, struct state *state, struct LinearComplexity_private_stats *stat, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[2][FMT_DOUBLE_BUFSIZ];	// Text of the doubles of a line
 	long int i;
 
 	/*
@@ -577,17 +655,18 @@ LinearComplexity_print_stat(FILE * stream, struct state *state, struct LinearCom
 		}
 	}
 	if (state->legacy_output == true) {
-		io_ret = fprintf(stream, "%9.6f%9.6f\n", stat->chi2, p_value);
+		io_ret = fprintf(stream, "%s%s\n", formatDouble(value[0], state, stat->chi2, 9),
+				 formatDouble(value[1], state, p_value, 9));
 		if (io_ret <= 0) {
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%9.6f\n", stat->chi2);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value[0], state, stat->chi2, 9));
 		if (io_ret <= 0) {
 			return false;
 		}
 		if (stat->success == true) {
-			io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value);
+			io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value[0], state, p_value, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -597,7 +676,7 @@ LinearComplexity_print_stat(FILE * stream, struct state *state, struct LinearCom
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value);
+			io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value[0], state, p_value, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -624,9 +703,10 @@ LinearComplexity_print_stat(FILE * stream, struct state *state, struct LinearCom
  *      false --> an I/O error occurred
  */
 static bool
-LinearComplexity_print_p_value(FILE * stream, double p_value)
+LinearComplexity_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -634,6 +714,9 @@ LinearComplexity_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(103, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(103, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -644,7 +727,7 @@ LinearComplexity_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -658,209 +741,65 @@ LinearComplexity_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * LinearComplexity_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * LinearComplexity_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value         // p_value iteration test result(s)
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-LinearComplexity_print(struct state *state)
+static void
+LinearComplexity_print(struct thread_state *thread_state, struct LinearComplexity_private_stats *stat, double p_value)
 {
-	struct LinearComplexity_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(104, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(104, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(104, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(104, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(104, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(104, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(104, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
-	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
-
-	/*
-	 * Open results.txt file
+	 * Begin the row of this iteration
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print stat to stats.txt
 	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct LinearComplexity_private_stats, i);
-
-		/*
-		 * Get p_value for this iteration
-		 */
-		p_value = get_value(state->p_val[test_num], double, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = LinearComplexity_print_stat(stats, state, stat, p_value);
-		if (ok == false) {
-			errp(104, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = LinearComplexity_print_p_value(results, p_value);
-		if (ok == false) {
-			errp(104, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = LinearComplexity_print_stat(buffer->stats, state, stat, p_value);
+	if (ok == false) {
+		errp(104, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_value to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(104, __func__, "error flushing to: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = LinearComplexity_print_p_value(buffer->results, state, p_value);
+	if (ok == false) {
+		errp(104, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(104, __func__, "error closing: %s", stats_txt);
-	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(104, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(104, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(104, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = LinearComplexity_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(104, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(104, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(104, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -928,7 +867,7 @@ LinearComplexity_metric_print(struct state *state, long int sampleCount, long in
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1035,9 +974,8 @@ LinearComplexity_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1056,73 +994,28 @@ LinearComplexity_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(106, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(106, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1143,12 +1036,6 @@ LinearComplexity_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1181,11 +1068,6 @@ LinearComplexity_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -1217,6 +1099,10 @@ LinearComplexity_destroy(struct state *state)
 			free(state->linear_t[i]);
 			state->linear_t[i] = NULL;
 		}
+		if (state->linear_s[i] != NULL) {
+			free(state->linear_s[i]);
+			state->linear_s[i] = NULL;
+		}
 	}
 
 	if (state->linear_b != NULL) {
@@ -1231,6 +1117,10 @@ LinearComplexity_destroy(struct state *state)
 		free(state->linear_t);
 		state->linear_t = NULL;
 	}
+	if (state->linear_s != NULL) {
+		free(state->linear_s);
+		state->linear_s = NULL;
+	}
 
 	return;
 }
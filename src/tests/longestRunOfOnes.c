@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/debug.h"
 
 
@@ -209,13 +212,23 @@ static const struct runs_table runs_table[] = {
 	 },
 };
 
+/*
+ * Longest run of ones in each byte value, used for blocks of M = 8 bits
+ *
+ * The table is filled by LongestRunOfOnes_init() before any thread is started.
+ */
+static BYTE longest_run_byte[1 << BITS_N_BYTE];
+
 
 /*
  * Forward static function declarations
  */
+static int longestRunInWord(WORD64 w, int cap);
+static int longestRunInBlock(const WORD64 *packed, long int start, long int M, int cap);
 static bool LongestRunOfOnes_print_stat(FILE * stream, struct state *state, struct LongestRunOfOnes_private_stats *stat,
 					double p_value);
-static bool LongestRunOfOnes_print_p_value(FILE * stream, double p_value);
+static bool LongestRunOfOnes_print_p_value(FILE * stream, struct state *state, double p_value);
+static void LongestRunOfOnes_print(struct thread_state *thread_state, struct LongestRunOfOnes_private_stats *stat, double p_value);
 static void LongestRunOfOnes_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
 
 
@@ -233,6 +246,7 @@ void
 LongestRunOfOnes_init(struct state *state)
 {
 	long int n;		// Length of a single bit stream
+	int i;
 
 	/*
 	 * Check preconditions (firewall)
@@ -265,6 +279,13 @@ LongestRunOfOnes_init(struct state *state)
 		return;
 	}
 
+	/*
+	 * Compute the longest run of ones of each byte value
+	 */
+	for (i = 0; i < (1 << BITS_N_BYTE); i++) {
+		longest_run_byte[i] = (BYTE) longestRunInWord((WORD64) i, BITS_N_BYTE);
+	}
+
 	/*
 	 * Create working sub-directory if forming files such as results.txt and stats.txt
 	 */
@@ -276,10 +297,6 @@ LongestRunOfOnes_init(struct state *state)
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct LongestRunOfOnes_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double),
 						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
 
@@ -316,9 +333,11 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 	int max_class;		// Maximum length to consider
 	long int v_obs;		// Current maximum run length for current block
 	double chi_term;	// Term for the statistic formula: chi^2 = chi_term * chi_term
-	long int run;		// Counter used to find longest run of ones
+	WORD64 *packed;		// Packed bit stream of this thread
+	WORD64 lo;		// Low word of a 128 bit block
+	WORD64 hi;		// High word of a 128 bit block
+	int cap;		// Run length at and above which all runs fall in the last class
 	long int i;
-	long int j;
 
 	/*
 	 * Check preconditions (firewall)
@@ -334,11 +353,11 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 		dbg(DBG_LOW, "iterate function[%d] %s called when test vector was false", test_num, __func__);
 		return;
 	}
-	if (state->epsilon == NULL) {
-		err(111, __func__, "state->epsilon is NULL");
+	if (state->packed_epsilon == NULL) {
+		err(111, __func__, "state->packed_epsilon is NULL");
 	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(111, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->packed_epsilon[thread_state->thread_id] == NULL) {
+		err(111, __func__, "state->packed_epsilon[%ld] is NULL", thread_state->thread_id);
 	}
 
 	/*
@@ -367,6 +386,8 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 	min_class = runs_table[stat.runs_table_index].min_class;
 	max_class = runs_table[stat.runs_table_index].max_class;
 	stat.N = n / stat.M;
+	packed = state->packed_epsilon[thread_state->thread_id];
+	cap = max_class + 1;
 
 	/*
 	 * Clear counters
@@ -375,23 +396,41 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 
 	/*
 	 * Step 1: partition the sequence into N independent M-bit blocks
+	 *
+	 * NOTE: Only whether the longest run is <= min_class, between min_class and max_class,
+	 *       or > max_class matters, so run lengths are computed up to cap = max_class + 1.
 	 */
 	for (i = 0; i < stat.N; i++) {
 
 		/*
 		 * Step 2a: determine maximum 1-bit run length for this block
 		 */
-		v_obs = 0;
-		run = 0;
-		for (j = 0; j < stat.M; j++) {
-			if (state->epsilon[thread_state->thread_id][(i * stat.M) + j] == 1) {
-				run++;
-				if (run > v_obs) {
-					v_obs = run;
-				}
-			} else {
-				run = 0;
+		switch (stat.M) {
+		case BITS_N_BYTE:
+
+			/*
+			 * The block is byte i of the packed bit stream
+			 */
+			v_obs = longest_run_byte[(packed[i / sizeof(WORD64)] >> ((i % sizeof(WORD64)) * BITS_N_BYTE)) & 0xff];
+			break;
+
+		case 2 * BITS_N_WORD64:
+
+			/*
+			 * The block is words 2*i and 2*i+1 of the packed bit stream: count how many times
+			 * the 128 bit block has to be ANDed with itself shifted by 1 bit until it becomes 0
+			 */
+			lo = packed[2 * i];
+			hi = packed[2 * i + 1];
+			for (v_obs = 0; (lo | hi) != 0 && v_obs < cap; v_obs++) {
+				lo &= (lo >> 1) | (hi << (BITS_N_WORD64 - 1));
+				hi &= hi >> 1;
 			}
+			break;
+
+		default:
+			v_obs = longestRunInBlock(packed, i * stat.M, stat.M, cap);
+			break;
 		}
 
 		/*
@@ -418,7 +457,7 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 	/*
 	 * Step 4: compute the test P-value
 	 */
-	p_value = cephes_igamc((double) CLASS_COUNT_LONGEST_RUN / 2.0, stat.chi2 / 2.0);
+	p_value = pvalue_igamc((double) CLASS_COUNT_LONGEST_RUN / 2.0, stat.chi2 / 2.0);
 
 	/*
 	 * Lock mutex before making changes to the shared state
@@ -455,9 +494,6 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 	/*
 	 * Record values computed during this iteration
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
-	}
 	append_value(state->p_val[test_num], &p_value);
 
 	/*
@@ -467,10 +503,123 @@ LongestRunOfOnes_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		LongestRunOfOnes_print(thread_state, &stat, p_value);
+	}
+
 	return;
 }
 
 
+/*
+ * longestRunInWord - determine the longest run of ones in a word
+ *
+ * given:
+ *      w               // word to examine
+ *      cap             // maximum run length of interest
+ *
+ * returns:
+ *      the length of the longest run of ones in w, or cap if that length is >= cap
+ *
+ * Each time w is ANDed with itself shifted by 1 bit, every run of ones becomes 1 bit shorter.
+ */
+static int
+longestRunInWord(WORD64 w, int cap)
+{
+	int len;		// Longest run length found so far
+
+	for (len = 0; w != 0 && len < cap; len++) {
+		w &= w >> 1;
+	}
+	return len;
+}
+
+
+/*
+ * longestRunInBlock - determine the longest run of ones in a block of a packed bit stream
+ *
+ * given:
+ *      packed          // bit stream packed by packEpsilon()
+ *      start           // index of the first bit of the block
+ *      M               // number of bits in the block
+ *      cap             // maximum run length of interest
+ *
+ * returns:
+ *      the length of the longest run of ones in the block, or cap if that length is >= cap
+ *
+ * The block is examined 64 bits at a time.  A run of ones at the low end of a chunk
+ * extends the run that ended at the high end of the previous chunk.
+ */
+static int
+longestRunInBlock(const WORD64 *packed, long int start, long int M, int cap)
+{
+	WORD64 w;		// Chunk of the block
+	WORD64 mask;		// Mask of the valid bits of the chunk
+	long int pos;		// Position in the bit stream of the first bit of the chunk
+	long int word;		// Index of the word that holds the first bit of the chunk
+	long int run;		// Length of the run of ones that ends at the high end of the chunk
+	long int v_obs;		// Longest run length found so far
+	int shift;		// Position within its word of the first bit of the chunk
+	int bits;		// Number of bits in the chunk
+	int k;
+
+	v_obs = 0;
+	run = 0;
+	for (pos = start; pos < start + M && v_obs < cap; pos += bits) {
+
+		/*
+		 * Extract the next chunk of up to 64 bits
+		 */
+		bits = (int) MIN(start + M - pos, (long int) BITS_N_WORD64);
+		word = pos / BITS_N_WORD64;
+		shift = (int) (pos % BITS_N_WORD64);
+		w = packed[word] >> shift;
+		if (shift > 0) {
+			w |= packed[word + 1] << (BITS_N_WORD64 - shift);
+		}
+		mask = (bits == (int) BITS_N_WORD64) ? ~(WORD64) 0 : ((WORD64) 1 << bits) - 1;
+		w &= mask;
+
+		/*
+		 * A chunk of all ones just extends the current run
+		 */
+		if (w == mask) {
+			run += bits;
+			v_obs = MAX(v_obs, run);
+			continue;
+		}
+
+		/*
+		 * The ones at the low end of the chunk end the current run
+		 */
+		k = 0;
+		while ((w >> k) & 1) {
+			k++;
+		}
+		v_obs = MAX(v_obs, run + k);
+
+		/*
+		 * Runs within the chunk
+		 */
+		v_obs = MAX(v_obs, longestRunInWord(w, cap));
+
+		/*
+		 * The ones at the high end of the chunk start a new run
+		 */
+		k = 0;
+		while ((w >> (bits - 1 - k)) & 1) {
+			k++;
+		}
+		run = k;
+	}
+
+	return (int) MIN(v_obs, (long int) cap);
+}
+
+
 /*
  * LongestRunOfOnes_print_stat - print private_stats information to the end of an open file
  *
@@ -490,6 +639,7 @@ LongestRunOfOnes_print_stat(FILE * stream, struct state *state, struct LongestRu
 	int min_class;		// minimum length to consider
 	int max_class;		// maximum length to consider
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 	int i;
 
 	/*
@@ -559,7 +709,7 @@ LongestRunOfOnes_print_stat(FILE * stream, struct state *state, struct LongestRu
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(c) Chi^2            = %f\n", stat->chi2);
+	io_ret = fprintf(stream, "\t\t(c) Chi^2            = %s\n", formatDouble(value, state, stat->chi2, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
@@ -725,7 +875,7 @@ LongestRunOfOnes_print_stat(FILE * stream, struct state *state, struct LongestRu
 	 * Report on success or failure
 	 */
 	if (stat->success == true) {
-		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -735,7 +885,7 @@ LongestRunOfOnes_print_stat(FILE * stream, struct state *state, struct LongestRu
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -761,9 +911,10 @@ LongestRunOfOnes_print_stat(FILE * stream, struct state *state, struct LongestRu
  *      false --> an I/O error occurred
  */
 static bool
-LongestRunOfOnes_print_p_value(FILE * stream, double p_value)
+LongestRunOfOnes_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -771,6 +922,9 @@ LongestRunOfOnes_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(113, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(113, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -781,7 +935,7 @@ LongestRunOfOnes_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -795,209 +949,65 @@ LongestRunOfOnes_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * LongestRunOfOnes_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * LongestRunOfOnes_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value         // p_value iteration test result(s)
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-LongestRunOfOnes_print(struct state *state)
+static void
+LongestRunOfOnes_print(struct thread_state *thread_state, struct LongestRunOfOnes_private_stats *stat, double p_value)
 {
-	struct LongestRunOfOnes_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(114, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(114, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(114, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(114, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(114, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(114, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(114, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
-	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
-
-	/*
-	 * Open results.txt file
+	 * Begin the row of this iteration
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print stat to stats.txt
 	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct LongestRunOfOnes_private_stats, i);
-
-		/*
-		 * Get p_value for this iteration
-		 */
-		p_value = get_value(state->p_val[test_num], double, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = LongestRunOfOnes_print_stat(stats, state, stat, p_value);
-		if (ok == false) {
-			errp(114, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = LongestRunOfOnes_print_p_value(results, p_value);
-		if (ok == false) {
-			errp(114, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = LongestRunOfOnes_print_stat(buffer->stats, state, stat, p_value);
+	if (ok == false) {
+		errp(114, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_value to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(114, __func__, "error flushing to: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = LongestRunOfOnes_print_p_value(buffer->results, state, p_value);
+	if (ok == false) {
+		errp(114, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(114, __func__, "error closing: %s", stats_txt);
-	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(114, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(114, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(114, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = LongestRunOfOnes_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(114, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(114, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(114, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -1065,7 +1075,7 @@ LongestRunOfOnes_metric_print(struct state *state, long int sampleCount, long in
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1172,9 +1182,8 @@ LongestRunOfOnes_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1193,73 +1202,28 @@ LongestRunOfOnes_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(116, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(116, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1280,12 +1244,6 @@ LongestRunOfOnes_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1316,11 +1274,6 @@ LongestRunOfOnes_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
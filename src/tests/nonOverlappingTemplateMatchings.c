@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/debug.h"
 
 
@@ -164,8 +167,10 @@ static const long int numOfTemplates[MAXTEMPLEN + 1] = {
 static void appendTemplate(struct state *state, ULONG value, long int m);
 static bool NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 						       struct NonOverlappingTemplateMatchings_private_stats *stat,
-						       struct dyn_array *nonover_stats, long int nonstat_index);
-static bool NonOverlappingTemplateMatchings_print_p_value(FILE * stream, double p_value);
+						       struct nonover_stats *nonover_stats);
+static bool NonOverlappingTemplateMatchings_print_p_value(FILE * stream, struct state *state, double p_value);
+static void NonOverlappingTemplateMatchings_print(struct thread_state *thread_state,
+						  struct NonOverlappingTemplateMatchings_private_stats *stat, struct nonover_stats *nonover_stats);
 static void NonOverlappingTemplateMatchings_metric_print(struct state *state, long int sampleCount, long int toolow,
 							 long int *freqPerBin);
 
@@ -271,10 +276,6 @@ NonOverlappingTemplateMatchings_init(struct state *state)
 	 *
 	 * NonOverlapping Template Test uses array of struct nonover_stats instead of p_value doubles
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct NonOverlappingTemplateMatchings_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(struct nonover_stats), DEFAULT_CHUNK,
 						  numOfTemplates[m] * state->tp.numOfBitStreams, false);	// results.txt
 
@@ -420,6 +421,7 @@ NonOverlappingTemplateMatchings_iterate(struct thread_state *thread_state)
 {
 	struct NonOverlappingTemplateMatchings_private_stats stat;	// Stats for this iteration
 	struct nonover_stats *nonover_stats;	// Stats for a template of this iteration
+	double *half_chi2;			// chi2 / 2 of each template, then its p-value
 	long int n;				// Length of a single bit stream
 	long int m;				// NonOverlapping Template Test - block length
 	unsigned int W_obs;			// Counter of the number of occurrences of a template in a block
@@ -496,6 +498,15 @@ NonOverlappingTemplateMatchings_iterate(struct thread_state *thread_state)
 	 * Initialize array of nonover_stats
 	 */
 	nonover_stats = malloc((size_t) numOfTemplates[m] * sizeof(*nonover_stats));
+	if (nonover_stats == NULL) {
+		errp(132, __func__, "cannot malloc for nonover_stats: %ld elements of %lu bytes each", numOfTemplates[m],
+		     sizeof(*nonover_stats));
+	}
+	half_chi2 = malloc((size_t) numOfTemplates[m] * sizeof(*half_chi2));
+	if (half_chi2 == NULL) {
+		errp(132, __func__, "cannot malloc for half_chi2: %ld elements of %lu bytes each", numOfTemplates[m],
+		     sizeof(*half_chi2));
+	}
 
 	/*
 	 * Process all template values
@@ -564,10 +575,7 @@ NonOverlappingTemplateMatchings_iterate(struct thread_state *thread_state)
 			nonover_stat.chi2 += (chi2_term * chi2_term);
 		}
 
-		/*
-		 * Step 5: compute the test p-value
-		 */
-		nonover_stat.p_value = cephes_igamc(BLOCKS_NON_OVERLAPPING / 2.0, nonover_stat.chi2 / 2.0);
+		half_chi2[jj] = nonover_stat.chi2 / 2.0;
 
 		/*
 		 * Store the index of the template just tested in the stats
@@ -576,6 +584,14 @@ NonOverlappingTemplateMatchings_iterate(struct thread_state *thread_state)
 		nonover_stats[jj] = nonover_stat;
 	}
 
+	/*
+	 * Step 5: compute the test p-values of all the templates at once
+	 */
+	pvalue_igamc_batch(BLOCKS_NON_OVERLAPPING / 2.0, half_chi2, half_chi2, numOfTemplates[m]);
+	for (jj = 0; jj < numOfTemplates[m]; jj++) {
+		nonover_stats[jj].p_value = half_chi2[jj];
+	}
+
 	/*
 	 * Lock mutex before making changes to the shared state
 	 */
@@ -625,27 +641,29 @@ NonOverlappingTemplateMatchings_iterate(struct thread_state *thread_state)
 		 * This is the only case when we append a struct to the p-value array.
 		 */
 		append_value(state->p_val[test_num], &nonover_stat);
+		nonover_stats[jj].success = nonover_stat.success;
 	}
 
 	/*
-	 * Record special values computed during this iteration
-	 *
-	 * Unlike other tests, we have one stat but multiple nonover_stat
-	 * (one for each template) per iteration.
-	 *
-	 * NOTE: The number of nonover_stat values in state->p_val is numOfTemplates[m].
+	 * Unlock mutex after making changes to the shared state
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
+	if (thread_state->mutex != NULL) {
+		pthread_mutex_unlock(thread_state->mutex);
 	}
 
 	/*
-	 * Unlock mutex after making changes to the shared state
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
 	 */
-	if (thread_state->mutex != NULL) {
-		pthread_mutex_unlock(thread_state->mutex);
+	if (state->resultstxtFlag == true) {
+		NonOverlappingTemplateMatchings_print(thread_state, &stat, nonover_stats);
 	}
 
+	/*
+	 * Free the per iteration arrays
+	 */
+	free(nonover_stats);
+	free(half_chi2);
+
 	return;
 }
 
@@ -657,24 +675,24 @@ NonOverlappingTemplateMatchings_iterate(struct thread_state *thread_state)
  *      stream          // open writable FILE stream
  *      state           // run state to test under
  *      stat            // struct NonOverlappingTemplateMatchings_private_stats for format and print
- *      nonover_stats   // dynamic array of nonover_stats values
- *      nonstat_index   // starting index in nonover_stats array for 1st template of the iteration
+ *      nonover_stats   // nonover_stats of each template of the iteration
  *
  * returns:
  *      true --> no errors
  *      false --> an I/O error occurred
  *
  * NOTE: This function prints the initial header for an iteration to the stats.txt file.
- *       Finally the nonover_stats dynamic array is used to print the results from each
+ *       Finally the nonover_stats array is used to print the results from each
  *       template to stats.txt for this iteration.
  */
 static bool
 NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 					   struct NonOverlappingTemplateMatchings_private_stats *stat,
-					   struct dyn_array *nonover_stats, long int nonstat_index)
+					   struct nonover_stats *nonover_stats)
 {
 	struct nonover_stats *nonover_stat;	// Current nonover_stats for a given iteration
 	int io_ret;				// I/O return status
+	char value[2][FMT_DOUBLE_BUFSIZ];	// Text of the doubles of a line
 	long int i;
 	long int j;
 
@@ -693,12 +711,6 @@ NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 	if (nonover_stats == NULL) {
 		err(133, __func__, "stat nonover_stats is NULL");
 	}
-	if (nonstat_index < 0) {
-		err(133, __func__, "stat nonstat_index: %ld < 0", nonstat_index);
-	}
-	if (nonstat_index >= nonover_stats->count) {
-		err(133, __func__, "stat nonstat_index: %ld >= dyn_array count: %ld", nonstat_index, nonover_stats->count);
-	}
 
 	/*
 	 * Print head of stat to a file
@@ -720,7 +732,8 @@ NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 		if (io_ret <= 0) {
 			return false;
 		}
-		io_ret = fprintf(stream, "\tMean = %f\tVariance = %f\tM = %ld\tm = %ld\tn = %ld\n", stat->mu, stat->sigma_squared,
+		io_ret = fprintf(stream, "\tMean = %s\tVariance = %s\tM = %ld\tm = %ld\tn = %ld\n",
+				 formatDouble(value[0], state, stat->mu, 0), formatDouble(value[1], state, stat->sigma_squared, 0),
 				 stat->M, state->tp.nonOverlappingTemplateLength, state->tp.n);
 		if (io_ret <= 0) {
 			return false;
@@ -750,11 +763,11 @@ NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 		if (io_ret <= 0) {
 			return false;
 		}
-		io_ret = fprintf(stream, "Mean = %f\n", stat->mu);
+		io_ret = fprintf(stream, "Mean = %s\n", formatDouble(value[0], state, stat->mu, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
-		io_ret = fprintf(stream, "Variance = %f\n", stat->sigma_squared);
+		io_ret = fprintf(stream, "Variance = %s\n", formatDouble(value[0], state, stat->sigma_squared, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -791,21 +804,12 @@ NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 	/*
 	 * Print values for each template of this iteration
 	 */
-	for (i = 0; i < numOfTemplates[state->tp.nonOverlappingTemplateLength]; ++i, ++nonstat_index) {
+	for (i = 0; i < numOfTemplates[state->tp.nonOverlappingTemplateLength]; ++i) {
 
 		/*
 		 * Find address of the current nonover_stats element
 		 */
-		if (nonstat_index >= nonover_stats->count) {
-			warn(__func__, "nonstat_index: %ld went beyond nonover_stats dyn_array count: %ld",
-			     nonstat_index, nonover_stats->count);
-			return false;
-		}
-		if (nonstat_index < 0) {
-			warn(__func__, "nonstat_index: %ld underflowed < 0", nonstat_index);
-			return false;
-		}
-		nonover_stat = addr_value(nonover_stats, struct nonover_stats, nonstat_index);
+		nonover_stat = &nonover_stats[i];
 
 		/*
 		 * Print template bits
@@ -840,19 +844,20 @@ NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
 					"nonover_stat->success == true for jj: %ld", nonover_stat->template_index);
 		}
 		if (nonover_stat->success == true) {
-			io_ret = fprintf(stream, "%9.6f %f SUCCESS %3ld\n", nonover_stat->chi2, nonover_stat->p_value,
-					 nonover_stat->template_index);
+			io_ret = fprintf(stream, "%s %s SUCCESS %3ld\n", formatDouble(value[0], state, nonover_stat->chi2, 9),
+					 formatDouble(value[1], state, nonover_stat->p_value, 0), nonover_stat->template_index);
 			if (io_ret <= 0) {
 				return false;
 			}
 		} else if (nonover_stat->p_value == NON_P_VALUE) {
-			io_ret = fprintf(stream, "%9.6f	 __INVALID__ %3ld\n", nonover_stat->chi2, nonover_stat->template_index);
+			io_ret = fprintf(stream, "%s	 __INVALID__ %3ld\n", formatDouble(value[0], state, nonover_stat->chi2, 9),
+					 nonover_stat->template_index);
 			if (io_ret <= 0) {
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "%9.6f %f FAILURE %3ld\n", nonover_stat->chi2, nonover_stat->p_value,
-					 nonover_stat->template_index);
+			io_ret = fprintf(stream, "%s %s FAILURE %3ld\n", formatDouble(value[0], state, nonover_stat->chi2, 9),
+					 formatDouble(value[1], state, nonover_stat->p_value, 0), nonover_stat->template_index);
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -886,9 +891,10 @@ NonOverlappingTemplateMatchings_print_stat(FILE * stream, struct state *state,
  *      false --> an I/O error occurred
  */
 static bool
-NonOverlappingTemplateMatchings_print_p_value(FILE * stream, double p_value)
+NonOverlappingTemplateMatchings_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -896,6 +902,9 @@ NonOverlappingTemplateMatchings_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(134, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(134, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -906,7 +915,7 @@ NonOverlappingTemplateMatchings_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -920,225 +929,72 @@ NonOverlappingTemplateMatchings_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * NonOverlappingTemplateMatchings_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * NonOverlappingTemplateMatchings_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      nonover_stats   // nonover_stats of each template of the iteration
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-NonOverlappingTemplateMatchings_print(struct state *state)
+static void
+NonOverlappingTemplateMatchings_print(struct thread_state *thread_state, struct NonOverlappingTemplateMatchings_private_stats *stat,
+					    struct nonover_stats *nonover_stats)
 {
-	struct NonOverlappingTemplateMatchings_private_stats *stat;	// Pointer to statistics of an iteration
-	struct nonover_stats *nonover_stat;	// current nonover_stats for a given iteration
-	FILE *stats = NULL;			// Open stats.txt file
-	FILE *results = NULL;			// Open results.txt file
-	FILE *data = NULL;			// Open data*.txt file
-	char *stats_txt = NULL;			// Pathname for stats.txt
-	char *results_txt = NULL;		// Pathname for results.txt
-	char *data_txt = NULL;			// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];		// Basename for a given data*.txt pathname
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
 	bool ok;				// true -> I/O was OK
-	long int nonstat_index;			// Starting index into state->nonstat from which to print
-	int snprintf_ret;			// snprintf return value
-	int io_ret;				// I/O return status
-	long int i;
 	long int j;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(135, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
+	if (thread_state == NULL) {
+		err(135, __func__, "thread_state arg is NULL");
 	}
-	if (state->partitionCount[test_num] < 1) {
-		err(135, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(135, __func__, "state is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(135, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	if (stat == NULL) {
+		err(135, __func__, "stat arg is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(135, __func__, "format for data0*.txt filename is NULL");
+	if (nonover_stats == NULL) {
+		err(135, __func__, "nonover_stats arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
+	 * Begin the row of this iteration
 	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Open results.txt file
+	 * Print stat and the stats of each template to stats.txt
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	errno = 0;	// paranoia
+	ok = NonOverlappingTemplateMatchings_print_stat(buffer->stats, state, stat, nonover_stats);
+	if (ok == false) {
+		errp(135, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
+	}
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print the p_value of each template to results.txt
 	 */
-	nonstat_index = 0;
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct NonOverlappingTemplateMatchings_private_stats, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
+	for (j = 0; j < numOfTemplates[state->tp.nonOverlappingTemplateLength]; ++j) {
 		errno = 0;	// paranoia
-		ok = NonOverlappingTemplateMatchings_print_stat(stats, state, stat, state->p_val[test_num], nonstat_index);
+		ok = NonOverlappingTemplateMatchings_print_p_value(buffer->results, state, nonover_stats[j].p_value);
 		if (ok == false) {
-			errp(135, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		for (j = 0; j < numOfTemplates[state->tp.nonOverlappingTemplateLength]; ++j, ++nonstat_index) {
-
-			/*
-			 * Find address of the current nonover_stats element
-			 */
-			if (nonstat_index >= state->p_val[test_num]->count) {
-				err(135, __func__, "nonstat_index: %ld went beyond p_val count: %ld",
-				    nonstat_index, state->p_val[test_num]->count);
-			}
-			if (nonstat_index < 0) {
-				err(135, __func__, "nonstat_index: %ld underflowed < 0", nonstat_index);
-			}
-			nonover_stat = addr_value(state->p_val[test_num], struct nonover_stats, nonstat_index);
-
-			/*
-			 * Print p_value
-			 */
-			errno = 0;	// paranoia
-			ok = NonOverlappingTemplateMatchings_print_p_value(results, nonover_stat->p_value);
-			if (ok == false) {
-				errp(135, __func__, "error in writing to %s", results_txt);
-			}
+			errp(135, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 		}
 	}
 
-	/*
-	 * Flush and close stats.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(135, __func__, "error flushing to: %s", stats_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(135, __func__, "error closing: %s", stats_txt);
-	}
-	free(stats_txt);
-	stats_txt = NULL;
 
 	/*
-	 * Flush and close results.txt, free pathname
+	 * End the row of this iteration
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(135, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(135, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
-
-	/*
-	 * Write data*.txt for each data file if we need to partition results
-	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(135, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (nonstat_index = j; nonstat_index < state->p_val[test_num]->count;
-				     nonstat_index += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					nonover_stat = addr_value(state->p_val[test_num], struct nonover_stats, nonstat_index);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = NonOverlappingTemplateMatchings_print_p_value(data, nonover_stat->p_value);
-					if (ok == false) {
-						errp(135, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(135, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(135, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -1206,7 +1062,7 @@ NonOverlappingTemplateMatchings_metric_print(struct state *state, long int sampl
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1311,12 +1167,10 @@ NonOverlappingTemplateMatchings_metric_print(struct state *state, long int sampl
 void
 NonOverlappingTemplateMatchings_metrics(struct state *state)
 {
-	struct nonover_stats *nonover_stat;	// current nonover_stats for a given iteration
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1335,75 +1189,29 @@ NonOverlappingTemplateMatchings_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(137, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(137, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(137, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		err(137, __func__,
+		    "metrics driver interface for %s[%d] called with tallied p_values: %ld != %ld*%d=%ld",
+		    state->testNames[test_num], test_num, tally->count,
+		    state->tp.numOfBitStreams, state->partitionCount[test_num],
+		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			nonover_stat = addr_value(state->p_val[test_num], struct nonover_stats, i);
-			p_value = nonover_stat->p_value;
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1424,12 +1232,6 @@ NonOverlappingTemplateMatchings_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1462,11 +1264,6 @@ NonOverlappingTemplateMatchings_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/debug.h"
 
 
@@ -64,7 +67,9 @@ static bool RandomExcursions_print_stat(FILE * stream, struct state *state, stru
 					long int iteration);
 static bool RandomExcursions_print_stat2(FILE * stream, struct state *state, struct RandomExcursions_private_stats *stat,
 					 long int p, double p_value);
-static bool RandomExcursions_print_p_value(FILE * stream, double p_value);
+static bool RandomExcursions_print_p_value(FILE * stream, struct state *state, double p_value);
+static void RandomExcursions_print(struct thread_state *thread_state,
+				   struct RandomExcursions_private_stats *stat, double *p_values);
 static void RandomExcursions_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
 
 
@@ -116,28 +121,6 @@ RandomExcursions_init(struct state *state)
 		return;
 	}
 
-	/*
-	 * Allocate the partial sums and the cycle arrays for each thread
-	 */
-	state->rnd_excursion_S = malloc((size_t) state->numberOfThreads * sizeof(*state->rnd_excursion_S));
-	if (state->rnd_excursion_S == NULL) {
-		errp(150, __func__, "cannot malloc for rnd_excursion_S: %ld elements of %lu bytes each", state->numberOfThreads,
-		     sizeof(*state->rnd_excursion_S));
-	}
-	state->rnd_excursion_cycle = malloc((size_t) state->numberOfThreads * sizeof(*state->rnd_excursion_cycle));
-	if (state->rnd_excursion_cycle == NULL) {
-		errp(150, __func__, "cannot malloc for rnd_excursion_cycle: %ld elements of %lu bytes each", state->numberOfThreads,
-		     sizeof(*state->rnd_excursion_cycle));
-	}
-	for (i = 0; i < state->numberOfThreads; i++) {
-		state->rnd_excursion_S[i] = malloc(n * sizeof(state->rnd_excursion_S[i][0]));
-		if (state->rnd_excursion_S[i] == NULL) {
-			errp(150, __func__, "cannot malloc of %ld elements of %ld bytes each for state->rnd_excursion_S[%ld]",
-			     n, sizeof(state->rnd_excursion_S[i][0]), i);
-		}
-		state->rnd_excursion_cycle[i] = create_dyn_array(sizeof(long int), DEFAULT_CHUNK, (long int) state->c.sqrtn, true);
-	}
-
 	/*
 	 * Create working sub-directory if forming files such as results.txt and stats.txt
 	 */
@@ -209,10 +192,6 @@ RandomExcursions_init(struct state *state)
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct RandomExcursions_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double), DEFAULT_CHUNK,
 						  NUMBER_OF_STATES_RND_EXCURSION * state->tp.numOfBitStreams, false); // results.txt
 
@@ -242,19 +221,11 @@ void
 RandomExcursions_iterate(struct thread_state *thread_state)
 {
 	struct RandomExcursions_private_stats stat;	// Stats for this iteration
-	long int n;					// Length of a single bit stream
-	long int v[DEGREES_OF_FREEDOM_RND_EXCURSION][NUMBER_OF_STATES_RND_EXCURSION];	// Global frequency counters
-	struct dyn_array *cycle;	// Counter used for single iterations
-	long int *S;			// Array of the partial sums of the -1/+1 states
-	long int count_index;		// Index of the count array to be incremented
-	long int offset;		// Sum offset used to get the index of a state value in the counter array
+	struct random_walk *walk;	// Random walk of the bit stream
 	long int x;			// State value to test
 	long int labs_x;		// Absolute value of the state value x
-	long int cycleStart;		// Index where a cycle starts
-	long int cycleStop;		// Index where a cycle ends
-	long int occurrences;		// Number of occurrences of a given state value in a cycle
 	double p_value;			// p_value iteration test result(s)
-	double *p_values;		// Array of p-values produced by this test
+	double p_values[NUMBER_OF_STATES_RND_EXCURSION];	// Array of p-values produced by this test
 	double sum_term;		// Value whose square is used to compute the test statistic
 	long int i;
 	long int j;
@@ -273,27 +244,12 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 		dbg(DBG_LOW, "iterate function[%d] %s called when test vector was false", test_num, __func__);
 		return;
 	}
-	if (state->epsilon == NULL) {
-		err(151, __func__, "state->epsilon is NULL");
-	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(151, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->random_walk == NULL) {
+		err(151, __func__, "state->random_walk is NULL");
 	}
 	if (state->rnd_excursion_stateX == NULL) {
 		err(151, __func__, "state->rnd_excursion_stateX is NULL");
 	}
-	if (state->rnd_excursion_S == NULL) {
-		err(151, __func__, "state->rnd_excursion_S is NULL");
-	}
-	if (state->rnd_excursion_S[thread_state->thread_id] == NULL) {
-		err(151, __func__, "state->rnd_excursion_S[%ld] is NULL", thread_state->thread_id);
-	}
-	if (state->rnd_excursion_cycle == NULL) {
-		err(151, __func__, "state->rnd_excursion_cycle is NULL");
-	}
-	if (state->rnd_excursion_cycle[thread_state->thread_id] == NULL) {
-		err(151, __func__, "state->rnd_excursion_cycle[%ld] is NULL", thread_state->thread_id);
-	}
 	if (state->cSetup != true) {
 		err(151, __func__, "test constants not setup prior to calling %s for %s[%d]",
 		    __func__, state->testNames[test_num], test_num);
@@ -302,55 +258,17 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 	/*
 	 * Collect parameters from state
 	 */
-	n = state->tp.n;
-	S = state->rnd_excursion_S[thread_state->thread_id];
-	cycle = state->rnd_excursion_cycle[thread_state->thread_id];
+	walk = &state->random_walk[thread_state->thread_id];
 
 	/*
-	 * Clear the cycle array for this iteration
+	 * Steps 3 to 6: get the partial sums of successively larger sub-sequences, the number
+	 * of cycles and, for each non-zero state value x, the frequency of x within each cycle
+	 *
+	 * These have already been computed by computeRandomWalk():
+	 * walk->v[k][i] contains the exact number of cycles in which state i occurs exactly k times.
 	 */
-	clear_dyn_array(cycle);
-
-	/*
-	 * Step 3: compute the partial sums of successively larger sub-sequences
-	 */
-	if ((int) state->epsilon[thread_state->thread_id][0] == 1) {
-		S[0] = 1;
-	} else if ((int) state->epsilon[thread_state->thread_id][0] == 0) {
-		S[0] = - 1;
-	} else {
-		err(41, __func__, "found a bit different than 1 or 0 in the sequence");
-	}
-	for (i = 1; i < n; i++) {
-		if ((int) state->epsilon[thread_state->thread_id][i] == 1) {
-			S[i] = S[i - 1] + 1;
-		} else if ((int) state->epsilon[thread_state->thread_id][i] == 0) {
-			S[i] = S[i - 1] - 1;
-		} else {
-			err(41, __func__, "found a bit different than 1 or 0 in the sequence");
-		}
-
-		/*
-		 * Step 4a: whenever a 0 in the partial sums is found, which means that a cycle has
-		 * ended, append the ending position of that cycle to the cycle array
-		 */
-		if (S[i] == 0) {
-			append_value(cycle, &i);
-		}
-	}
-
-	/*
-	 * Step 4b: count the last cycle if it was not counted already
-	 */
-	if (S[n - 1] != 0) {
-		append_value(cycle, &n);
-	}
-
-	/*
-	 * Step 4c: get the total number of cycles.
-	 * The number of cycles will be equal to the number of elements in the cycles array.
-	 */
-	stat.number_of_cycles = cycle->count;
+	stat.number_of_cycles = walk->number_of_cycles;
+	memcpy(stat.counter, walk->last_cycle, sizeof(stat.counter));
 
 	/*
 	 * Step 4d: determine if there are enough cycles
@@ -362,109 +280,6 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 	 */
 	if (stat.test_possible == true) {
 
-		/*
-		 * Zeroize variables and global counters
-		 */
-		memset(v, 0, sizeof(v));
-		cycleStop = 0;
-
-		/*
-		 * Step 5: for each cycle and for each non-zero state value x,
-		 * compute the frequency of each x within each cycle.
-		 */
-		for (j = 0; j < stat.number_of_cycles; j++) {
-
-			/*
-			 * Get beginning and ending indexes of the cycle j
-			 */
-			cycleStart = cycleStop;
-			cycleStop = get_value(cycle, long int, j);
-
-			/*
-			 * Zeroize the counters for this test
-			 */
-			memset(stat.counter, 0, sizeof(stat.counter));
-
-			/*
-			 * Check preconditions (firewall)
-			 */
-			if (cycleStart < 0) {
-				err(151, __func__, "cycleStart: %ld < 0", cycleStart);
-			}
-			if (cycleStart > n) {
-				err(151, __func__, "cycleStart: %ld > n: %ld", cycleStart, n);
-			}
-			if (cycleStop < 0) {
-				err(151, __func__, "cycleStop: %ld < 0", cycleStop);
-			}
-			if (cycleStop > n) {
-				err(151, __func__, "cycleStop: %ld > n: %ld", cycleStop, n);
-			}
-
-			/*
-			 * Consider each partial sum value of the cycle
-			 */
-			for (i = cycleStart; i < cycleStop; i++) {
-
-				/*
-				 * Check if the value of the partial sum is one of the state values of interest
-				 */
-				if ((labs(S[i]) >= 1) && (labs(S[i]) <= MAX_EXCURSION_RND_EXCURSION)) {
-
-					/*
-					 * Get the index of this state value in the counter array.
-					 * This is done because the array cannot have negative indexes.
-					 * Thus, the most negative x will correspond to the item in index 0.
-					 *
-					 * For example, if MAX_EXCURSION_RND_EXCURSION is 4, the counter for
-					 * x = -4 is the counter[0] and the counter for x = 4 is counter[7]
-					 */
-					offset = (S[i] < 0) ? MAX_EXCURSION_RND_EXCURSION : MAX_EXCURSION_RND_EXCURSION - 1;
-					count_index = S[i] + offset;
-
-					/*
-					 * Check preconditions (firewall)
-					 */
-					if (count_index < 0) {
-						err(151, __func__, "count_index: %ld < 0", count_index);
-					}
-
-					/*
-					 * Increase the counter of the considered state value
-					 */
-					stat.counter[count_index]++;
-				}
-			}
-
-			/*
-			 * Step 6: for each of the states, increase the the counters of v consequently:
-			 * v[k][i] contains the exact number of cycles in which state i occurs exactly k times
-			 */
-			for (i = 0; i < NUMBER_OF_STATES_RND_EXCURSION; i++) {
-
-				/*
-				 * Get the number of occurrences of the state value in cycle i
-				 */
-				occurrences = stat.counter[i];
-
-				/*
-				 * If the number of occurrences is between 0 and MAX_K, count it in its counter
-				 */
-				if ((occurrences >= 0) && (occurrences < (DEGREES_OF_FREEDOM_RND_EXCURSION - 1))) {
-					v[stat.counter[i]][i]++;
-				}
-
-				/*
-				 * If the number of occurrences is bigger than MAX_K, count it in the MAX_K counter
-				 */
-				else if (occurrences >= DEGREES_OF_FREEDOM_RND_EXCURSION - 1) {
-					v[DEGREES_OF_FREEDOM_RND_EXCURSION - 1][i]++;
-				}
-			}
-		}
-
-		p_values = malloc(NUMBER_OF_STATES_RND_EXCURSION * sizeof(*p_values));
-
 		/*
 		 * Compute the test statistic and the p-value for each of the states.
 		 */
@@ -491,23 +306,24 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 			 */
 			stat.chi2[i] = 0.0;
 			for (j = 0; j < DEGREES_OF_FREEDOM_RND_EXCURSION; j++) {
-				sum_term = (double) v[j][i] - ((double) stat.number_of_cycles
+				sum_term = (double) walk->v[j][i] - ((double) stat.number_of_cycles
 							       * state->rnd_excursion_pi_terms[labs_x - 1][j]);
 				stat.chi2[i] += sum_term * sum_term / ((double) stat.number_of_cycles
 								       * state->rnd_excursion_pi_terms[labs_x - 1][j]);
 			}
 
 			/*
-			 * Step 8: compute the p-value for this state
+			 * Step 8 (first half): save the igamc() argument of this state
 			 */
-			p_value = cephes_igamc((double) (DEGREES_OF_FREEDOM_RND_EXCURSION - 1) / 2.0, stat.chi2[i] / 2.0);
-
-			/*
-			 * Save p-value in the arrays of p-values
-			 */
-			p_values[i] = p_value;
+			p_values[i] = stat.chi2[i] / 2.0;
 		}
 
+		/*
+		 * Step 8 (second half): compute the p-values of all the states at once
+		 */
+		pvalue_igamc_batch((double) (DEGREES_OF_FREEDOM_RND_EXCURSION - 1) / 2.0, p_values, p_values,
+				   NUMBER_OF_STATES_RND_EXCURSION);
+
 		/*
 		 * Lock mutex before making changes to the shared state
 		 */
@@ -555,13 +371,6 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 			 */
 			append_value(state->p_val[test_num], &p_value);
 		}
-
-		/*
-		 * Record stats of this iteration
-		 */
-		if (state->resultstxtFlag == true) {
-			append_value(state->stats[test_num], &stat);
-		}
 	}
 
 	/*
@@ -587,15 +396,13 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 			stat.success[i] = false;	// FAILURE
 		}
 		memset(stat.counter, 0, sizeof(stat.counter));
-		if (state->resultstxtFlag == true) {
-			append_value(state->stats[test_num], &stat);
-		}
 
 		/*
 		 * Record non p-value of this invalid iteration
 		 */
 		p_value = NON_P_VALUE;
 		for (i = 0; i < NUMBER_OF_STATES_RND_EXCURSION; i++) {
+			p_values[i] = p_value;
 			append_value(state->p_val[test_num], &p_value);
 		}
 	}
@@ -607,6 +414,13 @@ RandomExcursions_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		RandomExcursions_print(thread_state, &stat, p_values);
+	}
+
 	return;
 }
 
@@ -632,6 +446,7 @@ static bool
 RandomExcursions_print_stat(FILE * stream, struct state *state, struct RandomExcursions_private_stats *stat, long int iteration)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 	long int n;		// Length of a single bit stream
 
 	/*
@@ -743,7 +558,8 @@ RandomExcursions_print_stat(FILE * stream, struct state *state, struct RandomExc
 	 */
 	else {
 		if (state->legacy_output == true) {
-			io_ret = fprintf(stream, "\t\t(c) Rejection Constraint = %f\n", (double) state->c.min_zero_crossings);
+			io_ret = fprintf(stream, "\t\t(c) Rejection Constraint = %s\n",
+					 formatDouble(value, state, (double) state->c.min_zero_crossings, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -793,6 +609,7 @@ RandomExcursions_print_stat2(FILE * stream, struct state *state, struct RandomEx
 			     double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[2][FMT_DOUBLE_BUFSIZ];	// Text of the doubles of a line
 
 	/*
 	 * Check preconditions (firewall)
@@ -842,14 +659,15 @@ RandomExcursions_print_stat2(FILE * stream, struct state *state, struct RandomEx
 	}
 	if (state->legacy_output == true) {
 		if (p_value == NON_P_VALUE) {
-			io_ret = fprintf(stream, "x = %2ld chi^2 = %9.6f p_value = __INVALID__\n", state->rnd_excursion_stateX[p],
-					 stat->chi2[p]);
+			io_ret = fprintf(stream, "x = %2ld chi^2 = %s p_value = __INVALID__\n", state->rnd_excursion_stateX[p],
+					 formatDouble(value[0], state, stat->chi2[p], 9));
 			if (io_ret <= 0) {
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "x = %2ld chi^2 = %9.6f p_value = %f\n", state->rnd_excursion_stateX[p],
-					 stat->chi2[p], p_value);
+			io_ret = fprintf(stream, "x = %2ld chi^2 = %s p_value = %s\n", state->rnd_excursion_stateX[p],
+					 formatDouble(value[0], state, stat->chi2[p], 9),
+					 formatDouble(value[1], state, p_value, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -862,8 +680,8 @@ RandomExcursions_print_stat2(FILE * stream, struct state *state, struct RandomEx
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "x = %2ld  visits = %4ld  p_value = %f\n",
-					 state->rnd_excursion_stateX[p], stat->counter[p], p_value);
+			io_ret = fprintf(stream, "x = %2ld  visits = %4ld  p_value = %s\n", state->rnd_excursion_stateX[p],
+					 stat->counter[p], formatDouble(value[0], state, p_value, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -893,9 +711,10 @@ RandomExcursions_print_stat2(FILE * stream, struct state *state, struct RandomEx
  *      false --> an I/O error occurred
  */
 static bool
-RandomExcursions_print_p_value(FILE * stream, double p_value)
+RandomExcursions_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -903,6 +722,9 @@ RandomExcursions_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(154, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(154, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -913,7 +735,7 @@ RandomExcursions_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -927,225 +749,84 @@ RandomExcursions_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * RandomExcursions_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * RandomExcursions_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_values        // NUMBER_OF_STATES_RND_EXCURSION p_values of the iteration
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-RandomExcursions_print(struct state *state)
+static void
+RandomExcursions_print(struct thread_state *thread_state, struct RandomExcursions_private_stats *stat, double *p_values)
 {
-	struct RandomExcursions_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 	long int p;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(155, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
+	if (thread_state == NULL) {
+		err(155, __func__, "thread_state arg is NULL");
 	}
-	if (state->partitionCount[test_num] < 1) {
-		err(155, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(155, __func__, "state is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(155, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	if (stat == NULL) {
+		err(155, __func__, "stat arg is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(155, __func__, "format for data0*.txt filename is NULL");
+	if (p_values == NULL) {
+		err(155, __func__, "p_values arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
+	 * Begin the row of this iteration
 	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Open results.txt file
+	 * Print stat to stats.txt
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	errno = 0;	// paranoia
+	ok = RandomExcursions_print_stat(buffer->stats, state, stat, thread_state->iteration_being_done);
+	if (ok == false) {
+		errp(155, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
+	}
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print all of the excursion states for this iteration
 	 */
-	for (i = 0, j = 0; i < state->stats[test_num]->count; ++i, j += NUMBER_OF_STATES_RND_EXCURSION) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct RandomExcursions_private_stats, i);
+	for (p = 0; p < NUMBER_OF_STATES_RND_EXCURSION; p++) {
 
 		/*
-		 * Print stat to stats.txt
+		 * Print, if possible, the excursion success or failure, visit and p_value
 		 */
 		errno = 0;	// paranoia
-		ok = RandomExcursions_print_stat(stats, state, stat, i);
+		ok = RandomExcursions_print_stat2(buffer->stats, state, stat, p, p_values[p]);
 		if (ok == false) {
-			errp(155, __func__, "error in writing to %s", stats_txt);
+			errp(155, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 		}
 
 		/*
-		 * Print all of the excursion states for this iteration
+		 * Print p_value to results.txt
 		 */
-		for (p = 0; p < NUMBER_OF_STATES_RND_EXCURSION; p++) {
-
-			/*
-			 * Get p_value for this excursion state of this iteration
-			 */
-			p_value = get_value(state->p_val[test_num], double, j + p);
-
-			/*
-			 * Print, if possible, the excursion success or failure, visit and p_value
-			 */
-			errno = 0;	// paranoia
-			ok = RandomExcursions_print_stat2(stats, state, stat, p, p_value);
-			if (ok == false) {
-				errp(155, __func__, "error in writing to %s", stats_txt);
-			}
-
-			/*
-			 * Print p_value to results.txt
-			 */
-			errno = 0;	// paranoia
-			ok = RandomExcursions_print_p_value(results, p_value);
-			if (ok == false) {
-				errp(155, __func__, "error in writing to %s", results_txt);
-			}
+		errno = 0;	// paranoia
+		ok = RandomExcursions_print_p_value(buffer->results, state, p_values[p]);
+		if (ok == false) {
+			errp(155, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 		}
 	}
 
-	/*
-	 * Flush and close stats.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(155, __func__, "error flushing to: %s", stats_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(155, __func__, "error closing: %s", stats_txt);
-	}
-	free(stats_txt);
-	stats_txt = NULL;
-
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(155, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(155, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(155, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = RandomExcursions_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(155, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(155, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(155, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -1213,7 +894,7 @@ RandomExcursions_metric_print(struct state *state, long int sampleCount, long in
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1320,9 +1001,8 @@ RandomExcursions_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1341,73 +1021,28 @@ RandomExcursions_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(157, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(157, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1428,12 +1063,6 @@ RandomExcursions_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1466,11 +1095,6 @@ RandomExcursions_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -1492,24 +1116,6 @@ RandomExcursions_destroy(struct state *state)
 		free(state->rnd_excursion_stateX);
 		state->rnd_excursion_stateX = NULL;
 	}
-	for (i = 0; i < state->numberOfThreads; i++) {
-		if (state->rnd_excursion_S[i] != NULL) {
-			free(state->rnd_excursion_S[i]);
-			state->rnd_excursion_S[i] = NULL;
-		}
-		if (state->rnd_excursion_cycle[i] != NULL) {
-			free_dyn_array(state->rnd_excursion_cycle[i]);
-			state->rnd_excursion_cycle[i] = NULL;
-		}
-	}
-	if (state->rnd_excursion_S != NULL) {
-		free(state->rnd_excursion_S);
-		state->rnd_excursion_S = NULL;
-	}
-	if (state->rnd_excursion_cycle != NULL) {
-		free(state->rnd_excursion_cycle);
-		state->rnd_excursion_cycle = NULL;
-	}
 	// Free the theoretical probabilities matrix
 	if (state->rnd_excursion_pi_terms != NULL) {
 
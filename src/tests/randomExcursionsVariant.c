@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/debug.h"
 
 
@@ -63,7 +66,9 @@ static bool RandomExcursionsVariant_print_stat(FILE * stream, struct state *stat
 					       struct RandomExcursionsVariant_private_stats *stat, long int iteration);
 static bool RandomExcursionsVariant_print_stat2(FILE * stream, struct state *state,
 						struct RandomExcursionsVariant_private_stats *stat, long int p, double p_value);
-static bool RandomExcursionsVariant_print_p_value(FILE * stream, double p_value);
+static bool RandomExcursionsVariant_print_p_value(FILE * stream, struct state *state, double p_value);
+static void RandomExcursionsVariant_print(struct thread_state *thread_state,
+					  struct RandomExcursionsVariant_private_stats *stat, double *p_values);
 static void RandomExcursionsVariant_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
 
 
@@ -139,29 +144,9 @@ RandomExcursionsVariant_init(struct state *state)
 		state->rnd_excursion_var_stateX[NUMBER_OF_STATES_RND_EXCURSION_VAR - MAX_EXCURSION_RND_EXCURSION_VAR + i - 1] = i;
 	}
 
-	/*
-	 * Allocate partial sums working array for each thread
-	 */
-	state->ex_var_partial_sums = malloc((size_t) state->numberOfThreads * sizeof(*state->ex_var_partial_sums));
-	if (state->ex_var_partial_sums == NULL) {
-		errp(190, __func__, "cannot malloc for ex_var_partial_sums: %ld elements of %lu bytes each", state->numberOfThreads,
-		     sizeof(*state->ex_var_partial_sums));
-	}
-	for (i = 0; i < state->numberOfThreads; i++) {
-		state->ex_var_partial_sums[i] = malloc(n * sizeof(state->ex_var_partial_sums[i][0]));
-		if (state->ex_var_partial_sums[i] == NULL) {
-			errp(190, __func__, "cannot malloc of %ld elements of %ld bytes each for state->ex_var_partial_sums[%ld]",
-			     state->tp.n, sizeof(state->ex_var_partial_sums[i][0]), i);
-		}
-	}
-
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct RandomExcursionsVariant_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double), DEFAULT_CHUNK, NUMBER_OF_STATES_RND_EXCURSION_VAR *
 			state->tp.numOfBitStreams, false);						// results.txt
 
@@ -191,12 +176,10 @@ void
 RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 {
 	struct RandomExcursionsVariant_private_stats stat;	// Stats for this iteration
-	long int n;		// Length of a single bit stream
-	long int *S;		// Array of the partial sums of the -1/+1 states
+	struct random_walk *walk;	// Random walk of the bit stream
 	double p_value;		// p_value iteration test result(s)
-	double *p_values;	// Array of p-values produced by this test
+	double p_values[NUMBER_OF_STATES_RND_EXCURSION_VAR];	// Array of p-values produced by this test
 	long int i;
-	long int j;
 
 	/*
 	 * Check preconditions (firewall)
@@ -212,21 +195,12 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 		dbg(DBG_LOW, "iterate function[%d] %s called when test vector was false", test_num, __func__);
 		return;
 	}
-	if (state->epsilon == NULL) {
-		err(161, __func__, "state->epsilon is NULL");
-	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(161, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->random_walk == NULL) {
+		err(161, __func__, "state->random_walk is NULL");
 	}
 	if (state->rnd_excursion_var_stateX == NULL) {
 		err(161, __func__, "state->rnd_excursion_var_stateX is NULL");
 	}
-	if (state->ex_var_partial_sums == NULL) {
-		err(161, __func__, "state->ex_var_partial_sums is NULL");
-	}
-	if (state->ex_var_partial_sums[thread_state->thread_id] == NULL) {
-		err(161, __func__, "state->ex_var_partial_sums[%ld] is NULL", thread_state->thread_id);
-	}
 	if (state->cSetup != true) {
 		err(161, __func__, "test constants not setup prior to calling %s for %s[%d]",
 		    __func__, state->testNames[test_num], test_num);
@@ -235,48 +209,16 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 	/*
 	 * Collect parameters from state
 	 */
-	S = state->ex_var_partial_sums[thread_state->thread_id];
-	n = state->tp.n;
-
-	/*
-	 * Set the initial value of the counter of the number of cycles
-	 */
-	stat.number_of_cycles = 0;
-
-	/*
-	 * Step 2: compute the partial sums of successively larger sub-sequences
-	 */
-	if ((int) state->epsilon[thread_state->thread_id][0] == 1) {
-		S[0] = 1;
-	} else if ((int) state->epsilon[thread_state->thread_id][0] == 0) {
-		S[0] = - 1;
-	} else {
-		err(41, __func__, "found a bit different than 1 or 0 in the sequence");
-	}
-	for (j = 1; j < n; j++) {
-		if ((int) state->epsilon[thread_state->thread_id][j] == 1) {
-			S[j] = S[j - 1] + 1;
-		} else if ((int) state->epsilon[thread_state->thread_id][j] == 0) {
-			S[j] = S[j - 1] - 1;
-		} else {
-			err(41, __func__, "found a bit different than 1 or 0 in the sequence");
-		}
-
-		/*
-		 * Step 3a: whenever a 0 in the partial sums is found, which means that a cycle has
-		 * ended, count a new cycle in the counter of cycles
-		 */
-		if (S[j] == 0) {
-			stat.number_of_cycles++;
-		}
-	}
+	walk = &state->random_walk[thread_state->thread_id];
 
 	/*
-	 * Step 3b: count the last cycle if it was not counted already
+	 * Steps 2 to 3b: get the partial sums of successively larger sub-sequences and the number of cycles
+	 *
+	 * These have already been computed by computeRandomWalk(): the visits to each partial sum
+	 * value x in [-MAX_EXCURSION_RND_EXCURSION_VAR, MAX_EXCURSION_RND_EXCURSION_VAR] are counted
+	 * in walk->visits[x + MAX_EXCURSION_RND_EXCURSION_VAR].
 	 */
-	if (S[n - 1] != 0) {
-		stat.number_of_cycles++;
-	}
+	stat.number_of_cycles = walk->number_of_cycles;
 
 	/*
 	 * Step 3c: determine if there are enough cycles
@@ -288,8 +230,6 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 	 */
 	if (stat.test_possible == true) {
 
-		p_values = malloc(NUMBER_OF_STATES_RND_EXCURSION_VAR * sizeof(*p_values));
-
 		/*
 		 * For each of the state values, compute the test statistic and the p-value
 		 */
@@ -298,12 +238,7 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 			/*
 			 * Step 4: count times when the partial sum matches this excursion state value
 			 */
-			stat.counter[i] = 0;
-			for (j = 0; j < n; j++) {
-				if (S[j] == state->rnd_excursion_var_stateX[i]) {
-					stat.counter[i]++;
-				}
-			}
+			stat.counter[i] = walk->visits[state->rnd_excursion_var_stateX[i] + MAX_EXCURSION_RND_EXCURSION_VAR];
 
 			/*
 			 * Step 5: compute the test p-value for this excursion state value
@@ -365,13 +300,6 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 			 */
 			append_value(state->p_val[test_num], &p_value);
 		}
-
-		/*
-		 * Record stats of this iteration
-		 */
-		if (state->resultstxtFlag == true) {
-			append_value(state->stats[test_num], &stat);
-		}
 	}
 
 	/*
@@ -398,15 +326,13 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 			stat.success[i] = false;	// FAILURE
 		}
 		memset(stat.counter, 0, sizeof(stat.counter));
-		if (state->resultstxtFlag == true) {
-			append_value(state->stats[test_num], &stat);
-		}
 
 		/*
 		 * Record non p-value of this invalid iteration
 		 */
 		p_value = NON_P_VALUE;
 		for (i = 0; i < NUMBER_OF_STATES_RND_EXCURSION_VAR; i++) {
+			p_values[i] = p_value;
 			append_value(state->p_val[test_num], &p_value);
 		}
 	}
@@ -418,6 +344,13 @@ RandomExcursionsVariant_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		RandomExcursionsVariant_print(thread_state, &stat, p_values);
+	}
+
 	return;
 }
 
@@ -576,6 +509,7 @@ RandomExcursionsVariant_print_stat2(FILE * stream, struct state *state, struct R
 				    long int p, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -631,8 +565,9 @@ RandomExcursionsVariant_print_stat2(FILE * stream, struct state *state, struct R
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "(x = %2ld) Total visits = %4ld; p-value = %f\n",
-					 state->rnd_excursion_var_stateX[p], stat->counter[p], p_value);
+			io_ret = fprintf(stream, "(x = %2ld) Total visits = %4ld; p-value = %s\n",
+					 state->rnd_excursion_var_stateX[p], stat->counter[p],
+					 formatDouble(value, state, p_value, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -645,8 +580,8 @@ RandomExcursionsVariant_print_stat2(FILE * stream, struct state *state, struct R
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "x = %2ld  visits = %4ld  p_value = %f\n",
-					 state->rnd_excursion_var_stateX[p], stat->counter[p], p_value);
+			io_ret = fprintf(stream, "x = %2ld  visits = %4ld  p_value = %s\n", state->rnd_excursion_var_stateX[p],
+					 stat->counter[p], formatDouble(value, state, p_value, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -676,9 +611,10 @@ RandomExcursionsVariant_print_stat2(FILE * stream, struct state *state, struct R
  *      false --> an I/O error occurred
  */
 static bool
-RandomExcursionsVariant_print_p_value(FILE * stream, double p_value)
+RandomExcursionsVariant_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -686,6 +622,9 @@ RandomExcursionsVariant_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(164, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(164, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -696,7 +635,7 @@ RandomExcursionsVariant_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -710,225 +649,85 @@ RandomExcursionsVariant_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * RandomExcursionsVariant_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * RandomExcursionsVariant_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_values        // NUMBER_OF_STATES_RND_EXCURSION_VAR p_values of the iteration
  *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
- *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-RandomExcursionsVariant_print(struct state *state)
+static void
+RandomExcursionsVariant_print(struct thread_state *thread_state,
+			      struct RandomExcursionsVariant_private_stats *stat, double *p_values)
 {
-	struct RandomExcursionsVariant_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 	long int p;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(165, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
+	if (thread_state == NULL) {
+		err(165, __func__, "thread_state arg is NULL");
 	}
-	if (state->partitionCount[test_num] < 1) {
-		err(165, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(165, __func__, "state is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(165, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	if (stat == NULL) {
+		err(165, __func__, "stat arg is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(165, __func__, "format for data0*.txt filename is NULL");
+	if (p_values == NULL) {
+		err(165, __func__, "p_values arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
+	 * Begin the row of this iteration
 	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Open results.txt file
+	 * Print stat to stats.txt
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	errno = 0;	// paranoia
+	ok = RandomExcursionsVariant_print_stat(buffer->stats, state, stat, thread_state->iteration_being_done);
+	if (ok == false) {
+		errp(165, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
+	}
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print all of the excursion states for this iteration
 	 */
-	for (i = 0, j = 0; i < state->stats[test_num]->count; ++i, j += NUMBER_OF_STATES_RND_EXCURSION_VAR) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct RandomExcursionsVariant_private_stats, i);
+	for (p = 0; p < NUMBER_OF_STATES_RND_EXCURSION_VAR; p++) {
 
 		/*
-		 * Print stat to stats.txt
+		 * Print, if possible, the excursion success or failure, visit and p_value
 		 */
 		errno = 0;	// paranoia
-		ok = RandomExcursionsVariant_print_stat(stats, state, stat, i);
+		ok = RandomExcursionsVariant_print_stat2(buffer->stats, state, stat, p, p_values[p]);
 		if (ok == false) {
-			errp(165, __func__, "error in writing to %s", stats_txt);
+			errp(165, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 		}
 
 		/*
-		 * Print all of the excursion states for this iteration
+		 * Print p_value to results.txt
 		 */
-		for (p = 0; p < NUMBER_OF_STATES_RND_EXCURSION_VAR; p++) {
-
-			/*
-			 * Get p_value for this excursion state of this iteration
-			 */
-			p_value = get_value(state->p_val[test_num], double, j + p);
-
-			/*
-			 * Print, if possible, the excursion success or failure, visit and p_value
-			 */
-			errno = 0;	// paranoia
-			ok = RandomExcursionsVariant_print_stat2(stats, state, stat, p, p_value);
-			if (ok == false) {
-				errp(165, __func__, "error in writing to %s", stats_txt);
-			}
-
-			/*
-			 * Print p_value to results.txt
-			 */
-			errno = 0;	// paranoia
-			ok = RandomExcursionsVariant_print_p_value(results, p_value);
-			if (ok == false) {
-				errp(165, __func__, "error in writing to %s", results_txt);
-			}
+		errno = 0;	// paranoia
+		ok = RandomExcursionsVariant_print_p_value(buffer->results, state, p_values[p]);
+		if (ok == false) {
+			errp(165, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 		}
 	}
 
-	/*
-	 * Flush and close stats.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(165, __func__, "error flushing to: %s", stats_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(165, __func__, "error closing: %s", stats_txt);
-	}
-	free(stats_txt);
-	stats_txt = NULL;
 
 	/*
-	 * Flush and close results.txt, free pathname
+	 * End the row of this iteration
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(165, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(165, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
-
-	/*
-	 * Write data*.txt for each data file if we need to partition results
-	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(165, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = RandomExcursionsVariant_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(165, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(165, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(165, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -996,7 +795,7 @@ RandomExcursionsVariant_metric_print(struct state *state, long int sampleCount,
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1103,9 +902,8 @@ RandomExcursionsVariant_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1124,73 +922,28 @@ RandomExcursionsVariant_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(167, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     (long int) state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(167, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1211,12 +964,6 @@ RandomExcursionsVariant_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1233,8 +980,6 @@ RandomExcursionsVariant_metrics(struct state *state)
 void
 RandomExcursionsVariant_destroy(struct state *state)
 {
-	long int i;
-
 	/*
 	 * Check preconditions (firewall)
 	 */
@@ -1249,11 +994,6 @@ RandomExcursionsVariant_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -1275,16 +1015,6 @@ RandomExcursionsVariant_destroy(struct state *state)
 		free(state->rnd_excursion_var_stateX);
 		state->rnd_excursion_var_stateX = NULL;
 	}
-	for (i = 0; i < state->numberOfThreads; i++) {
-		if (state->ex_var_partial_sums[i] != NULL) {
-			free(state->ex_var_partial_sums[i]);
-			state->ex_var_partial_sums[i] = NULL;
-		}
-	}
-	if (state->ex_var_partial_sums != NULL) {
-		free(state->ex_var_partial_sums);
-		state->ex_var_partial_sums = NULL;
-	}
 
 	return;
 }
@@ -36,8 +36,11 @@
 #include <limits.h>
 #include "../utils/externs.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/matrix.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/debug.h"
 
 
@@ -47,9 +50,9 @@
 struct Rank_private_stats {
 	bool success;		// Success or failure of iteration test
 	double chi_squared;	// Chi squared for rank frequencies
-	long int F_M;		// Frequency of rank NUMBER_OF_ROWS_RANK fpr this iteration
-	long int F_M_minus_one;	// Frequency of rank NUMBER_OF_ROWS_RANK-1 fpr this iteration
-	long int F_remaining;	// Frequency of rank < NUMBER_OF_ROWS_RANK-1 fpr this iteration
+	long int F_M;		// Frequency of rank M fpr this iteration
+	long int F_M_minus_one;	// Frequency of rank M-1 fpr this iteration
+	long int F_remaining;	// Frequency of rank < M-1 fpr this iteration
 };
 
 
@@ -62,9 +65,11 @@ static const enum test test_num = TEST_RANK;	// This test number
 /*
  * Static variables declarations
  */
-static double p_32;			// Probability of rank NUMBER_OF_ROWS_RANK
-static double p_31;			// Probability of rank NUMBER_OF_ROWS_RANK - 1
-static double p_30;			// Probability of rank < NUMBER_OF_ROWS_RANK - 1
+static int M;				// Number of rows of each matrix
+static int Q;				// Number of columns of each matrix
+static double p_M;			// Probability of rank M
+static double p_M_minus_one;		// Probability of rank M - 1
+static double p_remaining;		// Probability of rank < M - 1
 static long int matrix_count;		// Total possible matrix for a given bit stream length
 
 
@@ -72,7 +77,8 @@ static long int matrix_count;		// Total possible matrix for a given bit stream l
  * Forward static function declarations
  */
 static bool Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *stat, double p_value);
-static bool Rank_print_p_value(FILE * stream, double p_value);
+static bool Rank_print_p_value(FILE * stream, struct state *state, double p_value);
+static void Rank_print(struct thread_state *thread_state, struct Rank_private_stats *stat, double p_value);
 static void Rank_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
 
 
@@ -108,15 +114,30 @@ Rank_init(struct state *state)
 		err(170, __func__, "test constants not setup prior to calling %s for %s[%d]",
 		    __func__, state->testNames[test_num], test_num);
 	}
-	if (((long int) NUMBER_OF_ROWS_RANK * (long int) NUMBER_OF_COLS_RANK) > (long int) LONG_MAX) {	// paranoia
-		err(170, __func__, "NUMBER_OF_ROWS_RANK: %d * NUMBER_OF_COLS_RANK: %d cannot fit into a long int because"
-				"the product is > %ld", NUMBER_OF_ROWS_RANK, NUMBER_OF_COLS_RANK, LONG_MAX);
+
+	/*
+	 * Disable test if conditions do not permit this test from being run
+	 */
+	if (state->tp.rankMatrixSize < MIN_M_RANK) {
+		warn(__func__, "disabling test %s[%d]: requires matrix size(M): %ld >= %d",
+		     state->testNames[test_num], test_num, state->tp.rankMatrixSize, MIN_M_RANK);
+		state->testVector[test_num] = false;
+		return;
+	} else if (state->tp.rankMatrixSize > MAX_NUMBER_OF_COLS_RANK) {
+		warn(__func__, "disabling test %s[%d]: requires matrix size(M): %ld <= %d",
+		     state->testNames[test_num], test_num, state->tp.rankMatrixSize, MAX_NUMBER_OF_COLS_RANK);
+		state->testVector[test_num] = false;
+		return;
 	}
 
 	/*
 	 * Collect parameters from state
+	 *
+	 * The matrices are square, as in SP 800-22: M rows of Q == M columns.
 	 */
-	matrix_count = state->tp.n / (NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK);
+	M = (int) state->tp.rankMatrixSize;
+	Q = M;
+	matrix_count = state->tp.n / (M * Q);
 
 	/*
 	 * Disable test if conditions do not permit this test from being run
@@ -129,52 +150,48 @@ Rank_init(struct state *state)
 	}
 
 	/*
-	 * Compute probability of rank NUMBER_OF_ROWS_RANK
+	 * Compute probability of rank M
 	 */
-	r = NUMBER_OF_ROWS_RANK;
+	r = M;
 	product = 1.0;
 	for (i = 0; i <= r - 1; i++) {
-		product *= ((1.0 - pow(2.0, i - NUMBER_OF_ROWS_RANK))
-			    * (1.0 - pow(2.0, i - NUMBER_OF_COLS_RANK))) / (1.0 - pow(2.0, i - r));
+		product *= ((1.0 - pow(2.0, i - M)) * (1.0 - pow(2.0, i - Q))) / (1.0 - pow(2.0, i - r));
 	}
-	p_32 = pow(2.0, r * (NUMBER_OF_ROWS_RANK + NUMBER_OF_COLS_RANK - r)
-			- NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK) * product;
-	if (p_32 <= 0.0) {	// paranoia
-		err(50, __func__, "bogus p_32 value: %f should be > 0.0", p_32);
+	p_M = pow(2.0, r * (M + Q - r) - M * Q) * product;
+	if (p_M <= 0.0) {	// paranoia
+		err(50, __func__, "bogus p_M value: %f should be > 0.0", p_M);
 	}
-	if (p_32 >= 1.0) {	// paranoia
-		err(50, __func__, "bogus p_32 value: %f should be < 1.0", p_32);
+	if (p_M >= 1.0) {	// paranoia
+		err(50, __func__, "bogus p_M value: %f should be < 1.0", p_M);
 	}
 
 	/*
-	 * Compute probability of rank NUMBER_OF_ROWS_RANK - 1
+	 * Compute probability of rank M - 1
 	 */
-	r = NUMBER_OF_ROWS_RANK - 1;
+	r = M - 1;
 	product = 1.0;
 	for (i = 0; i <= r - 1; i++) {
-		product *= ((1.0 - pow(2.0, i - NUMBER_OF_ROWS_RANK))
-			    * (1.0 - pow(2.0, i - NUMBER_OF_COLS_RANK))) / (1.0 - pow(2.0, i - r));
+		product *= ((1.0 - pow(2.0, i - M)) * (1.0 - pow(2.0, i - Q))) / (1.0 - pow(2.0, i - r));
 	}
-	p_31 = pow(2.0, r * (NUMBER_OF_ROWS_RANK + NUMBER_OF_COLS_RANK - r)
-			- NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK) * product;
-	if (p_31 <= 0.0) {	// paranoia
-		err(50, __func__, "bogus p_31 value: %f should be > 0.0", p_31);
+	p_M_minus_one = pow(2.0, r * (M + Q - r) - M * Q) * product;
+	if (p_M_minus_one <= 0.0) {	// paranoia
+		err(50, __func__, "bogus p_M_minus_one value: %f should be > 0.0", p_M_minus_one);
 	}
-	if (p_31 >= 1.0) {	// paranoia
-		err(50, __func__, "bogus p_31 value: %f should be < 1.0", p_31);
+	if (p_M_minus_one >= 1.0) {	// paranoia
+		err(50, __func__, "bogus p_M_minus_one value: %f should be < 1.0", p_M_minus_one);
 	}
 
 	/*
-	 * Compute probability of rank < NUMBER_OF_ROWS_RANK - 1
+	 * Compute probability of rank < M - 1
 	 */
-	p_30 = 1.0 - (p_32 + p_31);
-	if (p_30 <= 0.0) {	// paranoia
-		err(50, __func__, "bogus p_30 value: %f == (1.0 - p32: %f - p_31: %f) should be > 0.0",
-		    p_30, p_31, p_32);
+	p_remaining = 1.0 - (p_M + p_M_minus_one);
+	if (p_remaining <= 0.0) {	// paranoia
+		err(50, __func__, "bogus p_remaining value: %f == (1.0 - p_M: %f - p_M_minus_one: %f) should be > 0.0",
+		    p_remaining, p_M, p_M_minus_one);
 	}
-	if (p_30 >= 1.0) {	// paranoia
-		err(50, __func__, "bogus p_30 value: %f == (1.0 - p32: %f - p_31: %f) should be < 1.0",
-		    p_30, p_31, p_32);
+	if (p_remaining >= 1.0) {	// paranoia
+		err(50, __func__, "bogus p_remaining value: %f == (1.0 - p_M: %f - p_M_minus_one: %f) should be < 1.0",
+		    p_remaining, p_M, p_M_minus_one);
 	}
 
 	/*
@@ -186,7 +203,11 @@ Rank_init(struct state *state)
 		     sizeof(*state->rank_matrix));
 	}
 	for (i = 0; i < state->numberOfThreads; i++) {
-		state->rank_matrix[i] = create_matrix(NUMBER_OF_ROWS_RANK, NUMBER_OF_COLS_RANK);
+		state->rank_matrix[i] = malloc(LANES_RANK * M * sizeof(state->rank_matrix[i][0]));
+		if (state->rank_matrix[i] == NULL) {
+			errp(50, __func__, "cannot malloc for rank_matrix[%d]: %d elements of %ld bytes each", i,
+			     LANES_RANK * M, sizeof(state->rank_matrix[i][0]));
+		}
 	}
 
 	/*
@@ -200,10 +221,6 @@ Rank_init(struct state *state)
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct Rank_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double),
 						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
 
@@ -233,12 +250,12 @@ void
 Rank_iterate(struct thread_state *thread_state)
 {
 	struct Rank_private_stats stat;	// Stats for this iteration
-	BitSequence **matrix;		// The matrix state->rank_matrix
-	BitSequence *row;		// A row of the matrix state->rank_matrix
-	int R;				// Rank of a given NUMBER_OF_ROWS_RANK by NUMBER_OF_COLS_RANK matrix
+	WORD64 *matrix;			// The matrices state->rank_matrix
+	int ranks[LANES_RANK];		// Ranks of the matrices reduced at once
+	int count;			// Number of matrices reduced at once
+	int l;
 	double p_value;			// p_value iteration test result(s)
 	long int k;
-	long int i;
 
 	/*
 	 * Check preconditions (firewall)
@@ -254,11 +271,11 @@ Rank_iterate(struct thread_state *thread_state)
 		dbg(DBG_LOW, "iterate function[%d] %s called when test vector was false", test_num, __func__);
 		return;
 	}
-	if (state->epsilon == NULL) {
-		err(171, __func__, "state->epsilon is NULL");
+	if (state->packed_epsilon == NULL) {
+		err(171, __func__, "state->packed_epsilon is NULL");
 	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(171, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->packed_epsilon[thread_state->thread_id] == NULL) {
+		err(171, __func__, "state->packed_epsilon[%ld] is NULL", thread_state->thread_id);
 	}
 	if (state->rank_matrix == NULL) {
 		err(171, __func__, "state->rank_matrix is NULL");
@@ -279,46 +296,35 @@ Rank_iterate(struct thread_state *thread_state)
 	stat.F_M_minus_one = 0;
 
 	/*
-	 * Zeroize the Rank test matrix
+	 * Step 1a: divide the sequence into disjoint blocks of M * Q bits
+	 *
+	 * NOTE: computeRank() reduces up to LANES_RANK interleaved matrices at a time, and selects
+	 *       the batched kernel for each full set of LANES_RANK of them.
 	 */
-	for (i = 0; i < NUMBER_OF_ROWS_RANK; ++i) {
+	for (k = 0; k < matrix_count; k += count) {
+		count = (int) MIN(LANES_RANK, matrix_count - k);
 
 		/*
-		 * Find the row
-		 */
-		row = matrix[i];
-		if (row == NULL) {	// paranoia
-			err(171, __func__, "row pointer %ld of rank_matrix is NULL", i);
-		}
-
-		/*
-		 * Zeroize the full row
-		 */
-		memset(row, 0, NUMBER_OF_COLS_RANK * sizeof(row[0]));
-	}
-
-	/*
-	 * Step 1a: divide the sequence into disjoint blocks of NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK bits
-	 */
-	for (k = 0; k < matrix_count; k++) {
-
-		/*
-	 	 * Step 1b: copy bits of each block into a NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK matrix
+	 	 * Step 1b: copy bits of each block into a M * Q matrix
 	 	 */
-		def_matrix(thread_state, NUMBER_OF_ROWS_RANK, NUMBER_OF_COLS_RANK, matrix, k);
+		for (l = 0; l < count; l++) {
+			def_matrix(thread_state, M, Q, matrix + l, count, k + l);
+		}
 
 		/*
 	 	 * Step 2: determine the binary rank of each matrix
 	 	 */
-		R = computeRank(NUMBER_OF_ROWS_RANK, NUMBER_OF_COLS_RANK, matrix);
+		computeRank(M, Q, matrix, count, ranks);
 
 		/*
 		 * Step 3a: count the number of matrices with rank = (full rank) and rank = (full rank - 1)
 		 */
-		if (R == NUMBER_OF_ROWS_RANK) {
-			stat.F_M++;	// rank NUMBER_OF_ROWS_RANK found
-		} else if (R == (NUMBER_OF_ROWS_RANK - 1)) {
-			stat.F_M_minus_one++;	// rank NUMBER_OF_ROWS_RANK-1 found
+		for (l = 0; l < count; l++) {
+			if (ranks[l] == M) {
+				stat.F_M++;	// rank M found
+			} else if (ranks[l] == (M - 1)) {
+				stat.F_M_minus_one++;	// rank M-1 found
+			}
 		}
 	}
 
@@ -330,15 +336,15 @@ Rank_iterate(struct thread_state *thread_state)
 	/*
 	 * Step 4: compute the test statistic
 	 */
-	stat.chi_squared = (((stat.F_M - matrix_count * p_32) *
-			     (stat.F_M - matrix_count * p_32) /
-			     (matrix_count * p_32)) +
-			    ((stat.F_M_minus_one - matrix_count * p_31) *
-			     (stat.F_M_minus_one - matrix_count * p_31) /
-			     (matrix_count * p_31)) +
-			    ((stat.F_remaining - matrix_count * p_30) *
-			     (stat.F_remaining - matrix_count * p_30) /
-			     (matrix_count * p_30)));
+	stat.chi_squared = (((stat.F_M - matrix_count * p_M) *
+			     (stat.F_M - matrix_count * p_M) /
+			     (matrix_count * p_M)) +
+			    ((stat.F_M_minus_one - matrix_count * p_M_minus_one) *
+			     (stat.F_M_minus_one - matrix_count * p_M_minus_one) /
+			     (matrix_count * p_M_minus_one)) +
+			    ((stat.F_remaining - matrix_count * p_remaining) *
+			     (stat.F_remaining - matrix_count * p_remaining) /
+			     (matrix_count * p_remaining)));
 
 	/*
 	 * Step 5: compute the test P-value
@@ -380,9 +386,6 @@ Rank_iterate(struct thread_state *thread_state)
 	/*
 	 * Record values computed during this iteration
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
-	}
 	append_value(state->p_val[test_num], &p_value);
 
 	/*
@@ -392,6 +395,13 @@ Rank_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		Rank_print(thread_state, &stat, p_value);
+	}
+
 	return;
 }
 
@@ -413,6 +423,7 @@ static bool
 Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *stat, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -462,27 +473,27 @@ Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *s
 			return false;
 		}
 	}
-	io_ret = fprintf(stream, "\t\t(a) Probability P_%d = %f\n", NUMBER_OF_ROWS_RANK, p_32);
+	io_ret = fprintf(stream, "\t\t(a) Probability P_%d = %s\n", M, formatDouble(value, state, p_M, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(b)             P_%d = %f\n", NUMBER_OF_ROWS_RANK - 1, p_31);
+	io_ret = fprintf(stream, "\t\t(b)             P_%d = %s\n", M - 1, formatDouble(value, state, p_M_minus_one, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(c)             P_%d = %f\n", NUMBER_OF_ROWS_RANK - 2, p_30);
+	io_ret = fprintf(stream, "\t\t(c)             P_%d = %s\n", M - 2, formatDouble(value, state, p_remaining, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(d) Frequency   F_%d = %ld\n", NUMBER_OF_ROWS_RANK, stat->F_M);
+	io_ret = fprintf(stream, "\t\t(d) Frequency   F_%d = %ld\n", M, stat->F_M);
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(e)             F_%d = %ld\n", NUMBER_OF_ROWS_RANK - 1, stat->F_M_minus_one);
+	io_ret = fprintf(stream, "\t\t(e)             F_%d = %ld\n", M - 1, stat->F_M_minus_one);
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(f)             F_%d = %ld\n", NUMBER_OF_ROWS_RANK - 2, stat->F_remaining);
+	io_ret = fprintf(stream, "\t\t(f)             F_%d = %ld\n", M - 2, stat->F_remaining);
 	if (io_ret <= 0) {
 		return false;
 	}
@@ -490,19 +501,19 @@ Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *s
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(h) Chi^2            = %f\n", stat->chi_squared);
+	io_ret = fprintf(stream, "\t\t(h) Chi^2            = %s\n", formatDouble(value, state, stat->chi_squared, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
 	if (state->legacy_output == true) {
 		io_ret = fprintf(stream, "\t\t(i) NOTE: %ld BITS WERE DISCARDED.\n",
-				 state->tp.n % (NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK));
+				 state->tp.n % (M * Q));
 		if (io_ret <= 0) {
 			return false;
 		}
 	} else {
 		io_ret = fprintf(stream, "\t\t(i) %ld bits were discarded\n",
-				 state->tp.n % (NUMBER_OF_ROWS_RANK * NUMBER_OF_COLS_RANK));
+				 state->tp.n % (M * Q));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -516,7 +527,7 @@ Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *s
 	 * Report success or failure
 	 */
 	if (stat->success == true) {
-		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -526,7 +537,7 @@ Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *s
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -552,9 +563,10 @@ Rank_print_stat(FILE * stream, struct state *state, struct Rank_private_stats *s
  *      false --> an I/O error occurred
  */
 static bool
-Rank_print_p_value(FILE * stream, double p_value)
+Rank_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -562,6 +574,9 @@ Rank_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(173, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(173, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -572,7 +587,7 @@ Rank_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -586,209 +601,65 @@ Rank_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * Rank_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * Rank_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value         // p_value iteration test result(s)
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-Rank_print(struct state *state)
+static void
+Rank_print(struct thread_state *thread_state, struct Rank_private_stats *stat, double p_value)
 {
-	struct Rank_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;				// p_value iteration test result(s)
-	FILE *stats = NULL;			// Open stats.txt file
-	FILE *results = NULL;			// Open results.txt file
-	FILE *data = NULL;			// Open data*.txt file
-	char *stats_txt = NULL;			// Pathname for stats.txt
-	char *results_txt = NULL;		// Pathname for results.txt
-	char *data_txt = NULL;			// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];		// Basename for a given data*.txt pathname
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
 	bool ok;				// true -> I/O was OK
-	int snprintf_ret;			// snprintf return value
-	int io_ret;				// I/O return status
-	long int i;
-	long int j;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(174, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(174, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(174, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(174, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(174, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(174, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(174, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
+	 * Begin the row of this iteration
 	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Open results.txt file
+	 * Print stat to stats.txt
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
-
-	/*
-	 * Write results.txt and stats.txt files
-	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct Rank_private_stats, i);
-
-		/*
-		 * Get p_value for this iteration
-		 */
-		p_value = get_value(state->p_val[test_num], double, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Rank_print_stat(stats, state, stat, p_value);
-		if (ok == false) {
-			errp(174, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Rank_print_p_value(results, p_value);
-		if (ok == false) {
-			errp(174, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = Rank_print_stat(buffer->stats, state, stat, p_value);
+	if (ok == false) {
+		errp(174, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_value to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(174, __func__, "error flushing to: %s", stats_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(174, __func__, "error closing: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = Rank_print_p_value(buffer->results, state, p_value);
+	if (ok == false) {
+		errp(174, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(174, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(174, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(174, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = Rank_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(174, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(174, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(174, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -856,7 +727,7 @@ Rank_metric_print(struct state *state, long int sampleCount, long int toolow, lo
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -963,9 +834,8 @@ Rank_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -984,73 +854,28 @@ Rank_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(176, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(176, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1071,12 +896,6 @@ Rank_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1093,7 +912,7 @@ Rank_metrics(struct state *state)
 void
 Rank_destroy(struct state *state)
 {
-	int i, j;
+	int i;
 
 	/*
 	 * Check preconditions (firewall)
@@ -1109,11 +928,6 @@ Rank_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -1137,12 +951,6 @@ Rank_destroy(struct state *state)
 	 */
 	for (i = 0; i < state->numberOfThreads; i++) {
 		if (state->rank_matrix[i] != NULL) {
-			for (j = 0; j < NUMBER_OF_ROWS_RANK; j++) {
-				if (state->rank_matrix[i][j] != NULL) {
-					free(state->rank_matrix[i][j]);
-					state->rank_matrix[i][j] = NULL;
-				}
-			}
 			free(state->rank_matrix[i]);
 			state->rank_matrix[i] = NULL;
 		}
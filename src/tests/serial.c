@@ -35,7 +35,10 @@
 #include <errno.h>
 #include "../utils/externs.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/debug.h"
 
 
@@ -65,7 +68,8 @@ static const enum test test_num = TEST_SERIAL;	// This test number
 static double compute_psi2(struct thread_state *thread_state, long int blocksize);
 static bool Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stats *stat, double p_value1,
 			      double p_value2);
-static bool Serial_print_p_value(FILE * stream, double p_value);
+static bool Serial_print_p_value(FILE * stream, struct state *state, double p_value);
+static void Serial_print(struct thread_state *thread_state, struct Serial_private_stats *stat, double p_value1, double p_value2);
 static void Serial_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin, int index);
 
 
@@ -147,10 +151,6 @@ Serial_init(struct state *state)
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct Serial_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double),
 						  DEFAULT_CHUNK, 2 * state->tp.numOfBitStreams, false);	// results.txt data
 
@@ -220,8 +220,8 @@ Serial_iterate(struct thread_state *thread_state)
 	/*
 	 * Step 5: compute the test P-values
 	 */
-	p_value1 = cephes_igamc((double) ((long int) 1 << (m - 1)) / 2.0, stat.del1 / 2.0);
-	p_value2 = cephes_igamc((double) ((long int) 1 << (m - 2)) / 2.0, stat.del2 / 2.0);
+	p_value1 = pvalue_igamc((double) ((long int) 1 << (m - 1)) / 2.0, stat.del1 / 2.0);
+	p_value2 = pvalue_igamc((double) ((long int) 1 << (m - 2)) / 2.0, stat.del2 / 2.0);
 
 	/*
 	 * Record success or failure for this iteration (1st test)
@@ -283,9 +283,6 @@ Serial_iterate(struct thread_state *thread_state)
 	/*
 	 * Record values computed during this iteration
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
-	}
 	append_value(state->p_val[test_num], &p_value1);
 	append_value(state->p_val[test_num], &p_value2);
 
@@ -296,6 +293,13 @@ Serial_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		Serial_print(thread_state, &stat, p_value1, p_value2);
+	}
+
 	return;
 }
 
@@ -446,6 +450,7 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 	long int n;		// Length of a single bit stream
 	long int m;		// Serial block length (state->tp.serialBlockLength)
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -506,23 +511,23 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(c) Psi_m               = %f\n", stat->psim0);
+	io_ret = fprintf(stream, "\t\t(c) Psi_m               = %s\n", formatDouble(value, state, stat->psim0, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(d) Psi_m-1             = %f\n", stat->psim1);
+	io_ret = fprintf(stream, "\t\t(d) Psi_m-1             = %s\n", formatDouble(value, state, stat->psim1, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(e) Psi_m-2             = %f\n", stat->psim2);
+	io_ret = fprintf(stream, "\t\t(e) Psi_m-2             = %s\n", formatDouble(value, state, stat->psim2, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(f) Del_1               = %f\n", stat->del1);
+	io_ret = fprintf(stream, "\t\t(f) Del_1               = %s\n", formatDouble(value, state, stat->del1, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(g) Del_2               = %f\n", stat->del2);
+	io_ret = fprintf(stream, "\t\t(g) Del_2               = %s\n", formatDouble(value, state, stat->del2, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
@@ -532,7 +537,7 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 	}
 	if (state->legacy_output == true) {
 		if (stat->success1 == true) {
-			io_ret = fprintf(stream, "SUCCESS\t\tp_value1 = %f\n", p_value1);
+			io_ret = fprintf(stream, "SUCCESS\t\tp_value1 = %s\n", formatDouble(value, state, p_value1, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -542,13 +547,13 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "FAILURE\t\tp_value1 = %f\n", p_value1);
+			io_ret = fprintf(stream, "FAILURE\t\tp_value1 = %s\n", formatDouble(value, state, p_value1, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
 		}
 		if (stat->success2 == true) {
-			io_ret = fprintf(stream, "SUCCESS\t\tp_value2 = %f\n\n", p_value2);
+			io_ret = fprintf(stream, "SUCCESS\t\tp_value2 = %s\n\n", formatDouble(value, state, p_value2, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -558,14 +563,14 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "FAILURE\t\tp_value2 = %f\n\n", p_value2);
+			io_ret = fprintf(stream, "FAILURE\t\tp_value2 = %s\n\n", formatDouble(value, state, p_value2, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
 		}
 	} else {
 		if (stat->success1 == true) {
-			io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n", p_value1);
+			io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n", formatDouble(value, state, p_value1, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -575,13 +580,13 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n", p_value1);
+			io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n", formatDouble(value, state, p_value1, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
 		}
 		if (stat->success2 == true) {
-			io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value2);
+			io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value, state, p_value2, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -591,7 +596,7 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
 				return false;
 			}
 		} else {
-			io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value2);
+			io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value, state, p_value2, 0));
 			if (io_ret <= 0) {
 				return false;
 			}
@@ -618,9 +623,10 @@ Serial_print_stat(FILE * stream, struct state *state, struct Serial_private_stat
  *      false --> an I/O error occurred
  */
 static bool
-Serial_print_p_value(FILE * stream, double p_value)
+Serial_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -628,6 +634,9 @@ Serial_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(194, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(194, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -638,7 +647,7 @@ Serial_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -652,221 +661,71 @@ Serial_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * Serial_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * Serial_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value1        // first p_value of the iteration
+ *      p_value2        // second p_value of the iteration
  *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
- *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-Serial_print(struct state *state)
+static void
+Serial_print(struct thread_state *thread_state, struct Serial_private_stats *stat, double p_value1, double p_value2)
 {
-	struct Serial_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;				// Generic p_value iteration
-	double p_value1;			// p_value iteration test result(s) - #1
-	double p_value2;			// p_value iteration test result(s) - #2
-	FILE *stats = NULL;			// Open stats.txt file
-	FILE *results = NULL;			// Open results.txt file
-	FILE *data = NULL;			// Open data*.txt file
-	char *stats_txt = NULL;			// Pathname for stats.txt
-	char *results_txt = NULL;		// Pathname for results.txt
-	char *data_txt = NULL;			// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];		// Basename for a given data*.txt pathname
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
 	bool ok;				// true -> I/O was OK
-	int snprintf_ret;			// snprintf return value
-	int io_ret;				// I/O return status
-	long int i;
-	long int j;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(195, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(195, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(195, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(195, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(195, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(195, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(195, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
-	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
-
-	/*
-	 * Open results.txt file
+	 * Begin the row of this iteration
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Write results.txt and stats.txt files
+	 * Print stat to stats.txt
 	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct Serial_private_stats, i);
-
-		/*
-		 * Get both p_values for this iteration
-		 */
-		p_value1 = get_value(state->p_val[test_num], double, i * 2);
-		p_value2 = get_value(state->p_val[test_num], double, (i * 2) + 1);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Serial_print_stat(stats, state, stat, p_value1, p_value2);
-		if (ok == false) {
-			errp(195, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print 1st p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Serial_print_p_value(results, p_value1);
-		if (ok == false) {
-			errp(195, __func__, "error in writing to %s", results_txt);
-		}
-
-		/*
-		 * Print 2nd p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Serial_print_p_value(results, p_value2);
-		if (ok == false) {
-			errp(195, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = Serial_print_stat(buffer->stats, state, stat, p_value1, p_value2);
+	if (ok == false) {
+		errp(195, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_values to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(195, __func__, "error flushing to: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = Serial_print_p_value(buffer->results, state, p_value1);
+	if (ok == false) {
+		errp(195, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(195, __func__, "error closing: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = Serial_print_p_value(buffer->results, state, p_value2);
+	if (ok == false) {
+		errp(195, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(195, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(195, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(195, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = Serial_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(195, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(195, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(195, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -934,7 +793,7 @@ Serial_metric_print(struct state *state, long int sampleCount, long int toolow,
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1041,9 +900,8 @@ Serial_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1062,73 +920,28 @@ Serial_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(197, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(197, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-			}
-			// Case: general (non-random excursion) test
-			else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1149,12 +962,6 @@ Serial_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1187,11 +994,6 @@ Serial_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
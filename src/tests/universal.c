@@ -36,7 +36,10 @@
 #include <limits.h>
 #include "../utils/externs.h"
 #include "../utils/utilities.h"
+#include "../utils/stats_txt.h"
+#include "../utils/fmt_double.h"
 #include "../utils/cephes.h"
+#include "../utils/pvalue.h"
 #include "../utils/debug.h"
 
 
@@ -84,8 +87,10 @@ static const double variance[MAX_L_UNIVERSAL + 1] = {
  * Forward static function declarations
  */
 static bool Universal_print_stat(FILE * stream, struct state *state, struct Universal_private_stats *stat, double p_value);
-static bool Universal_print_p_value(FILE * stream, double p_value);
+static bool Universal_print_p_value(FILE * stream, struct state *state, double p_value);
+static void Universal_print(struct thread_state *thread_state, struct Universal_private_stats *stat, double p_value);
 static void Universal_metric_print(struct state *state, long int sampleCount, long int toolow, long int *freqPerBin);
+static inline UINT Universal_block(const WORD64 *packed, long int pos, long int L);
 
 
 /*
@@ -104,6 +109,7 @@ Universal_init(struct state *state)
 	long int n;		// Length of a single bit stream
 	long int L;		// Length of each block
 	long int p;		// Number of possible L-bit blocks and size of the table T
+	long int len;		// Number of precomputed log2 distances
 	long int i;
 
 	/*
@@ -214,6 +220,26 @@ Universal_init(struct state *state)
 		}
 	}
 
+	/*
+	 * Precompute log2(d) for the small distances d between re-occurrences of the same L-bit block
+	 *
+	 * The distances are geometrically distributed with mean 2^L, so all but about exp(-16) of them fall below
+	 * 16 * 2^L.  MAX_LOG2_UNIVERSAL is 16 * 2^MAX_L_UNIVERSAL, so that this holds for every L (8 MB for L = 16).
+	 * Each entry is computed with the very same expression used for the rare larger distances in
+	 * Universal_iterate(), so the accumulated sum is unchanged.  The table is read-only and shared by all threads.
+	 */
+	len = MIN(16 * p, MAX_LOG2_UNIVERSAL);
+	state->universal_log2 = malloc((size_t) len * sizeof(state->universal_log2[0]));
+	if (state->universal_log2 == NULL) {
+		errp(200, __func__, "cannot malloc of %ld elements of %lu bytes each for state->universal_log2",
+		     len, sizeof(state->universal_log2[0]));
+	}
+	state->universal_log2[0] = 0.0;	// distance 0 never occurs
+	for (i = 1; i < len; i++) {
+		state->universal_log2[i] = log((double) i) / state->c.log2;
+	}
+	state->universal_log2_len = len;
+
 	/*
 	 * Create working sub-directory if forming files such as results.txt and stats.txt
 	 */
@@ -225,10 +251,6 @@ Universal_init(struct state *state)
 	/*
 	 * Allocate dynamic arrays
 	 */
-	if (state->resultstxtFlag == true) {
-		state->stats[test_num] = create_dyn_array(sizeof(struct Universal_private_stats),
-							  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);        // stats.txt
-	}
 	state->p_val[test_num] = create_dyn_array(sizeof(double),
 						  DEFAULT_CHUNK, state->tp.numOfBitStreams, false);	// results.txt
 
@@ -259,14 +281,17 @@ Universal_iterate(struct thread_state *thread_state)
 {
 	struct Universal_private_stats stat;	// Stats for this iteration
 	long int L;		// Length of each block
-	long int *T;		// Table with block number of the last occurrence of each block
+	UINT *T;		// Table with block number of the last occurrence of each block
+	const WORD64 *packed;	// Packed bit stream of this thread
+	const double *log2_of;	// Precomputed log2 of small distances
+	long int log2_len;	// Number of precomputed log2 distances
 	long int p;		// Number of possible L-bit blocks and size of the table T
 	double arg;		// Term used to compute p-value
 	double p_value;		// p_value iteration test result(s)
 	double c;		// Constant used in the formula of the standard deviation
-	long decRep;		// Decimal representation of a block
+	UINT decRep;		// Decimal representation of a block
+	long int d;		// Distance between re-occurrences of the same L-bit block
 	long int i;
-	long int j;
 
 	/*
 	 * Check preconditions (firewall)
@@ -282,11 +307,14 @@ Universal_iterate(struct thread_state *thread_state)
 		dbg(DBG_LOW, "iterate function[%d] %s called when test vector was false", test_num, __func__);
 		return;
 	}
-	if (state->epsilon == NULL) {
-		err(201, __func__, "state->epsilon is NULL");
+	if (state->packed_epsilon == NULL) {
+		err(201, __func__, "state->packed_epsilon is NULL");
 	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(201, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->packed_epsilon[thread_state->thread_id] == NULL) {
+		err(201, __func__, "state->packed_epsilon[%ld] is NULL", thread_state->thread_id);
+	}
+	if (state->universal_log2 == NULL) {
+		err(201, __func__, "state->universal_log2 is NULL");
 	}
 	if (state->universal_T == NULL) {
 		err(201, __func__, "state->universal_T is NULL");
@@ -304,6 +332,9 @@ Universal_iterate(struct thread_state *thread_state)
 	 */
 	L = state->universal_L;
 	T = state->universal_T[thread_state->thread_id];
+	packed = state->packed_epsilon[thread_state->thread_id];
+	log2_of = state->universal_log2;
+	log2_len = state->universal_log2_len;
 
 	/*
 	 * Check preconditions (firewall)
@@ -323,6 +354,9 @@ Universal_iterate(struct thread_state *thread_state)
 	}
 	stat.Q = 10 * p;
 	stat.K = 100 * stat.Q;
+	if (stat.Q + stat.K > (long int) UINT_MAX) {	// paranoia
+		err(201, __func__, "Q + K: %ld does not fit in the T table entries", stat.Q + stat.K);
+	}
 	stat.sum = 0.0;
 	memset(T, 0, p * sizeof(T[0]));	// zeroize T
 
@@ -337,15 +371,12 @@ Universal_iterate(struct thread_state *thread_state)
 		 * It is convenient to use this representation because we can store and
 		 * have access to the contents of each block in the table T with size 2^L.
 		 */
-		decRep = 0;
-		for (j = 0; j < L; j++) {
-			decRep += state->epsilon[thread_state->thread_id][(i - 1) * L + j] * ((long int) 1 << (L - 1 - j));
-		}
+		decRep = Universal_block(packed, (i - 1) * L, L);
 
 		/*
 		 * Save the block number of this last occurrence of the this L-bit block in the table.
 		 */
-		T[decRep] = i;
+		T[decRep] = (UINT) i;
 	}
 
 	/*
@@ -357,21 +388,23 @@ Universal_iterate(struct thread_state *thread_state)
 		/*
 		 * Get decimal representation of the block
 		 */
-		decRep = 0;
-		for (j = 0; j < L; j++) {
-			decRep += state->epsilon[thread_state->thread_id][(i - 1) * L + j] * ((long int) 1 << (L - 1 - j));
-		}
+		decRep = Universal_block(packed, (i - 1) * L, L);
 
 		/*
 		 * Add the distance between re-occurrences of the same L-bit block to an
 		 * accumulating log2 sum of all the differences detected in the K blocks
 		 */
-		stat.sum += log(i - T[decRep]) / state->c.log2;
+		d = i - (long int) T[decRep];
+		if (d < log2_len) {
+			stat.sum += log2_of[d];
+		} else {
+			stat.sum += log(d) / state->c.log2;
+		}
 
 		/*
 		 * Replace the value in the table with the location of the current block
 		 */
-		T[decRep] = i;
+		T[decRep] = (UINT) i;
 	}
 
 	/*
@@ -422,9 +455,6 @@ Universal_iterate(struct thread_state *thread_state)
 	/*
 	 * Record values computed during this iteration
 	 */
-	if (state->resultstxtFlag == true) {
-		append_value(state->stats[test_num], &stat);
-	}
 	append_value(state->p_val[test_num], &p_value);
 
 	/*
@@ -434,6 +464,13 @@ Universal_iterate(struct thread_state *thread_state)
 		pthread_mutex_unlock(thread_state->mutex);
 	}
 
+	/*
+	 * Print the stats.txt and results.txt lines of this iteration (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		Universal_print(thread_state, &stat, p_value);
+	}
+
 	return;
 }
 
@@ -457,6 +494,7 @@ Universal_print_stat(FILE * stream, struct state *state, struct Universal_privat
 	long int n;		// Length of a single bit stream
 	long int L;		// Length of each block
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -518,23 +556,23 @@ Universal_print_stat(FILE * stream, struct state *state, struct Universal_privat
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(d) sum       = %f\n", stat->sum);
+	io_ret = fprintf(stream, "\t\t(d) sum       = %s\n", formatDouble(value, state, stat->sum, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(e) sigma     = %f\n", stat->sigma);
+	io_ret = fprintf(stream, "\t\t(e) sigma     = %s\n", formatDouble(value, state, stat->sigma, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(f) variance  = %f\n", variance[L]);
+	io_ret = fprintf(stream, "\t\t(f) variance  = %s\n", formatDouble(value, state, variance[L], 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(g) exp_value = %f\n", expected_value[L]);
+	io_ret = fprintf(stream, "\t\t(g) exp_value = %s\n", formatDouble(value, state, expected_value[L], 0));
 	if (io_ret <= 0) {
 		return false;
 	}
-	io_ret = fprintf(stream, "\t\t(h) phi       = %f\n", stat->f_n);
+	io_ret = fprintf(stream, "\t\t(h) phi       = %s\n", formatDouble(value, state, stat->f_n, 0));
 	if (io_ret <= 0) {
 		return false;
 	}
@@ -554,7 +592,7 @@ Universal_print_stat(FILE * stream, struct state *state, struct Universal_privat
 		return false;
 	}
 	if (stat->success == true) {
-		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "SUCCESS\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -564,7 +602,7 @@ Universal_print_stat(FILE * stream, struct state *state, struct Universal_privat
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "FAILURE\t\tp_value = %f\n\n", p_value);
+		io_ret = fprintf(stream, "FAILURE\t\tp_value = %s\n\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -590,9 +628,10 @@ Universal_print_stat(FILE * stream, struct state *state, struct Universal_privat
  *      false --> an I/O error occurred
  */
 static bool
-Universal_print_p_value(FILE * stream, double p_value)
+Universal_print_p_value(FILE * stream, struct state *state, double p_value)
 {
 	int io_ret;		// I/O return status
+	char value[FMT_DOUBLE_BUFSIZ];	// Text of a double
 
 	/*
 	 * Check preconditions (firewall)
@@ -600,6 +639,9 @@ Universal_print_p_value(FILE * stream, double p_value)
 	if (stream == NULL) {
 		err(203, __func__, "stream arg is NULL");
 	}
+	if (state == NULL) {
+		err(203, __func__, "state arg is NULL");
+	}
 
 	/*
 	 * Print p_value to a file
@@ -610,7 +652,7 @@ Universal_print_p_value(FILE * stream, double p_value)
 			return false;
 		}
 	} else {
-		io_ret = fprintf(stream, "%f\n", p_value);
+		io_ret = fprintf(stream, "%s\n", formatDouble(value, state, p_value, 0));
 		if (io_ret <= 0) {
 			return false;
 		}
@@ -624,213 +666,65 @@ Universal_print_p_value(FILE * stream, double p_value)
 
 
 /*
- * Universal_print - print to results.txt, data*.txt, stats.txt for all iterations
+ * Universal_print - print the stats.txt and results.txt lines of an iteration
  *
  * given:
- *      state           // run state to test under
- *
- * This function is called for once to print dynamic arrays into
- * results.txt, data*.txt, stats.txt.
+ *      thread_state    // state of the thread that performed the iteration
+ *      stat            // statistics of the iteration
+ *      p_value         // p_value iteration test result(s)
  *
- * NOTE: The initialize and iterate functions must be called before this function is called.
+ * The lines are formatted into the buffer of the thread and written, in the order of the iterations,
+ * by the stats.txt writer thread, which also writes each results.txt line into the data*.txt file
+ * of its partition if we need to partition results.
  */
-void
-Universal_print(struct state *state)
+static void
+Universal_print(struct thread_state *thread_state, struct Universal_private_stats *stat, double p_value)
 {
-	struct Universal_private_stats *stat;	// Pointer to statistics of an iteration
-	double p_value;			// p_value iteration test result(s)
-	FILE *stats = NULL;		// Open stats.txt file
-	FILE *results = NULL;		// Open results.txt file
-	FILE *data = NULL;		// Open data*.txt file
-	char *stats_txt = NULL;		// Pathname for stats.txt
-	char *results_txt = NULL;	// Pathname for results.txt
-	char *data_txt = NULL;		// Pathname for data*.txt
-	char data_filename[BUFSIZ + 1];	// Basename for a given data*.txt pathname
-	bool ok;			// true -> I/O was OK
-	int snprintf_ret;		// snprintf return value
-	int io_ret;			// I/O return status
-	long int i;
-	long int j;
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	bool ok;				// true -> I/O was OK
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(204, __func__, "state arg is NULL");
-	}
-	if (state->testVector[test_num] != true) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] called when test vector was false", state->testNames[test_num],
-		    test_num);
-		return;
-	}
-	if (state->resultstxtFlag == false) {
-		dbg(DBG_HIGH, "Print driver interface for %s[%d] was not enabled with -s", state->testNames[test_num], test_num);
-		return;
-	}
-	if (state->partitionCount[test_num] < 1) {
-		err(204, __func__,
-		    "print driver interface for %s[%d] called with state.partitionCount: %d < 0",
-		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
+	if (thread_state == NULL) {
+		err(204, __func__, "thread_state arg is NULL");
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		err(204, __func__,
-		    "print driver interface for %s[%d] called with p_val count: %ld != %ld*%d=%ld",
-		    state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		    state->tp.numOfBitStreams, state->partitionCount[test_num],
-		    state->tp.numOfBitStreams * state->partitionCount[test_num]);
+	struct state *state = thread_state->global_state;
+	if (state == NULL) {
+		err(204, __func__, "state is NULL");
 	}
-	if (state->datatxt_fmt[test_num] == NULL) {
-		err(204, __func__, "format for data0*.txt filename is NULL");
+	if (stat == NULL) {
+		err(204, __func__, "stat arg is NULL");
 	}
 
 	/*
-	 * Open stats.txt file
+	 * Begin the row of this iteration
 	 */
-	stats_txt = filePathName(state->subDir[test_num], "stats.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", stats_txt);
-	stats = openTruncate(stats_txt);
+	buffer = beginStatsTxtRow(thread_state, test_num, thread_state->iteration_being_done);
 
 	/*
-	 * Open results.txt file
+	 * Print stat to stats.txt
 	 */
-	results_txt = filePathName(state->subDir[test_num], "results.txt");
-	dbg(DBG_HIGH, "about to open/truncate: %s", results_txt);
-	results = openTruncate(results_txt);
-
-	/*
-	 * Write results.txt and stats.txt files
-	 */
-	for (i = 0; i < state->stats[test_num]->count; ++i) {
-
-		/*
-		 * Locate stat for this iteration
-		 */
-		stat = addr_value(state->stats[test_num], struct Universal_private_stats, i);
-
-		/*
-		 * Get p_value for this iteration
-		 */
-		p_value = get_value(state->p_val[test_num], double, i);
-
-		/*
-		 * Print stat to stats.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Universal_print_stat(stats, state, stat, p_value);
-		if (ok == false) {
-			errp(204, __func__, "error in writing to %s", stats_txt);
-		}
-
-		/*
-		 * Print p_value to results.txt
-		 */
-		errno = 0;	// paranoia
-		ok = Universal_print_p_value(results, p_value);
-		if (ok == false) {
-			errp(204, __func__, "error in writing to %s", results_txt);
-		}
+	errno = 0;	// paranoia
+	ok = Universal_print_stat(buffer->stats, state, stat, p_value);
+	if (ok == false) {
+		errp(204, __func__, "error in writing iteration %ld to stats.txt", thread_state->iteration_being_done + 1);
 	}
 
 	/*
-	 * Flush and close stats.txt, free pathname
+	 * Print p_value to results.txt
 	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(stats);
-	if (io_ret != 0) {
-		errp(204, __func__, "error flushing to: %s", stats_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(stats);
-	if (io_ret != 0) {
-		errp(204, __func__, "error closing: %s", stats_txt);
+	errno = 0;	// paranoia
+	ok = Universal_print_p_value(buffer->results, state, p_value);
+	if (ok == false) {
+		errp(204, __func__, "error in writing iteration %ld to results.txt", thread_state->iteration_being_done + 1);
 	}
-	free(stats_txt);
-	stats_txt = NULL;
 
-	/*
-	 * Flush and close results.txt, free pathname
-	 */
-	errno = 0;		// paranoia
-	io_ret = fflush(results);
-	if (io_ret != 0) {
-		errp(204, __func__, "error flushing to: %s", results_txt);
-	}
-	errno = 0;		// paranoia
-	io_ret = fclose(results);
-	if (io_ret != 0) {
-		errp(204, __func__, "error closing: %s", results_txt);
-	}
-	free(results_txt);
-	results_txt = NULL;
 
 	/*
-	 * Write data*.txt for each data file if we need to partition results
+	 * End the row of this iteration
 	 */
-	if (state->partitionCount[test_num] > 1) {
-
-		/*
-		 * For each data file
-		 */
-		for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-			/*
-			 * Form the data*.txt basename
-			 */
-			errno = 0;	// paranoia
-			snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[test_num], j + 1);
-			data_filename[BUFSIZ] = '\0';	// paranoia
-			if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
-				errp(204, __func__,
-				     "snprintf failed for %d bytes for data%03ld.txt, returned: %d", BUFSIZ, j + 1, snprintf_ret);
-			}
-
-			/*
-			 * Form the data*.txt filename
-			 */
-			data_txt = filePathName(state->subDir[test_num], data_filename);
-			dbg(DBG_HIGH, "about to open/truncate: %s", data_txt);
-			data = openTruncate(data_txt);
-
-			/*
-			 * Write this particular data*.txt filename
-			 */
-			if (j < state->p_val[test_num]->count) {
-				for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-					/*
-					 * Get p_value for an iteration belonging to this data*.txt filename
-					 */
-					p_value = get_value(state->p_val[test_num], double, i);
-
-					/*
-					 * Print p_value to results.txt
-					 */
-					errno = 0;	// paranoia
-					ok = Universal_print_p_value(data, p_value);
-					if (ok == false) {
-						errp(204, __func__, "error in writing to %s", data_txt);
-					}
-
-				}
-			}
-
-			/*
-			 * Flush and close data*.txt, free pathname
-			 */
-			errno = 0;	// paranoia
-			io_ret = fflush(data);
-			if (io_ret != 0) {
-				errp(204, __func__, "error flushing to: %s", data_txt);
-			}
-			errno = 0;	// paranoia
-			io_ret = fclose(data);
-			if (io_ret != 0) {
-				errp(204, __func__, "error closing: %s", data_txt);
-			}
-			free(data_txt);
-			data_txt = NULL;
-		}
-	}
+	endStatsTxtRow(buffer);
 
 	return;
 }
@@ -898,7 +792,7 @@ Universal_metric_print(struct state *state, long int sampleCount, long int toolo
 			chi2 += (freqPerBin[i] - expCount) * (freqPerBin[i] - expCount) / expCount;
 		}
 		// Uniformity threshold level
-		uniformity = cephes_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
+		uniformity = pvalue_igamc((state->tp.uniformity_bins - 1.0) / 2.0, chi2 / 2.0);
 	}
 
 	/*
@@ -1005,9 +899,8 @@ Universal_metrics(struct state *state)
 {
 	long int sampleCount;	// Number of bitstreams in which we will count p_values
 	long int toolow;	// p_values that were below alpha
-	double p_value;		// p_value iteration test result(s)
-	long int *freqPerBin;	// Uniformity frequency bins
-	long int i;
+	struct metric_tally *tally;	// Tally of the p_values of each partition
+	long int *freqPerBin;	// Uniformity frequency bins of the partition
 	long int j;
 
 	/*
@@ -1026,73 +919,28 @@ Universal_metrics(struct state *state)
 		    "metrics driver interface for %s[%d] called with state.partitionCount: %d < 0",
 		    state->testNames[test_num], test_num, state->partitionCount[test_num]);
 	}
-	if (state->p_val[test_num]->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
-		warn(__func__,
-		     "metrics driver interface for %s[%d] called with p_val length: %ld != bit streams: %ld",
-		     state->testNames[test_num], test_num, state->p_val[test_num]->count,
-		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
-	}
 
 	/*
-	 * Allocate uniformity frequency bins
+	 * The p_values of every partition have been tallied by the driver
 	 */
-	freqPerBin = malloc(state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-	if (freqPerBin == NULL) {
-		errp(206, __func__, "cannot malloc of %ld elements of %ld bytes each for freqPerBin",
-		     state->tp.uniformity_bins, sizeof(long int));
+	tally = state->tally[test_num];
+	if (tally == NULL) {
+		err(206, __func__, "state->tally[%d] is NULL", test_num);
+	}
+	if (tally->count != (state->tp.numOfBitStreams * state->partitionCount[test_num])) {
+		warn(__func__,
+		     "metrics driver interface for %s[%d] called with tallied p_values: %ld != bit streams: %ld",
+		     state->testNames[test_num], test_num, tally->count,
+		     state->tp.numOfBitStreams * state->partitionCount[test_num]);
 	}
 
 	/*
 	 * Print for each partition (or the whole set of p_values if partitionCount is 1)
 	 */
 	for (j = 0; j < state->partitionCount[test_num]; ++j) {
-
-		/*
-		 * Set counters to zero
-		 */
-		toolow = 0;
-		sampleCount = 0;
-		memset(freqPerBin, 0, state->tp.uniformity_bins * sizeof(freqPerBin[0]));
-
-		/*
-		 * Tally p_value
-		 */
-		for (i = j; i < state->p_val[test_num]->count; i += state->partitionCount[test_num]) {
-
-			// Get the iteration p_value
-			p_value = get_value(state->p_val[test_num], double, i);
-			if (p_value == NON_P_VALUE) {
-				continue;	// the test was not possible for this iteration
-			}
-			// Case: random excursion test
-			if (state->is_excursion[test_num] == true) {
-				// Random excursion tests only sample > 0 p_values
-				if (p_value > 0.0) {
-					++sampleCount;
-				} else {
-					// Ignore p_value of 0 for random excursion tests
-					continue;
-				}
-
-				// Case: general (non-random excursion) test
-			} else {
-				// All other tests count all p_values
-				++sampleCount;
-			}
-
-			// Count the number of p_values below alpha
-			if (p_value < state->tp.alpha) {
-				++toolow;
-			}
-			// Tally the p_value in a uniformity bin
-			if (p_value >= 1.0) {
-				++freqPerBin[state->tp.uniformity_bins - 1];
-			} else if (p_value >= 0.0) {
-				++freqPerBin[(int) floor(p_value * (double) state->tp.uniformity_bins)];
-			} else {
-				++freqPerBin[0];
-			}
-		}
+		sampleCount = tally->sampleCount[j];
+		toolow = tally->toolow[j];
+		freqPerBin = tally->freqPerBin + j * state->tp.uniformity_bins;
 
 		/*
 		 * Print uniformity and proportional information for a tallied count
@@ -1113,12 +961,6 @@ Universal_metrics(struct state *state)
 		}
 	}
 
-	/*
-	 * Free allocated storage
-	 */
-	free(freqPerBin);
-	freqPerBin = NULL;
-
 	return;
 }
 
@@ -1151,11 +993,6 @@ Universal_destroy(struct state *state)
 	/*
 	 * Free dynamic arrays
 	 */
-	if (state->stats[test_num] != NULL) {
-		free_dyn_array(state->stats[test_num]);
-		free(state->stats[test_num]);
-		state->stats[test_num] = NULL;
-	}
 	if (state->p_val[test_num] != NULL) {
 		free_dyn_array(state->p_val[test_num]);
 		free(state->p_val[test_num]);
@@ -1183,6 +1020,41 @@ Universal_destroy(struct state *state)
 		free(state->universal_T);
 		state->universal_T = NULL;
 	}
+	if (state->universal_log2 != NULL) {
+		free(state->universal_log2);
+		state->universal_log2 = NULL;
+	}
+	state->universal_log2_len = 0;
 
 	return;
 }
+
+
+/*
+ * Universal_block - extract an L-bit block from a packed bit stream
+ *
+ * given:
+ *      packed          // packed bit stream (LSB first, with a trailing zero padding word)
+ *      pos             // bit position of the first bit of the block
+ *      L               // length of the block, 1 <= L <= MAX_L_UNIVERSAL
+ *
+ * returns:
+ *      the L bits starting at pos, with the bit at pos as the least significant bit
+ *
+ * NOTE: The result is the bit-reversed value of the traditional MSB-first decimal representation.
+ *       Since bit reversal is a one-to-one map of the 2^L blocks onto themselves, using it to index the
+ *       table T finds exactly the same re-occurrences, and the test statistic is unchanged.
+ */
+static inline UINT
+Universal_block(const WORD64 *packed, long int pos, long int L)
+{
+	long int word = pos / BITS_N_WORD64;	// word holding the first bit of the block
+	long int shift = pos % BITS_N_WORD64;	// offset of the first bit within that word
+	WORD64 w;
+
+	w = packed[word] >> shift;
+	if (shift + L > BITS_N_WORD64) {
+		w |= packed[word + 1] << (BITS_N_WORD64 - shift);
+	}
+	return (UINT) (w & (((WORD64) 1 << L) - 1));
+}
@@ -109,6 +109,7 @@
 #   define BITS_N_BYTE			(8)					// Number of bits in a byte
 #   define BITS_N_INT			(BITS_N_BYTE * sizeof(int))		// Number of bits in an int
 #   define BITS_N_LONGINT		(BITS_N_BYTE * sizeof(long int))	// Number of bits in a long int
+#   define BITS_N_WORD64		(BITS_N_BYTE * sizeof(WORD64))		// Number of bits in a WORD64
 #   define MAX_DATA_DIGITS		(21)					// Decimal digits in (2^64)-1
 
 #   define NUMOFTESTS			(15)		// MAX TESTS DEFINED - must match max enum test value below
@@ -125,6 +126,7 @@
 #   define DEFAULT_BITCOUNT		(1048576)	// -P 9=bitcount, Length of a single bit stream
 #   define DEFAULT_UNIFORMITY_LEVEL	(0.0001)	// -P 10=uni_level, uniformity errors have values below this
 #   define DEFAULT_ALPHA		(0.01)		// -P 11=alpha, p_value significance level
+#   define DEFAULT_RANK			(32)		// -P 12=M, Rank Test - rows and columns of each matrix
 
 /*****************************************************************************
  INPUT SIZE RECOMMENDATIONS CONSTANTS
@@ -142,19 +144,23 @@
 #   define MIN_LENGTH_LONGESTRUN	(128)		// Minimum n for a Longest Runs test for TEST_LONGEST_RUN
 #   define CLASS_COUNT_LONGEST_RUN	(6)		// Number of classes == max_len - min_len + 1 for TEST_LONGEST_RUN
 
-#   define NUMBER_OF_ROWS_RANK		(32)		// Number of rows in the rank_matrix used by TEST_RANK
-#   define NUMBER_OF_COLS_RANK		(32)		// Number of columns in the rank_matrix used by TEST_RANK
+#   define MIN_M_RANK			(2)		// Minimum rows and columns of each matrix for TEST_RANK
+#   define MAX_NUMBER_OF_COLS_RANK	(64)		// Maximum columns (one WORD64 per row) used by TEST_RANK
+#   define LANES_RANK			(8)		// Matrices reduced at once by the batched TEST_RANK kernel
 #   define MIN_NUMBER_OF_MATRICES_RANK	(38)		// Minimum number of matrices required for TEST_RANK
-#   if NUMBER_OF_ROWS_RANK <= 0
-// force syntax error if NUMBER_OF_ROWS_RANK is not bigger than zero
-      -=*#@#*=- NUMBER_OF_ROWS_RANK must be > 0 -=*#@#*=-
-#   endif
-#   if NUMBER_OF_COLS_RANK <= 0
-// force syntax error if NUMBER_OF_COLS_RANK is not bigger than zero
-      -=*#@#*=- NUMBER_OF_COLS_RANK must be > 0 -=*#@#*=-
+#   if DEFAULT_RANK < MIN_M_RANK
+// force syntax error if DEFAULT_RANK is too small
+      -=*#@#*=- DEFAULT_RANK must be >= MIN_M_RANK -=*#@#*=-
+#   elif DEFAULT_RANK > MAX_NUMBER_OF_COLS_RANK
+// force syntax error if a row of the rank_matrix does not fit into a WORD64
+      -=*#@#*=- DEFAULT_RANK must be <= MAX_NUMBER_OF_COLS_RANK -=*#@#*=-
 #   endif
 
 #   define MIN_LENGTH_FFT		(1000)		// Minimum n for TEST_FFT
+#   define MAX_DFT_BATCH		(64)		// Maximum number of bitstreams transformed together by TEST_DFT
+#   define MAX_RESERVOIR_SIZE		(1 << 20)	// Maximum number of p_values sampled per partition by -G samples
+#   define MIN_LENGTH_PARALLEL_FFT	(1 << 20)	// Minimum n for TEST_DFT to spread one transform over threads
+#   define MAX_LEGACY_FFT_WAYS	(16)		// Maximum number of sub-transforms of the split legacy FFT
 
 #   define BLOCKS_NON_OVERLAPPING	(8)		// Number of blocks N used by TEST_NON_OVERLAPPING
 #   define MAX_BLOCKS_NON_OVERLAPPING	(100)		// Maximum number N of blocks used by TEST_NON_OVERLAPPING
@@ -179,12 +185,14 @@
 #   define MIN_UNIVERSAL		(387840)	// Minimum n to allow L >= 6 for TEST_UNIVERSAL
 #   define MIN_L_UNIVERSAL		(6)		// Minimum value of L for TEST_UNIVERSAL
 #   define MAX_L_UNIVERSAL		(16)		// Maximum value of L for TEST_UNIVERSAL
+#   define MAX_LOG2_UNIVERSAL		(16 << MAX_L_UNIVERSAL)	// Maximum number of precomputed log2 distances for TEST_UNIVERSAL
 
 #   define MIN_LENGTH_LINEARCOMPLEXITY	(1000000)	// Minimum n for TEST_LINEARCOMPLEXITY
 #   define MIN_M_LINEARCOMPLEXITY	(500)		// Minimum M for TEST_LINEARCOMPLEXITY
 #   define MAX_M_LINEARCOMPLEXITY	(5000)		// Maximum M for TEST_LINEARCOMPLEXITY
 #   define MIN_N_LINEARCOMPLEXITY	(200)		// Minimum N for TEST_LINEARCOMPLEXITY
 #   define K_LINEARCOMPLEXITY		(6)		// Degrees of freedom for TEST_LINEARCOMPLEXITY
+#   define LANES_LINEARCOMPLEXITY	(64)		// Blocks processed at once (1 per WORD64 bit) by TEST_LINEARCOMPLEXITY
 
 #   define MIN_LENGTH_CUSUM		(100)		// Minimum n for TEST_CUSUM
 
@@ -196,6 +204,10 @@
 #   define MIN_LENGTH_RND_EXCURSION_VAR		(1000000)	// Minimum n for TEST_RND_EXCURSION_VAR
 #   define MAX_EXCURSION_RND_EXCURSION_VAR	(9)		// Maximum excursion for state values in TEST_RND_EXCURSION_VAR
 #   define NUMBER_OF_STATES_RND_EXCURSION_VAR	(2*MAX_EXCURSION_RND_EXCURSION_VAR) // Number of states for TEST_RND_EXCURSION_VAR
+#   if MAX_EXCURSION_RND_EXCURSION_VAR < MAX_EXCURSION_RND_EXCURSION
+// force syntax error if the random walk pass does not cover the states of both random excursion tests
+      -=*#@#*=- MAX_EXCURSION_RND_EXCURSION_VAR must be >= MAX_EXCURSION_RND_EXCURSION -=*#@#*=-
+#   endif
 
 #   define GLOBAL_MIN_BITCOUNT			(1000)		// Section 2.0 min recommended length of a single bit stream
 #   if GLOBAL_MIN_BITCOUNT <= 0
@@ -247,11 +259,13 @@ enum run_mode {
 	MODE_ITERATE_AND_ASSESS = 'b',	// Test the data specified from '-g generator' (default mode)
 	MODE_ITERATE_ONLY = 'i',	// Test the given data, but not assess it, and instead save the p-values in a binary file
 	MODE_ASSESS_ONLY = 'a',		// Collect the p-values from the binary files specified from '-d file...' and assess them
+	MODE_MERGE_ONLY = 'm',		// Merge the binary files specified from '-d file...' into a single binary file
 };
 
 #   define MIN_PARAM (1)	// minimum -P parameter number
-#   define MAX_PARAM (11)	// maximum -P parameter number
+#   define MAX_PARAM (12)	// maximum -P parameter number
 #   define MAX_INT_PARAM (9)	// maximum -P parameter that is an integer, beyond this are doubles
+#   define MAX_DOUBLE_PARAM (11)	// maximum -P parameter that is a double, beyond this are integers again
 
 enum param {
 	PARAM_continue = 0,				// Don't prompt for any more parameters
@@ -266,6 +280,7 @@ enum param {
 	PARAM_n = 9,					// -P 9=bitcount, Length of a single bit stream
 	PARAM_uniformity_level = 10,			// -P 10=uni_level, uniformity errors have values below this
 	PARAM_alpha = 11,				// -P 11=alpha, p_value significance level
+	PARAM_rankMatrixSize = 12,			// -P 12=M, Rank Test - rows and columns of each matrix
 };
 
 /*
@@ -286,6 +301,7 @@ typedef struct _testParameters {
 	long int n;					// -P 9=bitcount, Length of a single bit stream
 	double uniformity_level;			// -P 10=uni_level, uniformity errors have values below this
 	double alpha;					// -P 11=alpha, p_value significance level
+	long int rankMatrixSize;			// -P 12=M, Rank Test - rows and columns of each matrix
 } TP;
 
 /*
@@ -351,6 +367,38 @@ struct nonover_stats {
 	unsigned int Wj[BLOCKS_NON_OVERLAPPING]; // Number of times that m-bit template occurs within each block
 };
 
+/*
+ * Tally of the p_values of each partition of a test, computed for all tests at once by the metrics phase
+ */
+struct metric_tally {
+	long int count;			// Number of p_values tallied, sampled or not, of all partitions
+	long int *sampleCount;		// Number of p_values counted in each partition
+	long int *toolow;		// Number of p_values below alpha in each partition
+	long int *freqPerBin;		// Uniformity bins of each partition, uniformity_bins of them per partition
+	double *reservoir;		// NULL or reservoirSize p_values sampled from each partition of merged files
+};
+
+/*
+ * Random walk of the -1/+1 adjusted bits of a bit stream, computed once per bit stream
+ * for TEST_CUSUM, TEST_RND_EXCURSION and TEST_RND_EXCURSION_VAR (see utils/random_walk.c)
+ */
+struct random_walk {
+	long int S;			// Final partial sum
+	long int S_max;			// Maximum partial sum (or 0 if all partial sums are negative)
+	long int S_min;			// Minimum partial sum (or 0 if all partial sums are positive)
+	long int number_of_cycles;	// Number of cycles: returns to 0, plus 1 if the walk does not end at 0
+
+	// Number of visits to each partial sum value x in [-MAX_EXCURSION_RND_EXCURSION_VAR, MAX_EXCURSION_RND_EXCURSION_VAR],
+	// the number of visits to x is in visits[x + MAX_EXCURSION_RND_EXCURSION_VAR]
+	long int visits[2 * MAX_EXCURSION_RND_EXCURSION_VAR + 1];
+
+	// v[k][i] is the number of cycles in which the TEST_RND_EXCURSION state with index i occurs exactly k times
+	// (or at least k times when k == DEGREES_OF_FREEDOM_RND_EXCURSION - 1)
+	long int v[DEGREES_OF_FREEDOM_RND_EXCURSION][NUMBER_OF_STATES_RND_EXCURSION];
+
+	long int last_cycle[NUMBER_OF_STATES_RND_EXCURSION];	// Visits to each TEST_RND_EXCURSION state in the last cycle
+};
+
 /*
  * Struct representing a node of the filenames linked-list
  */
@@ -388,6 +436,8 @@ struct state {
 
 	bool resultstxtFlag;		// -s: true -> create result.txt, data*.txt, and stats.txt
 					//		(def: don't create)
+	bool exactFlag;			// -x: true -> print the doubles of stats.txt, results.txt and data*.txt
+					//		in the shortest round-trip format (def: as with %f)
 
 	bool randomDataArg;		// true randdata arg was given
 	char *randomDataPath;		// randdata: path to a random data file, or "-" (stdin), or "/dev/null", or NULL (no file)
@@ -399,14 +449,28 @@ struct state {
 	bool numberOfThreadsFlag;	// true if -T numberOfFlag was given
 	long int numberOfThreads;	// Number of threads to use for the current execution
 	long int iterationsMissing;	// Number of iterations that need to be completed
+	long int threadBudget;		// Number of threads that may run at once (before capping to the bitstreams)
 
 	bool jobnumFlag;		// true if -j jobnum was given
 	long int jobnum;		// -j jobnum: seek into randdata num*bitcount*iterations bits unless reading from stdin
 	long int base_seek;		// Seek position for the input file indicating where we want to start testing it
+	long int firstIteration;	// Index among all jobs of the first iteration tested by this process
 
 	char *pvalues_dir;		// Directory where to look for the .pvalues binary files
 	struct Node *filenames;		// Names of the .pvalues files
 
+	bool wisdomFlag;		// true if -W wisdomFile was given
+	char *wisdomFile;		// -W wisdomFile: FFTW wisdom file loaded and saved by TEST_DFT
+
+	bool dftBatchFlag;		// true if -B dftBatch was given
+	long int dftBatch;		// -B dftBatch: number of bitstreams transformed together by TEST_DFT
+
+	bool aggregateFlag;		// true if -G samples was given, -m i or -m m writes tallies instead of p_values
+	long int reservoirSize;		// -G samples: p_values sampled from each partition into an aggregated file
+
+	bool shardWorkersFlag;		// true if -K workers was given
+	long int shardWorkers;		// -K workers: number of worker processes testing shards of the iterations
+
 	TP tp;				// Test parameters
 	bool promptFlag;		// true --> prompt for change of parameters if -A
 	bool uniformityBinsFlag;	// -P 8 was given with custom uniformity bins
@@ -426,13 +490,16 @@ struct state {
 	int partitionCount[NUMOFTESTS + 1];	// Partition the result for test i into partitionCount[i] data*.txt files
 	char *datatxt_fmt[NUMOFTESTS + 1];	// Format of data*.txt filenames or NULL
 
-	struct dyn_array *stats[NUMOFTESTS + 1];// Per test dynamic array of per iteration data (for stats.txt if -s)
+	struct stats_txt_writer *stats_txt;	// Writer of stats.txt, results.txt and data*.txt during the iterations if -s, or NULL
 	struct dyn_array *p_val[NUMOFTESTS + 1];// Per test dynamic array of p_values (nonover_stats for the nonOverlapping test)
+	struct metric_tally *tally[NUMOFTESTS + 1];// Per test tally of p_val during the metrics phase, or NULL
 
 	bool is_excursion[NUMOFTESTS + 1];	// true --> test is a form of random excursion
 
 	BitSequence **epsilon;			// Bit stream
 	BitSequence *tmpepsilon;		// Buffer to write to file in dataFormat
+	WORD64 **packed_epsilon;		// Bit stream packed 64 bits per word, bit i is bit (i % 64) of word i / 64
+	struct random_walk *random_walk;	// Random walk of the bit stream of each thread, NULL if no test uses it
 
 	long int count[NUMOFTESTS + 1];		// Count of completed iterations, including tests skipped due to conditions
 	long int valid[NUMOFTESTS + 1];		// Count of completed testable iterations, ignores tests skipped due to conditions
@@ -449,23 +516,25 @@ struct state {
 
 	struct dyn_array *nonovTemplates;	// Array of non-overlapping template words for TEST_NON_OVERLAPPING
 
-	double **fft_m;				// test m array for TEST_DFT
 	double **fft_X;				// test X array for TEST_DFT
 # if defined(LEGACY_FFT)
 	double **fft_wsave;			// test wsave array for legacy dfft library in TEST_DFT
+	double **fft_sub;			// Decimated sub-sequences for the split legacy dfft in TEST_DFT
 #else /* LEGACY_FFT */
 	fftw_plan *fftw_p;			// Plan containing information about the fastest way to compute the transform
 	fftw_complex **fftw_out;		// Output array for fftw library output in TEST_DFT
 #endif /* LEGACY_FFT */
+	long int *fft_fill;			// Number of bitstreams batched in fft_X for TEST_DFT
+	long int **fft_iteration;		// Iteration number of each bitstream batched in fft_X for TEST_DFT
 
-	BitSequence ***rank_matrix;		// Rank test 32 by 32 matrix for TEST_RANK
+	WORD64 **rank_matrix;			// Rank test LANES_RANK interleaved matrices (one WORD64 per row) for TEST_RANK
 
 	long int *rnd_excursion_var_stateX;	// Pointer to NUMBER_OF_STATES_RND_EXCURSION_VAR states for TEST_RND_EXCURSION_VAR
-	long int **ex_var_partial_sums;		// Array of n partial sums for TEST_RND_EXCURSION_VAR
 
-	BitSequence **linear_b;			// LFSR array b for TEST_LINEARCOMPLEXITY
-	BitSequence **linear_c;			// LFSR array c for TEST_LINEARCOMPLEXITY
-	BitSequence **linear_t;			// LFSR array t for TEST_LINEARCOMPLEXITY
+	WORD64 **linear_b;			// Bit-sliced LFSR array b (times x^(j-m)) for TEST_LINEARCOMPLEXITY
+	WORD64 **linear_c;			// Bit-sliced LFSR array c for TEST_LINEARCOMPLEXITY
+	WORD64 **linear_t;			// Bit-sliced LFSR array t for TEST_LINEARCOMPLEXITY
+	WORD64 **linear_s;			// Bit-sliced M-bit blocks of the bit stream for TEST_LINEARCOMPLEXITY
 
 	long int **apen_C;			// Frequency count for TEST_APEN
 	long int apen_C_len;			// Number of long ints in apen_C for TEST_APEN
@@ -476,10 +545,10 @@ struct state {
 	BitSequence **nonper_seq;		// Special BitSequence for TEST_NON_OVERLAPPING
 
 	long int universal_L;			// Length of each block for TEST_UNIVERSAL
-	long int **universal_T;			// Working Universal template
+	UINT **universal_T;			// Working Universal template
+	double *universal_log2;			// Precomputed log2(d) of small distances d for TEST_UNIVERSAL
+	long int universal_log2_len;		// Number of doubles in universal_log2 for TEST_UNIVERSAL
 
-	long int **rnd_excursion_S;		// Sum of -1/+1 states for TEST_RND_EXCURSION
-	struct dyn_array **rnd_excursion_cycle;	// Contains the index of the ending position of each cycle for TEST_RND_EXCURSION
 	long int *rnd_excursion_stateX;		// Pointer to NUMBER_OF_STATES_RND_EXCURSION states for TEST_RND_EXCURSION_VAR
 	double **rnd_excursion_pi_terms;	// Theoretical probabilities for states of TEST_RND_EXCURSION_VAR
 
@@ -500,8 +569,12 @@ struct thread_state {
  */
 extern void init(struct state *state);
 extern void iterate(struct thread_state *thread_state);
+extern void flush(struct thread_state *thread_state);
 extern void print(struct state *state);
 extern void metrics(struct state *state);
+extern void allocMetricTallies(struct state *state);
+extern void tallyMetrics(struct state *state);
+extern void freeMetricTallies(struct state *state);
 extern void destroy(struct state *state);
 
 extern void parse_args(struct state *state, int argc, char **argv);
@@ -46,6 +46,9 @@
 #include "utilities.h"
 #include "debug.h"
 #include "stat_fncs.h"
+#include "random_walk.h"
+#include "stats_txt.h"
+#include "fmt_double.h"
 
 extern long int debuglevel;	// -v lvl: defines the level of verbosity for debugging
 
@@ -55,7 +58,7 @@ extern long int debuglevel;	// -v lvl: defines the level of verbosity for debugg
 struct driver {
 	void (*init) (struct state *state);			// Initialize the test and check input size recommendations
 	void (*iterate) (struct thread_state * thread_state);	// Perform a single iteration test on the bitstream
-	void (*print) (struct state *state);			// Log iteration info into stats.txt, data*.txt, results.txt if -s
+	void (*flush) (struct thread_state * thread_state);	// Finish iterations batched by a thread, or NULL
 	void (*metrics) (struct state *state);			// Uniformity and proportional analysis of a test
 	void (*destroy) (struct state *state);			// Final test cleanup and memory de-allocation
 };
@@ -73,7 +76,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_FREQUENCY = 1, Frequency test (frequency.c)
 	 Frequency_init,
 	 Frequency_iterate,
-	 Frequency_print,
+	 NULL,
 	 Frequency_metrics,
 	 Frequency_destroy,
 	 },
@@ -81,7 +84,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_BLOCK_FREQUENCY = 2, Block Frequency test (blockFrequency.c)
 	 BlockFrequency_init,
 	 BlockFrequency_iterate,
-	 BlockFrequency_print,
+	 NULL,
 	 BlockFrequency_metrics,
 	 BlockFrequency_destroy,
 	 },
@@ -89,7 +92,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_CUSUM = 3, Cumulative Sums test (cusum.c)
 	 CumulativeSums_init,
 	 CumulativeSums_iterate,
-	 CumulativeSums_print,
+	 NULL,
 	 CumulativeSums_metrics,
 	 CumulativeSums_destroy,
 	 },
@@ -97,7 +100,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_RUNS = 4, Runs test (runs.c)
 	 Runs_init,
 	 Runs_iterate,
-	 Runs_print,
+	 NULL,
 	 Runs_metrics,
 	 Runs_destroy,
 	 },
@@ -105,7 +108,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_LONGEST_RUN = 5, Longest Runs test (longestRunOfOnes.c)
 	 LongestRunOfOnes_init,
 	 LongestRunOfOnes_iterate,
-	 LongestRunOfOnes_print,
+	 NULL,
 	 LongestRunOfOnes_metrics,
 	 LongestRunOfOnes_destroy,
 	 },
@@ -113,7 +116,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_RANK = 6, Rank test (rank.c)
 	 Rank_init,
 	 Rank_iterate,
-	 Rank_print,
+	 NULL,
 	 Rank_metrics,
 	 Rank_destroy,
 	 },
@@ -121,7 +124,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_DFT = 7, Discrete Fourier Transform test (discreteFourierTransform.c)
 	 DiscreteFourierTransform_init,
 	 DiscreteFourierTransform_iterate,
-	 DiscreteFourierTransform_print,
+	 DiscreteFourierTransform_flush,
 	 DiscreteFourierTransform_metrics,
 	 DiscreteFourierTransform_destroy,
 	 },
@@ -129,7 +132,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_NON_OVERLAPPING = 8, Non-overlapping Template test (nonOverlappingTemplateMatchings.c)
 	 NonOverlappingTemplateMatchings_init,
 	 NonOverlappingTemplateMatchings_iterate,
-	 NonOverlappingTemplateMatchings_print,
+	 NULL,
 	 NonOverlappingTemplateMatchings_metrics,
 	 NonOverlappingTemplateMatchings_destroy,
 	 },
@@ -137,7 +140,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_OVERLAPPING = 9, Overlapping Template test (overlappingTemplateMatchings.c)
 	 OverlappingTemplateMatchings_init,
 	 OverlappingTemplateMatchings_iterate,
-	 OverlappingTemplateMatchings_print,
+	 NULL,
 	 OverlappingTemplateMatchings_metrics,
 	 OverlappingTemplateMatchings_destroy,
 	 },
@@ -145,7 +148,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_UNIVERSAL = 10, Universal test (universal.c)
 	 Universal_init,
 	 Universal_iterate,
-	 Universal_print,
+	 NULL,
 	 Universal_metrics,
 	 Universal_destroy,
 	 },
@@ -153,7 +156,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_APEN = 11, Approximate Entropy test (approximateEntropy.c)
 	 ApproximateEntropy_init,
 	 ApproximateEntropy_iterate,
-	 ApproximateEntropy_print,
+	 NULL,
 	 ApproximateEntropy_metrics,
 	 ApproximateEntropy_destroy,
 	 },
@@ -161,7 +164,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_RND_EXCURSION = 12, Random Excursions test (randomExcursions.c)
 	 RandomExcursions_init,
 	 RandomExcursions_iterate,
-	 RandomExcursions_print,
+	 NULL,
 	 RandomExcursions_metrics,
 	 RandomExcursions_destroy,
 	 },
@@ -169,7 +172,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_RND_EXCURSION_VAR = 13, Random Excursions Variant test (randomExcursionsVariant.c)
 	 RandomExcursionsVariant_init,
 	 RandomExcursionsVariant_iterate,
-	 RandomExcursionsVariant_print,
+	 NULL,
 	 RandomExcursionsVariant_metrics,
 	 RandomExcursionsVariant_destroy,
 	 },
@@ -177,7 +180,7 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_SERIAL = 14, Serial test (serial.c)
 	 Serial_init,
 	 Serial_iterate,
-	 Serial_print,
+	 NULL,
 	 Serial_metrics,
 	 Serial_destroy,
 	 },
@@ -185,16 +188,32 @@ static const struct driver testDriver[NUMOFTESTS + 1] = {
 	{			// TEST_LINEARCOMPLEXITY = 15, Linear Complexity test (linearComplexity.c)
 	 LinearComplexity_init,
 	 LinearComplexity_iterate,
-	 LinearComplexity_print,
+	 NULL,
 	 LinearComplexity_metrics,
 	 LinearComplexity_destroy,
 	 },
 };
 
+/*
+ * Work shared by the threads of the metrics phase: chunks of METRIC_CHUNK_ROWS rows (iterations)
+ * of the p_val of each test are handed out, test after test
+ */
+#define METRIC_CHUNK_ROWS (16384)
+
+struct metric_work {
+	struct state *state;		// Run state whose p_val arrays are tallied
+	pthread_mutex_t *mutex;		// Protects the fields below and the state->tally arrays
+	int test;			// Test whose p_val is being handed out
+	long int next;			// Index in p_val of the first p_value of the next chunk
+};
+
 /*
  * Forward static function declarations
  */
 static void finishMetricTestsSentence(test_metric_result result, struct state *state);
+static void *tallyMetricsThread(void *work);
+static void tallyMetricsChunk(struct state *state, int test, long int start, long int end,
+			      long int *sampleCount, long int *toolow, long int *freqPerBin);
 
 /*
  * Init - initialize the variables needed for each test and check if the input size recommendations are respected
@@ -353,9 +372,11 @@ init(struct state *state)
 	}
 
 	/*
-	 * Set the number of iterations not done yet to be equal to the total numOfBitstreams
+	 * Set the number of iterations not done yet to be equal to the total numOfBitstreams,
+	 * starting at the first iteration of the -j jobnum job
 	 */
 	state->iterationsMissing = state->tp.numOfBitStreams;
+	state->firstIteration = state->jobnum * state->tp.numOfBitStreams;
 
 	/*
 	 * Allocate the array for the bit streams copied to memory
@@ -377,6 +398,44 @@ init(struct state *state)
 		}
 	}
 
+	/*
+	 * Allocate the array for the packed copy of the bit stream of each thread
+	 *
+	 * NOTE: One extra word is allocated (and kept zero) so that a test can always read
+	 *       the word that follows the one holding the last bit of the bit stream.
+	 */
+	state->packed_epsilon = calloc((size_t) state->numberOfThreads, sizeof(*state->packed_epsilon));
+	if (state->packed_epsilon == NULL) {
+		errp(50, __func__, "cannot calloc for packed_epsilon: %ld elements of %lu bytes each", state->numberOfThreads,
+		     sizeof(*state->packed_epsilon));
+	}
+	for (i = 0; i < state->numberOfThreads; i++) {
+		state->packed_epsilon[i] = calloc((size_t) (state->tp.n / BITS_N_WORD64 + 2), sizeof(WORD64));
+		if (state->packed_epsilon[i] == NULL) {
+			errp(50, __func__, "cannot calloc for packed_epsilon[%d]: %ld elements of %lu bytes each", i,
+			     state->tp.n / BITS_N_WORD64 + 2, sizeof(WORD64));
+		}
+	}
+
+	/*
+	 * Select the popcount kernels used on the packed bit streams
+	 */
+	setupPopcount();
+
+	/*
+	 * Allocate the random walk shared by the cumulative sums and random excursion tests
+	 */
+	initRandomWalk(state);
+
+	/*
+	 * Open the stats.txt, results.txt and data*.txt files written during the iterations if -s,
+	 * and prepare the shortest round-trip format of their doubles if -x
+	 */
+	if (state->resultstxtFlag == true) {
+		initFmtDouble(state);
+		initStatsTxt(state);
+	}
+
 	/*
 	 * Report the end of the init phase
 	 */
@@ -408,6 +467,18 @@ iterate(struct thread_state *thread_state)
 		err(51, __func__, "state is NULL");
 	}
 
+	/*
+	 * Pack the bitstream of this thread for the tests that work on 64 bits at a time
+	 */
+	packEpsilon(state, thread_state->thread_id);
+
+	/*
+	 * Walk the partial sums of the bitstream once for all the tests that need them
+	 */
+	if (state->random_walk != NULL) {
+		computeRandomWalk(state, thread_state->thread_id);
+	}
+
 	/*
 	 * Perform an iteration for each test on the current bitstream
 	 */
@@ -426,37 +497,68 @@ iterate(struct thread_state *thread_state)
 
 
 /*
- * Print - print to results.txt, data*.txt, stats.txt for all iterations
+ * flush - finish the iterations that enabled tests have batched up in a thread
  *
  * given:
- *      state           // current processing state
+ *      thread_state    // state of the thread that has no more bitstreams to iterate on
+ *
+ * Tests that accumulate several bitstreams before processing them (such as the
+ * Discrete Fourier Transform test with -B dftBatch) process what is left here.
  */
 void
-print(struct state *state)
+flush(struct thread_state *thread_state)
 {
 	int i;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
+	if (thread_state == NULL) {
+		err(55, __func__, "thread_state arg is NULL");
+	}
+	struct state *state = thread_state->global_state;
 	if (state == NULL) {
-		err(52, __func__, "state arg is NULL");
+		err(55, __func__, "state is NULL");
 	}
 
 	/*
-	 * Print results from each test
-	 *
-	 * or old code: partition results
+	 * Flush each enabled test that batches its iterations
 	 */
-	dbg(DBG_LOW, "Start of print phase");
-	for (i = 1; i <= NUMOFTESTS; i++) {
-		if (state->testVector[i] == true) {
-			if (testDriver[i].print != NULL) {
-				testDriver[i].print(state);	// print results of a test
-			}
+	for (i = 1; i <= NUMOFTESTS; ++i) {
+		if (state->testVector[i] == true && testDriver[i].flush != NULL) {
+			testDriver[i].flush(thread_state);
 		}
 	}
 
+	return;
+}
+
+
+/*
+ * Print - finish writing results.txt, data*.txt, stats.txt for all iterations
+ *
+ * given:
+ *      state           // current processing state
+ *
+ * The rows of each iteration are formatted by the threads and written by the stats.txt writer
+ * thread during the iterate phase.  All that is left is to wait for the last rows to be written.
+ */
+void
+print(struct state *state)
+{
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(52, __func__, "state arg is NULL");
+	}
+
+	/*
+	 * Write the last rows of each test, and close the files
+	 */
+	dbg(DBG_LOW, "Start of print phase");
+	closeStatsTxt(state);
+
 	/*
 	 * Report the end of the print phase
 	 */
@@ -536,9 +638,14 @@ metrics(struct state *state)
 	}
 
 	/*
-	 * Perform metrics processing for each test and print each result to the output files
+	 * Tally the p_values of all partitions of all tests, in parallel
 	 */
 	dbg(DBG_LOW, "Start of assess phase");
+	tallyMetrics(state);
+
+	/*
+	 * Perform metrics processing for each test and print each result to the output files
+	 */
 	for (i = 1; i <= NUMOFTESTS; i++) {	// FOR EACH TEST
 
 		// Check if the test is enabled
@@ -554,6 +661,7 @@ metrics(struct state *state)
 			}
 		}
 	}
+	freeMetricTallies(state);
 
 	/*
 	 * Print additional information to output files
@@ -1113,6 +1221,321 @@ metrics(struct state *state)
 	return;
 }
 
+/*
+ * allocMetricTallies - allocate the zeroized tally of each enabled test that has none yet
+ *
+ * given:
+ *      state           // current processing state
+ *
+ * A tally has state->partitionCount[test] partitions of state->tp.uniformity_bins bins.
+ */
+void
+allocMetricTallies(struct state *state)
+{
+	long int partitions;		// Number of partitions of a test
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(56, __func__, "state arg is NULL");
+	}
+	if (state->tp.uniformity_bins < 1) {
+		err(56, __func__, "uniformity_bins: %ld must be > 0", state->tp.uniformity_bins);
+	}
+
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->testVector[i] != true || testDriver[i].metrics == NULL || state->p_val[i] == NULL ||
+		    state->tally[i] != NULL) {
+			continue;
+		}
+		partitions = state->partitionCount[i];
+		if (partitions < 1) {
+			err(56, __func__, "partitionCount[%d]: %ld must be > 0", i, partitions);
+		}
+		state->tally[i] = malloc(sizeof(*state->tally[i]));
+		if (state->tally[i] == NULL) {
+			errp(56, __func__, "cannot malloc for tally[%d]: %lu bytes", i, sizeof(*state->tally[i]));
+		}
+		state->tally[i]->count = 0;
+		state->tally[i]->reservoir = NULL;
+		state->tally[i]->sampleCount = calloc((size_t) partitions, sizeof(long int));
+		state->tally[i]->toolow = calloc((size_t) partitions, sizeof(long int));
+		state->tally[i]->freqPerBin = calloc((size_t) (partitions * state->tp.uniformity_bins), sizeof(long int));
+		if (state->tally[i]->sampleCount == NULL || state->tally[i]->toolow == NULL ||
+		    state->tally[i]->freqPerBin == NULL) {
+			errp(56, __func__, "cannot calloc tally[%d] of %ld partitions of %ld bins", i, partitions,
+			     state->tp.uniformity_bins);
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * tallyMetrics - tally the p_values of each partition of each enabled test
+ *
+ * given:
+ *      state           // current processing state
+ *
+ * The p_val array of each test is read once, in order, by up to state->threadBudget threads that
+ * each take chunks of whole rows.  A row holds the partitionCount p_values of an iteration, so the
+ * counters of all partitions are updated in the same sequential pass.  The result of each test is
+ * added to state->tally[test], which may already hold the tallies read from aggregated .pvalues
+ * files, for the *_metrics() function of the test to print.
+ */
+void
+tallyMetrics(struct state *state)
+{
+	struct metric_work work;	// Work shared by the threads
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_attr_t attr;
+	long int threads;		// Number of threads tallying p_values
+	int io_ret;			// pthread return status
+	void *status;
+	long int t;
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(56, __func__, "state arg is NULL");
+	}
+
+	/*
+	 * Allocate the missing tallies and count the p_values about to be tallied
+	 */
+	allocMetricTallies(state);
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->tally[i] != NULL) {
+			state->tally[i]->count += state->p_val[i]->count;
+		}
+	}
+
+	/*
+	 * Run the tallying threads
+	 */
+	threads = MAX(state->threadBudget, 1);
+	pthread_t thread[threads];
+	work.state = state;
+	work.mutex = &mutex;
+	work.test = 1;
+	work.next = 0;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	for (t = 0; t < threads; t++) {
+		io_ret = pthread_create(&thread[t], &attr, tallyMetricsThread, &work);
+		if (io_ret != 0) {
+			errp(56, __func__, "error on pthread_create()");
+		}
+	}
+	pthread_attr_destroy(&attr);
+	for (t = 0; t < threads; t++) {
+		io_ret = pthread_join(thread[t], &status);
+		if (io_ret != 0) {
+			errp(56, __func__, "error on pthread_join()");
+		}
+	}
+	pthread_mutex_destroy(&mutex);
+	dbg(DBG_MED, "tallied the p_values of all tests with %ld threads", threads);
+
+	return;
+}
+
+
+/*
+ * tallyMetricsThread - tally chunks of p_val rows until no chunk is left
+ *
+ * given:
+ *      work            // pointer to the struct metric_work shared by all threads
+ */
+static void *
+tallyMetricsThread(void *work)
+{
+	struct metric_work *w = (struct metric_work *) work;
+	struct state *state;		// Run state whose p_val arrays are tallied
+	struct metric_tally *tally;	// Tally of the test of the chunk
+	long int *sampleCount;		// Chunk sampleCount of each partition
+	long int *toolow;		// Chunk toolow of each partition
+	long int *freqPerBin;		// Chunk uniformity bins of each partition
+	long int partitions;		// Number of partitions of the test of the chunk
+	long int bins;			// Number of uniformity bins
+	long int start;			// Index in p_val of the first p_value of the chunk
+	long int end;			// Index in p_val beyond the last p_value of the chunk
+	long int j;
+	int test;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (w == NULL) {
+		err(57, __func__, "work arg is NULL");
+	}
+	state = w->state;
+	if (state == NULL) {
+		err(57, __func__, "work->state is NULL");
+	}
+	bins = state->tp.uniformity_bins;
+
+	while (1) {
+
+		/*
+		 * Take the next chunk, moving on to the next test with p_values left
+		 */
+		pthread_mutex_lock(w->mutex);
+		while (w->test <= NUMOFTESTS && (state->tally[w->test] == NULL || w->next >= state->p_val[w->test]->count)) {
+			w->test++;
+			w->next = 0;
+		}
+		if (w->test > NUMOFTESTS) {
+			pthread_mutex_unlock(w->mutex);
+			break;
+		}
+		test = w->test;
+		partitions = state->partitionCount[test];
+		start = w->next;
+		end = MIN(start + METRIC_CHUNK_ROWS * partitions, state->p_val[test]->count);
+		w->next = end;
+		pthread_mutex_unlock(w->mutex);
+
+		/*
+		 * Tally the chunk into counters of its own
+		 */
+		sampleCount = calloc((size_t) partitions, sizeof(long int));
+		toolow = calloc((size_t) partitions, sizeof(long int));
+		freqPerBin = calloc((size_t) (partitions * bins), sizeof(long int));
+		if (sampleCount == NULL || toolow == NULL || freqPerBin == NULL) {
+			errp(57, __func__, "cannot calloc chunk tally of %ld partitions of %ld bins", partitions, bins);
+		}
+		tallyMetricsChunk(state, test, start, end, sampleCount, toolow, freqPerBin);
+
+		/*
+		 * Add the chunk to the tally of the test
+		 */
+		pthread_mutex_lock(w->mutex);
+		tally = state->tally[test];
+		for (j = 0; j < partitions; j++) {
+			tally->sampleCount[j] += sampleCount[j];
+			tally->toolow[j] += toolow[j];
+		}
+		for (j = 0; j < partitions * bins; j++) {
+			tally->freqPerBin[j] += freqPerBin[j];
+		}
+		pthread_mutex_unlock(w->mutex);
+
+		free(sampleCount);
+		free(toolow);
+		free(freqPerBin);
+	}
+
+	return NULL;
+}
+
+
+/*
+ * tallyMetricsChunk - tally the p_values of a chunk of whole p_val rows of a test
+ *
+ * given:
+ *      state           // current processing state
+ *      test            // test whose p_val is tallied
+ *      start           // index in p_val of the first p_value, a multiple of partitionCount[test]
+ *      end             // index in p_val beyond the last p_value
+ *      sampleCount     // zeroized count of sampled p_values of each partition
+ *      toolow          // zeroized count of p_values below alpha of each partition
+ *      freqPerBin      // zeroized uniformity_bins bins of each partition
+ *
+ * The element i of p_val belongs to partition i % partitionCount[test].
+ */
+static void
+tallyMetricsChunk(struct state *state, int test, long int start, long int end,
+		  long int *sampleCount, long int *toolow, long int *freqPerBin)
+{
+	const char *data;		// Elements of p_val
+	size_t elm_size;		// Size of an element of p_val
+	long int partitions;		// Number of partitions of the test
+	long int bins;			// Number of uniformity bins
+	double alpha;			// Significance level
+	bool excursion;			// true ==> test is a form of random excursion
+	double p_value;			// p_value of an iteration
+	long int *bin;			// Uniformity bins of the partition of p_value
+	long int i;
+	long int j;
+
+	data = (const char *) state->p_val[test]->data;
+	elm_size = state->p_val[test]->elm_size;
+	partitions = state->partitionCount[test];
+	bins = state->tp.uniformity_bins;
+	alpha = state->tp.alpha;
+	excursion = state->is_excursion[test];
+
+	for (i = start, j = 0; i < end; i++, j = ((j + 1 == partitions) ? 0 : j + 1)) {
+
+		// Get the iteration p_value, the first member of an element (even of a struct nonover_stats)
+		p_value = *(const double *) (data + i * elm_size);
+		if (p_value == NON_P_VALUE) {
+			continue;	// the test was not possible for this iteration
+		}
+		// Random excursion tests only sample > 0 p_values, all other tests count all p_values
+		if (excursion == true && !(p_value > 0.0)) {
+			continue;
+		}
+		++sampleCount[j];
+
+		// Count the number of p_values below alpha
+		if (p_value < alpha) {
+			++toolow[j];
+		}
+		// Tally the p_value in a uniformity bin
+		bin = freqPerBin + j * bins;
+		if (p_value >= 1.0) {
+			++bin[bins - 1];
+		} else if (p_value >= 0.0) {
+			++bin[(int) floor(p_value * (double) bins)];
+		} else {
+			++bin[0];
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * freeMetricTallies - free the p_value tallies of the metrics phase
+ *
+ * given:
+ *      state           // current processing state
+ */
+void
+freeMetricTallies(struct state *state)
+{
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(56, __func__, "state arg is NULL");
+	}
+
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->tally[i] != NULL) {
+			free(state->tally[i]->sampleCount);
+			free(state->tally[i]->toolow);
+			free(state->tally[i]->freqPerBin);
+			free(state->tally[i]->reservoir);
+			free(state->tally[i]);
+			state->tally[i] = NULL;
+		}
+	}
+
+	return;
+}
+
+
 static void finishMetricTestsSentence(test_metric_result result, struct state *state) {
 	int io_ret;		// I/O return status
 
@@ -1216,6 +1639,10 @@ destroy(struct state *state)
 		free(state->workDir);
 		state->workDir = NULL;
 	}
+	if (state->wisdomFile != NULL && state->wisdomFlag == true) {
+		free(state->wisdomFile);
+		state->wisdomFile = NULL;
+	}
 	if (state->tmpepsilon != NULL) {
 		free(state->tmpepsilon);
 		state->tmpepsilon = NULL;
@@ -1230,6 +1657,17 @@ destroy(struct state *state)
 		free(state->epsilon);
 		state->epsilon = NULL;
 	}
+	if (state->packed_epsilon != NULL) {
+		for (i = 0; i < state->numberOfThreads; i++) {
+			if (state->packed_epsilon[i] != NULL) {
+				free(state->packed_epsilon[i]);
+				state->packed_epsilon[i] = NULL;
+			}
+		}
+		free(state->packed_epsilon);
+		state->packed_epsilon = NULL;
+	}
+	destroyRandomWalk(state);
 	if (state->freqFilePath != NULL) {
 		free(state->freqFilePath);
 		state->freqFilePath = NULL;
@@ -399,6 +399,9 @@ append_array(struct dyn_array *array, void *array_to_add_p, long int total_eleme
 	required_elements_to_allocate = array->chunk *
 			((total_elements_to_add - available_empty_elements + (array->chunk - 1)) / array->chunk);
 	if (available_empty_elements <= total_elements_to_add) {
+		if (required_elements_to_allocate <= 0) {
+			required_elements_to_allocate = array->chunk;	// an exact fit still grows by one chunk
+		}
 		grow_dyn_array(array, required_elements_to_allocate);
 	}
 
@@ -413,6 +416,49 @@ append_array(struct dyn_array *array, void *array_to_add_p, long int total_eleme
 }
 
 
+/*
+ * reserve_dyn_array - make room for a number of elements beyond the ones in use
+ *
+ * given:
+ *      array                   pointer to the dynamic array
+ *      total_elements          number of elements that must fit after array->count
+ *
+ * The allocation grows by exactly the missing number of elements, so that a caller that knows the
+ * final size of the array allocates it once.  The count of elements in use is not changed.
+ *
+ * This function does not return on error.
+ */
+void
+reserve_dyn_array(struct dyn_array *array, long int total_elements)
+{
+	long int missing_elements;
+
+	/*
+	 * Check preconditions (firewall) - sanity check args
+	 */
+	if (array == NULL) {
+		err(65, __func__, "array arg is NULL");
+	}
+	if (total_elements < 0) {
+		err(65, __func__, "total_elements arg must be >= 0: %ld", total_elements);
+	}
+	if (sum_will_overflow_long(array->count, total_elements)) {
+		err(65, __func__, "reserving %ld elements after the %ld in use does not fit in a long int", total_elements,
+		    array->count);
+	}
+
+	/*
+	 * Expand dynamic array if needed
+	 */
+	missing_elements = array->count + total_elements - array->allocated;
+	if (missing_elements > 0) {
+		grow_dyn_array(array, missing_elements);
+	}
+
+	return;
+}
+
+
 /*
  * Free_dyn_array - free a dynamic array
  *
@@ -0,0 +1,810 @@
+/*****************************************************************************
+ D O U B L E   F O R M A T T I N G
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+
+// Exit codes: 250 thru 254
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../utils/externs.h"
+#include "utilities.h"
+#include "fmt_double.h"
+#include "debug.h"
+
+
+/*
+ * IEEE 754 double precision layout
+ */
+#define DOUBLE_MANTISSA_BITS (52)
+#define DOUBLE_EXPONENT_BITS (11)
+#define DOUBLE_BIAS (1023)
+
+/*
+ * Largest magnitude formatted by fixedDouble() without snprintf(), so that value * 10^precision fits in 60 bits
+ */
+#define FIXED_DOUBLE_MAX (1e18)
+
+/*
+ * Number of bits and entries of the tables of powers of 5 of the shortest round-trip format
+ *
+ * See: Ulf Adams, "Ryu: fast float-to-string conversion", PLDI 2018.
+ */
+#define POW5_BITCOUNT (125)
+#define POW5_INV_BITCOUNT (125)
+#define POW5_TABLE_SIZE (326)
+#define POW5_INV_TABLE_SIZE (342)
+
+/*
+ * Number of 32 bit words of the integers used to compute the tables, enough for 2 * 5^(POW5_INV_TABLE_SIZE-1)
+ */
+#define BIG_WORDS (28)
+
+/*
+ * Powers of 10 that fit in 64 bits
+ */
+static const uint64_t pow10_64[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+	10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+	1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+	10000000000000000000ULL
+};
+
+/*
+ * Powers of 5 up to FMT_DOUBLE_MAX_PRECISION
+ */
+static const uint64_t pow5_64[FMT_DOUBLE_MAX_PRECISION + 1] = {
+	1ULL, 5ULL, 25ULL, 125ULL, 625ULL, 3125ULL, 15625ULL, 78125ULL, 390625ULL, 1953125ULL
+};
+
+/*
+ * Tables of the shortest round-trip format, low and high 64 bits of each entry
+ *
+ * pow5_split[i] holds the POW5_BITCOUNT most significant bits of 5^i, and pow5_inv_split[i]
+ * holds 2^(bits(5^i) - 1 + POW5_INV_BITCOUNT) / 5^i + 1.  Both are filled in by initFmtDouble().
+ */
+static uint64_t pow5_split[POW5_TABLE_SIZE][2];
+static uint64_t pow5_inv_split[POW5_INV_TABLE_SIZE][2];
+static bool pow5_tables_ready = false;
+
+
+/*
+ * Forward static function declarations
+ */
+static uint64_t umul128(uint64_t a, uint64_t b, uint64_t *product_hi);
+static uint64_t mulShift64(uint64_t m, const uint64_t *mul, int j);
+static int pow5bits(int e);
+static int log10Pow2(int e);
+static int log10Pow5(int e);
+static bool multipleOfPowerOf5(uint64_t value, int p);
+static int decimalLength17(uint64_t v);
+static int bigBits(const uint32_t *big);
+static bool bigBit(const uint32_t *big, int bit);
+static char *padDouble(char *buf, char *digits, int len, int width);
+
+
+/*
+ * initFmtDouble - compute the tables of the shortest round-trip format of doubles if -x
+ *
+ * given:
+ *      state           // run state to test under
+ *
+ * The tables of powers of 5 and of their inverses are computed exactly, once, before any thread
+ * formats a double with shortestDouble().
+ */
+void
+initFmtDouble(struct state *state)
+{
+	uint32_t pow5[BIG_WORDS];	// 5^i
+	uint32_t rem[BIG_WORDS];	// Remainder of the division of a power of 2 by 5^i
+	uint64_t carry;			// Carry of a multiplication or borrow of a subtraction
+	int len;			// Number of bits of 5^i
+	int shift;			// Number of bits shifted
+	int i;
+	int j;
+	int k;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(250, __func__, "state arg is NULL");
+	}
+
+	/*
+	 * Nothing to do unless -x
+	 */
+	if (state->exactFlag == false || pow5_tables_ready == true) {
+		return;
+	}
+
+	/*
+	 * Compute the tables from each 5^i
+	 */
+	memset(pow5, 0, sizeof(pow5));
+	pow5[0] = 1;
+	for (i = 0; i < POW5_INV_TABLE_SIZE; i++) {
+		len = bigBits(pow5);
+		if (len != pow5bits(i)) {
+			err(250, __func__, "bits of 5^%d: %d != pow5bits(%d): %d", i, len, i, pow5bits(i));
+		}
+
+		/*
+		 * Keep the POW5_BITCOUNT most significant bits of 5^i
+		 */
+		if (i < POW5_TABLE_SIZE) {
+			shift = len - POW5_BITCOUNT;
+			pow5_split[i][0] = 0;
+			pow5_split[i][1] = 0;
+			for (j = 0; j < POW5_BITCOUNT; j++) {
+				if (j + shift >= 0 && bigBit(pow5, j + shift) == true) {
+					pow5_split[i][j / 64] |= (uint64_t) 1 << (j % 64);
+				}
+			}
+		}
+
+		/*
+		 * Divide 2^(len - 1 + POW5_INV_BITCOUNT) by 5^i, one quotient bit at a time
+		 */
+		memset(rem, 0, sizeof(rem));
+		pow5_inv_split[i][0] = 0;
+		pow5_inv_split[i][1] = 0;
+		for (j = len - 1 + POW5_INV_BITCOUNT; j >= 0; j--) {
+
+			/*
+			 * Shift the next bit of the dividend into the remainder
+			 */
+			carry = (j == len - 1 + POW5_INV_BITCOUNT) ? 1 : 0;
+			for (k = 0; k < BIG_WORDS; k++) {
+				uint64_t word = ((uint64_t) rem[k] << 1) | carry;
+				rem[k] = (uint32_t) word;
+				carry = word >> 32;
+			}
+
+			/*
+			 * Subtract 5^i if it fits
+			 */
+			for (k = BIG_WORDS - 1; k > 0 && rem[k] == pow5[k]; k--) {
+			}
+			if (rem[k] >= pow5[k]) {
+				carry = 0;
+				for (k = 0; k < BIG_WORDS; k++) {
+					uint64_t word = (uint64_t) rem[k] - pow5[k] - carry;
+					rem[k] = (uint32_t) word;
+					carry = (word >> 32) & 1;
+				}
+				if (j >= 128) {
+					err(250, __func__, "quotient of the inverse of 5^%d does not fit in 128 bits", i);
+				}
+				pow5_inv_split[i][j / 64] |= (uint64_t) 1 << (j % 64);
+			}
+		}
+		pow5_inv_split[i][0]++;
+		if (pow5_inv_split[i][0] == 0) {
+			pow5_inv_split[i][1]++;
+		}
+
+		/*
+		 * Multiply by 5 for the next power
+		 */
+		carry = 0;
+		for (k = 0; k < BIG_WORDS; k++) {
+			uint64_t word = (uint64_t) pow5[k] * 5 + carry;
+			pow5[k] = (uint32_t) word;
+			carry = word >> 32;
+		}
+		if (carry != 0 || pow5[BIG_WORDS - 1] >= (1U << 30)) {
+			err(250, __func__, "5^%d does not fit in %d words", i + 1, BIG_WORDS);
+		}
+	}
+	pow5_tables_ready = true;
+
+	return;
+}
+
+
+/*
+ * fixedDouble - format a double as with printf("%*.*f", width, precision, value)
+ *
+ * given:
+ *      buf             // buffer of at least FMT_DOUBLE_BUFSIZ bytes
+ *      value           // double to format
+ *      width           // minimum number of characters, padded with leading spaces, 0-FMT_DOUBLE_MAX_WIDTH
+ *      precision       // number of digits after the decimal point, 0-FMT_DOUBLE_MAX_PRECISION
+ *
+ * returns:
+ *      buf, holding the NUL terminated text
+ *
+ * The value is scaled by 10^precision exactly in 128 bit integer arithmetic and rounded to the
+ * nearest integer, ties to even, so the text is the same as the one of the C library in its
+ * default rounding mode.  Values that are not finite or too large are handed to snprintf().
+ */
+char *
+fixedDouble(char *buf, double value, int width, int precision)
+{
+	char digits[FMT_DOUBLE_BUFSIZ];	// Text of the value, built backwards from its end
+	char *p;			// Next character of digits to fill in
+	uint64_t bits;			// IEEE 754 representation of value
+	uint64_t m;			// Mantissa of value
+	int e;				// Binary exponent of value, value == m * 2^e
+	uint64_t lo;			// Low 64 bits of m * 5^precision
+	uint64_t hi;			// High 64 bits of m * 5^precision
+	uint64_t n;			// value * 10^precision, rounded to the nearest integer
+	uint64_t rem_lo;		// Low 64 bits of the bits shifted out of n
+	uint64_t rem_hi;		// High 64 bits of the bits shifted out of n
+	uint64_t half_lo;		// Low 64 bits of half the unit of n
+	uint64_t half_hi;		// High 64 bits of half the unit of n
+	uint64_t int_part;		// Digits before the decimal point
+	uint64_t frac_part;		// Digits after the decimal point
+	int r;				// Number of bits to shift out
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (buf == NULL) {
+		err(251, __func__, "buf arg is NULL");
+	}
+	if (width < 0 || width > FMT_DOUBLE_MAX_WIDTH) {
+		err(251, __func__, "width: %d must be >= 0 and <= %d", width, FMT_DOUBLE_MAX_WIDTH);
+	}
+	if (precision < 0 || precision > FMT_DOUBLE_MAX_PRECISION) {
+		err(251, __func__, "precision: %d must be >= 0 and <= %d", precision, FMT_DOUBLE_MAX_PRECISION);
+	}
+
+	/*
+	 * Leave values that are not finite or too large to the C library
+	 */
+	if (!isfinite(value) || fabs(value) >= FIXED_DOUBLE_MAX / (double) pow10_64[precision]) {
+		snprintf(buf, FMT_DOUBLE_BUFSIZ, "%*.*f", width, precision, value);
+		return buf;
+	}
+
+	/*
+	 * Split value into m * 2^e
+	 */
+	memcpy(&bits, &value, sizeof(bits));
+	m = bits & (((uint64_t) 1 << DOUBLE_MANTISSA_BITS) - 1);
+	e = (int) ((bits >> DOUBLE_MANTISSA_BITS) & ((1 << DOUBLE_EXPONENT_BITS) - 1));
+	if (e == 0) {
+		e = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS;
+	} else {
+		m |= (uint64_t) 1 << DOUBLE_MANTISSA_BITS;
+		e -= DOUBLE_BIAS + DOUBLE_MANTISSA_BITS;
+	}
+
+	/*
+	 * Compute value * 10^precision == (m * 5^precision) * 2^(e + precision), rounded to the nearest integer
+	 */
+	lo = umul128(m, pow5_64[precision], &hi);
+	e += precision;
+	if (e >= 0) {
+		n = lo << e;
+	} else {
+		r = -e;
+		if (r >= 128) {
+			n = 0;
+		} else {
+			if (r < 64) {
+				n = (hi << (64 - r)) | (lo >> r);
+				rem_hi = 0;
+				rem_lo = lo & (((uint64_t) 1 << r) - 1);
+				half_hi = 0;
+				half_lo = (uint64_t) 1 << (r - 1);
+			} else if (r == 64) {
+				n = hi;
+				rem_hi = 0;
+				rem_lo = lo;
+				half_hi = 0;
+				half_lo = (uint64_t) 1 << 63;
+			} else {
+				n = hi >> (r - 64);
+				rem_hi = hi & (((uint64_t) 1 << (r - 64)) - 1);
+				rem_lo = lo;
+				half_hi = (uint64_t) 1 << (r - 65);
+				half_lo = 0;
+			}
+			if (rem_hi > half_hi || (rem_hi == half_hi && rem_lo > half_lo) ||
+			    (rem_hi == half_hi && rem_lo == half_lo && (n & 1) == 1)) {
+				n++;
+			}
+		}
+	}
+
+	/*
+	 * Write the digits backwards from the end of the buffer
+	 */
+	int_part = n / pow10_64[precision];
+	frac_part = n % pow10_64[precision];
+	p = digits + sizeof(digits);
+	for (i = 0; i < precision; i++) {
+		*--p = (char) ('0' + frac_part % 10);
+		frac_part /= 10;
+	}
+	if (precision > 0) {
+		*--p = '.';
+	}
+	do {
+		*--p = (char) ('0' + int_part % 10);
+		int_part /= 10;
+	} while (int_part > 0);
+	if ((bits >> 63) != 0) {
+		*--p = '-';
+	}
+
+	return padDouble(buf, p, (int) (digits + sizeof(digits) - p), width);
+}
+
+
+/*
+ * shortestDouble - format a double with the fewest digits that read back as the same double
+ *
+ * given:
+ *      buf             // buffer of at least FMT_DOUBLE_BUFSIZ bytes
+ *      value           // double to format
+ *
+ * returns:
+ *      buf, holding the NUL terminated text
+ *
+ * The digits are found with the Ryu algorithm (see the POW5_BITCOUNT comment), and are the ones
+ * closest to value among the shortest that strtod() reads back as value.  As with %g, they are
+ * printed in positional notation when the decimal exponent is >= -4 and < 17, and otherwise in
+ * scientific notation with an exponent of at least 2 digits.
+ */
+char *
+shortestDouble(char *buf, double value)
+{
+	char digits[FMT_DOUBLE_BUFSIZ];	// Text of the value
+	char *p;			// Next character of digits to fill in
+	char out[17];			// Shortest digits, most significant first
+	uint64_t bits;			// IEEE 754 representation of value
+	uint64_t ieee_mantissa;		// Mantissa bits of value
+	int ieee_exponent;		// Exponent bits of value
+	int e2;				// Binary exponent of the interval of value
+	uint64_t m2;			// Mantissa of value
+	bool even;			// true ==> the bounds of the interval read back as value
+	uint64_t mv;			// 4 * m2
+	uint32_t mm_shift;		// 1 ==> the lower bound is as close as the upper one
+	uint64_t vr;			// Decimal value, scaled
+	uint64_t vp;			// Decimal upper bound, scaled
+	uint64_t vm;			// Decimal lower bound, scaled
+	int e10;			// Decimal exponent of vr, vp and vm
+	bool vm_trailing_zeros;		// true ==> the digits removed from vm were all zeros
+	bool vr_trailing_zeros;		// true ==> the digits removed from vr were all zeros
+	int removed;			// Number of digits removed
+	int last_removed_digit;		// Last digit removed from vr
+	uint64_t output;		// Shortest digits
+	int olength;			// Number of shortest digits
+	int exp;			// Decimal exponent of the first digit
+	int q;
+	int i;
+	int j;
+	int k;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (buf == NULL) {
+		err(252, __func__, "buf arg is NULL");
+	}
+	if (pow5_tables_ready == false) {
+		err(252, __func__, "initFmtDouble() was not called with -x");
+	}
+
+	/*
+	 * Leave values that are not finite to the C library
+	 */
+	if (!isfinite(value)) {
+		snprintf(buf, FMT_DOUBLE_BUFSIZ, "%f", value);
+		return buf;
+	}
+
+	/*
+	 * Print zeros as 0 or -0
+	 */
+	memcpy(&bits, &value, sizeof(bits));
+	p = digits;
+	if ((bits >> 63) != 0) {
+		*p++ = '-';
+	}
+	ieee_mantissa = bits & (((uint64_t) 1 << DOUBLE_MANTISSA_BITS) - 1);
+	ieee_exponent = (int) ((bits >> DOUBLE_MANTISSA_BITS) & ((1 << DOUBLE_EXPONENT_BITS) - 1));
+	if (ieee_exponent == 0 && ieee_mantissa == 0) {
+		*p++ = '0';
+		return padDouble(buf, digits, (int) (p - digits), 0);
+	}
+
+	/*
+	 * Find the interval of the reals that round to value, scaled by 4 to keep its bounds integers
+	 */
+	if (ieee_exponent == 0) {
+		e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+		m2 = ieee_mantissa;
+	} else {
+		e2 = ieee_exponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+		m2 = ((uint64_t) 1 << DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+	}
+	even = (m2 & 1) == 0;
+	mv = 4 * m2;
+	mm_shift = (ieee_mantissa != 0 || ieee_exponent <= 1) ? 1 : 0;
+
+	/*
+	 * Convert the interval to decimal, keeping track of whether the digits dropped were all zeros
+	 */
+	vm_trailing_zeros = false;
+	vr_trailing_zeros = false;
+	if (e2 >= 0) {
+		q = log10Pow2(e2) - (e2 > 3 ? 1 : 0);
+		e10 = q;
+		k = POW5_INV_BITCOUNT + pow5bits(q) - 1;
+		i = -e2 + q + k;
+		vr = mulShift64(4 * m2, pow5_inv_split[q], i);
+		vp = mulShift64(4 * m2 + 2, pow5_inv_split[q], i);
+		vm = mulShift64(4 * m2 - 1 - mm_shift, pow5_inv_split[q], i);
+		if (q <= 21) {
+			if (mv % 5 == 0) {
+				vr_trailing_zeros = multipleOfPowerOf5(mv, q);
+			} else if (even == true) {
+				vm_trailing_zeros = multipleOfPowerOf5(mv - 1 - mm_shift, q);
+			} else {
+				vp -= multipleOfPowerOf5(mv + 2, q) ? 1 : 0;
+			}
+		}
+	} else {
+		q = log10Pow5(-e2) - (-e2 > 1 ? 1 : 0);
+		e10 = q + e2;
+		i = -e2 - q;
+		k = pow5bits(i) - POW5_BITCOUNT;
+		j = q - k;
+		vr = mulShift64(4 * m2, pow5_split[i], j);
+		vp = mulShift64(4 * m2 + 2, pow5_split[i], j);
+		vm = mulShift64(4 * m2 - 1 - mm_shift, pow5_split[i], j);
+		if (q <= 1) {
+			vr_trailing_zeros = true;
+			if (even == true) {
+				vm_trailing_zeros = (mm_shift == 1);
+			} else {
+				--vp;
+			}
+		} else if (q < 63) {
+			vr_trailing_zeros = (mv & (((uint64_t) 1 << q) - 1)) == 0;
+		}
+	}
+
+	/*
+	 * Remove the digits that vp and vm do not need to tell apart, then round vr
+	 */
+	removed = 0;
+	last_removed_digit = 0;
+	if (vm_trailing_zeros == true || vr_trailing_zeros == true) {
+		while (vp / 10 > vm / 10) {
+			vm_trailing_zeros &= (vm % 10 == 0);
+			vr_trailing_zeros &= (last_removed_digit == 0);
+			last_removed_digit = (int) (vr % 10);
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			++removed;
+		}
+		if (vm_trailing_zeros == true) {
+			while (vm % 10 == 0) {
+				vr_trailing_zeros &= (last_removed_digit == 0);
+				last_removed_digit = (int) (vr % 10);
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+		}
+		if (vr_trailing_zeros == true && last_removed_digit == 5 && vr % 2 == 0) {
+			last_removed_digit = 4;	// Round ties to even
+		}
+		output = vr + (((vr == vm && (even == false || vm_trailing_zeros == false)) || last_removed_digit >= 5) ? 1 : 0);
+	} else {
+		bool round_up = false;	// true ==> the last digit removed from vr was >= 5
+		while (vp / 10 > vm / 10) {
+			round_up = (vr % 10 >= 5);
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			++removed;
+		}
+		output = vr + ((vr == vm || round_up == true) ? 1 : 0);
+	}
+	olength = decimalLength17(output);
+	exp = e10 + removed + olength - 1;
+	for (i = olength - 1; i >= 0; i--) {
+		out[i] = (char) ('0' + output % 10);
+		output /= 10;
+	}
+
+	/*
+	 * Print the digits in positional notation
+	 */
+	if (exp >= -4 && exp < 17) {
+		if (exp < 0) {
+			*p++ = '0';
+			*p++ = '.';
+			for (i = -1; i > exp; i--) {
+				*p++ = '0';
+			}
+		}
+		for (i = 0; i < olength; i++) {
+			*p++ = out[i];
+			if (i == exp && i < olength - 1) {
+				*p++ = '.';
+			}
+		}
+		for (i = olength - 1; i < exp; i++) {
+			*p++ = '0';
+		}
+
+	/*
+	 * Print the digits in scientific notation
+	 */
+	} else {
+		for (i = 0; i < olength; i++) {
+			*p++ = out[i];
+			if (i == 0 && olength > 1) {
+				*p++ = '.';
+			}
+		}
+		p += sprintf(p, "e%c%02d", (exp < 0) ? '-' : '+', abs(exp));
+	}
+
+	return padDouble(buf, digits, (int) (p - digits), 0);
+}
+
+
+/*
+ * formatDouble - format a double of the stats.txt, results.txt or data*.txt files
+ *
+ * given:
+ *      buf             // buffer of at least FMT_DOUBLE_BUFSIZ bytes
+ *      state           // run state to test under
+ *      value           // double to format
+ *      width           // minimum number of characters, padded with leading spaces, 0-FMT_DOUBLE_MAX_WIDTH
+ *
+ * returns:
+ *      buf, holding the NUL terminated text
+ *
+ * Doubles are printed as with %*.6f, or with -x in the shortest round-trip format.  With -x, a double
+ * wider than a non-zero width is preceded by a space, so that it is not run into a previous column.
+ */
+char *
+formatDouble(char *buf, struct state *state, double value, int width)
+{
+	char digits[FMT_DOUBLE_BUFSIZ];	// Shortest round-trip text of the value
+	int len;			// Length of digits
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (buf == NULL) {
+		err(253, __func__, "buf arg is NULL");
+	}
+	if (state == NULL) {
+		err(253, __func__, "state arg is NULL");
+	}
+	if (width < 0 || width > FMT_DOUBLE_MAX_WIDTH) {
+		err(253, __func__, "width: %d must be >= 0 and <= %d", width, FMT_DOUBLE_MAX_WIDTH);
+	}
+
+	/*
+	 * Format the value in the format of this run
+	 */
+	if (state->exactFlag == false) {
+		return fixedDouble(buf, value, width, FMT_DOUBLE_PRECISION);
+	}
+	len = (int) strlen(shortestDouble(digits, value));
+	if (width > 0 && len >= width) {
+		width = len + 1;
+	}
+
+	return padDouble(buf, digits, len, width);
+}
+
+
+/*
+ * umul128 - multiply two 64 bit integers into a 128 bit product
+ *
+ * given:
+ *      a               // first factor
+ *      b               // second factor
+ *      product_hi      // where to store the high 64 bits of the product
+ *
+ * returns:
+ *      low 64 bits of the product
+ */
+static uint64_t
+umul128(uint64_t a, uint64_t b, uint64_t *product_hi)
+{
+	uint64_t a_lo = (uint32_t) a;
+	uint64_t a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t) b;
+	uint64_t b_hi = b >> 32;
+	uint64_t b00 = a_lo * b_lo;
+	uint64_t b01 = a_lo * b_hi;
+	uint64_t b10 = a_hi * b_lo;
+	uint64_t b11 = a_hi * b_hi;
+	uint64_t mid1 = b10 + (b00 >> 32);
+	uint64_t mid2 = b01 + (uint32_t) mid1;
+
+	*product_hi = b11 + (mid1 >> 32) + (mid2 >> 32);
+	return (mid2 << 32) | (uint32_t) b00;
+}
+
+
+/*
+ * mulShift64 - multiply by a 128 bit table entry and shift right
+ *
+ * given:
+ *      m               // 64 bit factor
+ *      mul             // low and high 64 bits of the 128 bit factor
+ *      j               // number of bits to shift the product right, 65-127
+ *
+ * returns:
+ *      (m * mul) >> j
+ */
+static uint64_t
+mulShift64(uint64_t m, const uint64_t *mul, int j)
+{
+	uint64_t high0;			// High 64 bits of m * mul[0]
+	uint64_t high1;			// High 64 bits of m * mul[1]
+	uint64_t low1;			// Low 64 bits of m * mul[1]
+	uint64_t sum;			// Bits 64 thru 127 of m * mul
+
+	umul128(m, mul[0], &high0);
+	low1 = umul128(m, mul[1], &high1);
+	sum = high0 + low1;
+	if (sum < high0) {
+		++high1;
+	}
+
+	return (high1 << (128 - j)) | (sum >> (j - 64));
+}
+
+
+/*
+ * pow5bits - number of bits of 5^e, for 0 <= e <= 3528
+ */
+static int
+pow5bits(int e)
+{
+	return (int) (((uint32_t) e * 1217359) >> 19) + 1;
+}
+
+
+/*
+ * log10Pow2 - floor(log10(2^e)), for 0 <= e <= 1650
+ */
+static int
+log10Pow2(int e)
+{
+	return (int) (((uint32_t) e * 78913) >> 18);
+}
+
+
+/*
+ * log10Pow5 - floor(log10(5^e)), for 0 <= e <= 2620
+ */
+static int
+log10Pow5(int e)
+{
+	return (int) (((uint32_t) e * 732923) >> 20);
+}
+
+
+/*
+ * multipleOfPowerOf5 - determine if a value is a multiple of 5^p
+ */
+static bool
+multipleOfPowerOf5(uint64_t value, int p)
+{
+	int count = 0;			// Number of factors of 5 of value
+
+	while (value % 5 == 0 && count < p) {
+		value /= 5;
+		count++;
+	}
+
+	return count >= p;
+}
+
+
+/*
+ * decimalLength17 - number of decimal digits of a value < 10^17
+ */
+static int
+decimalLength17(uint64_t v)
+{
+	int len = 1;			// Number of digits
+
+	while (len < 17 && v >= pow10_64[len]) {
+		len++;
+	}
+
+	return len;
+}
+
+
+/*
+ * bigBits - number of bits of a BIG_WORDS words integer
+ */
+static int
+bigBits(const uint32_t *big)
+{
+	int k;
+	int bits;
+
+	for (k = BIG_WORDS - 1; k > 0 && big[k] == 0; k--) {
+	}
+	for (bits = 32 * k; bits < 32 * (k + 1) && (big[k] >> (bits - 32 * k)) != 0; bits++) {
+	}
+
+	return bits;
+}
+
+
+/*
+ * bigBit - determine if a bit of a BIG_WORDS words integer is set
+ */
+static bool
+bigBit(const uint32_t *big, int bit)
+{
+	if (bit >= 32 * BIG_WORDS) {
+		return false;
+	}
+
+	return ((big[bit / 32] >> (bit % 32)) & 1) != 0;
+}
+
+
+/*
+ * padDouble - copy the text of a double into buf, padded with leading spaces to width
+ *
+ * given:
+ *      buf             // buffer of at least FMT_DOUBLE_BUFSIZ bytes
+ *      digits          // text of the double, not NUL terminated
+ *      len             // length of the text
+ *      width           // minimum number of characters
+ *
+ * returns:
+ *      buf, holding the NUL terminated text
+ */
+static char *
+padDouble(char *buf, char *digits, int len, int width)
+{
+	int pad = (width > len) ? width - len : 0;	// Number of leading spaces
+
+	memset(buf, ' ', (size_t) pad);
+	memcpy(buf + pad, digits, (size_t) len);
+	buf[pad + len] = '\0';
+
+	return buf;
+}
@@ -0,0 +1,55 @@
+/*****************************************************************************
+     D O U B L E   F O R M A T T I N G   F U N C T I O N   P R O T O T Y P E S
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+#ifndef _FMT_DOUBLE_H_
+#   define _FMT_DOUBLE_H_
+
+#   include <float.h>
+#   include "../utils/defs.h"
+
+/*
+ * Largest width and precision of a formatted double
+ */
+#   define FMT_DOUBLE_MAX_WIDTH (32)
+#   define FMT_DOUBLE_MAX_PRECISION (9)
+
+/*
+ * Size of a buffer large enough for any formatted double, such as DBL_MAX printed with %.9f
+ */
+#   define FMT_DOUBLE_BUFSIZ (1 + DBL_MAX_10_EXP + 1 + 1 + FMT_DOUBLE_MAX_PRECISION + FMT_DOUBLE_MAX_WIDTH + 1)
+
+/*
+ * Precision of the doubles in the stats.txt, results.txt and data*.txt files, as with %f
+ */
+#   define FMT_DOUBLE_PRECISION (6)
+
+extern void initFmtDouble(struct state *state);
+extern char *fixedDouble(char *buf, double value, int width, int precision);
+extern char *shortestDouble(char *buf, double value);
+extern char *formatDouble(char *buf, struct state *state, double value, int width);
+
+#endif				/* _FMT_DOUBLE_H_ */
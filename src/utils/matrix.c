@@ -35,148 +35,110 @@
 #include "debug.h"
 
 
-#define	MATRIX_FORWARD_ELIMINATION	0
-#define	MATRIX_BACKWARD_ELIMINATION	1
-
-// static declaratione
-static void perform_elementary_row_operations(int flag, int i, int M, int Q, BitSequence ** A);
-static int find_unit_element_and_swap(int flag, int i, int M, int Q, BitSequence ** A);
-static int swap_rows(int index_first_row, int index_second_row, int Q, BitSequence ** A);
-static int determine_rank(int m, int M, int Q, BitSequence ** A);
+/*
+ * Static function declarations
+ */
+static int computeRankScalar(int M, WORD64 *matrix, int stride);
+static void computeRankBatch(int M, WORD64 *matrices, int *ranks);
 
 
-int
-computeRank(int M, int Q, BitSequence **matrix)
+/*
+ * computeRank - compute the rank over GF(2) of up to LANES_RANK matrices stored one row per word
+ *
+ * given:
+ *      M               // Number of rows in each matrix
+ *      Q               // Number of columns in each row of each matrix (must be <= MAX_NUMBER_OF_COLS_RANK)
+ *      matrices        // count interleaved matrices: row i of matrix l is matrices[i * count + l],
+ *                      // where bit j is the element in row i and column j
+ *      count           // number of matrices, 1 <= count <= LANES_RANK
+ *      ranks           // array of count ints where the rank of each matrix is returned
+ *
+ * NOTE: The content of the matrices is destroyed by this function.
+ *
+ * A full set of LANES_RANK matrices is reduced by the batched kernel, any fewer matrices
+ * one at a time by the scalar kernel.  Both return the same ranks.
+ */
+void
+computeRank(int M, int Q, WORD64 *matrices, int count, int *ranks)
 {
-	int i;
-	int rank;
-	int m = MIN(M, Q);
+	int l;
 
 	/*
-	 * Forward application of elementary row operations
+	 * Check preconditions (firewall)
 	 */
-	for (i = 0; i < m - 1; i++) {
-		if (matrix[i][i] == 1) {
-			perform_elementary_row_operations(MATRIX_FORWARD_ELIMINATION, i, M, Q, matrix);
-		} else if (matrix[i][i] == 0) {
-			if (find_unit_element_and_swap(MATRIX_FORWARD_ELIMINATION, i, M, Q, matrix) == 1) {
-				perform_elementary_row_operations(MATRIX_FORWARD_ELIMINATION, i, M, Q, matrix);
-			}
-		} else {
-			err(122, __func__, "matrix[%d][%d] == %u (should contain 1 or 0).", i, i, matrix[i][i]);
-		}
+	if (matrices == NULL) {
+		err(122, __func__, "matrices arg is NULL");
 	}
-
-	/*
-	 * Backward application of elementary row operations
-	 */
-	for (i = m - 1; i > 0; i--) {
-		if (matrix[i][i] == 1) {
-			perform_elementary_row_operations(MATRIX_BACKWARD_ELIMINATION, i, M, Q, matrix);
-		} else if (matrix[i][i] == 0) {
-			if (find_unit_element_and_swap(MATRIX_BACKWARD_ELIMINATION, i, M, Q, matrix) == 1) {
-				perform_elementary_row_operations(MATRIX_BACKWARD_ELIMINATION, i, M, Q, matrix);
-			}
-		} else {
-			err(122, __func__, "matrix[%d][%d] == %u (should contain 1 or 0).", i, i, matrix[i][i]);
-		}
+	if (ranks == NULL) {
+		err(122, __func__, "ranks arg is NULL");
 	}
-
-	rank = determine_rank(m, M, Q, matrix);
-
-	return rank;
-}
-
-static void
-perform_elementary_row_operations(int flag, int i, int M, int Q, BitSequence ** A)
-{
-	int j;
-	int k;
-
-	if (flag == MATRIX_FORWARD_ELIMINATION) {
-		for (j = i + 1; j < M; j++) {
-			if (A[j][i] == 1) {
-				for (k = i; k < Q; k++) {
-					A[j][k] = (BitSequence) ((A[j][k] + A[i][k]) % 2);
-				}
-			}
-		}
-	} else {
-		for (j = i - 1; j >= 0; j--) {
-			if (A[j][i] == 1) {
-				for (k = 0; k < Q; k++) {
-					A[j][k] = (BitSequence) ((A[j][k] + A[i][k]) % 2);
-				}
-			}
-		}
+	if (M <= 0) {
+		err(122, __func__, "number of rows: %d must be > 0", M);
+	}
+	if (Q <= 0 || Q > MAX_NUMBER_OF_COLS_RANK) {
+		err(122, __func__, "number of columns per row: %d must be > 0 and <= %d", Q, MAX_NUMBER_OF_COLS_RANK);
+	}
+	if (count <= 0 || count > LANES_RANK) {
+		err(122, __func__, "number of matrices: %d must be > 0 and <= %d", count, LANES_RANK);
 	}
-}
-
-static int
-find_unit_element_and_swap(int flag, int i, int M, int Q, BitSequence ** A)
-{
-	int index;
-	int row_op = 0;
 
-	if (flag == MATRIX_FORWARD_ELIMINATION) {
-		index = i + 1;
-		while ((index < M) && (A[index][i] == 0)) {
-			index++;
-		}
-		if (index < M) {
-			row_op = swap_rows(i, index, Q, A);
-		}
+	/*
+	 * Select the kernel
+	 */
+	if (count == LANES_RANK) {
+		computeRankBatch(M, matrices, ranks);
 	} else {
-		index = i - 1;
-		while ((index >= 0) && (A[index][i] == 0)) {
-			index--;
-		}
-		if (index >= 0) {
-			row_op = swap_rows(i, index, Q, A);
+		for (l = 0; l < count; l++) {
+			ranks[l] = computeRankScalar(M, matrices + l, count);
 		}
 	}
 
-	return row_op;
+	return;
 }
 
-static int
-swap_rows(int index_first_row, int index_second_row, int Q, BitSequence ** A)
-{
-	int p;
-	BitSequence temp;
-
-	for (p = 0; p < Q; p++) {
-		temp = A[index_first_row][p];
-		A[index_first_row][p] = A[index_second_row][p];
-		A[index_second_row][p] = temp;
-	}
-
-	return 1;
-}
 
+/*
+ * computeRankScalar - compute the rank over GF(2) of a single matrix
+ *
+ * given:
+ *      M       // Number of rows in the matrix
+ *      matrix  // matrix of M rows, where row i is matrix[i * stride]
+ *      stride  // distance between two consecutive rows of matrix
+ *
+ * returns:
+ *      the rank of the matrix
+ *
+ * The rank is computed by Gaussian elimination applied to whole rows at a time:
+ * each non-zero row is a pivot row and its lowest set bit is the pivot column.
+ * The pivot row is XORed into every following row that has a 1 in the pivot column,
+ * so that the pivot column is cleared in all the following rows.  A row that is
+ * reduced to zero is linearly dependent on the rows above it.  The rank is the number
+ * of pivot rows, hence no backward elimination and no row swapping is needed.
+ */
 static int
-determine_rank(int m, int M, int Q, BitSequence ** A)
+computeRankScalar(int M, WORD64 *matrix, int stride)
 {
+	WORD64 pivot;		// Pivot row
+	WORD64 pivot_bit;	// Bit of the pivot column in the pivot row
+	WORD64 mask;		// All 1s if the row has to be reduced, 0 otherwise
+	int rank;		// Rank of the matrix
 	int i;
 	int j;
-	int rank;
-	int allZeroes;
 
 	/*
-	 * DETERMINE RANK, THAT IS, COUNT THE NUMBER OF NONZERO ROWS
+	 * Forward elimination, one row at a time
 	 */
-
-	rank = m;
+	rank = 0;
 	for (i = 0; i < M; i++) {
-		allZeroes = 1;
-		for (j = 0; j < Q; j++) {
-			if (A[i][j] == 1) {
-				allZeroes = 0;
-				break;
-			}
+		pivot = matrix[(long int) i * stride];
+		if (pivot == 0) {
+			continue;
 		}
-		if (allZeroes == 1) {
-			rank--;
+		rank++;
+		pivot_bit = pivot & (~pivot + 1);	// lowest set bit of the pivot row
+		for (j = i + 1; j < M; j++) {
+			mask = (WORD64) 0 - ((matrix[(long int) j * stride] & pivot_bit) != 0);
+			matrix[(long int) j * stride] ^= pivot & mask;
 		}
 	}
 
@@ -185,105 +147,121 @@ determine_rank(int m, int M, int Q, BitSequence ** A)
 
 
 /*
- * create_matrix - allocate a 2D matrix of BitSequence values
+ * computeRankBatch - compute the rank over GF(2) of LANES_RANK matrices at once
  *
  * given:
- *      M       // Number of rows in the matrix
- *      Q       // Number of columns in each matrix row
+ *      M               // Number of rows in each matrix
+ *      matrices        // LANES_RANK interleaved matrices: row i of matrix l is matrices[i * LANES_RANK + l]
+ *      ranks           // array of LANES_RANK ints where the rank of each matrix is returned
  *
- * returns:
- *      An allocated 2D matrix of BitSequence values.
- *
- * NOTE: This function does NOT return on error.
- *
- * NOTE: Unlike older versions of this function, create_matrix()
- *       does not zeroize the matrix.
+ * This performs the same elimination as computeRankScalar() on LANES_RANK matrices (lanes)
+ * in lock step.  Each lane selects its own pivot column: a lane whose row is zero has
+ * no pivot bit and so its mask is 0, which leaves the following rows of that lane
+ * unchanged.  Since no lane branches, the loops over the lanes are free of any
+ * data dependent control flow and are suitable for vectorization by the compiler.
  */
-BitSequence **
-create_matrix(int M, int Q)
+static void
+computeRankBatch(int M, WORD64 *matrices, int *ranks)
 {
-	BitSequence **matrix;	// matrix top return
+	WORD64 pivot[LANES_RANK];	// Pivot row of each lane
+	WORD64 pivot_bit[LANES_RANK];	// Bit of the pivot column in the pivot row of each lane
+	WORD64 *row;			// Current row of each lane
+	WORD64 *next;			// Row of each lane to reduce with the pivot row
 	int i;
+	int j;
+	int l;
 
-	/*
-	 * Check preconditions (firewall)
-	 */
-	if (M < 0) {
-		err(120, __func__, "number of rows: %d must be > 0", M);
-	}
-	if (Q < 0) {
-		err(120, __func__, "number of columns per rows: %d must be > 0", Q);
-	}
-
-	/*
-	 * Allocate array of matrix rows
-	 */
-	matrix = malloc(M * sizeof(matrix[0]));
-	if (matrix == NULL) {
-		errp(120, __func__, "cannot malloc of %ld elements of %ld bytes each for matrix rows",
-		     (long int) M, sizeof(BitSequence *));
+	for (l = 0; l < LANES_RANK; l++) {
+		ranks[l] = 0;
 	}
 
 	/*
-	 * Allocate the columns for each matrix row
+	 * Forward elimination, one row of all lanes at a time
 	 */
 	for (i = 0; i < M; i++) {
-		matrix[i] = malloc(Q * sizeof(matrix[0][0]));
-		if (matrix[i] == NULL) {
-			errp(120, __func__, "cannot malloc of %ld elements of %ld bytes each for matrix[%d] column",
-			     (long int) Q, sizeof(BitSequence), i);
+		row = matrices + (long int) i * LANES_RANK;
+		for (l = 0; l < LANES_RANK; l++) {
+			pivot[l] = row[l];
+			pivot_bit[l] = pivot[l] & (~pivot[l] + 1);	// lowest set bit, 0 if the row is zero
+			ranks[l] += (pivot[l] != 0);
+		}
+		for (j = i + 1; j < M; j++) {
+			next = matrices + (long int) j * LANES_RANK;
+			for (l = 0; l < LANES_RANK; l++) {
+				next[l] ^= pivot[l] & ((WORD64) 0 - ((next[l] & pivot_bit[l]) != 0));
+			}
 		}
 	}
 
-	return matrix;
+	return;
 }
 
 
 /*
- * def_matrix - fills the given matrix m with consecutive bits from the sequence.
- *              MUST be called after create_matrix function has allocated memory for m.
+ * def_matrix - fills the given matrix m with consecutive bits from the packed sequence
  *
  * given:
  *      M       // Number of rows in the matrix m
- *      Q       // Number of columns in each row of the matrix m
- *      m       // allocated 2D matrix of BitSequence values
+ *      Q       // Number of columns in each row of the matrix m (must be <= MAX_NUMBER_OF_COLS_RANK)
+ *      m       // allocated matrix of M rows
+ *      stride  // distance between two consecutive rows of m (1 unless the matrices are interleaved)
  *      k       // offset for the bits to copy to this matrix (counts the matrices that were already filled)
+ *
+ * Bit j of m[i * stride] is set to bit (k * M * Q + i * Q + j) of the bit stream.
  */
 void
-def_matrix(struct thread_state *thread_state, int M, int Q, BitSequence ** m, long int k)
+def_matrix(struct thread_state *thread_state, int M, int Q, WORD64 *m, int stride, long int k)
 {
+	WORD64 *packed;		// Packed bit stream of this thread
+	WORD64 row;		// Row being extracted
+	WORD64 row_mask;	// Mask of the Q bits of a row
+	long int pos;		// Position in the bit stream of the first bit of the row
+	long int word;		// Index of the word that holds the first bit of the row
+	int shift;		// Position within its word of the first bit of the row
 	int i;
-	int j;
 
 	/*
 	 * Check preconditions (firewall)
 	 */
 	if (thread_state == NULL) {
-		err(225, __func__, "thread_state arg is NULL");
+		err(121, __func__, "thread_state arg is NULL");
 	}
 	struct state *state = thread_state->global_state;
 	if (state == NULL) {
 		err(121, __func__, "state arg is NULL");
 	}
-	if (state->epsilon == NULL) {
-		err(121, __func__, "state->epsilon is NULL");
+	if (state->packed_epsilon == NULL) {
+		err(121, __func__, "state->packed_epsilon is NULL");
 	}
-	if (state->epsilon[thread_state->thread_id] == NULL) {
-		err(151, __func__, "state->epsilon[%ld] is NULL", thread_state->thread_id);
+	if (state->packed_epsilon[thread_state->thread_id] == NULL) {
+		err(121, __func__, "state->packed_epsilon[%ld] is NULL", thread_state->thread_id);
 	}
-	if (M < 0) {
+	if (m == NULL) {
+		err(121, __func__, "m arg is NULL");
+	}
+	if (M <= 0) {
 		err(121, __func__, "number of rows: %d must be > 0", M);
 	}
-	if (Q < 0) {
-		err(121, __func__, "number of columns per rows: %d must be > 0", Q);
+	if (Q <= 0 || Q > MAX_NUMBER_OF_COLS_RANK) {
+		err(121, __func__, "number of columns per row: %d must be > 0 and <= %d", Q, MAX_NUMBER_OF_COLS_RANK);
+	}
+	if (stride <= 0) {
+		err(121, __func__, "stride: %d must be > 0", stride);
 	}
 	if (k < 0) {
-		err(121, __func__, "offset for the values to copy from the sequence to to m: %d must be > 0", Q);
+		err(121, __func__, "offset for the values to copy from the sequence to m: %ld must be >= 0", k);
 	}
+	packed = state->packed_epsilon[thread_state->thread_id];
+	row_mask = (Q == (int) BITS_N_WORD64) ? ~(WORD64) 0 : ((WORD64) 1 << Q) - 1;
 
 	for (i = 0; i < M; i++) {
-		for (j = 0; j < Q; j++) {
-			m[i][j] = state->epsilon[thread_state->thread_id][k * (M * Q) + j + i * M];
+		pos = k * M * Q + (long int) i * Q;
+		word = pos / BITS_N_WORD64;
+		shift = (int) (pos % BITS_N_WORD64);
+		row = packed[word] >> shift;
+		if (shift + Q > (int) BITS_N_WORD64) {
+			row |= packed[word + 1] << (BITS_N_WORD64 - shift);
 		}
+		m[(long int) i * stride] = row & row_mask;
 	}
 }
@@ -30,8 +30,7 @@
 
 #include "../utils/defs.h"
 
-extern int computeRank(int M, int Q, BitSequence ** matrix);
-extern BitSequence **create_matrix(int M, int Q);
-extern void def_matrix(struct thread_state *thread_state, int M, int Q, BitSequence ** m, long int k);
+extern void computeRank(int M, int Q, WORD64 *matrices, int count, int *ranks);
+extern void def_matrix(struct thread_state *thread_state, int M, int Q, WORD64 *m, int stride, long int k);
 
 #endif				/* MATRIX_H */
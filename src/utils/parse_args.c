@@ -88,6 +88,9 @@ static struct state const defaultstate = {
 	// resultstxtFlag
 	false,				// No -s, don't create results.txt, data*.txt and stats.txt files
 
+	// exactFlag
+	false,				// No -x, print doubles as with %f
+
 	// randomDataArg & randomDataPath
 	false,				// no randdata arg was given
 	"/dev/null",			// default input file is /dev/null
@@ -101,16 +104,34 @@ static struct state const defaultstate = {
 	false,
 	0,
 	0,
+	0,
 
-	// jobnumFlag, jobnum & base_seek
+	// jobnumFlag, jobnum, base_seek & firstIteration
 	false,				// No -j jobnum was given
 	0,				// Begin at start of randdata (-j 0)
 	0,				// Default seek to 0
+	0,				// First iteration set by init()
 
 	// pvalues_dir & filenames
 	NULL,				// Directory where to look for the .pvalues binary files
 	NULL,				// Names of the .pvalues files
 
+	// wisdomFlag & wisdomFile
+	false,				// No -W wisdomFile was given
+	NULL,				// Use the default FFTW wisdom file
+
+	// dftBatchFlag & dftBatch
+	false,				// No -B dftBatch was given
+	1,				// Transform one bitstream at a time
+
+	// aggregateFlag & reservoirSize
+	false,				// No -G samples was given
+	0,				// Do not sample p_values
+
+	// shardWorkersFlag & shardWorkers
+	false,				// No -K workers was given
+	0,				// Test all iterations in this process
+
 	// tp, promptFlag, uniformityBinsFlag
 	{DEFAULT_BLOCK_FREQUENCY,	// -P 1=M, Block Frequency Test - block length
 	 DEFAULT_NON_OVERLAPPING,	// -P 2=m, NonOverlapping Template Test - block length
@@ -123,6 +144,7 @@ static struct state const defaultstate = {
 	 DEFAULT_BITCOUNT,		// -P 9=bitcount, Length of a single bit stream
 	 DEFAULT_UNIFORMITY_LEVEL,	// -P 10=uni_level, uniformity errors have values below this
 	 DEFAULT_ALPHA,			// -P 11=alpha, p_value significance level
+	 DEFAULT_RANK,			// -P 12=M, Rank Test - rows and columns of each matrix
 	},
 	false,				// Do not prompt for change of parameters
 	false,				// No -P 8 was given with custom uniformity bins
@@ -189,10 +211,13 @@ static struct state const defaultstate = {
 	 NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	},
 
-	// stats, p_val - per test dynamic arrays
+	// stats_txt, p_val - stats.txt writer and per test dynamic arrays
+	NULL,
 	{NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	 NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	},
+
+	// tally
 	{NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	 NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	},
@@ -202,7 +227,9 @@ static struct state const defaultstate = {
 	 false, false, false, false, true, true, false, false,
 	},
 
-	// epsilon, tmpepsilon
+	// epsilon, tmpepsilon, packed_epsilon, random_walk
+	NULL,
+	NULL,
 	NULL,
 	NULL,
 
@@ -238,12 +265,12 @@ static struct state const defaultstate = {
 	// nonovTemplates
 	NULL,
 
-	// fft_m, fft_X
-	NULL,
+	// fft_X
 	NULL,
 
 # if defined(LEGACY_FFT)
-	// fft_wsave
+	// fft_wsave, fft_sub
+	NULL,
 	NULL,
 #else /* LEGACY_FFT */
 	// fftw_p and fftw_out
@@ -251,14 +278,18 @@ static struct state const defaultstate = {
 	NULL,
 #endif /* LEGACY_FFT */
 
-	// rank_matrix
+	// fft_fill, fft_iteration
+	NULL,
 	NULL,
 
-	// rnd_excursion_var_stateX, ex_var_partial_sums
+	// rank_matrix
 	NULL,
+
+	// rnd_excursion_var_stateX
 	NULL,
 
-	// linear_b, linear_c, linear_t
+	// linear_b, linear_c, linear_t, linear_s
+	NULL,
 	NULL,
 	NULL,
 	NULL,
@@ -274,13 +305,13 @@ static struct state const defaultstate = {
 	// nonper_seq
 	NULL,
 
-	// universal_L, universal_T
+	// universal_L, universal_T, universal_log2, universal_log2_len
 	0,
 	0,
-
-	// rnd_excursion_S, rnd_excursion_cycle, rnd_excursion_stateX, rnd_excursion_pi_terms
-	NULL,
 	NULL,
+	0,
+
+	// rnd_excursion_stateX, rnd_excursion_pi_terms
 	NULL,
 	NULL,
 
@@ -297,8 +328,9 @@ static struct state const defaultstate = {
 static const char * const usage =
 "[-v level] [-A] [-t test1[,test2]..]\n"
 "             [-P num=value[,num=value]..] [-i iterations] [-I reportCycle] [-O]\n"
-"             [-w workDir] [-c] [-s] [-F format] [-j jobnum] [-S bitcount]\n"
-"             [-m mode] [-T numOfThreads] [-d pvaluesdir] [-h] [randdata]\n"
+"             [-w workDir] [-c] [-s] [-x] [-F format] [-j jobnum] [-S bitcount]\n"
+"             [-m mode] [-T numOfThreads] [-d pvaluesdir] [-W wisdomFile]\n"
+"             [-B dftBatch] [-G samples] [-K workers] [-h] [randdata]\n"
 "\n"
 "    -v  debuglevel     debug level (def: 0 -> no debug messages)\n"
 "    -A                 ask a human what to do, use obsolete interactive mode (def: batch mode)\n"
@@ -328,6 +360,7 @@ static const char * const usage =
 "       9: Bits to process per iteration (same as -S bitcount):	1048576 (== 1024*1024)\n"
 "      10: Uniformity Cutoff Level:				0.0001\n"
 "      11: Alpha Confidence Level:				0.01\n"
+"      12: Rank Test - rows and columns of each matrix(M):	32 (2 to 64)\n"
 "      Warning: Change the above parameters only if you really know what you are doing!\n";
 static const char * const usage2 =
 "\n"
@@ -339,6 +372,8 @@ static const char * const usage2 =
 "    -w workDir         write experiment results under workDir (def: .)\n"
 "    -c                 don't create any directories needed for creating files (def: do create)\n"
 "    -s                 create result.txt, data*.txt, and stats.txt (def: don't create)\n"
+"    -x                 with -s, print their p-values and statistics with the fewest digits that read back as the same\n"
+"                       double (def: 6 digits after the decimal point as with %f) (not allowed with -O)\n"
 "    -F format          randdata format: 'r': raw binary, 'a': ASCII '0'/'1' chars (def: 'r')\n"
 "    -S bitcount        Number of bits to process in a single iteration (def: 1048576 == 1024*1024) (same as -P 9=bitcount)\n"
 "    -j jobnum          seek into randdata, jobnum * bitcount * iterations bits (def: 0)\n"
@@ -348,10 +383,16 @@ static const char * const usage2 =
 "                       i --> test the given data, but not assess it, and instead save the p-values in a binary filename\n"
 "                             of the form: workDir/sts.__jobnum__.__iterations__.__bitcount__.pvalue\n"
 "                       a --> collect the p-values from the binary files specified from '-d pvaluesdir' and assess them\n"
+"                             (files written with -G samples are merged by adding their bins and pass counts)\n"
+"                       m --> merge the binary files specified from '-d pvaluesdir' into a single binary file under workDir\n"
+"                             The files must hold consecutive, non-overlapping iterations of the same test parameters.\n"
+"                             With -i iterations, they must hold exactly the iterations of job -j jobnum (def: 0).\n"
+"                             The merged file holds p-values if all files do, and tallies otherwise or with -G samples.\n"
 "\n"
-"    -T numOfThreads    custom number of threads for this run (default: takes the number of cores of the CPU)\n"
+"    -T numOfThreads    custom number of threads for this run (default: takes the number of cores of the CPU)\n";
+static const char * const usage3 =
 "\n"
-"    -d pvaluesdir      path to the folder with the binary files with previously computed p-values (requires mode -m a)\n"
+"    -d pvaluesdir      path to the folder with the binary files with previously computed p-values (requires mode -m a or -m m)\n"
 "                       This will assess p-values found files of the form:\n"
 "\n"
 "                           pvaluesdir/sts.__jobnum__.__iterations__.__bitcount__.pvalues\n"
@@ -360,6 +401,19 @@ static const char * const usage2 =
 "                       iterations that the given file holds.  The __jobnum__ field is the job number and is ignored.\n"
 "                       All other files and directories under pvaluesdir are ignored.\n"
 "\n"
+"    -W wisdomFile      load and save FFTW wisdom for the Discrete Fourier Transform test in wisdomFile\n"
+"                       (def: $XDG_CACHE_HOME/sts/fftw-wisdom.__bitcount__ if XDG_CACHE_HOME is set,\n"
+"                       otherwise workDir/fftw-wisdom.__bitcount__) (ignored by the legacy FFT build)\n"
+"    -B dftBatch        number of bitstreams the Discrete Fourier Transform test transforms together, 1-64 (def: 1)\n"
+"                       Batching 4 to 16 bitstreams speeds up small to moderate bitcounts at the cost of memory.\n"
+"    -G samples         with -m i or -m m, write the uniformity bins and pass counts of each test instead of its p-values,\n"
+"                       plus up to samples randomly chosen p-values of each partition, 0-1048576 (def: write p-values)\n"
+"                       All jobs should use the same -P 8=bins, -O or -i iterations so that their bins can be merged.\n"
+"    -K workers         with -m b or -m i, fork workers processes, each pinned to its share of the CPUs, that test\n"
+"                       contiguous shards of the iterations and return their p-values over pipes (def: test in this process)\n"
+"                       The -T numOfThreads threads are shared among the workers.\n"
+"                       Not allowed with -O or when randdata is -, and -s is ignored.\n"
+"\n"
 "    -h                 print this message and exit\n"
 "\n"
 "    randdata           path to the input file to test (required for -m b and -m i, optional for -A and -m a)\n"
@@ -423,7 +477,7 @@ parse_args(struct state *state, int argc, char **argv)
 	 */
 	opterr = 0;
 	brkt = NULL;
-	while ((option = getopt(argc, argv, "v:Abt:g:pP:S:i:I:Ow:csf:F:j:m:T:d:h")) != -1) {
+	while ((option = getopt(argc, argv, "v:Abt:g:pP:S:i:I:Ow:csxf:F:j:m:T:d:W:B:G:K:h")) != -1) {
 		switch (option) {
 
 		case 'v':	// -v debuglevel
@@ -510,7 +564,7 @@ parse_args(struct state *state, int argc, char **argv)
 				/*
 				 * Parse parameter value
 				 */
-				if (num <= MAX_INT_PARAM) {
+				if (num <= MAX_INT_PARAM || num > MAX_DOUBLE_PARAM) {
 
 					// Parse parameter number as an integer
 					scan_cnt = sscanf(phrase, "%ld=%ld", &num, &value);
@@ -607,6 +661,10 @@ parse_args(struct state *state, int argc, char **argv)
 			state->resultstxtFlag = true;
 			break;
 
+		case 'x':	// -x (print doubles in the shortest round-trip format)
+			state->exactFlag = true;
+			break;
+
 		case 'F':	// -F format: 'r' or '1': raw binary, 'a' or '0': ASCII '0'/'1' chars
 			state->dataFormatFlag = true;
 			state->dataFormat = (enum format) (optarg[0]);
@@ -658,8 +716,11 @@ parse_args(struct state *state, int argc, char **argv)
 			case MODE_ASSESS_ONLY:
 				state->runMode = MODE_ASSESS_ONLY;
 				break;
+			case MODE_MERGE_ONLY:
+				state->runMode = MODE_MERGE_ONLY;
+				break;
 			default:
-				usage_err(1, __func__, "-m mode must be one of w, b, i or a: %c", optarg[0]);
+				usage_err(1, __func__, "-m mode must be one of w, b, i, a or m: %c", optarg[0]);
 				break;
 			}
 			break;
@@ -682,11 +743,54 @@ parse_args(struct state *state, int argc, char **argv)
 			}
 			break;
 
+		case 'W':	// -W wisdomFile (FFTW wisdom used by the Discrete Fourier Transform test)
+			state->wisdomFlag = true;
+			state->wisdomFile = strdup(optarg);
+			if (state->wisdomFile == NULL) {
+				errp(1, __func__, "strdup of %lu bytes for -W wisdomFile failed", strlen(optarg));
+			}
+			break;
+
+		case 'B':	// -B dftBatch (bitstreams transformed together by the Discrete Fourier Transform test)
+			state->dftBatchFlag = true;
+			state->dftBatch = str2longint(&success, optarg);
+			if (success == false) {
+				usage_errp(1, __func__, "error in parsing -B dftBatch: %s", optarg);
+			}
+			if (state->dftBatch < 1 || state->dftBatch > MAX_DFT_BATCH) {
+				usage_err(1, __func__, "-B dftBatch: %ld must be in the range [1-%d]", state->dftBatch,
+					  MAX_DFT_BATCH);
+			}
+			break;
+
+		case 'G':	// -G samples (write aggregated .pvalues files in -m i mode)
+			state->aggregateFlag = true;
+			state->reservoirSize = str2longint(&success, optarg);
+			if (success == false) {
+				usage_errp(1, __func__, "error in parsing -G samples: %s", optarg);
+			}
+			if (state->reservoirSize < 0 || state->reservoirSize > MAX_RESERVOIR_SIZE) {
+				usage_err(1, __func__, "-G samples: %ld must be in the range [0-%d]", state->reservoirSize,
+					  MAX_RESERVOIR_SIZE);
+			}
+			break;
+
+		case 'K':	// -K workers (test shards of the iterations in worker processes)
+			state->shardWorkersFlag = true;
+			state->shardWorkers = str2longint(&success, optarg);
+			if (success == false) {
+				usage_errp(1, __func__, "error in parsing -K workers: %s", optarg);
+			}
+			if (state->shardWorkers < 1) {
+				usage_err(1, __func__, "-K workers: %ld must be > 0", state->shardWorkers);
+			}
+			break;
+
 		case 'h':	// -h (print out help)
 			if (program == NULL) {
-				fprintf(stderr, "usage: sts %s%s", usage, usage2);
+				fprintf(stderr, "usage: sts %s%s%s", usage, usage2, usage3);
 			} else {
-				fprintf(stderr, "usage: %s %s%s", program, usage, usage2);
+				fprintf(stderr, "usage: %s %s%s%s", program, usage, usage2, usage3);
 			}
 			fprintf(stderr, "\nVersion: %s\n", version);
 			exit(0);
@@ -725,10 +829,35 @@ parse_args(struct state *state, int argc, char **argv)
 		break;
 	case MODE_ASSESS_ONLY:
 		break;
+	case MODE_MERGE_ONLY:
+		if (state->pvalues_dir == NULL) {
+			usage_err(1, __func__, "-m m requires -d pvaluesdir");
+		}
+		if (state->jobnumFlag == true && state->iterationFlag == false) {
+			usage_err(1, __func__, "-j jobnum with -m m requires -i iterations, the number of iterations of the job");
+		}
+		break;
 	default:
 		err(1, __func__, "unknown run mode: %u", state->runMode);
 		break;
 	}
+	if (state->aggregateFlag == true && state->runMode != MODE_ITERATE_ONLY && state->runMode != MODE_MERGE_ONLY) {
+		usage_err(1, __func__, "-G samples requires -m i or -m m");
+	}
+	if (state->shardWorkersFlag == true) {
+		if (state->runMode != MODE_ITERATE_AND_ASSESS && state->runMode != MODE_ITERATE_ONLY) {
+			usage_err(1, __func__, "-K workers requires -m b or -m i");
+		}
+		if (state->stdinData == true) {
+			usage_err(1, __func__, "-K workers not allowed when randdata is - (reading data from standard input)");
+		}
+		if (state->legacy_output == true) {
+			usage_err(1, __func__, "-K workers not allowed with -O, as the workers would all write to freq.txt");
+		}
+	}
+	if (state->exactFlag == true && state->legacy_output == true) {
+		usage_err(1, __func__, "-x not allowed with -O, as the legacy output prints doubles as with %%f");
+	}
 
 
 	// if reading random data from stdin, we cannot be interactive
@@ -736,7 +865,7 @@ parse_args(struct state *state, int argc, char **argv)
 		if (state->batchmode == false) {
 			usage_err(1, __func__, "-A not allowed when randdata is - (reading data from standard input)");
 		}
-		if (state->iterationFlag == false && state->runMode != MODE_ASSESS_ONLY) {
+		if (state->iterationFlag == false && state->runMode != MODE_ASSESS_ONLY && state->runMode != MODE_MERGE_ONLY) {
 			usage_err(1, __func__, "-i bitstreams or -m a requited when randdata is - "
 					       "(reading data from standard input)");
 		}
@@ -820,6 +949,16 @@ parse_args(struct state *state, int argc, char **argv)
 		     sysconf(_SC_NPROCESSORS_ONLN));
 	}
 
+	/*
+	 * Remember how many threads may run at once before the number of threads is capped to the number
+	 * of bitstreams, so that tests can put the otherwise idle threads to use within a single iteration
+	 */
+	if (state->numberOfThreadsFlag == true) {
+		state->threadBudget = MAX(state->numberOfThreads, 1);
+	} else {
+		state->threadBudget = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+	}
+
 	/*
 	 * If a custom number of threads was set and this number is greater than the number of bitstreams
 	 * (aka iterations) set, fire a warning to the user that only $numOfBitstreams threads will be used.
@@ -831,6 +970,20 @@ parse_args(struct state *state, int argc, char **argv)
 		state->numberOfThreads = state->tp.numOfBitStreams;
 	}
 
+	/*
+	 * With -K workers, share the threads among the worker processes, each testing a shard of the bitstreams
+	 */
+	if (state->shardWorkersFlag == true) {
+		state->shardWorkers = MIN(state->shardWorkers, MAX(state->tp.numOfBitStreams, 1));
+		state->numberOfThreads = MIN(MAX(state->threadBudget / state->shardWorkers, 1), state->tp.numOfBitStreams);
+		if (state->resultstxtFlag == true) {
+			warn(__func__, "You have chosen to test in %ld worker processes with -K. In this mode the -s flag is "
+					"not supported. This run won't produce any stats.txt or results.txt file.",
+			     state->shardWorkers);
+			state->resultstxtFlag = false;
+		}
+	}
+
 	/*
 	 * Look for the matching .pvalues files in the folder given with -d
 	 */
@@ -838,6 +991,7 @@ parse_args(struct state *state, int argc, char **argv)
 		DIR *dir;
 		struct dirent *entry;
 		struct stat path_stat;
+		long int requested_iterations;	// -i iterations, before counting the ones of the files
 
 		if ((dir = opendir(state->pvalues_dir)) != NULL) {
 
@@ -845,6 +999,7 @@ parse_args(struct state *state, int argc, char **argv)
 			 * Set the number of bitstreams to 0, since we will count the number of iterations
 			 * from the filenames (assuming they were not renamed).
 			 */
+			requested_iterations = state->tp.numOfBitStreams;
 			state->tp.numOfBitStreams = 0;
 
 			/*
@@ -915,6 +1070,13 @@ parse_args(struct state *state, int argc, char **argv)
 			 */
 			closedir (dir);
 
+			/*
+			 * When merging with -i iterations, the merged file must hold the iterations of -j jobnum
+			 */
+			if (state->runMode == MODE_MERGE_ONLY && state->iterationFlag == true) {
+				state->tp.numOfBitStreams = requested_iterations;
+			}
+
 		} else {
 			/* could not open directory */
 			err(1, __func__, "Could not open the directory: %s", state->pvalues_dir);
@@ -922,13 +1084,14 @@ parse_args(struct state *state, int argc, char **argv)
 	}
 
 	/*
-	 * When running in ASSESS_ONLY MODE
+	 * When running in ASSESS_ONLY or MERGE_ONLY MODE
 	 */
-	if (state->runMode == MODE_ASSESS_ONLY) {
+	if (state->runMode == MODE_ASSESS_ONLY || state->runMode == MODE_MERGE_ONLY) {
 
 		if (state->resultstxtFlag == true) {
-			warn(__func__, "You have chosen to use the sts in mode 'a' (assess only). In this mode the -s flag is "
-					"not supported. This run won't produce any stats.txt or results.txt file.");
+			warn(__func__, "You have chosen to use the sts in mode '%c' (%s only). In this mode the -s flag is "
+					"not supported. This run won't produce any stats.txt or results.txt file.", state->runMode,
+			     (state->runMode == MODE_ASSESS_ONLY) ? "assess" : "merge");
 			state->resultstxtFlag = false;
 		}
 	}
@@ -990,10 +1153,10 @@ change_params(struct state *state, long int parameter, long int value, double d_
 		state->tp.linearComplexitySequenceLength = value;
 		break;
 	case PARAM_numOfBitStreams:
-		state->uniformityBinsFlag = true;
 		state->tp.numOfBitStreams = value;
 		break;
 	case PARAM_uniformity_bins:
+		state->uniformityBinsFlag = true;
 		state->tp.uniformity_bins = value;
 		break;
 	case PARAM_n:
@@ -1005,6 +1168,9 @@ change_params(struct state *state, long int parameter, long int value, double d_
 	case PARAM_alpha:
 		state->tp.alpha = d_value;
 		break;
+	case PARAM_rankMatrixSize:
+		state->tp.rankMatrixSize = value;
+		break;
 	default:
 		err(2, __func__, "invalid parameter option: %ld", parameter);
 		break;
@@ -1054,6 +1220,10 @@ print_option_summary(struct state *state, char *where)
 						"assess them'");
 				break;
 
+			case MODE_MERGE_ONLY:
+				dbg(DBG_MED, "\tMerge the binary files specified from '-d file...' into a single binary file");
+				break;
+
 			default:
 				dbg(DBG_MED, "\tUnknown assessment mode: %c", state->runMode);
 				break;
@@ -1139,11 +1309,38 @@ print_option_summary(struct state *state, char *where)
 	case MODE_ASSESS_ONLY:
 		dbg(DBG_MED, "\t  -m a: collect the p-values from the binary files specified from '-d file...' and assess them");
 		break;
+	case MODE_MERGE_ONLY:
+		dbg(DBG_MED, "\t  -m m: merge the binary files specified from '-d file...' into a single binary file");
+		break;
 	default:
 		dbg(DBG_MED, "\t  -m %c: unknown runMode", state->runMode);
 		break;
 	}
 	dbg(DBG_MED, "\tworkDir: -w %s", state->workDir);
+	if (state->wisdomFlag == true) {
+		dbg(DBG_MED, "\tFFTW wisdom file: -W %s", state->wisdomFile);
+	} else {
+		dbg(DBG_MED, "\tno -W wisdomFile was given");
+	}
+	if (state->dftBatchFlag == true) {
+		dbg(DBG_MED, "\t-B %ld was given", state->dftBatch);
+	} else {
+		dbg(DBG_MED, "\tno -B dftBatch was given");
+	}
+	dbg(DBG_MED, "\t  DFT test transforms %ld bitstream(s) at a time", state->dftBatch);
+	if (state->aggregateFlag == true) {
+		dbg(DBG_MED, "\t-G %ld was given", state->reservoirSize);
+		dbg(DBG_MED, "\t  write tallies and %ld sampled p_values per partition instead of p_values", state->reservoirSize);
+	} else {
+		dbg(DBG_MED, "\tno -G samples was given");
+	}
+	if (state->shardWorkersFlag == true) {
+		dbg(DBG_MED, "\t-K %ld was given", state->shardWorkers);
+		dbg(DBG_MED, "\t  test shards of the iterations in %ld worker processes of %ld threads each", state->shardWorkers,
+		    state->numberOfThreads);
+	} else {
+		dbg(DBG_MED, "\tno -K workers was given");
+	}
 	if (state->subDirsFlag == true) {
 		dbg(DBG_MED, "\t-c was given");
 	} else {
@@ -1161,6 +1358,13 @@ print_option_summary(struct state *state, char *where)
 		dbg(DBG_MED, "\tno -s was given");
 		dbg(DBG_MED, "\t  do not create result.txt, data*.txt and stats.txt");
 	}
+	if (state->exactFlag == true) {
+		dbg(DBG_MED, "\t-x was given");
+		dbg(DBG_MED, "\t  print doubles in the shortest round-trip format");
+	} else {
+		dbg(DBG_MED, "\tno -x was given");
+		dbg(DBG_MED, "\t  print doubles as with %%f");
+	}
 	if (state->dataFormatFlag == true) {
 		dbg(DBG_MED, "\t-F format was given");
 	} else {
@@ -1215,6 +1419,7 @@ print_option_summary(struct state *state, char *where)
 	dbg(DBG_MED, "\toverlappingTemplateBlockLength = %ld", state->tp.overlappingTemplateLength);
 	dbg(DBG_MED, "\tserialBlockLength = %ld", state->tp.serialBlockLength);
 	dbg(DBG_MED, "\tlinearComplexitySequenceLength = %ld", state->tp.linearComplexitySequenceLength);
+	dbg(DBG_MED, "\trankMatrixSize = %ld", state->tp.rankMatrixSize);
 	dbg(DBG_MED, "\tapproximateEntropyBlockLength = %ld", state->tp.approximateEntropyBlockLength);
 	dbg(DBG_MED, "\tnumOfBitStreams = %ld", state->tp.numOfBitStreams);
 	dbg(DBG_MED, "\tbins = %ld", state->tp.uniformity_bins);
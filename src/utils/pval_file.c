@@ -0,0 +1,1945 @@
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+// Exit codes: 80 thru 89
+
+// global capabilities
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../utils/externs.h"
+#include "utilities.h"
+#include "pval_file.h"
+#include "debug.h"
+
+
+/*
+ * Number of doubles (or struct nonover_stats) staged in memory when a column can not be
+ * written or appended with a single call
+ */
+#define PVAL_FILE_BUFFER (8192)
+
+/*
+ * A .pvalues file to merge, with the range of iterations that it holds
+ */
+struct pval_file_entry {
+	char *filename;			// Name of the file under state->pvalues_dir
+	int64_t jobnum;			// -j jobnum of the run that wrote the file
+	int64_t first_iteration;	// Index of the first iteration of the file among all jobs
+	int64_t iterations;		// Number of iterations (bit streams) in the file
+	uint32_t kind;			// enum pval_file_kind
+	int64_t reservoir_size;		// p_values sampled per partition of an aggregated file, 0 otherwise
+};
+
+
+/*
+ * A raw version 2 .pvalues file to read in assess mode, and where its columns go in state->p_val
+ */
+struct pval_read_entry {
+	char *filename;			// Name of the file under state->pvalues_dir
+	bool swap;			// true ==> the file was written in the other byte order
+	bool failed;			// true ==> the file could not be read and its slices are dropped
+	int64_t offset[NUMOFTESTS + 1];	// Offset in the file of the column of each test, 0 ==> none
+	long int count[NUMOFTESTS + 1];	// Number of p_values in the column of each test
+	long int start[NUMOFTESTS + 1];	// Index in the p_val of each test of the first p_value of the file
+};
+
+/*
+ * Work shared by the threads of the reading phase: the files are handed out one at a time
+ */
+struct pval_read_work {
+	struct state *state;		// Run state whose p_val arrays are filled
+	struct pval_read_entry *entry;	// Files to read
+	long int count;			// Number of files to read
+	pthread_mutex_t *mutex;		// Protects next
+	long int next;			// Index in entry of the next file to read
+};
+
+/*
+ * Forward static function declarations
+ */
+static void writeColumn(struct state *state, int test, FILE * stream, const char *path);
+static void writeAggregateColumn(struct state *state, int test, FILE * stream, const char *path);
+static void writePvalFile(struct state *state, long int jobnum, long int first_iteration, long int iterations);
+static void writePvalStream(struct state *state, FILE * stream, const char *path, long int jobnum, long int first_iteration,
+			    long int iterations);
+static void sampleReservoir(struct state *state, int test, double *reservoir, long int *seen);
+static void mergeReservoir(double *into, long int into_population, const double *from, long int from_count,
+			   long int from_population, long int size, uint64_t *seed);
+static uint64_t nextSample(uint64_t *seed);
+static int compareEntries(const void *a, const void *b);
+static void readPvalFileV1(struct state *state, FILE * p_val_file, const char *filename);
+static bool readPvalFileV2(struct state *state, int fd, bool *bins_fixed, const char *filename);
+static bool readPvalImage(struct state *state, const void *image, size_t size, bool *bins_fixed, const char *filename);
+static void readPvalSlices(struct state *state, struct pval_read_entry *entry, long int count);
+static void *readPvalSlicesThread(void *work);
+static bool readPvalSlice(struct state *state, int test, int fd, struct pval_read_entry *entry, double *buf);
+static bool preadFully(int fd, void *buf, size_t len, off_t offset);
+static bool readFully(int fd, void *buf, size_t len);
+static bool checkPvalHeader(struct state *state, struct pval_file_header *header, off_t size, bool *swap,
+			    bool *bins_fixed, bool merging, const char *filename);
+static void rejectPvalFile(bool merging, const char *filename, const char *fmt, ...);
+static void appendColumn(struct state *state, int test, const double *column, long int count, bool swap);
+static void addAggregateColumn(struct state *state, int test, const int64_t *column, struct pval_file_header *header,
+			       bool swap);
+static uint32_t swap32(uint32_t value);
+static uint64_t swap64(uint64_t value);
+static void swapInt64(int64_t *value);
+static void swapDouble(double *value);
+
+
+/*
+ * write_p_val_to_file - write the p_values of this run into a version 2 .pvalues file
+ *
+ * given:
+ *      state           // run state whose p_values are written
+ *
+ * The file is first written as workDir/sts.jobnum.iterations.bitcount.work, and renamed to
+ * workDir/sts.jobnum.iterations.bitcount.pvalues once it is complete.  With -G samples, the file
+ * holds the metric tally of each test and reservoirSize p_values sampled from each partition.
+ */
+void
+write_p_val_to_file(struct state *state)
+{
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(80, __func__, "state arg was NULL");
+	}
+
+	writePvalFile(state, state->jobnum, state->firstIteration, state->tp.numOfBitStreams);
+}
+
+
+/*
+ * write_p_val_to_stream - write the p_values of this run as a version 2 .pvalues file to an open stream
+ *
+ * given:
+ *      state           // run state whose p_values are written
+ *      stream          // open stream, such as a pipe, to write to
+ *      name            // name of the stream, for error messages
+ *
+ * The stream is not flushed nor closed.  With -G samples, the tallies of the p_values are written.
+ */
+void
+write_p_val_to_stream(struct state *state, FILE * stream, const char *name)
+{
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(80, __func__, "state arg was NULL");
+	}
+	if (stream == NULL) {
+		err(80, __func__, "stream arg was NULL");
+	}
+	if (name == NULL) {
+		err(80, __func__, "name arg was NULL");
+	}
+
+	writePvalStream(state, stream, name, state->jobnum, state->firstIteration, state->tp.numOfBitStreams);
+}
+
+
+/*
+ * writePvalFile - write the p_values, or the tallies with -G samples, of a range of iterations
+ *
+ * given:
+ *      state           // run state whose p_values are written
+ *      jobnum          // job number of the file
+ *      first_iteration // index of the first iteration of the file among all jobs
+ *      iterations      // number of iterations of the file
+ */
+static void
+writePvalFile(struct state *state, long int jobnum, long int first_iteration, long int iterations)
+{
+	char *filename;			// Name of the work file, then of the final file
+	char *work_filepath;		// Path of the work file
+	char *final_filepath;		// Path of the final file
+	FILE *p_val_file;		// Open work file
+
+	/*
+	 * Compute the filename of the working file (.work)
+	 */
+	if (asprintf(&filename, "sts.%04ld.%ld.%ld.work", jobnum, iterations, state->tp.n) < 0) {
+		errp(80, __func__, "asprintf of the work filename failed");
+	}
+	work_filepath = filePathName(state->workDir, filename);
+	free(filename);
+
+	/*
+	 * Write the header and then the columns
+	 */
+	p_val_file = fopen(work_filepath, "wb");
+	if (p_val_file == NULL) {
+		errp(80, __func__, "cannot open p-value file for writing: %s", work_filepath);
+	}
+	writePvalStream(state, p_val_file, work_filepath, jobnum, first_iteration, iterations);
+
+	/*
+	 * Close the "working" file
+	 */
+	errno = 0;		// paranoia
+	if (fclose(p_val_file) != 0) {
+		errp(80, __func__, "error while closing p-value file: %s", work_filepath);
+	}
+
+	/*
+	 * Compute the final filename
+	 */
+	if (asprintf(&filename, "sts.%04ld.%ld.%ld.pvalues", jobnum, iterations, state->tp.n) < 0) {
+		errp(80, __func__, "asprintf of the final filename failed");
+	}
+	final_filepath = filePathName(state->workDir, filename);
+
+	/*
+	 * Rename the work file (.work) to have its final filename (.pvalues)
+	 */
+	if (rename(work_filepath, final_filepath) < 0) {
+		errp(80, __func__, "error in renaming %s to %s", work_filepath, final_filepath);
+	}
+
+	/*
+	 * Free allocated memory
+	 */
+	free(filename);
+	free(work_filepath);
+	free(final_filepath);
+}
+
+
+/*
+ * writePvalStream - write the header and columns of a range of iterations to an open stream
+ *
+ * given:
+ *      state           // run state whose p_values are written
+ *      stream          // open stream to write to
+ *      path            // path or name of the stream
+ *      jobnum          // job number of the file
+ *      first_iteration // index of the first iteration of the file among all jobs
+ *      iterations      // number of iterations of the file
+ */
+static void
+writePvalStream(struct state *state, FILE * stream, const char *path, long int jobnum, long int first_iteration,
+		long int iterations)
+{
+	struct pval_file_header header;	// Header of the file
+	int64_t offset;			// Offset of the next column
+	int64_t record;			// Number of 8 byte words of a partition of an aggregated column
+	size_t ret;			// fwrite return
+	int i;
+
+	/*
+	 * Fill in the header, with the column of each test right after the previous one
+	 */
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PVAL_FILE_MAGIC, sizeof(PVAL_FILE_MAGIC));
+	header.version = PVAL_FILE_VERSION;
+	header.endian = PVAL_FILE_ENDIAN;
+	header.header_size = (uint32_t) sizeof(header);
+	header.kind = (state->aggregateFlag == true) ? PVAL_FILE_AGGREGATE : PVAL_FILE_RAW;
+	header.jobnum = jobnum;
+	header.first_iteration = first_iteration;
+	header.iterations = iterations;
+	header.reservoir_size = (state->aggregateFlag == true) ? state->reservoirSize : 0;
+	header.tp.blockFrequencyBlockLength = state->tp.blockFrequencyBlockLength;
+	header.tp.nonOverlappingTemplateLength = state->tp.nonOverlappingTemplateLength;
+	header.tp.overlappingTemplateLength = state->tp.overlappingTemplateLength;
+	header.tp.approximateEntropyBlockLength = state->tp.approximateEntropyBlockLength;
+	header.tp.serialBlockLength = state->tp.serialBlockLength;
+	header.tp.linearComplexitySequenceLength = state->tp.linearComplexitySequenceLength;
+	header.tp.numOfBitStreams = state->tp.numOfBitStreams;
+	header.tp.uniformity_bins = state->tp.uniformity_bins;
+	header.tp.n = state->tp.n;
+	header.tp.uniformity_level = state->tp.uniformity_level;
+	header.tp.alpha = state->tp.alpha;
+	header.tp.rankMatrixSize = state->tp.rankMatrixSize;
+	if (state->aggregateFlag == true) {
+		tallyMetrics(state);
+	}
+	record = 2 + header.tp.uniformity_bins + header.reservoir_size;
+	offset = (int64_t) sizeof(header);
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->testVector[i] != true || state->p_val[i] == NULL ||
+		    (state->aggregateFlag == true && state->tally[i] == NULL)) {
+			continue;
+		}
+		header.column[i].offset = offset;
+		if (state->aggregateFlag == true) {
+			header.column[i].count = state->partitionCount[i] * record;
+		} else {
+			header.column[i].count = state->p_val[i]->count;
+		}
+		header.column[i].partitionCount = state->partitionCount[i];
+		offset += header.column[i].count * (int64_t) sizeof(double);
+	}
+
+	/*
+	 * Write the header and then the columns
+	 */
+	ret = fwrite(&header, sizeof(header), 1, stream);
+	if (ret != 1) {
+		errp(80, __func__, "error while writing the header to p-value file: %s", path);
+	}
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (header.column[i].offset == 0) {
+			continue;
+		}
+		if (state->aggregateFlag == true) {
+			writeAggregateColumn(state, i, stream, path);
+		} else {
+			writeColumn(state, i, stream, path);
+		}
+	}
+	if (state->aggregateFlag == true) {
+		freeMetricTallies(state);
+	}
+}
+
+
+/*
+ * writeColumn - write the column of p_values of a test
+ *
+ * given:
+ *      state           // run state whose p_values are written
+ *      test            // test whose p_values are written
+ *      stream          // open .pvalues work file
+ *      path            // path of the work file
+ *
+ * An array of doubles is written with a single fwrite.  The p_value is the first member of each
+ * struct nonover_stats of TEST_NON_OVERLAPPING, whose p_values are gathered into a buffer first.
+ */
+static void
+writeColumn(struct state *state, int test, FILE * stream, const char *path)
+{
+	struct dyn_array *p_val;	// p_values of the test
+	double *buf;			// Buffer of gathered p_values
+	long int count;			// Number of p_values in the column
+	long int done;			// Number of p_values already written
+	long int len;			// Number of p_values in the buffer
+	long int i;
+
+	p_val = state->p_val[test];
+	count = p_val->count;
+	if (count == 0) {
+		return;
+	}
+
+	/*
+	 * Write an array of doubles in place
+	 */
+	if (p_val->elm_size == sizeof(double)) {
+		if (fwrite(p_val->data, sizeof(double), (size_t) count, stream) != (size_t) count) {
+			errp(81, __func__, "error while writing %ld p-values of test %d to p-value file: %s", count, test, path);
+		}
+		return;
+	}
+
+	/*
+	 * Gather the p_values of an array of structs
+	 */
+	buf = malloc(PVAL_FILE_BUFFER * sizeof(buf[0]));
+	if (buf == NULL) {
+		errp(81, __func__, "cannot malloc of %d elements of %lu bytes each for buf", PVAL_FILE_BUFFER, sizeof(buf[0]));
+	}
+	for (done = 0; done < count; done += len) {
+		len = MIN(count - done, PVAL_FILE_BUFFER);
+		for (i = 0; i < len; i++) {
+			memcpy(&buf[i], (char *) p_val->data + (done + i) * p_val->elm_size, sizeof(double));
+		}
+		if (fwrite(buf, sizeof(double), (size_t) len, stream) != (size_t) len) {
+			errp(81, __func__, "error while writing %ld p-values of test %d to p-value file: %s", len, test, path);
+		}
+	}
+	free(buf);
+
+	return;
+}
+
+
+/*
+ * writeAggregateColumn - write the metric tally and sampled p_values of each partition of a test
+ *
+ * given:
+ *      state           // run state whose p_values were tallied by tallyMetrics()
+ *      test            // test whose tally is written
+ *      stream          // open .pvalues work file
+ *      path            // path of the work file
+ */
+static void
+writeAggregateColumn(struct state *state, int test, FILE * stream, const char *path)
+{
+	struct metric_tally *tally;	// Tally of the test
+	int64_t *counts;		// sampleCount, toolow and bins of a partition
+	double *reservoir;		// Sampled p_values of all partitions, or NULL
+	long int *seen;			// Number of p_values of p_val sampled from each partition
+	long int partitions;		// Number of partitions of the test
+	long int bins;			// Number of uniformity bins
+	long int size;			// Number of sampled p_values per partition
+	uint64_t seed;			// State of the sampling generator
+	long int j;
+	long int k;
+
+	tally = state->tally[test];
+	partitions = state->partitionCount[test];
+	bins = state->tp.uniformity_bins;
+
+	/*
+	 * Sample the p_values of each partition
+	 */
+	reservoir = NULL;
+	size = state->reservoirSize;
+	if (size > 0) {
+		reservoir = malloc((size_t) (partitions * size) * sizeof(reservoir[0]));
+		seen = calloc((size_t) partitions, sizeof(seen[0]));
+		if (reservoir == NULL || seen == NULL) {
+			errp(84, __func__, "cannot malloc of %ld elements of %lu bytes each for reservoir",
+			     partitions * size, sizeof(reservoir[0]));
+		}
+		sampleReservoir(state, test, reservoir, seen);
+
+		/*
+		 * Merge in the p_values sampled from the aggregated files of a merge, which are the
+		 * p_values counted by the tally beyond the ones of p_val
+		 */
+		if (tally->reservoir != NULL) {
+			seed = ((uint64_t) state->jobnum << 8) ^ (uint64_t) test ^ UINT64_C(0x5555555555555555);
+			for (j = 0; j < partitions; j++) {
+				mergeReservoir(reservoir + j * size, seen[j], tally->reservoir + j * size,
+					       MIN(size, tally->sampleCount[j] - seen[j]), tally->sampleCount[j] - seen[j], size,
+					       &seed);
+			}
+		}
+		free(seen);
+	}
+
+	/*
+	 * Write the record of each partition
+	 */
+	counts = malloc((size_t) (2 + bins) * sizeof(counts[0]));
+	if (counts == NULL) {
+		errp(84, __func__, "cannot malloc of %ld elements of %lu bytes each for counts", 2 + bins, sizeof(counts[0]));
+	}
+	for (j = 0; j < partitions; j++) {
+		counts[0] = tally->sampleCount[j];
+		counts[1] = tally->toolow[j];
+		for (k = 0; k < bins; k++) {
+			counts[2 + k] = tally->freqPerBin[j * bins + k];
+		}
+		if (fwrite(counts, sizeof(counts[0]), (size_t) (2 + bins), stream) != (size_t) (2 + bins)) {
+			errp(84, __func__, "error while writing the tally of test %d to p-value file: %s", test, path);
+		}
+		if (reservoir != NULL &&
+		    fwrite(reservoir + j * state->reservoirSize, sizeof(reservoir[0]), (size_t) state->reservoirSize,
+			   stream) != (size_t) state->reservoirSize) {
+			errp(84, __func__, "error while writing the sampled p-values of test %d to p-value file: %s", test, path);
+		}
+	}
+	free(counts);
+	free(reservoir);
+
+	return;
+}
+
+
+/*
+ * sampleReservoir - sample reservoirSize p_values from each partition of a test
+ *
+ * given:
+ *      state           // run state whose p_values are sampled
+ *      test            // test whose p_values are sampled
+ *      reservoir       // reservoirSize slots for each partition
+ *      seen            // zeroized, set to the number of p_values sampled from each partition
+ *
+ * Every p_value counted in the sampleCount of its partition has the same chance to be kept
+ * (reservoir sampling).  The choice only depends on the job number, so a job always writes the
+ * same file.  The slots left unused by a partition with fewer p_values are set to NON_P_VALUE.
+ */
+static void
+sampleReservoir(struct state *state, int test, double *reservoir, long int *seen)
+{
+	const char *data;		// Elements of p_val
+	size_t elm_size;		// Size of an element of p_val
+	long int partitions;		// Number of partitions of the test
+	long int size;			// Number of slots of a partition
+	uint64_t seed;			// State of the sampling generator
+	uint64_t slot;			// Slot that may receive a p_value
+	double p_value;			// p_value of an iteration
+	long int i;
+	long int j;
+
+	data = (const char *) state->p_val[test]->data;
+	elm_size = state->p_val[test]->elm_size;
+	partitions = state->partitionCount[test];
+	size = state->reservoirSize;
+	for (i = 0; i < partitions * size; i++) {
+		reservoir[i] = NON_P_VALUE;
+	}
+	seed = ((uint64_t) state->jobnum << 8) ^ (uint64_t) test;
+
+	for (i = 0, j = 0; i < state->p_val[test]->count; i++, j = ((j + 1 == partitions) ? 0 : j + 1)) {
+
+		// Only sample the p_values that the metric tally counts
+		p_value = *(const double *) (data + i * elm_size);
+		if (p_value == NON_P_VALUE || (state->is_excursion[test] == true && !(p_value > 0.0))) {
+			continue;
+		}
+		if (seen[j] < size) {
+			reservoir[j * size + seen[j]] = p_value;
+		} else {
+			slot = nextSample(&seed) % (uint64_t) (seen[j] + 1);
+			if (slot < (uint64_t) size) {
+				reservoir[j * size + (long int) slot] = p_value;
+			}
+		}
+		++seen[j];
+	}
+
+	return;
+}
+
+
+/*
+ * mergeReservoir - merge two samples of p_values into a sample of their union
+ *
+ * given:
+ *      into            // sample of MIN(size, into_population) p_values, replaced by the merged sample
+ *      into_population // number of p_values into was sampled from
+ *      from            // sample of from_count p_values
+ *      from_count      // MIN(size, from_population) or more p_values in from
+ *      from_population // number of p_values from was sampled from
+ *      size            // number of slots of into
+ *      seed            // state of the sampling generator
+ *
+ * Each slot draws a p_value of into or of from with a probability proportional to the p_values left
+ * in their populations, so the merged sample is a uniform sample of the union of the populations when
+ * both samples are uniform samples of theirs.  The slots left unused are set to NON_P_VALUE.
+ */
+static void
+mergeReservoir(double *into, long int into_population, const double *from, long int from_count,
+	       long int from_population, long int size, uint64_t *seed)
+{
+	double *a;			// p_values of into not yet drawn
+	double *b;			// p_values of from not yet drawn
+	long int na;			// Number of p_values left in a
+	long int nb;			// Number of p_values left in b
+	long int idx;			// Index of the p_value drawn from a or b
+	long int k;
+
+	na = MIN(size, into_population);
+	nb = from_count;
+	a = malloc((size_t) (na + nb + 1) * sizeof(a[0]));
+	if (a == NULL) {
+		errp(85, __func__, "cannot malloc of %ld elements of %lu bytes each for a", na + nb + 1, sizeof(a[0]));
+	}
+	b = a + na;
+	memcpy(a, into, (size_t) na * sizeof(a[0]));
+	memcpy(b, from, (size_t) nb * sizeof(b[0]));
+
+	for (k = 0; k < size && into_population + from_population > 0; k++) {
+		if (nextSample(seed) % (uint64_t) (into_population + from_population) < (uint64_t) into_population) {
+			if (na <= 0) {
+				err(85, __func__, "sample of %ld p_values is too small", MIN(size, into_population));
+			}
+			idx = (long int) (nextSample(seed) % (uint64_t) na);
+			into[k] = a[idx];
+			a[idx] = a[--na];
+			--into_population;
+		} else {
+			if (nb <= 0) {
+				err(85, __func__, "sample of %ld p_values is too small", from_count);
+			}
+			idx = (long int) (nextSample(seed) % (uint64_t) nb);
+			into[k] = b[idx];
+			b[idx] = b[--nb];
+			--from_population;
+		}
+	}
+	for (; k < size; k++) {
+		into[k] = NON_P_VALUE;
+	}
+	free(a);
+
+	return;
+}
+
+
+/*
+ * nextSample - return the next value of the splitmix64 generator used by sampleReservoir()
+ */
+static uint64_t
+nextSample(uint64_t *seed)
+{
+	uint64_t z;
+
+	z = (*seed += UINT64_C(0x9e3779b97f4a7c15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return z ^ (z >> 31);
+}
+
+
+/*
+ * read_from_p_val_file - append the p_values of every .pvalues file found by parse_args() to state->p_val
+ *
+ * given:
+ *      state           // run state to assess
+ *
+ * Both version 1 and version 2 files are read.  A file that can not be read, or that was written
+ * with incompatible test parameters, is skipped with a warning.  The tallies of aggregated files
+ * are added to state->tally, ahead of the tally of the p_values in the metrics phase.
+ *
+ * The headers of all files are checked first, so that the p_val of each test is allocated once to
+ * its final size.  The columns of the raw version 2 files are then read by up to state->threadBudget
+ * threads, straight into the slice of p_val that each file was given.  Version 1 and aggregated files
+ * are read while checking the headers, as their p_values can not be counted ahead.
+ */
+void
+read_from_p_val_file(struct state *state)
+{
+	struct pval_read_entry *entry;	// Raw version 2 files to read
+	struct pval_file_header header;	// Header of the current file
+	struct Node *current;		// Current node of the list of .pvalues filenames
+	struct stat st;			// Status of the current file
+	char *path;			// Path of the current file
+	FILE *p_val_file;		// Open current file
+	long int files;			// Number of .pvalues filenames
+	long int count;			// Number of raw version 2 files to read
+	long int total[NUMOFTESTS + 1];	// Number of p_values of each test in the raw version 2 files
+	bool bins_fixed;		// true ==> aggregated files must have state->tp.uniformity_bins bins
+	bool swap;			// true ==> the current file was written in the other byte order
+	long int j;
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(82, __func__, "state arg was NULL");
+	}
+	dbg(DBG_LOW, "start of reading pvalue file(s) phase");
+	bins_fixed = (state->uniformityBinsFlag == true || state->legacy_output == true);
+	for (files = 0, current = state->filenames; current != NULL; current = current->next) {
+		files++;
+	}
+	entry = calloc((size_t) MAX(files, 1), sizeof(entry[0]));
+	if (entry == NULL) {
+		errp(82, __func__, "cannot calloc of %ld elements of %lu bytes each for entry", files, sizeof(entry[0]));
+	}
+	for (i = 0; i <= NUMOFTESTS; i++) {
+		total[i] = 0;
+	}
+
+	/*
+	 * Check the header of every file
+	 */
+	count = 0;
+	for (current = state->filenames; current != NULL; current = current->next) {
+
+		/*
+		 * Open the file
+		 */
+		if (current->filename == NULL) {
+			err(82, __func__, "current p-value filename is NULL");
+		}
+		dbg(DBG_MED, "parsing p-value file: %s", current->filename);
+		path = filePathName(state->pvalues_dir, current->filename);
+		p_val_file = fopen(path, "rb");
+		free(path);
+		if (p_val_file == NULL) {
+			warnp(__func__, "skipping p-value file due to error in opening p-value file: %s", current->filename);
+			continue;
+		}
+
+		/*
+		 * Read version 1 and aggregated files now, and note where the columns of raw files go
+		 */
+		if (fread(&header, sizeof(header), 1, p_val_file) != 1 ||
+		    memcmp(header.magic, PVAL_FILE_MAGIC, sizeof(PVAL_FILE_MAGIC)) != 0) {
+			rewind(p_val_file);
+			readPvalFileV1(state, p_val_file, current->filename);
+		} else if (fstat(fileno(p_val_file), &st) < 0) {
+			warnp(__func__, "skipping p-value file, cannot stat: %s", current->filename);
+		} else if (checkPvalHeader(state, &header, st.st_size, &swap, &bins_fixed, false, current->filename) == false) {
+			// checkPvalHeader() warned
+		} else if (header.kind == PVAL_FILE_AGGREGATE) {
+			readPvalFileV2(state, fileno(p_val_file), &bins_fixed, current->filename);
+		} else {
+			entry[count].filename = current->filename;
+			entry[count].swap = swap;
+			for (i = 1; i <= NUMOFTESTS; i++) {
+				if (state->testVector[i] != true || state->p_val[i] == NULL) {
+					continue;
+				}
+				if (header.column[i].offset == 0) {
+					warn(__func__, "p-value file has no p-values for test %s[%d]: %s", state->testNames[i], i,
+					     current->filename);
+					continue;
+				}
+				entry[count].offset[i] = header.column[i].offset;
+				entry[count].count[i] = (long int) header.column[i].count;
+				total[i] += entry[count].count[i];
+			}
+			count++;
+		}
+		fclose(p_val_file);
+	}
+
+	/*
+	 * Give each raw file its slice of the p_val of each test, allocated once
+	 */
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (total[i] == 0) {
+			continue;
+		}
+		reserve_dyn_array(state->p_val[i], total[i]);
+		total[i] = state->p_val[i]->count;
+		for (j = 0; j < count; j++) {
+			entry[j].start[i] = total[i];
+			total[i] += entry[j].count[i];
+		}
+	}
+
+	/*
+	 * Read the raw files
+	 */
+	if (count > 0) {
+		readPvalSlices(state, entry, count);
+	}
+	free(entry);
+
+	dbg(DBG_LOW, "end of reading pvalue file(s) phase\n");
+}
+
+
+/*
+ * readPvalSlices - read the columns of raw version 2 files into their slices of state->p_val
+ *
+ * given:
+ *      state           // run state to assess
+ *      entry           // files to read, with their slices reserved in state->p_val
+ *      count           // number of files to read
+ *
+ * The slices of files that could not be read are dropped by moving the following slices down, so
+ * that the p_val of each test ends up holding the p_values of the files that were read, in order.
+ */
+static void
+readPvalSlices(struct state *state, struct pval_read_entry *entry, long int count)
+{
+	struct pval_read_work work;	// Work shared by the threads
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_attr_t attr;
+	struct dyn_array *p_val;	// p_values of the current test
+	long int threads;		// Number of threads reading files
+	long int end;			// Index in p_val beyond the last p_value read
+	int io_ret;			// pthread return status
+	void *status;
+	long int t;
+	long int j;
+	int i;
+
+	/*
+	 * Run the reading threads
+	 */
+	threads = MIN(MAX(state->threadBudget, 1), count);
+	pthread_t thread[threads];
+	work.state = state;
+	work.entry = entry;
+	work.count = count;
+	work.mutex = &mutex;
+	work.next = 0;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	for (t = 0; t < threads; t++) {
+		io_ret = pthread_create(&thread[t], &attr, readPvalSlicesThread, &work);
+		if (io_ret != 0) {
+			errp(88, __func__, "error on pthread_create()");
+		}
+	}
+	pthread_attr_destroy(&attr);
+	for (t = 0; t < threads; t++) {
+		io_ret = pthread_join(thread[t], &status);
+		if (io_ret != 0) {
+			errp(88, __func__, "error on pthread_join()");
+		}
+	}
+	pthread_mutex_destroy(&mutex);
+	dbg(DBG_MED, "read %ld raw p-value file(s) with %ld threads", count, threads);
+
+	/*
+	 * Account for the p_values read, dropping the slices of the files that were skipped
+	 */
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		p_val = state->p_val[i];
+		if (p_val == NULL) {
+			continue;
+		}
+		end = p_val->count;
+		for (j = 0; j < count; j++) {
+			if (entry[j].failed == true || entry[j].count[i] == 0) {
+				continue;
+			}
+			if (entry[j].start[i] != end) {
+				memmove((char *) p_val->data + end * p_val->elm_size,
+					(char *) p_val->data + entry[j].start[i] * p_val->elm_size,
+					(size_t) entry[j].count[i] * p_val->elm_size);
+			}
+			end += entry[j].count[i];
+		}
+		p_val->count = end;	// the slices were reserved by reserve_dyn_array()
+	}
+
+	return;
+}
+
+
+/*
+ * readPvalSlicesThread - read files until no file is left
+ *
+ * given:
+ *      work            // pointer to the struct pval_read_work shared by all threads
+ */
+static void *
+readPvalSlicesThread(void *work)
+{
+	struct pval_read_work *w = (struct pval_read_work *) work;
+	struct pval_read_entry *entry;	// File being read
+	double *buf;			// Buffer of p_values to convert
+	char *path;			// Path of the file
+	int fd;				// Open file
+	long int n;
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (w == NULL) {
+		err(88, __func__, "work arg is NULL");
+	}
+	buf = malloc(PVAL_FILE_BUFFER * sizeof(buf[0]));
+	if (buf == NULL) {
+		errp(88, __func__, "cannot malloc of %d elements of %lu bytes each for buf", PVAL_FILE_BUFFER, sizeof(buf[0]));
+	}
+
+	while (1) {
+
+		/*
+		 * Take the next file
+		 */
+		pthread_mutex_lock(w->mutex);
+		n = w->next;
+		if (n < w->count) {
+			w->next++;
+		}
+		pthread_mutex_unlock(w->mutex);
+		if (n >= w->count) {
+			break;
+		}
+		entry = &w->entry[n];
+
+		/*
+		 * Read the column of each test into its slice
+		 */
+		dbg(DBG_HIGH, "reading p-value file: %s", entry->filename);
+		path = filePathName(w->state->pvalues_dir, entry->filename);
+		fd = open(path, O_RDONLY);
+		free(path);
+		if (fd < 0) {
+			warnp(__func__, "skipping p-value file due to error in opening p-value file: %s", entry->filename);
+			entry->failed = true;
+			continue;
+		}
+		(void) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+		for (i = 1; i <= NUMOFTESTS && entry->failed == false; i++) {
+			if (entry->count[i] == 0 || readPvalSlice(w->state, i, fd, entry, buf) == true) {
+				continue;
+			}
+			if (errno == 0) {
+				warn(__func__, "skipping p-value file, it ends within the p-values of test %s[%d]: %s",
+				     w->state->testNames[i], i, entry->filename);
+			} else {
+				warnp(__func__, "skipping p-value file, cannot read the p-values of test %s[%d]: %s",
+				      w->state->testNames[i], i, entry->filename);
+			}
+			entry->failed = true;
+		}
+		close(fd);
+	}
+	free(buf);
+
+	return NULL;
+}
+
+
+/*
+ * readPvalSlice - read the column of a test of a raw version 2 file into its slice of p_val
+ *
+ * given:
+ *      state           // run state to assess
+ *      test            // test whose column is read
+ *      fd              // open file descriptor of the file
+ *      entry           // file being read
+ *      buf             // buffer of PVAL_FILE_BUFFER doubles
+ *
+ * returns:
+ *      true ==> the column was read, false ==> it was not (errno tells why, 0 on a short file)
+ *
+ * An array of doubles in host byte order is read into the slice with a single large read.
+ * Otherwise the p_values are read a buffer at a time and converted to elements of p_val.
+ */
+static bool
+readPvalSlice(struct state *state, int test, int fd, struct pval_read_entry *entry, double *buf)
+{
+	struct dyn_array *p_val;	// p_values of the test
+	unsigned char *slice;		// Slice of p_val of the file
+	long int count;			// Number of p_values in the column
+	long int done;			// Number of p_values already read
+	long int len;			// Number of p_values in the buffer
+	long int i;
+
+	p_val = state->p_val[test];
+	slice = (unsigned char *) p_val->data + entry->start[test] * p_val->elm_size;
+	count = entry->count[test];
+
+	/*
+	 * Read an array of doubles in host byte order in place
+	 */
+	if (p_val->elm_size == sizeof(double) && entry->swap == false) {
+		return preadFully(fd, slice, (size_t) count * sizeof(double), (off_t) entry->offset[test]);
+	}
+
+	/*
+	 * Otherwise convert the p_values to elements of p_val, a buffer at a time
+	 */
+	for (done = 0; done < count; done += len) {
+		len = MIN(count - done, PVAL_FILE_BUFFER);
+		if (preadFully(fd, buf, (size_t) len * sizeof(double),
+			       (off_t) (entry->offset[test] + done * (long int) sizeof(double))) == false) {
+			return false;
+		}
+		for (i = 0; i < len; i++) {
+			if (entry->swap == true) {
+				swapDouble(&buf[i]);
+			}
+			memcpy(slice + (done + i) * p_val->elm_size, &buf[i], sizeof(buf[i]));	// p_value is the first member
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * preadFully - read len bytes at offset of a file, retrying short reads
+ *
+ * given:
+ *      fd              // open file descriptor
+ *      buf             // where to read
+ *      len             // number of bytes to read
+ *      offset          // offset in the file of the first byte
+ *
+ * returns:
+ *      true ==> all bytes were read, false ==> they were not (errno is 0 at the end of the file)
+ */
+static bool
+preadFully(int fd, void *buf, size_t len, off_t offset)
+{
+	ssize_t ret;			// pread return
+
+	while (len > 0) {
+		ret = pread(fd, buf, len, offset);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret <= 0) {
+			if (ret == 0) {
+				errno = 0;
+			}
+			return false;
+		}
+		buf = (char *) buf + ret;
+		len -= (size_t) ret;
+		offset += ret;
+	}
+
+	return true;
+}
+
+
+/*
+ * merge_p_val_files - merge the .pvalues files found by parse_args() into a single .pvalues file
+ *
+ * given:
+ *      state           // run state to merge
+ *
+ * The files must be version 2 files written with the test parameters of this run, and together hold
+ * consecutive iterations without overlap.  With -i iterations, they must hold exactly the iterations of
+ * job -j jobnum (def: 0).  A file that can not be merged, or a missing iteration, is fatal.  The files
+ * are read in the order of their iterations, and the merged file is written under workDir with the job
+ * number of -j jobnum, or of the first file without -i iterations.  It holds p_values when
+ * all files do, and the tallies of aggregated files otherwise or with -G samples.
+ */
+void
+merge_p_val_files(struct state *state)
+{
+	struct pval_file_entry *entry;	// Files to merge
+	struct pval_file_header header;	// Header of the current file
+	struct Node *current;		// Current node of the list of .pvalues filenames
+	struct stat st;			// Status of the current file
+	char *path;			// Path of the current file
+	FILE *p_val_file;		// Open current file
+	long int files;			// Number of .pvalues filenames
+	long int count;			// Number of files to merge
+	long int iterations;		// Number of iterations of all files to merge
+	long int first;			// First iteration of the merged file
+	long int last;			// Iteration that follows the last one of the merged file
+	long int size;			// Number of p_values sampled per partition of the merged file
+	bool aggregate;			// true ==> at least one file to merge is aggregated
+	bool bins_fixed;		// true ==> aggregated files must have state->tp.uniformity_bins bins
+	bool swap;			// true ==> the current file was written in the other byte order
+	long int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(87, __func__, "state arg was NULL");
+	}
+	dbg(DBG_LOW, "start of merging pvalue file(s) phase");
+	bins_fixed = (state->uniformityBinsFlag == true || state->legacy_output == true);
+
+	/*
+	 * Check the header of every file
+	 */
+	for (files = 0, current = state->filenames; current != NULL; current = current->next) {
+		files++;
+	}
+	entry = calloc((size_t) MAX(files, 1), sizeof(entry[0]));
+	if (entry == NULL) {
+		errp(87, __func__, "cannot calloc of %ld elements of %lu bytes each for entry", files, sizeof(entry[0]));
+	}
+	count = 0;
+	for (current = state->filenames; current != NULL; current = current->next) {
+		path = filePathName(state->pvalues_dir, current->filename);
+		p_val_file = fopen(path, "rb");
+		if (p_val_file == NULL) {
+			errp(87, __func__, "cannot open p-value file for reading: %s", path);
+		}
+		free(path);
+		if (fstat(fileno(p_val_file), &st) < 0) {
+			errp(87, __func__, "cannot stat p-value file: %s", current->filename);
+		}
+		if (fread(&header, sizeof(header), 1, p_val_file) != 1 ||
+		    memcmp(header.magic, PVAL_FILE_MAGIC, sizeof(PVAL_FILE_MAGIC)) != 0) {
+			err(87, __func__, "cannot merge p-value file, only version %d files hold their range of iterations: %s",
+			    PVAL_FILE_VERSION, current->filename);
+		}
+		fclose(p_val_file);
+		(void) checkPvalHeader(state, &header, st.st_size, &swap, &bins_fixed, true, current->filename);
+		entry[count].filename = current->filename;
+		entry[count].jobnum = header.jobnum;
+		entry[count].first_iteration = header.first_iteration;
+		entry[count].iterations = header.iterations;
+		entry[count].kind = header.kind;
+		entry[count].reservoir_size = header.reservoir_size;
+		count++;
+	}
+	if (count == 0) {
+		err(87, __func__, "no p-value file to merge in: %s", state->pvalues_dir);
+	}
+
+	/*
+	 * Order the files by their iterations, which must follow each other
+	 */
+	qsort(entry, (size_t) count, sizeof(entry[0]), compareEntries);
+	iterations = 0;
+	aggregate = false;
+	size = (state->aggregateFlag == true) ? state->reservoirSize : MAX_RESERVOIR_SIZE;
+	for (i = 0; i < count; i++) {
+		if (i > 0 && entry[i].first_iteration < entry[i - 1].first_iteration + entry[i - 1].iterations) {
+			err(87, __func__, "iterations %ld to %ld of p-value file %s overlap the ones of p-value file %s",
+			    (long int) entry[i].first_iteration, (long int) (entry[i].first_iteration + entry[i].iterations - 1),
+			    entry[i].filename, entry[i - 1].filename);
+		}
+		if (i > 0 && entry[i].first_iteration > entry[i - 1].first_iteration + entry[i - 1].iterations) {
+			err(87, __func__, "iterations %ld to %ld are missing between p-value files %s and %s",
+			    (long int) (entry[i - 1].first_iteration + entry[i - 1].iterations),
+			    (long int) (entry[i].first_iteration - 1), entry[i - 1].filename, entry[i].filename);
+		}
+		iterations += entry[i].iterations;
+		if (entry[i].kind == PVAL_FILE_AGGREGATE) {
+			aggregate = true;
+			size = MIN(size, entry[i].reservoir_size);
+		}
+	}
+
+	/*
+	 * With -i iterations, the files must hold all of the iterations of job -j jobnum, and no others
+	 */
+	first = entry[0].first_iteration;
+	last = entry[count - 1].first_iteration + entry[count - 1].iterations;
+	if (state->iterationFlag == true) {
+		first = state->jobnum * state->tp.numOfBitStreams;
+		if (entry[0].first_iteration > first) {
+			err(87, __func__, "iterations %ld to %ld are missing before p-value file %s",
+			    (long int) first, (long int) (entry[0].first_iteration - 1), entry[0].filename);
+		}
+		if (entry[0].first_iteration < first) {
+			err(87, __func__, "iterations %ld to %ld of p-value file %s are before the first iteration %ld of job %ld",
+			    (long int) entry[0].first_iteration, (long int) (MIN(last, first) - 1), entry[0].filename,
+			    (long int) first, state->jobnum);
+		}
+		if (last < first + state->tp.numOfBitStreams) {
+			err(87, __func__, "iterations %ld to %ld are missing after p-value file %s",
+			    (long int) last, (long int) (first + state->tp.numOfBitStreams - 1), entry[count - 1].filename);
+		}
+		if (last > first + state->tp.numOfBitStreams) {
+			err(87, __func__, "iterations %ld to %ld of p-value file %s are after the last iteration %ld of job %ld",
+			    (long int) (first + state->tp.numOfBitStreams), (long int) (last - 1), entry[count - 1].filename,
+			    (long int) (first + state->tp.numOfBitStreams - 1), state->jobnum);
+		}
+	}
+
+	/*
+	 * Decide what the merged file holds
+	 */
+	if (state->aggregateFlag == true && size < state->reservoirSize) {
+		warn(__func__, "the aggregated p-value files only have %ld sampled p-values per partition, not %ld",
+		     size, state->reservoirSize);
+	}
+	if (aggregate == true) {
+		state->aggregateFlag = true;
+	}
+	state->reservoirSize = (state->aggregateFlag == true) ? size : 0;
+	state->tp.numOfBitStreams = iterations;
+
+	/*
+	 * Read the files in the order of their iterations
+	 */
+	for (i = 0; i < count; i++) {
+		dbg(DBG_MED, "merging p-value file: %s", entry[i].filename);
+		path = filePathName(state->pvalues_dir, entry[i].filename);
+		p_val_file = fopen(path, "rb");
+		if (p_val_file == NULL) {
+			errp(87, __func__, "cannot open p-value file for reading: %s", path);
+		}
+		if (readPvalFileV2(state, fileno(p_val_file), &bins_fixed, entry[i].filename) == false) {
+			err(87, __func__, "cannot merge p-value file: %s", path);
+		}
+		fclose(p_val_file);
+		free(path);
+	}
+
+	/*
+	 * Write the merged file
+	 */
+	writePvalFile(state, (state->iterationFlag == true) ? state->jobnum : (long int) entry[0].jobnum, (long int) first,
+		      iterations);
+	dbg(DBG_LOW, "merged %ld p-value file(s) holding iterations %ld to %ld", count, (long int) entry[0].first_iteration,
+	    (long int) entry[0].first_iteration + iterations - 1);
+	free(entry);
+
+	dbg(DBG_LOW, "end of merging pvalue file(s) phase\n");
+}
+
+
+/*
+ * compareEntries - order two struct pval_file_entry by their first iteration, for qsort()
+ */
+static int
+compareEntries(const void *a, const void *b)
+{
+	const struct pval_file_entry *ea = (const struct pval_file_entry *) a;
+	const struct pval_file_entry *eb = (const struct pval_file_entry *) b;
+
+	if (ea->first_iteration != eb->first_iteration) {
+		return (ea->first_iteration < eb->first_iteration) ? -1 : 1;
+	}
+	return (ea->jobnum < eb->jobnum) ? -1 : (ea->jobnum > eb->jobnum);
+}
+
+
+/*
+ * read_p_val_stream - read a version 2 .pvalues file from an open descriptor into memory
+ *
+ * given:
+ *      fd              // open descriptor, such as a pipe, positioned at the start of the file
+ *      name            // name of the stream, for warnings
+ *      size            // set to the size of the file in bytes
+ *
+ * returns:
+ *      malloced image of the file, NULL ==> the file could not be read (a warning was issued)
+ *
+ * The file must have been written by a host of the same byte order, as its size is computed from
+ * the columns of its header.  The image may be given to append_p_val_image() later on.
+ */
+void *
+read_p_val_stream(int fd, const char *name, size_t *size)
+{
+	struct pval_file_header header;	// Header of the file
+	unsigned char *image;		// Image of the file
+	int64_t end;			// Size of the file
+	int64_t column_end;		// Offset beyond the end of the current column
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (name == NULL) {
+		err(89, __func__, "name arg was NULL");
+	}
+	if (size == NULL) {
+		err(89, __func__, "size arg was NULL");
+	}
+
+	/*
+	 * Read the header and compute the size of the file
+	 */
+	if (readFully(fd, &header, sizeof(header)) == false) {
+		if (errno == 0) {
+			warn(__func__, "p-value stream ended within its header: %s", name);
+		} else {
+			warnp(__func__, "cannot read the header of p-value stream: %s", name);
+		}
+		return NULL;
+	}
+	if (memcmp(header.magic, PVAL_FILE_MAGIC, sizeof(PVAL_FILE_MAGIC)) != 0 || header.endian != PVAL_FILE_ENDIAN ||
+	    header.header_size != sizeof(header)) {
+		warn(__func__, "p-value stream does not start with a version %d header of this host: %s",
+		     PVAL_FILE_VERSION, name);
+		return NULL;
+	}
+	end = (int64_t) sizeof(header);
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (header.column[i].offset == 0) {
+			continue;
+		}
+		if (header.column[i].offset < end || header.column[i].count < 0 ||
+		    header.column[i].count > (INT64_MAX - header.column[i].offset) / (int64_t) sizeof(double)) {
+			warn(__func__, "column of test %d of p-value stream is not after the previous one: %s", i, name);
+			return NULL;
+		}
+		column_end = header.column[i].offset + header.column[i].count * (int64_t) sizeof(double);
+		end = MAX(end, column_end);
+	}
+
+	/*
+	 * Read the columns after the header
+	 */
+	image = malloc((size_t) end);
+	if (image == NULL) {
+		errp(89, __func__, "cannot malloc of %ld bytes for the image of p-value stream: %s", (long int) end, name);
+	}
+	memcpy(image, &header, sizeof(header));
+	if (readFully(fd, image + sizeof(header), (size_t) end - sizeof(header)) == false) {
+		if (errno == 0) {
+			warn(__func__, "p-value stream ended within its %ld bytes: %s", (long int) end, name);
+		} else {
+			warnp(__func__, "cannot read the %ld bytes of p-value stream: %s", (long int) end, name);
+		}
+		free(image);
+		return NULL;
+	}
+	*size = (size_t) end;
+
+	return image;
+}
+
+
+/*
+ * append_p_val_image - append the p_values of the in memory image of a version 2 .pvalues file to state->p_val
+ *
+ * given:
+ *      state           // run state whose p_val arrays are appended to
+ *      image           // image of the file, such as returned by read_p_val_stream()
+ *      size            // size of the image in bytes
+ *      name            // name of the image, for warnings
+ *
+ * returns:
+ *      true ==> the image was appended, false ==> it was skipped (a warning was issued)
+ */
+bool
+append_p_val_image(struct state *state, const void *image, size_t size, const char *name)
+{
+	bool bins_fixed;		// true ==> aggregated images must have state->tp.uniformity_bins bins
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(89, __func__, "state arg was NULL");
+	}
+	if (image == NULL) {
+		err(89, __func__, "image arg was NULL");
+	}
+	if (name == NULL) {
+		err(89, __func__, "name arg was NULL");
+	}
+	if (size < sizeof(struct pval_file_header)) {
+		warn(__func__, "skipping p-value image, too short for a version %d header: %s", PVAL_FILE_VERSION, name);
+		return false;
+	}
+
+	bins_fixed = (state->uniformityBinsFlag == true || state->legacy_output == true);
+	return readPvalImage(state, image, size, &bins_fixed, name);
+}
+
+
+/*
+ * readPvalFileV2 - append the p_values of a version 2 .pvalues file to state->p_val
+ *
+ * given:
+ *      state           // run state to assess
+ *      fd              // open file descriptor of the file
+ *      bins_fixed      // true ==> aggregated files must have state->tp.uniformity_bins bins
+ *      filename        // name of the file
+ *
+ * returns:
+ *      true ==> the file was read, false ==> the file was skipped (a warning was issued)
+ *
+ * The file is mapped and read in place by readPvalImage().
+ */
+static bool
+readPvalFileV2(struct state *state, int fd, bool *bins_fixed, const char *filename)
+{
+	struct stat st;			// Status of the file
+	void *map;			// Mapping of the whole file
+	bool ret;			// readPvalImage return
+
+	/*
+	 * Map the file
+	 */
+	if (fstat(fd, &st) < 0) {
+		warnp(__func__, "skipping p-value file, cannot stat: %s", filename);
+		return false;
+	}
+	if (st.st_size < (off_t) sizeof(struct pval_file_header)) {
+		warn(__func__, "skipping p-value file, too short for a version %d header: %s", PVAL_FILE_VERSION, filename);
+		return false;
+	}
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		warnp(__func__, "skipping p-value file, cannot mmap: %s", filename);
+		return false;
+	}
+	(void) madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+	/*
+	 * Read the file in place
+	 */
+	ret = readPvalImage(state, map, (size_t) st.st_size, bins_fixed, filename);
+	munmap(map, (size_t) st.st_size);
+
+	return ret;
+}
+
+
+/*
+ * readPvalImage - append the p_values of the image of a version 2 .pvalues file to state->p_val
+ *
+ * given:
+ *      state           // run state to assess
+ *      image           // image of the whole file, at least a header long
+ *      size            // size of the image in bytes
+ *      bins_fixed      // true ==> aggregated files must have state->tp.uniformity_bins bins
+ *      filename        // name of the file
+ *
+ * returns:
+ *      true ==> the file was read, false ==> the file was skipped (a warning was issued)
+ *
+ * Each column is appended to the p_val of its test with a single copy, or added to the tally of
+ * its test when the file is aggregated.
+ */
+static bool
+readPvalImage(struct state *state, const void *image, size_t size, bool *bins_fixed, const char *filename)
+{
+	struct pval_file_header header;	// Header of the file, in host byte order
+	bool swap;			// true ==> file was written in the other byte order
+	int i;
+
+	/*
+	 * Check the header
+	 */
+	memcpy(&header, image, sizeof(header));
+	if (checkPvalHeader(state, &header, (off_t) size, &swap, bins_fixed, false, filename) == false) {
+		return false;
+	}
+
+	/*
+	 * Append the column of each enabled test
+	 */
+	if (header.kind == PVAL_FILE_AGGREGATE) {
+		allocMetricTallies(state);
+	}
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->testVector[i] != true || state->p_val[i] == NULL) {
+			continue;
+		}
+		if (header.column[i].offset == 0) {
+			warn(__func__, "p-value file has no p-values for test %s[%d]: %s", state->testNames[i], i, filename);
+			continue;
+		}
+		if (header.kind == PVAL_FILE_AGGREGATE) {
+			if (state->tally[i] != NULL) {
+				addAggregateColumn(state, i, (const int64_t *) ((const char *) image + header.column[i].offset),
+						   &header, swap);
+			}
+		} else {
+			appendColumn(state, i, (const double *) ((const char *) image + header.column[i].offset),
+				     (long int) header.column[i].count, swap);
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * checkPvalHeader - check that a version 2 header describes a file that this run can assess
+ *
+ * given:
+ *      state           // run state to assess
+ *      header          // header of the file, converted in place to host byte order
+ *      size            // size of the file in bytes
+ *      swap            // set to true when the file was written in the other byte order
+ *      bins_fixed      // true ==> aggregated files must have state->tp.uniformity_bins bins
+ *      merging         // true ==> a file that can not be merged is fatal
+ *      filename        // name of the file
+ *
+ * returns:
+ *      true ==> the file can be read, false ==> skip the file (a warning was issued)
+ *
+ * When merging, every file must hold the same test parameters and partitions, as a merged file
+ * that silently lacked some of the iterations could not be told apart from a complete one.
+ *
+ * Unless the uniformity bins were fixed by -P 8 or -O, the first aggregated file sets the number of
+ * uniformity bins of the run, as its tallies can not be binned again.
+ */
+static bool
+checkPvalHeader(struct state *state, struct pval_file_header *header, off_t size, bool *swap,
+		bool *bins_fixed, bool merging, const char *filename)
+{
+	int i;
+
+	/*
+	 * Convert the header to host byte order if needed
+	 */
+	if (header->endian == PVAL_FILE_ENDIAN) {
+		*swap = false;
+	} else if (header->endian == swap32(PVAL_FILE_ENDIAN)) {
+		*swap = true;
+		header->version = swap32(header->version);
+		header->header_size = swap32(header->header_size);
+		header->kind = swap32(header->kind);
+		swapInt64(&header->jobnum);
+		swapInt64(&header->first_iteration);
+		swapInt64(&header->iterations);
+		swapInt64(&header->reservoir_size);
+		swapInt64(&header->tp.blockFrequencyBlockLength);
+		swapInt64(&header->tp.nonOverlappingTemplateLength);
+		swapInt64(&header->tp.overlappingTemplateLength);
+		swapInt64(&header->tp.approximateEntropyBlockLength);
+		swapInt64(&header->tp.serialBlockLength);
+		swapInt64(&header->tp.linearComplexitySequenceLength);
+		swapInt64(&header->tp.numOfBitStreams);
+		swapInt64(&header->tp.uniformity_bins);
+		swapInt64(&header->tp.n);
+		swapDouble(&header->tp.uniformity_level);
+		swapDouble(&header->tp.alpha);
+		swapInt64(&header->tp.rankMatrixSize);
+		for (i = 0; i <= NUMOFTESTS; i++) {
+			swapInt64(&header->column[i].offset);
+			swapInt64(&header->column[i].count);
+			swapInt64(&header->column[i].partitionCount);
+		}
+	} else {
+		rejectPvalFile(merging, filename, "unknown byte order mark 0x%08x", header->endian);
+		return false;
+	}
+
+	/*
+	 * Check the layout of the file
+	 */
+	if (header->version != PVAL_FILE_VERSION || header->header_size != sizeof(*header)) {
+		rejectPvalFile(merging, filename, "version %u with a %u byte header is not version %d",
+			       header->version, header->header_size, PVAL_FILE_VERSION);
+		return false;
+	}
+	if (header->kind != PVAL_FILE_RAW && header->kind != PVAL_FILE_AGGREGATE) {
+		rejectPvalFile(merging, filename, "unknown kind of file: %u", header->kind);
+		return false;
+	}
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (header->column[i].offset == 0) {
+			continue;
+		}
+		if (header->column[i].offset < (int64_t) sizeof(*header) || header->column[i].offset % sizeof(double) != 0 ||
+		    header->column[i].count < 0 ||
+		    header->column[i].count > (size - header->column[i].offset) / (int64_t) sizeof(double)) {
+			rejectPvalFile(merging, filename, "column of test %d is outside of the file", i);
+			return false;
+		}
+	}
+
+	/*
+	 * Check that the p_values were computed with the test parameters of this run
+	 */
+	if (header->tp.n != state->tp.n ||
+	    header->tp.blockFrequencyBlockLength != state->tp.blockFrequencyBlockLength ||
+	    header->tp.nonOverlappingTemplateLength != state->tp.nonOverlappingTemplateLength ||
+	    header->tp.overlappingTemplateLength != state->tp.overlappingTemplateLength ||
+	    header->tp.approximateEntropyBlockLength != state->tp.approximateEntropyBlockLength ||
+	    header->tp.serialBlockLength != state->tp.serialBlockLength ||
+	    header->tp.linearComplexitySequenceLength != state->tp.linearComplexitySequenceLength ||
+	    header->tp.rankMatrixSize != state->tp.rankMatrixSize) {
+		rejectPvalFile(merging, filename, "its test parameters differ from the ones of this run");
+		return false;
+	}
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->testVector[i] == true && header->column[i].offset != 0 &&
+		    header->column[i].partitionCount != state->partitionCount[i]) {
+			rejectPvalFile(merging, filename, "test %s[%d] has %ld partitions instead of %d",
+				       state->testNames[i], i, (long int) header->column[i].partitionCount,
+				       state->partitionCount[i]);
+			return false;
+		}
+	}
+
+	/*
+	 * Check that the tallies of an aggregated file can be added to the ones of this run
+	 */
+	if (header->kind == PVAL_FILE_AGGREGATE) {
+		if (header->tp.alpha != state->tp.alpha) {
+			rejectPvalFile(merging, filename, "its alpha: %f differs from the one of this run: %f",
+				       header->tp.alpha, state->tp.alpha);
+			return false;
+		}
+		if (header->tp.uniformity_bins < 1 || header->reservoir_size < 0 || header->reservoir_size > MAX_RESERVOIR_SIZE) {
+			rejectPvalFile(merging, filename, "invalid %ld bins or %ld samples",
+				       (long int) header->tp.uniformity_bins, (long int) header->reservoir_size);
+			return false;
+		}
+		for (i = 1; i <= NUMOFTESTS; i++) {
+			if (header->column[i].offset != 0 && header->column[i].count != header->column[i].partitionCount *
+			    (2 + header->tp.uniformity_bins + header->reservoir_size)) {
+				rejectPvalFile(merging, filename, "column of test %d has %ld words", i,
+					       (long int) header->column[i].count);
+				return false;
+			}
+		}
+		if (header->tp.uniformity_bins != state->tp.uniformity_bins) {
+			if (*bins_fixed == true) {
+				rejectPvalFile(merging, filename, "its %ld uniformity bins differ from the %ld of this run",
+					       (long int) header->tp.uniformity_bins, state->tp.uniformity_bins);
+				return false;
+			}
+			dbg(DBG_LOW, "using the %ld uniformity bins of aggregated p-value file: %s",
+			    (long int) header->tp.uniformity_bins, filename);
+			state->tp.uniformity_bins = header->tp.uniformity_bins;
+		}
+		*bins_fixed = true;
+	}
+	dbg(DBG_MED, "p-value file %s: job %ld, iterations %ld to %ld", filename, (long int) header->jobnum,
+	    (long int) header->first_iteration, (long int) (header->first_iteration + header->iterations - 1));
+
+	return true;
+}
+
+/*
+ * rejectPvalFile - report a p-value file that checkPvalHeader() can not accept
+ *
+ * given:
+ *      merging         // true ==> the file can not be merged, which is fatal
+ *      filename        // name of the file
+ *      fmt             // format of the reason why the file is rejected
+ *      ...             // args of the format
+ *
+ * This function does not return when merging.
+ */
+static void
+rejectPvalFile(bool merging, const char *filename, const char *fmt, ...)
+{
+	char reason[BUFSIZ];		// Reason why the file is rejected
+	va_list ap;			// Args of the format
+
+	va_start(ap, fmt);
+	vsnprintf(reason, sizeof(reason), fmt, ap);
+	va_end(ap);
+	if (merging == true) {
+		err(87, "checkPvalHeader", "cannot merge p-value file, %s: %s", reason, filename);
+	}
+	warn("checkPvalHeader", "skipping p-value file, %s: %s", reason, filename);
+}
+
+
+/*
+ * appendColumn - append a column of p_values to the p_val of a test
+ *
+ * given:
+ *      state           // run state to assess
+ *      test            // test whose p_val is appended to
+ *      column          // count p_values, possibly in the other byte order
+ *      count           // number of p_values in column
+ *      swap            // true ==> column is in the other byte order
+ */
+static void
+appendColumn(struct state *state, int test, const double *column, long int count, bool swap)
+{
+	struct dyn_array *p_val;	// p_values of the test
+	unsigned char *buf;		// Buffer of converted elements
+	long int done;			// Number of p_values already appended
+	long int len;			// Number of p_values in the buffer
+	double p_value;			// Current p_value
+	long int i;
+
+	p_val = state->p_val[test];
+	if (count == 0) {
+		return;
+	}
+
+	/*
+	 * Append an array of doubles in host byte order with a single copy
+	 */
+	if (p_val->elm_size == sizeof(double) && swap == false) {
+		append_array(p_val, (void *) column, count);
+		return;
+	}
+
+	/*
+	 * Otherwise convert the p_values to elements of p_val, a buffer at a time
+	 */
+	buf = calloc(PVAL_FILE_BUFFER, p_val->elm_size);
+	if (buf == NULL) {
+		errp(83, __func__, "cannot calloc of %d elements of %lu bytes each for buf", PVAL_FILE_BUFFER,
+		     p_val->elm_size);
+	}
+	for (done = 0; done < count; done += len) {
+		len = MIN(count - done, PVAL_FILE_BUFFER);
+		for (i = 0; i < len; i++) {
+			memcpy(&p_value, &column[done + i], sizeof(p_value));
+			if (swap == true) {
+				swapDouble(&p_value);
+			}
+			memcpy(buf + i * p_val->elm_size, &p_value, sizeof(p_value));	// p_value is the first member
+		}
+		append_array(p_val, buf, len);
+	}
+	free(buf);
+
+	return;
+}
+
+
+/*
+ * addAggregateColumn - add the metric tally of a test in an aggregated file to the tally of the run
+ *
+ * given:
+ *      state           // run state to assess or merge
+ *      test            // test whose tally is added to
+ *      column          // record of each partition, possibly in the other byte order
+ *      header          // header of the file, in host byte order
+ *      swap            // true ==> column is in the other byte order
+ *
+ * The sampled p_values of the file are merged into the ones of the tally when merging into an
+ * aggregated file (state->reservoirSize > 0), and skipped otherwise.
+ */
+static void
+addAggregateColumn(struct state *state, int test, const int64_t *column, struct pval_file_header *header,
+		   bool swap)
+{
+	struct metric_tally *tally;	// Tally of the test
+	const int64_t *record;		// Record of the current partition
+	double *sample;			// p_values sampled from the current partition
+	long int partitions;		// Number of partitions of the test
+	long int bins;			// Number of uniformity bins
+	long int size;			// Number of sampled p_values per partition of the tally
+	long int population;		// Number of p_values the tally of the partition was sampled from
+	long int count;			// Number of p_values in sample
+	uint64_t seed;			// State of the sampling generator
+	int64_t value;			// Current count
+	long int j;
+	long int k;
+
+	tally = state->tally[test];
+	partitions = state->partitionCount[test];
+	bins = state->tp.uniformity_bins;
+	size = state->reservoirSize;
+	if (size > header->reservoir_size) {
+		err(86, __func__, "file has %ld sampled p_values per partition < %ld", (long int) header->reservoir_size, size);
+	}
+
+	/*
+	 * Allocate the sampled p_values of the tally on first use
+	 */
+	sample = NULL;
+	if (size > 0) {
+		if (tally->reservoir == NULL) {
+			tally->reservoir = malloc((size_t) (partitions * size) * sizeof(tally->reservoir[0]));
+			if (tally->reservoir == NULL) {
+				errp(86, __func__, "cannot malloc of %ld elements of %lu bytes each for tally->reservoir",
+				     partitions * size, sizeof(tally->reservoir[0]));
+			}
+			for (k = 0; k < partitions * size; k++) {
+				tally->reservoir[k] = NON_P_VALUE;
+			}
+		}
+		sample = malloc((size_t) header->reservoir_size * sizeof(sample[0]));
+		if (sample == NULL) {
+			errp(86, __func__, "cannot malloc of %ld elements of %lu bytes each for sample",
+			     (long int) header->reservoir_size, sizeof(sample[0]));
+		}
+	}
+	seed = ((uint64_t) header->first_iteration << 8) ^ (uint64_t) test;
+
+	for (j = 0; j < partitions; j++) {
+		record = column + j * (2 + bins + header->reservoir_size);
+		population = tally->sampleCount[j];
+		for (k = 0; k < 2 + bins; k++) {
+			memcpy(&value, &record[k], sizeof(value));
+			if (swap == true) {
+				swapInt64(&value);
+			}
+			if (k == 0) {
+				tally->sampleCount[j] += (long int) value;
+			} else if (k == 1) {
+				tally->toolow[j] += (long int) value;
+			} else {
+				tally->freqPerBin[j * bins + k - 2] += (long int) value;
+			}
+		}
+
+		/*
+		 * Merge the sampled p_values of the partition
+		 */
+		if (sample != NULL) {
+			count = MIN(header->reservoir_size, tally->sampleCount[j] - population);
+			for (k = 0; k < count; k++) {
+				memcpy(&sample[k], &record[2 + bins + k], sizeof(sample[k]));
+				if (swap == true) {
+					swapDouble(&sample[k]);
+				}
+			}
+			mergeReservoir(tally->reservoir + j * size, population, sample, count,
+				       tally->sampleCount[j] - population, size, &seed);
+		}
+	}
+	tally->count += (long int) header->iterations * partitions;
+	free(sample);
+
+	return;
+}
+
+
+/*
+ * readPvalFileV1 - append the p_values of a version 1 .pvalues file to state->p_val
+ *
+ * given:
+ *      state           // run state to assess
+ *      p_val_file      // open file, at its beginning
+ *      filename        // name of the file
+ */
+static void
+readPvalFileV1(struct state *state, FILE * p_val_file, const char *filename)
+{
+	long int test_num;		// test number for the pvalues that follow in the pvalue file
+	long int p_val_index;		// current pvalue number for a given test number in the pvalue file
+	size_t ret;			// fread return
+
+	/*
+	 * Read the content of the file
+	 */
+	do {
+
+		/*
+		 * Read the test number
+		 */
+		ret = fread(&test_num, sizeof(test_num), 1, p_val_file);
+		if (ferror(p_val_file)) {
+			warnp(__func__, "skipping p-value, error while reading test number from p-value file: %s",
+			      filename);
+			break;
+		}
+		if (feof(p_val_file)) {
+			warn(__func__, "skipping p-value file, found EOF while reading test number from p-value file: %s",
+			     filename);
+			break;
+		}
+		if (ret != 1) {
+			warn(__func__, "skipping p-value file, unable to read test number from p-value file: %s",
+			     filename);
+			break;
+		}
+
+		/*
+		 * Read number of p-values for the current testnum
+		 */
+		long int number_of_p_vals;	// number of pvalues that follow in the pvalue file
+		ret = fread(&number_of_p_vals, sizeof(number_of_p_vals), 1, p_val_file);
+		if (ferror(p_val_file)) {
+			warnp(__func__, "skipping p-value file, error while reading number_of_p_vals from p-value file: %s",
+			      filename);
+			break;
+		}
+		if (feof(p_val_file)) {
+			warn(__func__, "skipping p-value file, found EOF while reading number of pvals in p-value file: %s",
+			     filename);
+			break;
+		}
+		if (ret != 1) {
+			warn(__func__, "skipping p-value file, unable to read number_of_p_vals from p-value file: %s",
+			     filename);
+			break;
+		}
+
+		/*
+		 * Read all the p-values for this test
+		 */
+		for (p_val_index = 0; p_val_index < number_of_p_vals; p_val_index++) {
+			double p_val;		// pvalue read from pvalue file
+
+			/*
+			 * Read one p-value
+			 */
+			ret = fread(&p_val, sizeof(p_val), 1, p_val_file);
+			if (ferror(p_val_file)) {
+				warnp(__func__, "error while reading a pvalue[%ld] from file: %s", p_val_index, filename);
+				break;
+			}
+			if (feof(p_val_file)) {
+				warn(__func__, "EOF while reading pvalue[%ld] from file: %s", p_val_index, filename);
+				break;
+			}
+			if (ret != 1) {
+				warn(__func__, "unable to read a pvalue[%ld] from file: %s", p_val_index, filename);
+				break;
+			}
+
+			/*
+			 * Append each read p-value to the p-values of this test
+			 */
+			if (test_num != TEST_NON_OVERLAPPING) {
+				append_value(state->p_val[test_num], &p_val);
+			} else {
+				struct nonover_stats nonov;
+				nonov.p_value = p_val;
+				append_value(state->p_val[test_num], &nonov);
+			}
+		}
+
+	} while (!feof(p_val_file) && !ferror(p_val_file) && ret == 1 && test_num < NUMOFTESTS);
+
+	return;
+}
+
+
+/*
+ * readFully - read len bytes from a descriptor, such as a pipe, retrying short reads
+ *
+ * given:
+ *      fd              // open file descriptor
+ *      buf             // where to read
+ *      len             // number of bytes to read
+ *
+ * returns:
+ *      true ==> all bytes were read, false ==> they were not (errno is 0 at the end of the file)
+ */
+static bool
+readFully(int fd, void *buf, size_t len)
+{
+	ssize_t ret;			// read return
+
+	while (len > 0) {
+		ret = read(fd, buf, len);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret <= 0) {
+			if (ret == 0) {
+				errno = 0;
+			}
+			return false;
+		}
+		buf = (char *) buf + ret;
+		len -= (size_t) ret;
+	}
+
+	return true;
+}
+
+
+/*
+ * swap32 - reverse the byte order of a 32 bit value
+ */
+static uint32_t
+swap32(uint32_t value)
+{
+	return ((value & 0x000000ffU) << 24) | ((value & 0x0000ff00U) << 8) |
+	       ((value & 0x00ff0000U) >> 8) | ((value & 0xff000000U) >> 24);
+}
+
+
+/*
+ * swap64 - reverse the byte order of a 64 bit value
+ */
+static uint64_t
+swap64(uint64_t value)
+{
+	return ((uint64_t) swap32((uint32_t) (value & 0xffffffffU)) << 32) | (uint64_t) swap32((uint32_t) (value >> 32));
+}
+
+
+/*
+ * swapInt64 - reverse the byte order of a 64 bit integer in place
+ */
+static void
+swapInt64(int64_t *value)
+{
+	uint64_t bits;
+
+	memcpy(&bits, value, sizeof(bits));
+	bits = swap64(bits);
+	memcpy(value, &bits, sizeof(bits));
+}
+
+
+/*
+ * swapDouble - reverse the byte order of a double in place
+ */
+static void
+swapDouble(double *value)
+{
+	uint64_t bits;
+
+	memcpy(&bits, value, sizeof(bits));
+	bits = swap64(bits);
+	memcpy(value, &bits, sizeof(bits));
+}
@@ -0,0 +1,98 @@
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+#ifndef _PVAL_FILE_H_
+#   define _PVAL_FILE_H_
+
+#   include <stdint.h>
+#   include "defs.h"
+
+/*
+ * .pvalues file format
+ *
+ * Version 1 files are a headerless stream of, for each enabled test: a long int test number,
+ * a long int count and count doubles.  They are still read, but no longer written.
+ *
+ * Version 2 files start with a struct pval_file_header, followed by one contiguous column of
+ * doubles for each test, at the offset given in the header.  A column holds the p_values of the
+ * test row after row, partitionCount p_values per iteration.  The header size and every column
+ * offset are multiples of 8, so the file can be mapped and its columns used in place.  All fields
+ * are in the byte order of the writing host, given by the endian field.
+ *
+ * The columns of an aggregated file (-G samples) hold instead, for each partition of the test,
+ * the int64_t sampleCount, toolow and uniformity_bins bins of its metric tally, followed by
+ * reservoir_size doubles: the p_values sampled from the partition, unused slots set to NON_P_VALUE.
+ * The count of such a column is its number of 8 byte words.
+ */
+#   define PVAL_FILE_MAGIC "STSPVAL"	// 7 characters and a NUL
+#   define PVAL_FILE_VERSION (2)
+#   define PVAL_FILE_ENDIAN ((uint32_t) 0x01020304)
+
+enum pval_file_kind {
+	PVAL_FILE_RAW = 1,		// Columns of p_values
+	PVAL_FILE_AGGREGATE = 2,	// Columns of metric tallies and sampled p_values
+};
+
+struct pval_file_tp {
+	int64_t blockFrequencyBlockLength;
+	int64_t nonOverlappingTemplateLength;
+	int64_t overlappingTemplateLength;
+	int64_t approximateEntropyBlockLength;
+	int64_t serialBlockLength;
+	int64_t linearComplexitySequenceLength;
+	int64_t numOfBitStreams;
+	int64_t uniformity_bins;
+	int64_t n;
+	double uniformity_level;
+	double alpha;
+	int64_t rankMatrixSize;
+};
+
+struct pval_file_column {
+	int64_t offset;			// Byte offset of the column in the file, 0 ==> test not in the file
+	int64_t count;			// Number of p_values in the column
+	int64_t partitionCount;		// Number of p_values of each iteration
+};
+
+struct pval_file_header {
+	char magic[8];			// PVAL_FILE_MAGIC
+	uint32_t version;		// PVAL_FILE_VERSION
+	uint32_t endian;		// PVAL_FILE_ENDIAN as stored by the writing host
+	uint32_t header_size;		// sizeof(struct pval_file_header)
+	uint32_t kind;			// enum pval_file_kind
+	int64_t jobnum;			// -j jobnum of the run that wrote the file
+	int64_t first_iteration;	// Index of the first iteration of the file among all jobs
+	int64_t iterations;		// Number of iterations (bit streams) in the file
+	int64_t reservoir_size;		// p_values sampled per partition of an aggregated file, 0 otherwise
+	struct pval_file_tp tp;		// Test parameters of the run that wrote the file
+	struct pval_file_column column[NUMOFTESTS + 1];	// Column of each test, column[0] is not used
+};
+
+extern void write_p_val_to_file(struct state *state);
+extern void write_p_val_to_stream(struct state *state, FILE * stream, const char *name);
+extern void *read_p_val_stream(int fd, const char *name, size_t *size);
+extern bool append_p_val_image(struct state *state, const void *image, size_t size, const char *name);
+extern void read_from_p_val_file(struct state *state);
+extern void merge_p_val_files(struct state *state);
+
+#endif				/* _PVAL_FILE_H_ */
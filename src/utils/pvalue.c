@@ -0,0 +1,289 @@
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+#include <stdbool.h>
+#include <math.h>
+#include "pvalue.h"
+#include "cephes.h"
+
+
+/*
+ * Closed forms are only used for a <= PVALUE_MAX_CLOSED_FORM_A, so that the finite sums stay short,
+ * and for x <= PVALUE_MAX_CLOSED_FORM_X, so that exp(-x) does not underflow.
+ */
+#define PVALUE_MAX_CLOSED_FORM_A (64.0)
+#define PVALUE_MAX_CLOSED_FORM_X (700.0)
+
+/*
+ * Batches are evaluated PVALUE_BATCH_BLOCK values at a time, in stack arrays that stay in L1 cache
+ */
+#define PVALUE_BATCH_BLOCK (64)
+
+#if defined(M_2_SQRTPI)
+#   define TWO_OVER_SQRTPI (M_2_SQRTPI)
+#else
+#   define TWO_OVER_SQRTPI ((double) 1.12837916709551257390)	// 2 / sqrt(pi)
+#endif
+
+
+/*
+ * Static function declarations
+ */
+static double igamc_integer(long int m, double x);
+static double igamc_half_integer(long int m, double x);
+
+
+/*
+ * pvalue_igamc - complemented incomplete gamma integral Q(a, x) used for the p-values of the tests
+ *
+ * given:
+ *      a               // degrees of freedom / 2 of the chi-square statistic
+ *      x               // chi-square statistic / 2
+ *
+ * returns:
+ *      Q(a, x), with the same conventions as cephes_igamc()
+ *
+ * The tests call this with small a that are whole or half integers, where Q(a, x) has a finite
+ * closed form that needs no continued fraction, no series and no lgamma():
+ *
+ *      Q(m, x)       = exp(-x) * sum_{k=0}^{m-1} x^k / k!
+ *      Q(m + 1/2, x) = erfc(sqrt(x)) + exp(-x) * sum_{k=1}^{m} x^(k - 1/2) / gamma(k + 1/2)
+ *
+ * All terms of these sums are positive, so they lose no precision to cancellation.
+ * Any other a, or a large a or x, is handed over to cephes_igamc().
+ *
+ * Validation: x was sampled at 20000 log spaced points from [1e-6, 700] for each a, keeping the
+ * points where Q(a, x) is a normal double.  The reference is Q(a, x) computed independently by
+ * mpmath.gammainc(a, x, regularized=True) with 40 significant digits.  Listed are the largest
+ * relative errors in units of 2^-52 (ulp), over all points / over the points where Q(a, x) >= 1e-3:
+ *
+ *        a     used by                        pvalue vs cephes   pvalue vs ref   cephes vs ref
+ *      ----    ---------------------------    ----------------   -------------   -------------
+ *       0.5    serial                            849.7 / 58.9      413.0 / 5.7     479.5 / 59.0
+ *       1      serial, approximate entropy       256.5 /  7.2        0.5 / 0.5     256.7 /  7.1
+ *       2      serial, approximate entropy       257.9 /  4.5        1.2 / 1.2     258.0 /  4.5
+ *       2.5    overlapping, rnd excursions       344.6 / 21.6        2.3 / 1.8     343.4 / 21.9
+ *       3      longest run, linear complexity    504.7 /  4.9        1.5 / 1.4     504.4 /  5.5
+ *       4      non-overlapping                   315.6 /  5.6        1.7 / 1.7     315.7 /  5.7
+ *       4.5    uniformity of all tests           368.9 / 10.6        2.5 / 2.5     369.0 / 10.4
+ *       8      block frequency, serial, apen     389.6 / 14.9        3.4 / 2.5     388.3 / 14.6
+ *      16      block frequency, serial, apen     364.5 / 16.8        4.9 / 3.9     363.4 / 17.4
+ *      32      block frequency, serial, apen      98.8 / 63.7        7.1 / 6.5      99.9 / 60.4
+ *      64      block frequency, serial, apen     271.5 / 271.5      10.5 / 9.2     269.2 / 269.2
+ *
+ * So pvalue_igamc() differs from cephes_igamc() by up to 850 ulp, and by up to 272 ulp where
+ * Q(a, x) >= 1e-3.  Those differences are the error of cephes_igamc(): the closed forms are
+ * within 11 ulp of the reference, except for Q(1/2, x) = erfc(sqrt(x)), whose relative error
+ * grows with x (to 413 ulp near x = 700) because of the rounding of sqrt(x).  Such x give
+ * p-values far below any alpha, so no test outcome depends on them.
+ */
+double
+pvalue_igamc(double a, double x)
+{
+	double twice_a;		// 2 * a, whole when a is a whole or half integer
+
+	/*
+	 * Same edge cases as cephes_igamc()
+	 */
+	if ((x <= 0) || (a <= 0)) {
+		return 1.0;
+	}
+
+	/*
+	 * Use the closed forms for small whole and half integer a
+	 */
+	twice_a = 2.0 * a;
+	if (a <= PVALUE_MAX_CLOSED_FORM_A && x <= PVALUE_MAX_CLOSED_FORM_X && twice_a == floor(twice_a)) {
+		if (a == floor(a)) {
+			return igamc_integer((long int) a, x);
+		}
+		return igamc_half_integer((long int) (a - 0.5), x);
+	}
+
+	/*
+	 * Fall back on the generic continued fraction / power series
+	 */
+	return cephes_igamc(a, x);
+}
+
+
+/*
+ * igamc_integer - Q(m, x) for a whole number m >= 1
+ *
+ * given:
+ *      m               // whole number of degrees of freedom / 2
+ *      x               // chi-square statistic / 2, 0 < x <= PVALUE_MAX_CLOSED_FORM_X
+ */
+static double
+igamc_integer(long int m, double x)
+{
+	double term;		// x^k / k!
+	double sum;		// Sum of the terms so far
+	long int k;
+
+	term = 1.0;
+	sum = 1.0;
+	for (k = 1; k < m; k++) {
+		term *= x / (double) k;
+		sum += term;
+	}
+
+	return exp(-x) * sum;
+}
+
+
+/*
+ * igamc_half_integer - Q(m + 1/2, x) for a whole number m >= 0
+ *
+ * given:
+ *      m               // whole part of the degrees of freedom / 2
+ *      x               // chi-square statistic / 2, 0 < x <= PVALUE_MAX_CLOSED_FORM_X
+ */
+static double
+igamc_half_integer(long int m, double x)
+{
+	double sqrt_x;		// Square root of x
+	double term;		// x^(k - 1/2) / gamma(k + 1/2)
+	double sum;		// Sum of the terms so far
+	long int k;
+
+	sqrt_x = sqrt(x);
+	term = TWO_OVER_SQRTPI * sqrt_x;	// x^(1/2) / gamma(3/2)
+	sum = 0.0;
+	for (k = 1; k <= m; k++) {
+		sum += term;
+		term *= x / ((double) k + 0.5);
+	}
+
+	return erfc(sqrt_x) + exp(-x) * sum;
+}
+
+
+/*
+ * pvalue_igamc_batch - complemented incomplete gamma integral Q(a, x[i]) of count values sharing the same a
+ *
+ * given:
+ *      a               // degrees of freedom / 2 of the chi-square statistics
+ *      x               // array of count chi-square statistics / 2
+ *      out             // array of count Q(a, x[i]) results, may be the same array as x
+ *      count           // number of values to evaluate
+ *
+ * The results are the same as count calls of pvalue_igamc(a, x[i]).  The closed form is chosen
+ * once for the whole batch, and its finite sum is done one term at a time across a block of
+ * values, so that the inner loops have no dependency between iterations and can be vectorized.
+ */
+void
+pvalue_igamc_batch(double a, const double *x, double *out, long int count)
+{
+	double xb[PVALUE_BATCH_BLOCK];		// Block of x values, each clamped to the closed form range
+	double sqrt_x[PVALUE_BATCH_BLOCK];	// Square root of each xb value
+	double term[PVALUE_BATCH_BLOCK];	// Current term of the sum of each xb value
+	double sum[PVALUE_BATCH_BLOCK];		// Sum of the terms so far of each xb value
+	double twice_a;				// 2 * a, whole when a is a whole or half integer
+	bool half;				// true ==> a is a half integer
+	long int m;				// Whole part of a
+	long int start;				// Index of the first value of the block
+	long int len;				// Number of values in the block
+	long int i;
+	long int k;
+
+	/*
+	 * Without a closed form for this a, evaluate the values one by one
+	 */
+	twice_a = 2.0 * a;
+	if (count <= 0) {
+		return;
+	}
+	if ((a <= 0) || (a > PVALUE_MAX_CLOSED_FORM_A) || (twice_a != floor(twice_a))) {
+		for (i = 0; i < count; i++) {
+			out[i] = pvalue_igamc(a, x[i]);
+		}
+		return;
+	}
+	m = (long int) floor(a);
+	half = (a != floor(a));
+
+	for (start = 0; start < count; start += PVALUE_BATCH_BLOCK) {
+		len = count - start;
+		if (len > PVALUE_BATCH_BLOCK) {
+			len = PVALUE_BATCH_BLOCK;
+		}
+
+		/*
+		 * Values outside of the closed form range are evaluated one by one at the end of the block
+		 */
+		for (i = 0; i < len; i++) {
+			xb[i] = ((x[start + i] > 0) && (x[start + i] <= PVALUE_MAX_CLOSED_FORM_X)) ? x[start + i] : 1.0;
+		}
+
+		if (half == true) {
+			/*
+			 * Q(m + 1/2, x) = erfc(sqrt(x)) + exp(-x) * sum_{k=1}^{m} x^(k - 1/2) / gamma(k + 1/2)
+			 */
+			for (i = 0; i < len; i++) {
+				sqrt_x[i] = sqrt(xb[i]);
+				term[i] = TWO_OVER_SQRTPI * sqrt_x[i];
+				sum[i] = 0.0;
+			}
+			for (k = 1; k <= m; k++) {
+				for (i = 0; i < len; i++) {
+					sum[i] += term[i];
+					term[i] *= xb[i] / ((double) k + 0.5);
+				}
+			}
+			for (i = 0; i < len; i++) {
+				sum[i] = erfc(sqrt_x[i]) + exp(-xb[i]) * sum[i];
+			}
+		} else {
+			/*
+			 * Q(m, x) = exp(-x) * sum_{k=0}^{m-1} x^k / k!
+			 */
+			for (i = 0; i < len; i++) {
+				term[i] = 1.0;
+				sum[i] = 1.0;
+			}
+			for (k = 1; k < m; k++) {
+				for (i = 0; i < len; i++) {
+					term[i] *= xb[i] / (double) k;
+					sum[i] += term[i];
+				}
+			}
+			for (i = 0; i < len; i++) {
+				sum[i] = exp(-xb[i]) * sum[i];
+			}
+		}
+
+		/*
+		 * Store the block, out may overlap x so it is only written now
+		 */
+		for (i = 0; i < len; i++) {
+			if ((x[start + i] > 0) && (x[start + i] <= PVALUE_MAX_CLOSED_FORM_X)) {
+				out[start + i] = sum[i];
+			} else {
+				out[start + i] = pvalue_igamc(a, x[start + i]);
+			}
+		}
+	}
+
+	return;
+}
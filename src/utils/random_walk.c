@@ -0,0 +1,295 @@
+/*****************************************************************************
+ R A N D O M   W A L K   R O U T I N E S
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+
+// Exit codes: 235 thru 239
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../utils/externs.h"
+#include "random_walk.h"
+#include "debug.h"
+
+
+/*
+ * Partial sums of the adjusted bits (+1 for a 1 bit, -1 for a 0 bit) of a byte
+ *
+ * Bit 0 of the byte is the first bit of the byte in the bit stream.
+ */
+struct walk_byte {
+	signed char sum;	// Sum of the 8 adjusted bits
+	signed char max;	// Maximum of the 8 partial sums
+	signed char min;	// Minimum of the 8 partial sums
+};
+
+/*
+ * Partial sums of each byte value, used to walk the packed bit stream 8 bits at a time
+ *
+ * The table is filled by initRandomWalk() before any thread is started.
+ */
+static struct walk_byte walk_byte_table[1 << BITS_N_BYTE];
+
+
+/*
+ * initRandomWalk - allocate the random walk of each thread if a test needs it
+ *
+ * given:
+ *      state           // run state to test under
+ *
+ * The random walk is needed by TEST_CUSUM, TEST_RND_EXCURSION and TEST_RND_EXCURSION_VAR.
+ * When none of these tests is enabled, state->random_walk is left NULL.
+ *
+ * NOTE: This function must be called after the tests have been initialized, as a test
+ *       may disable itself during its initialization, and before any thread is started.
+ */
+void
+initRandomWalk(struct state *state)
+{
+	int sum;		// Partial sum within a byte
+	int i;
+	int j;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(235, __func__, "state arg is NULL");
+	}
+
+	/*
+	 * Nothing to do if no test uses the random walk
+	 */
+	if (state->testVector[TEST_CUSUM] != true && state->testVector[TEST_RND_EXCURSION] != true &&
+	    state->testVector[TEST_RND_EXCURSION_VAR] != true) {
+		state->random_walk = NULL;
+		return;
+	}
+
+	/*
+	 * Compute the partial sums of each byte value
+	 */
+	for (i = 0; i < (1 << BITS_N_BYTE); i++) {
+		sum = 0;
+		walk_byte_table[i].max = -BITS_N_BYTE;
+		walk_byte_table[i].min = BITS_N_BYTE;
+		for (j = 0; j < BITS_N_BYTE; j++) {
+			sum += ((i >> j) & 1) ? 1 : -1;
+			walk_byte_table[i].max = (signed char) MAX(sum, walk_byte_table[i].max);
+			walk_byte_table[i].min = (signed char) MIN(sum, walk_byte_table[i].min);
+		}
+		walk_byte_table[i].sum = (signed char) sum;
+	}
+
+	/*
+	 * Allocate the random walk of each thread
+	 */
+	state->random_walk = calloc((size_t) state->numberOfThreads, sizeof(state->random_walk[0]));
+	if (state->random_walk == NULL) {
+		errp(235, __func__, "cannot calloc for random_walk: %ld elements of %lu bytes each", state->numberOfThreads,
+		     sizeof(state->random_walk[0]));
+	}
+
+	return;
+}
+
+
+/*
+ * endCycle - account for the state visits of a cycle that ended
+ *
+ * given:
+ *      walk            // random walk being computed
+ *      counter         // number of visits to each TEST_RND_EXCURSION state in the cycle that ended
+ *
+ * The counters of the cycle are added to walk->v, copied into walk->last_cycle and then
+ * cleared for the next cycle.
+ */
+static void
+endCycle(struct random_walk *walk, long int *counter)
+{
+	int i;
+
+	for (i = 0; i < NUMBER_OF_STATES_RND_EXCURSION; i++) {
+		walk->v[MIN(counter[i], DEGREES_OF_FREEDOM_RND_EXCURSION - 1)][i]++;
+	}
+	memcpy(walk->last_cycle, counter, sizeof(walk->last_cycle));
+	memset(counter, 0, sizeof(walk->last_cycle));
+	walk->number_of_cycles++;
+
+	return;
+}
+
+
+/*
+ * computeRandomWalk - walk the partial sums of the bit stream of a thread
+ *
+ * given:
+ *      state           // run state to test under
+ *      thread_id       // thread whose packed bit stream is to be walked
+ *
+ * The partial sums S_k of the adjusted bits (+1 for a 1 bit, -1 for a 0 bit) are walked
+ * once, collecting in state->random_walk[thread_id] everything needed by TEST_CUSUM,
+ * TEST_RND_EXCURSION and TEST_RND_EXCURSION_VAR: the final sum and the extrema of the
+ * partial sums, the number of cycles, the visits to each value in [-9, 9] and, for each
+ * cycle, the visits to each value in [-4, 4].
+ *
+ * The bit stream is walked 8 bits at a time through walk_byte_table[] while the partial
+ * sum is too far from 0 for any partial sum within the byte to be a value of interest.
+ */
+void
+computeRandomWalk(struct state *state, long int thread_id)
+{
+	struct random_walk *walk;	// Random walk being computed
+	long int counter[NUMBER_OF_STATES_RND_EXCURSION];	// Visits to each state in the current cycle
+	const struct walk_byte *partial;	// Partial sums of a byte of the bit stream
+	WORD64 *packed;			// Packed bit stream of this thread
+	long int n;			// Length of a single bit stream
+	long int S;			// Partial sum
+	long int S_max;			// Maximum partial sum
+	long int S_min;			// Minimum partial sum
+	long int bytes;			// Number of full bytes in the bit stream
+	long int i;
+	int byte;			// Byte of the bit stream being walked
+	int bits;			// Number of bits of the byte to walk
+	int b;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(236, __func__, "state arg is NULL");
+	}
+	if (state->random_walk == NULL) {
+		err(236, __func__, "state->random_walk is NULL");
+	}
+	if (state->packed_epsilon == NULL || state->packed_epsilon[thread_id] == NULL) {
+		err(236, __func__, "state->packed_epsilon[%ld] is NULL", thread_id);
+	}
+	walk = &state->random_walk[thread_id];
+	packed = state->packed_epsilon[thread_id];
+	n = state->tp.n;
+
+	/*
+	 * Zeroize the counters
+	 */
+	memset(walk, 0, sizeof(*walk));
+	memset(counter, 0, sizeof(counter));
+
+	S = 0;
+	S_max = 0;
+	S_min = 0;
+	bytes = n / BITS_N_BYTE;
+	for (i = 0; i <= bytes; i++) {
+
+		/*
+		 * Get the next byte of the bit stream, and the number of its bits that are in the bit stream
+		 */
+		byte = (int) ((packed[i / sizeof(WORD64)] >> ((i % sizeof(WORD64)) * BITS_N_BYTE)) & 0xff);
+		bits = (i < bytes) ? BITS_N_BYTE : (int) (n % BITS_N_BYTE);
+
+		/*
+		 * Walk a full byte at once when no partial sum within the byte can be a value of interest
+		 */
+		if (bits == BITS_N_BYTE && labs(S) > MAX_EXCURSION_RND_EXCURSION_VAR + BITS_N_BYTE) {
+			partial = &walk_byte_table[byte];
+			S_max = MAX(S + partial->max, S_max);
+			S_min = MIN(S + partial->min, S_min);
+			S += partial->sum;
+			continue;
+		}
+
+		for (b = 0; b < bits; b++) {
+			S += ((byte >> b) & 1) ? 1 : -1;
+			S_max = MAX(S, S_max);
+			S_min = MIN(S, S_min);
+			if (labs(S) > MAX_EXCURSION_RND_EXCURSION_VAR) {
+				continue;
+			}
+
+			/*
+			 * Count the visit to the value of the partial sum
+			 */
+			walk->visits[S + MAX_EXCURSION_RND_EXCURSION_VAR]++;
+
+			/*
+			 * A cycle ends whenever the partial sum returns to 0
+			 */
+			if (S == 0) {
+				endCycle(walk, counter);
+			}
+
+			/*
+			 * Count the visit to a TEST_RND_EXCURSION state
+			 *
+			 * The most negative state corresponds to the counter with index 0.
+			 * For example, if MAX_EXCURSION_RND_EXCURSION is 4, the counter for
+			 * x = -4 is the counter[0] and the counter for x = 4 is counter[7]
+			 */
+			else if (labs(S) <= MAX_EXCURSION_RND_EXCURSION) {
+				counter[S + ((S < 0) ? MAX_EXCURSION_RND_EXCURSION : MAX_EXCURSION_RND_EXCURSION - 1)]++;
+			}
+		}
+	}
+
+	/*
+	 * Count the last cycle if it did not end at 0
+	 */
+	if (S != 0) {
+		endCycle(walk, counter);
+	}
+
+	walk->S = S;
+	walk->S_max = S_max;
+	walk->S_min = S_min;
+
+	return;
+}
+
+
+/*
+ * destroyRandomWalk - free the random walk of each thread
+ *
+ * given:
+ *      state           // run state to test under
+ */
+void
+destroyRandomWalk(struct state *state)
+{
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(237, __func__, "state arg is NULL");
+	}
+
+	if (state->random_walk != NULL) {
+		free(state->random_walk);
+		state->random_walk = NULL;
+	}
+
+	return;
+}
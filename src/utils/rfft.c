@@ -0,0 +1,378 @@
+#if defined(LEGACY_FFT)
+/*****************************************************************************
+ R E A L   F F T   R O U T I N E S
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+/*
+ * A self-contained forward real FFT for power of 2 lengths, used by the legacy FFT build
+ * in place of the much slower FFTPACK port in dfft.c.
+ *
+ * The n real values are viewed as n / 2 complex values z[m] = x[2m] + i * x[2m+1], which
+ * are transformed by a radix-4 Stockham (self-sorting, so no bit reversal pass) complex FFT.
+ * A final pass separates the transforms of the even and odd samples and combines them into
+ * the n / 2 + 1 non-redundant frequencies of x.
+ *
+ * The twiddle factors of every pass are computed once by createRealFFT() and laid out in the
+ * order the passes read them, so that the inner loops only stream through memory and are
+ * easily vectorized by the compiler.
+ */
+
+
+// Exit codes: 240 thru 244
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rfft.h"
+#include "debug.h"
+
+
+static const double tpi = 6.28318530717958647692528676655900577;	// 2 * pi
+
+#define RFFT_BLOCK (1024)		// Number of consecutive complex values the depth first stages work on
+
+
+/*
+ * isRealFFTLength - determine if computeRealFFT() can transform sequences of a given length
+ *
+ * given:
+ *      n               // length of the real sequences
+ *
+ * returns:
+ *      true ==> n is a power of 2 that is at least 4
+ */
+bool
+isRealFFTLength(long int n)
+{
+	return n >= 4 && (n & (n - 1)) == 0;
+}
+
+
+/*
+ * createRealFFT - compute the twiddle factors for real FFTs of a given length
+ *
+ * given:
+ *      n               // length of the real sequences, see isRealFFTLength()
+ *
+ * returns:
+ *      malloced tables to pass to computeRealFFT() and then to destroyRealFFT()
+ *
+ * The tables are read-only once created, so a single set may be shared by all threads.
+ */
+struct real_fft *
+createRealFFT(long int n)
+{
+	struct real_fft *fft;	// Tables being created
+	long int len;		// Number of doubles in the stage table
+	long int nc;		// Length of the complex transforms of a stage
+	long int p;
+	double *w;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (isRealFFTLength(n) == false) {
+		err(240, __func__, "n: %ld must be a power of 2 that is at least 4", n);
+	}
+
+	/*
+	 * Allocate the tables
+	 */
+	fft = malloc(sizeof(*fft));
+	if (fft == NULL) {
+		errp(240, __func__, "cannot malloc of %ld bytes for fft", sizeof(*fft));
+	}
+	fft->n = n;
+	for (len = 0, nc = n / 2; nc >= 4; nc /= 4) {
+		len += 6 * (nc / 4);
+	}
+	fft->stage = malloc((size_t) (len + 1) * sizeof(fft->stage[0]));	// +1 as len is 0 when n is 4
+	if (fft->stage == NULL) {
+		errp(240, __func__, "cannot malloc of %ld elements of %ld bytes each for fft->stage",
+		     len + 1, sizeof(fft->stage[0]));
+	}
+	fft->post = malloc((size_t) (2 * (n / 4 + 1)) * sizeof(fft->post[0]));
+	if (fft->post == NULL) {
+		errp(240, __func__, "cannot malloc of %ld elements of %ld bytes each for fft->post",
+		     2 * (n / 4 + 1), sizeof(fft->post[0]));
+	}
+
+	/*
+	 * A radix-4 stage on complex transforms of length nc needs w^p, w^2p and w^3p for 0 <= p < nc / 4,
+	 * where w = exp(-2 * pi * i / nc).  Each is computed directly rather than by recurrence to keep
+	 * them accurate to the last bit.
+	 */
+	for (w = fft->stage, nc = n / 2; nc >= 4; nc /= 4) {
+		for (p = 0; p < nc / 4; p++) {
+			*w++ = cos(tpi * (double) p / (double) nc);
+			*w++ = -sin(tpi * (double) p / (double) nc);
+			*w++ = cos(tpi * (double) (2 * p) / (double) nc);
+			*w++ = -sin(tpi * (double) (2 * p) / (double) nc);
+			*w++ = cos(tpi * (double) (3 * p) / (double) nc);
+			*w++ = -sin(tpi * (double) (3 * p) / (double) nc);
+		}
+	}
+
+	/*
+	 * The final pass needs exp(-2 * pi * i * k / n) for 0 <= k <= n / 4
+	 */
+	for (p = 0; p <= n / 4; p++) {
+		fft->post[2 * p] = cos(tpi * (double) p / (double) n);
+		fft->post[2 * p + 1] = -sin(tpi * (double) p / (double) n);
+	}
+
+	return fft;
+}
+
+
+/*
+ * radix4Stage - one radix-4 stage of the complex FFT, on a range of the interleaved transforms
+ *
+ * given:
+ *      in              // input of the stage, as interleaved (re, im) pairs
+ *      out             // output of the stage, as interleaved (re, im) pairs
+ *      w               // twiddle factors of the stage
+ *      nc              // length of the complex transforms of the stage
+ *      s               // number of interleaved transforms, h / nc
+ *      q0              // first interleaved transform to work on
+ *      q1              // interleaved transform after the last one to work on
+ *
+ * The stage turns s interleaved transforms of length nc into 4 * s interleaved transforms
+ * of length nc / 4.  Transform q of the stage becomes the transforms q + s * k, 0 <= k < 4,
+ * of the next stage.
+ */
+static void
+radix4Stage(const double *in, double *out, const double *w, long int nc, long int s, long int q0, long int q1)
+{
+	long int n1 = nc / 4;	// Length of the transforms of the next stage
+	long int p;
+	long int q;
+
+	for (p = 0; p < n1; p++, w += 6) {
+		const double w1r = w[0], w1i = w[1];
+		const double w2r = w[2], w2i = w[3];
+		const double w3r = w[4], w3i = w[5];
+		const double *a = in + 2 * s * p;
+		const double *b = in + 2 * s * (p + n1);
+		const double *c = in + 2 * s * (p + 2 * n1);
+		const double *d = in + 2 * s * (p + 3 * n1);
+		double *y0 = out + 2 * s * (4 * p);
+		double *y1 = out + 2 * s * (4 * p + 1);
+		double *y2 = out + 2 * s * (4 * p + 2);
+		double *y3 = out + 2 * s * (4 * p + 3);
+
+		for (q = 2 * q0; q < 2 * q1; q += 2) {
+			const double apcr = a[q] + c[q], apci = a[q + 1] + c[q + 1];
+			const double amcr = a[q] - c[q], amci = a[q + 1] - c[q + 1];
+			const double bpdr = b[q] + d[q], bpdi = b[q + 1] + d[q + 1];
+			const double bmdr = b[q] - d[q], bmdi = b[q + 1] - d[q + 1];
+			const double t1r = amcr + bmdi, t1i = amci - bmdr;	// a - c - i * (b - d)
+			const double t2r = apcr - bpdr, t2i = apci - bpdi;	// a + c - (b + d)
+			const double t3r = amcr - bmdi, t3i = amci + bmdr;	// a - c + i * (b - d)
+
+			y0[q] = apcr + bpdr;
+			y0[q + 1] = apci + bpdi;
+			y1[q] = w1r * t1r - w1i * t1i;
+			y1[q + 1] = w1r * t1i + w1i * t1r;
+			y2[q] = w2r * t2r - w2i * t2i;
+			y2[q + 1] = w2r * t2i + w2i * t2r;
+			y3[q] = w3r * t3r - w3i * t3i;
+			y3[q + 1] = w3r * t3i + w3i * t3r;
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * blockStages - the remaining stages of the complex FFT, depth first on a block of interleaved transforms
+ *
+ * given:
+ *      in              // input of the current stage, as interleaved (re, im) pairs
+ *      out             // output of the current stage, as interleaved (re, im) pairs
+ *      w               // twiddle factors of the current stage
+ *      nc              // length of the complex transforms of the current stage
+ *      s               // number of interleaved transforms, h / nc
+ *      q0              // first interleaved transform of the block
+ *      len             // number of interleaved transforms in the block
+ *
+ * After the current stage, the block splits into 4 blocks of the next stage that depend on
+ * nothing else, so each is finished before moving on to the next.  This keeps the data of
+ * the last stages in cache, whereas running each stage over all of the data would stream
+ * it through memory log4(h) times.
+ */
+static void
+blockStages(double *in, double *out, const double *w, long int nc, long int s, long int q0, long int len)
+{
+	long int k;
+	long int q;
+
+	if (nc >= 4) {
+		radix4Stage(in, out, w, nc, s, q0, q0 + len);
+		for (k = 0; k < 4; k++) {
+			blockStages(out, in, w + 6 * (nc / 4), nc / 4, 4 * s, q0 + s * k, len);
+		}
+	} else if (nc == 2) {
+
+		/*
+		 * When log2(h) is odd, a final radix-2 stage is left
+		 */
+		for (q = 2 * q0; q < 2 * (q0 + len); q++) {
+			out[q] = in[q] + in[q + 2 * s];
+			out[q + 2 * s] = in[q] - in[q + 2 * s];
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * computeRealFFT - transform a real sequence in place
+ *
+ * given:
+ *      fft             // tables from createRealFFT() for the length of X
+ *      X               // sequence of fft->n reals, replaced by its transform
+ *      work            // work array of at least fft->n doubles
+ *
+ * On return X holds the n / 2 + 1 non-redundant frequencies of the sequence in the
+ * same layout as __ogg_fdrfftf() (saying that values followed by I are the imaginary parts):
+ *
+ *      [a, b, bI, c, cI, ..., l, lI, m]
+ */
+void
+computeRealFFT(const struct real_fft *fft, double *X, double *work)
+{
+	const double *w;	// Twiddle factors of the current stage
+	double *in;		// Input of the current stage, as interleaved (re, im) pairs
+	double *out;		// Output of the current stage, as interleaved (re, im) pairs
+	double *swap;
+	long int h;		// Length of the complex FFT
+	long int nc;		// Length of the complex transforms of the current stage
+	long int s;		// Number of interleaved transforms of the current stage, h / nc
+	long int k;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (fft == NULL) {
+		err(241, __func__, "fft arg is NULL");
+	}
+	if (X == NULL) {
+		err(241, __func__, "X arg is NULL");
+	}
+	if (work == NULL) {
+		err(241, __func__, "work arg is NULL");
+	}
+
+	/*
+	 * Complex FFT of length h on z[m] = X[2m] + i * X[2m+1], ping-ponging between X and work
+	 *
+	 * The first stages run over all of the data, until each interleaved transform is a run of at
+	 * least RFFT_BLOCK consecutive complex values.  The remaining stages run depth first.
+	 */
+	h = fft->n / 2;
+	in = X;
+	out = work;
+	w = fft->stage;
+	for (nc = h, s = 1; nc >= 4 && s < RFFT_BLOCK; nc /= 4, s *= 4) {
+		radix4Stage(in, out, w, nc, s, 0, s);
+		w += 6 * (nc / 4);
+		swap = in;
+		in = out;
+		out = swap;
+	}
+	blockStages(in, out, w, nc, s, 0, s);
+	for (; nc >= 2; nc /= (nc >= 4 ? 4 : 2)) {
+		swap = in;
+		in = out;
+		out = swap;
+	}
+
+	/*
+	 * The final pass reads the complex transform Z and writes into X, so Z must not be in X
+	 */
+	if (in == X) {
+		memcpy(work, X, (size_t) fft->n * sizeof(X[0]));
+		in = work;
+	}
+
+	/*
+	 * Split Z into the transforms E of the even and O of the odd samples, and combine them:
+	 *
+	 *      E[k] = (Z[k] + conj(Z[h-k])) / 2
+	 *      O[k] = -i * (Z[k] - conj(Z[h-k])) / 2
+	 *      X[k] = E[k] + exp(-2 * pi * i * k / n) * O[k]
+	 *      X[h-k] = conj(E[k] - exp(-2 * pi * i * k / n) * O[k])
+	 */
+	X[0] = in[0] + in[1];
+	X[fft->n - 1] = in[0] - in[1];
+	for (k = 1; k <= h / 2; k++) {
+		const double ar = in[2 * k], ai = in[2 * k + 1];		// Z[k]
+		const double br = in[2 * (h - k)], bi = -in[2 * (h - k) + 1];	// conj(Z[h-k])
+		const double er = 0.5 * (ar + br), ei = 0.5 * (ai + bi);
+		const double odr = 0.5 * (ai - bi), odi = -0.5 * (ar - br);
+		const double wr = fft->post[2 * k], wi = fft->post[2 * k + 1];
+		const double tr = wr * odr - wi * odi, ti = wr * odi + wi * odr;
+
+		X[2 * k - 1] = er + tr;
+		X[2 * k] = ei + ti;
+		if (k < h - k) {
+			X[2 * (h - k) - 1] = er - tr;
+			X[2 * (h - k)] = -(ei - ti);
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * destroyRealFFT - free the tables created by createRealFFT()
+ *
+ * given:
+ *      fft             // tables from createRealFFT(), or NULL
+ */
+void
+destroyRealFFT(struct real_fft *fft)
+{
+	if (fft == NULL) {
+		return;
+	}
+	if (fft->stage != NULL) {
+		free(fft->stage);
+		fft->stage = NULL;
+	}
+	if (fft->post != NULL) {
+		free(fft->post);
+		fft->post = NULL;
+	}
+	free(fft);
+
+	return;
+}
+#endif /* LEGACY_FFT */
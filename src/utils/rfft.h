@@ -0,0 +1,49 @@
+#if defined(LEGACY_FFT)
+/*****************************************************************************
+          R E A L   F F T   F U N C T I O N   P R O T O T Y P E S
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+#ifndef RFFT_H
+#   define RFFT_H
+
+#include <stdbool.h>
+
+/*
+ * Read-only tables of a power of 2 real FFT, shareable by any number of threads
+ */
+struct real_fft {
+	long int n;		// Length of the real sequences
+	double *stage;		// w^p, w^2p, w^3p (re, im) of each radix-4 stage of the complex FFT of length n / 2
+	double *post;		// exp(-2 * pi * i * k / n) (re, im) for 0 <= k <= n / 4
+};
+
+extern bool isRealFFTLength(long int n);
+extern struct real_fft *createRealFFT(long int n);
+extern void computeRealFFT(const struct real_fft *fft, double *X, double *work);
+extern void destroyRealFFT(struct real_fft *fft);
+
+#endif				/* RFFT_H */
+#endif /* LEGACY_FFT */
@@ -0,0 +1,469 @@
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+// Exit codes: 90 thru 98
+
+// global capabilities
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "../utils/externs.h"
+#include "utilities.h"
+#include "pval_file.h"
+#include "shard.h"
+#include "stat_fncs.h"
+#include "debug.h"
+
+
+/*
+ * Number of shards handed out per worker process, so that the workers done early take over the
+ * shards that the slower ones did not start yet
+ */
+#define SHARDS_PER_WORKER (4)
+
+/*
+ * A worker process, with its pipes
+ */
+struct shard_worker {
+	pid_t pid;			// Process id of the worker
+	int command;			// Write end of the pipe of shard numbers to the worker, -1 once closed
+	int result;			// Read end of the pipe of .pvalues streams from the worker
+	long int shard;			// Shard being tested by the worker, -1 ==> idle
+	cpu_set_t cpus;			// CPUs the worker is pinned to
+};
+
+
+/*
+ * Forward static function declarations
+ */
+static void splitCpus(struct shard_worker *worker, long int workers);
+static void sendShard(struct shard_worker *worker, long int shard);
+static void runWorker(struct state *state, long int id, struct shard_worker *worker, long int shardSize,
+		      long int first, long int iterations);
+
+
+/*
+ * launchShards - test the iterations of this run in -K worker processes and gather their p_values
+ *
+ * given:
+ *      state           // run state whose iterations are tested
+ *
+ * The iterations are cut into contiguous shards of the input, up to SHARDS_PER_WORKER per worker.
+ * Each worker is forked after init(), pinned to its own share of the CPUs, and tests one shard at a
+ * time with its own threads, on its own copy of the test state.  A worker is sent the number of its
+ * next shard over a pipe as soon as it returns the .pvalues stream of the previous one over another
+ * pipe.  The p_values of the shards are appended to state->p_val in the order of the shards, as if
+ * this process had tested all the iterations itself.
+ */
+void
+launchShards(struct state *state)
+{
+	struct shard_worker *worker;	// Worker processes
+	struct pollfd *pfd;		// Result pipes of the busy workers
+	struct shard_worker **busy;	// Worker of each entry of pfd
+	void **image;			// .pvalues stream of each shard not appended yet, or NULL
+	size_t *size;			// Size in bytes of each image
+	char name[BUFSIZ + 1];		// Name of a shard
+	char buf[BUFSIZ + 1];		// Time string buffer
+	int fds[4];			// Command and result pipes of a new worker
+	int status;			// Exit status of a worker
+	long int workers;		// Number of worker processes
+	long int shards;		// Number of shards
+	long int shardSize;		// Number of iterations per shard, except for the last one
+	long int next;			// Next shard to hand out
+	long int done;			// Number of shards appended to state->p_val
+	long int first;			// First iteration of this run
+	long int iterations;		// Number of iterations of this run
+	nfds_t npfd;			// Number of entries in pfd
+	long int k;
+	long int j;
+	int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(90, __func__, "state arg is NULL");
+	}
+	if (state->shardWorkers < 1) {
+		err(90, __func__, "shardWorkers: %ld must be > 0", state->shardWorkers);
+	}
+	if (state->stdinData == true) {
+		err(90, __func__, "cannot shard randdata read from standard input");
+	}
+
+	/*
+	 * Cut the iterations into shards
+	 */
+	first = state->firstIteration;
+	iterations = state->tp.numOfBitStreams;
+	workers = MIN(state->shardWorkers, iterations);
+	shards = MIN(workers * SHARDS_PER_WORKER, iterations);
+	shardSize = (iterations + shards - 1) / shards;
+	shards = (iterations + shardSize - 1) / shardSize;
+	dbg(DBG_LOW, "Start of iterate phase in %ld worker processes: %ld shards of %ld iterations", workers, shards,
+	    shardSize);
+
+	/*
+	 * Allocate the p_val of each test once for all shards
+	 */
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->testVector[i] == true && state->p_val[i] != NULL) {
+			reserve_dyn_array(state->p_val[i], iterations * state->partitionCount[i]);
+		}
+	}
+	worker = calloc((size_t) workers, sizeof(worker[0]));
+	pfd = calloc((size_t) workers, sizeof(pfd[0]));
+	busy = calloc((size_t) workers, sizeof(busy[0]));
+	image = calloc((size_t) shards, sizeof(image[0]));
+	size = calloc((size_t) shards, sizeof(size[0]));
+	if (worker == NULL || pfd == NULL || busy == NULL || image == NULL || size == NULL) {
+		errp(90, __func__, "cannot calloc the state of %ld workers and %ld shards", workers, shards);
+	}
+	splitCpus(worker, workers);
+
+	/*
+	 * Fork the workers, each opening randdata on its own
+	 */
+	if (fclose(state->streamFile) != 0) {
+		errp(90, __func__, "error closing: %s", state->randomDataPath);
+	}
+	state->streamFile = NULL;
+	(void) signal(SIGPIPE, SIG_IGN);	// a worker that died is reported when its result pipe ends
+	fflush(NULL);				// do not let the workers inherit buffered output
+	for (k = 0; k < workers; k++) {
+		if (pipe(fds) < 0 || pipe(fds + 2) < 0) {
+			errp(90, __func__, "cannot create the pipes of worker %ld", k);
+		}
+		worker[k].command = fds[1];
+		worker[k].result = fds[2];
+		worker[k].shard = -1;
+		worker[k].pid = fork();
+		if (worker[k].pid < 0) {
+			errp(90, __func__, "cannot fork worker %ld", k);
+		}
+		if (worker[k].pid == 0) {
+			for (j = 0; j < k; j++) {
+				close(worker[j].command);
+				close(worker[j].result);
+			}
+			close(fds[1]);
+			close(fds[2]);
+			worker[k].command = fds[0];
+			worker[k].result = fds[3];
+			runWorker(state, k, &worker[k], shardSize, first, iterations);
+		}
+		close(fds[0]);
+		close(fds[3]);
+		dbg(DBG_MED, "forked worker %ld as process %ld", k, (long int) worker[k].pid);
+	}
+
+	/*
+	 * Hand out the first shards
+	 */
+	next = 0;
+	for (k = 0; k < workers && next < shards; k++) {
+		sendShard(&worker[k], next++);
+	}
+
+	/*
+	 * Gather the result of each shard, handing out the next shard to the worker that returned it
+	 */
+	done = 0;
+	while (done < shards) {
+		npfd = 0;
+		for (k = 0; k < workers; k++) {
+			if (worker[k].shard >= 0) {
+				pfd[npfd].fd = worker[k].result;
+				pfd[npfd].events = POLLIN;
+				pfd[npfd].revents = 0;
+				busy[npfd++] = &worker[k];
+			}
+		}
+		if (npfd == 0) {
+			err(91, __func__, "no worker is busy, but only %ld of %ld shards are done", done, shards);
+		}
+		if (poll(pfd, npfd, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			errp(91, __func__, "error on poll() of the result pipes of %ld workers", (long int) npfd);
+		}
+		for (j = 0; j < (long int) npfd; j++) {
+			if (pfd[j].revents == 0) {
+				continue;
+			}
+			snprintf(name, BUFSIZ, "shard %ld of worker %ld", busy[j]->shard, (long int) (busy[j] - worker));
+			name[BUFSIZ] = '\0';	// paranoia
+			image[busy[j]->shard] = read_p_val_stream(busy[j]->result, name, &size[busy[j]->shard]);
+			if (image[busy[j]->shard] == NULL) {
+				err(91, __func__, "worker process %ld ended without returning its %s", (long int) busy[j]->pid,
+				    name);
+			}
+			busy[j]->shard = -1;
+			if (next < shards) {
+				sendShard(busy[j], next++);
+			} else {
+				close(busy[j]->command);
+				busy[j]->command = -1;
+			}
+		}
+
+		/*
+		 * Append the shards that are next in order
+		 */
+		while (done < shards && image[done] != NULL) {
+			snprintf(name, BUFSIZ, "shard %ld", done);
+			name[BUFSIZ] = '\0';	// paranoia
+			if (append_p_val_image(state, image[done], size[done], name) == false) {
+				err(91, __func__, "cannot append the p-values of %s", name);
+			}
+			free(image[done]);
+			image[done] = NULL;
+			if (state->reportCycle > 0) {
+				getTimestamp(buf, BUFSIZ);
+				msg("Completed iterations %ld to %ld of %ld at %s", done * shardSize + 1,
+				    MIN((done + 1) * shardSize, iterations), iterations, buf);
+			}
+			done++;
+		}
+	}
+
+	/*
+	 * Wait for the workers to exit
+	 */
+	for (k = 0; k < workers; k++) {
+		if (worker[k].command >= 0) {
+			close(worker[k].command);
+		}
+		close(worker[k].result);
+		if (waitpid(worker[k].pid, &status, 0) < 0) {
+			errp(92, __func__, "error on waitpid() of worker %ld", k);
+		}
+		if (WIFEXITED(status) == 0 || WEXITSTATUS(status) != 0) {
+			err(92, __func__, "worker process %ld did not exit cleanly: status 0x%x", (long int) worker[k].pid,
+			    status);
+		}
+	}
+	free(worker);
+	free(pfd);
+	free(busy);
+	free(image);
+	free(size);
+
+	dbg(DBG_LOW, "End of iterate phase in %ld worker processes\n", workers);
+
+	return;
+}
+
+
+/*
+ * splitCpus - give each worker a contiguous share of the CPUs this process may run on
+ *
+ * given:
+ *      worker          // workers whose cpus are set
+ *      workers         // number of workers
+ *
+ * When there are fewer CPUs than workers, the workers share them round robin.
+ */
+static void
+splitCpus(struct shard_worker *worker, long int workers)
+{
+	cpu_set_t allowed;		// CPUs this process may run on
+	long int *cpu;			// Number of each allowed CPU
+	long int cpus;			// Number of allowed CPUs
+	long int k;
+	long int j;
+
+	/*
+	 * List the allowed CPUs
+	 */
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+		warnp(__func__, "cannot get the CPUs this process may run on, workers will not be pinned");
+		for (k = 0; k < workers; k++) {
+			CPU_ZERO(&worker[k].cpus);
+		}
+		return;
+	}
+	cpu = calloc(CPU_SETSIZE, sizeof(cpu[0]));
+	if (cpu == NULL) {
+		errp(93, __func__, "cannot calloc of %d elements of %lu bytes each for cpu", CPU_SETSIZE, sizeof(cpu[0]));
+	}
+	for (cpus = 0, j = 0; j < CPU_SETSIZE; j++) {
+		if (CPU_ISSET(j, &allowed)) {
+			cpu[cpus++] = j;
+		}
+	}
+
+	/*
+	 * Give each worker its share
+	 */
+	for (k = 0; k < workers; k++) {
+		CPU_ZERO(&worker[k].cpus);
+		if (cpus >= workers) {
+			for (j = k * cpus / workers; j < (k + 1) * cpus / workers; j++) {
+				CPU_SET(cpu[j], &worker[k].cpus);
+			}
+		} else if (cpus > 0) {
+			CPU_SET(cpu[k % cpus], &worker[k].cpus);
+		}
+	}
+	free(cpu);
+
+	return;
+}
+
+
+/*
+ * sendShard - send a worker the number of the next shard to test
+ *
+ * given:
+ *      worker          // idle worker
+ *      shard           // shard to test
+ */
+static void
+sendShard(struct shard_worker *worker, long int shard)
+{
+	ssize_t ret;			// write return
+
+	do {
+		ret = write(worker->command, &shard, sizeof(shard));
+	} while (ret < 0 && errno == EINTR);
+	if (ret != (ssize_t) sizeof(shard)) {
+		errp(94, __func__, "cannot send shard %ld to worker process %ld", shard, (long int) worker->pid);
+	}
+	worker->shard = shard;
+	dbg(DBG_HIGH, "sent shard %ld to worker process %ld", shard, (long int) worker->pid);
+
+	return;
+}
+
+
+/*
+ * runWorker - test the shards sent by the parent process until its command pipe is closed
+ *
+ * given:
+ *      state           // copy of the run state of the parent, after init()
+ *      id              // number of the worker
+ *      worker          // worker, with the child ends of its pipes
+ *      shardSize       // number of iterations per shard, except for the last one
+ *      first           // first iteration of the run
+ *      iterations      // number of iterations of the run
+ *
+ * This function does not return.
+ */
+static void
+runWorker(struct state *state, long int id, struct shard_worker *worker, long int shardSize, long int first,
+	  long int iterations)
+{
+	FILE *stream;			// Result pipe
+	char name[BUFSIZ + 1];		// Name of the result pipe
+	long int threads;		// Number of threads allocated by init()
+	long int shard;			// Shard to test
+	ssize_t ret;			// read return
+	int i;
+
+	/*
+	 * Pin the worker to its CPUs
+	 */
+	if (CPU_COUNT(&worker->cpus) > 0 && sched_setaffinity(0, sizeof(worker->cpus), &worker->cpus) < 0) {
+		warnp(__func__, "worker %ld cannot be pinned to its %d CPUs", id, CPU_COUNT(&worker->cpus));
+	}
+	stream = fdopen(worker->result, "wb");
+	if (stream == NULL) {
+		errp(95, __func__, "worker %ld cannot open its result pipe", id);
+	}
+	snprintf(name, BUFSIZ, "result pipe of worker %ld", id);
+	name[BUFSIZ] = '\0';	// paranoia
+
+	/*
+	 * Test raw p_values with the threads of this worker, and let the parent report progress
+	 */
+	threads = state->numberOfThreads;
+	state->threadBudget = MAX(state->threadBudget / state->shardWorkers, 1);
+	state->aggregateFlag = false;
+	state->reportCycle = 0;
+
+	/*
+	 * Set up the transforms of TEST_DFT, which init() left to each worker, for the threads of this worker
+	 */
+	state->tp.numOfBitStreams = MIN(shardSize, iterations);
+	DiscreteFourierTransform_setup(state);
+
+	while (1) {
+
+		/*
+		 * Wait for the next shard
+		 */
+		do {
+			ret = read(worker->command, &shard, sizeof(shard));
+		} while (ret < 0 && errno == EINTR);
+		if (ret == 0) {
+			break;
+		}
+		if (ret != (ssize_t) sizeof(shard)) {
+			errp(95, __func__, "worker %ld cannot read its next shard", id);
+		}
+		dbg(DBG_MED, "worker %ld testing shard %ld", id, shard);
+
+		/*
+		 * Test the iterations of the shard as a job of its own
+		 */
+		state->firstIteration = first + shard * shardSize;
+		state->tp.numOfBitStreams = MIN(shardSize, iterations - shard * shardSize);
+		state->iterationsMissing = state->tp.numOfBitStreams;
+		state->numberOfThreads = MIN(threads, state->tp.numOfBitStreams);
+		for (i = 1; i <= NUMOFTESTS; i++) {
+			if (state->p_val[i] != NULL) {
+				clear_dyn_array(state->p_val[i]);
+			}
+		}
+		state->streamFile = fopen(state->randomDataPath, "r");
+		if (state->streamFile == NULL) {
+			errp(95, __func__, "worker %ld unable to open data file to reading: %s", id, state->randomDataPath);
+		}
+		invokeTestSuite(state);
+
+		/*
+		 * Return the p_values of the shard
+		 */
+		write_p_val_to_stream(state, stream, name);
+		if (fflush(stream) != 0) {
+			errp(95, __func__, "worker %ld cannot write the p-values of shard %ld", id, shard);
+		}
+	}
+
+	fclose(stream);
+	close(worker->command);
+	_exit(0);
+}
@@ -67,23 +67,14 @@ extern void LinearComplexity_iterate(struct thread_state *thread_state);
 extern void Serial_iterate(struct thread_state *thread_state);
 
 /*
- * Print functions
+ * Setup functions (only for tests whose set up each -K worker redoes after the fork)
  */
-extern void Frequency_print(struct state *state);
-extern void BlockFrequency_print(struct state *state);
-extern void CumulativeSums_print(struct state *state);
-extern void Runs_print(struct state *state);
-extern void LongestRunOfOnes_print(struct state *state);
-extern void Rank_print(struct state *state);
-extern void DiscreteFourierTransform_print(struct state *state);
-extern void NonOverlappingTemplateMatchings_print(struct state *state);
-extern void OverlappingTemplateMatchings_print(struct state *state);
-extern void Universal_print(struct state *state);
-extern void ApproximateEntropy_print(struct state *state);
-extern void RandomExcursions_print(struct state *state);
-extern void RandomExcursionsVariant_print(struct state *state);
-extern void LinearComplexity_print(struct state *state);
-extern void Serial_print(struct state *state);
+extern void DiscreteFourierTransform_setup(struct state *state);
+
+/*
+ * Flush functions (only for tests that batch bitstreams across iterations)
+ */
+extern void DiscreteFourierTransform_flush(struct thread_state *thread_state);
 
 /*
  * Compute metrics functions
@@ -0,0 +1,980 @@
+/*****************************************************************************
+ S T A T S . T X T   W R I T E R
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+
+// Exit codes: 245 thru 249
+
+// global capabilities
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "../utils/externs.h"
+#include "utilities.h"
+#include "stats_txt.h"
+#include "debug.h"
+
+
+/*
+ * Number of bytes of text a thread formats before handing its rows over to the writer thread
+ */
+#define STATS_TXT_BATCH_SIZE (1024 * 1024)
+
+/*
+ * Size of the stdio buffer of each stats.txt and results.txt file
+ */
+#define STATS_TXT_FILE_BUFSIZ (1024 * 1024)
+
+/*
+ * Number of bytes buffered for all the data*.txt files of a test, and at least for each of them
+ */
+#define STATS_TXT_DATA_SIZE (8 * 1024 * 1024)
+#define STATS_TXT_DATA_MIN (4096)
+
+/*
+ * The stats.txt and results.txt text of an iteration of a test
+ */
+struct stats_txt_row {
+	int test;			// Test of the row
+	long int iteration;		// Iteration of the row, counted from the first iteration of this run
+	size_t stats_offset;		// Offset of the stats.txt text of the row in the stats_text of its batch
+	size_t stats_len;		// Length of the stats.txt text of the row
+	size_t results_offset;		// Offset of the results.txt text of the row in the results_text of its batch
+	size_t results_len;		// Length of the results.txt text of the row, one line per p_value
+	struct stats_txt_batch *batch;	// Batch holding the text of the row
+};
+
+/*
+ * Rows formatted by a thread, handed over to the writer thread at once
+ */
+struct stats_txt_batch {
+	char *stats_text;		// stats.txt text of the rows
+	size_t stats_size;		// Length of stats_text
+	char *results_text;		// results.txt text of the rows
+	size_t results_size;		// Length of results_text
+	struct dyn_array *rows;		// struct stats_txt_row of each row, in the order they were formatted
+	long int unwritten;		// Number of rows not written yet
+	struct stats_txt_batch *next;	// Next batch queued for the writer thread
+};
+
+/*
+ * Output files of a test
+ */
+struct stats_txt_test {
+	char *stats_txt;		// Pathname of stats.txt
+	FILE *stats;			// Open stats.txt
+	char *results_txt;		// Pathname of results.txt
+	FILE *results;			// Open results.txt
+	int partitions;			// Number of data*.txt files, 0 ==> the results are not partitioned
+	int first_partition;		// First partition written, the earlier ones share its data*.txt filename
+	char **data_txt;		// Pathname of each data*.txt file
+	char *data;			// Buffer of the lines not written yet to each data*.txt file, data_size bytes each
+	size_t *data_len;		// Length of the lines in the buffer of each data*.txt file
+	size_t data_size;		// Size of the buffer of each data*.txt file
+	long int next;			// Next iteration to be written
+	struct stats_txt_row **pending;	// Rows of the iterations after next, at index iteration % pending_size, or NULL
+	long int pending_size;		// Number of entries in pending, 0 or a power of 2
+};
+
+/*
+ * Writer thread of the stats.txt, results.txt and data*.txt files of all the tests
+ */
+struct stats_txt_writer {
+	pthread_t thread;		// Writer thread
+	pthread_mutex_t mutex;		// Lock of the queue of batches
+	pthread_cond_t ready;		// Signaled when a batch is queued, or when closing
+	pthread_cond_t space;		// Signaled when a batch is dequeued
+	struct stats_txt_batch *head;	// First batch queued, or NULL
+	struct stats_txt_batch *tail;	// Last batch queued, or NULL
+	long int queued;		// Number of batches queued
+	long int max_queued;		// Number of batches queued after which the threads wait for the writer
+	bool closing;			// true ==> no more batches will be queued
+	struct stats_txt_buffer *buffer;	// Buffer of each thread
+	long int buffers;		// Number of buffers
+	struct stats_txt_test test[NUMOFTESTS + 1];	// Output files of each test
+};
+
+
+/*
+ * Forward static function declarations
+ */
+static void *writeStatsTxt(void *arg);
+static void handOver(struct stats_txt_buffer *buffer);
+static void writeBatch(struct stats_txt_writer *writer, struct stats_txt_batch *batch);
+static void holdRow(struct stats_txt_test *test, struct stats_txt_row *row);
+static void writeRow(struct stats_txt_test *test, struct stats_txt_row *row);
+static void flushData(struct stats_txt_test *test, int partition);
+
+
+/*
+ * initStatsTxt - open the stats.txt, results.txt and data*.txt files of the enabled tests
+ *
+ * given:
+ *      state           // run state to test under
+ *
+ * The files are truncated, and a writer thread is started.  During the iterations, each thread
+ * formats the stats.txt and results.txt text of its iterations in its own buffer, and hands it
+ * over to the writer thread STATS_TXT_BATCH_SIZE bytes at a time.  The writer thread writes the
+ * rows of each test in the order of the iterations, no matter which thread formatted them, and
+ * splits the results.txt lines of a row among the data*.txt files when they are partitioned.
+ *
+ * NOTE: This function must be called after the tests have been initialized, and before any thread
+ *       is started.
+ */
+void
+initStatsTxt(struct state *state)
+{
+	struct stats_txt_writer *writer;	// Writer of the files
+	struct stats_txt_test *test;		// Output files of a test
+	char data_filename[BUFSIZ + 1];		// Basename for a given data*.txt pathname
+	int snprintf_ret;			// snprintf return value
+	int io_ret;				// I/O return status
+	FILE *data;				// Truncated data*.txt file
+	long int i;
+	int j;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(245, __func__, "state arg is NULL");
+	}
+	if (state->resultstxtFlag == false) {
+		err(245, __func__, "called without -s");
+	}
+	if (state->numberOfThreads < 1) {
+		err(245, __func__, "numberOfThreads: %ld must be > 0", state->numberOfThreads);
+	}
+	if (state->stats_txt != NULL) {
+		err(245, __func__, "stats.txt files already open");
+	}
+
+	/*
+	 * Allocate the writer and the buffer of each thread
+	 */
+	writer = calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		errp(245, __func__, "cannot calloc the stats.txt writer of %lu bytes", sizeof(*writer));
+	}
+	writer->buffers = state->numberOfThreads;
+	writer->max_queued = 2 * writer->buffers;
+	writer->buffer = calloc((size_t) writer->buffers, sizeof(*writer->buffer));
+	if (writer->buffer == NULL) {
+		errp(245, __func__, "cannot calloc for buffer: %ld elements of %lu bytes each", writer->buffers,
+		     sizeof(*writer->buffer));
+	}
+	for (i = 0; i < writer->buffers; i++) {
+		writer->buffer[i].writer = writer;
+	}
+
+	/*
+	 * Open the files of each enabled test
+	 */
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		if (state->testVector[i] != true) {
+			continue;
+		}
+		if (state->subDir[i] == NULL) {
+			err(245, __func__, "no subdir for %s[%ld]", state->testNames[i], i);
+		}
+		test = &writer->test[i];
+
+		/*
+		 * Open stats.txt and results.txt with large stdio buffers
+		 */
+		test->stats_txt = filePathName(state->subDir[i], "stats.txt");
+		dbg(DBG_HIGH, "about to open/truncate: %s", test->stats_txt);
+		test->stats = openTruncate(test->stats_txt);
+		if (test->stats == NULL) {
+			errp(245, __func__, "cannot open for writing: %s", test->stats_txt);
+		}
+		test->results_txt = filePathName(state->subDir[i], "results.txt");
+		dbg(DBG_HIGH, "about to open/truncate: %s", test->results_txt);
+		test->results = openTruncate(test->results_txt);
+		if (test->results == NULL) {
+			errp(245, __func__, "cannot open for writing: %s", test->results_txt);
+		}
+		errno = 0;	// paranoia
+		io_ret = setvbuf(test->stats, NULL, _IOFBF, STATS_TXT_FILE_BUFSIZ);
+		if (io_ret != 0) {
+			errp(245, __func__, "cannot set the buffer of: %s", test->stats_txt);
+		}
+		errno = 0;	// paranoia
+		io_ret = setvbuf(test->results, NULL, _IOFBF, STATS_TXT_FILE_BUFSIZ);
+		if (io_ret != 0) {
+			errp(245, __func__, "cannot set the buffer of: %s", test->results_txt);
+		}
+
+		/*
+		 * Truncate the data*.txt files if we need to partition results
+		 *
+		 * A test may partition its results among thousands of data*.txt files, more than can be kept
+		 * open at once.  Their lines are buffered instead, and appended to each file once its buffer is full.
+		 */
+		if (state->partitionCount[i] > 1) {
+			if (state->datatxt_fmt[i] == NULL) {
+				err(245, __func__, "format for data0*.txt filename is NULL");
+			}
+			test->partitions = state->partitionCount[i];
+			test->data_size = MAX(STATS_TXT_DATA_SIZE / test->partitions, STATS_TXT_DATA_MIN);
+			test->data_txt = calloc((size_t) test->partitions, sizeof(*test->data_txt));
+			test->data_len = calloc((size_t) test->partitions, sizeof(*test->data_len));
+			test->data = malloc(test->partitions * test->data_size);
+			if (test->data_txt == NULL || test->data_len == NULL || test->data == NULL) {
+				errp(245, __func__, "cannot allocate the buffers of %d data*.txt files of %lu bytes each",
+				     test->partitions, test->data_size);
+			}
+			for (j = 0; j < test->partitions; j++) {
+
+				/*
+				 * Form the data*.txt filename
+				 */
+				errno = 0;	// paranoia
+				snprintf_ret = snprintf(data_filename, BUFSIZ, state->datatxt_fmt[i], j + 1);
+				data_filename[BUFSIZ] = '\0';	// paranoia
+				if (snprintf_ret <= 0 || snprintf_ret >= BUFSIZ || errno != 0) {
+					errp(245, __func__, "snprintf failed for %d bytes for data%03d.txt, returned: %d", BUFSIZ,
+					     j + 1, snprintf_ret);
+				}
+				test->data_txt[j] = filePathName(state->subDir[i], data_filename);
+
+				/*
+				 * Truncate the data*.txt file
+				 */
+				dbg(DBG_HIGH, "about to open/truncate: %s", test->data_txt[j]);
+				data = openTruncate(test->data_txt[j]);
+				if (data == NULL) {
+					errp(245, __func__, "cannot open for writing: %s", test->data_txt[j]);
+				}
+				errno = 0;	// paranoia
+				io_ret = fclose(data);
+				if (io_ret != 0) {
+					errp(245, __func__, "error closing: %s", test->data_txt[j]);
+				}
+			}
+
+			/*
+			 * When fewer than 10 partitions are formed, they all share the data.txt filename,
+			 * which holds only the lines of the last partition, as each partition truncates it
+			 */
+			if (strcmp(test->data_txt[0], test->data_txt[test->partitions - 1]) == 0) {
+				test->first_partition = test->partitions - 1;
+			}
+		}
+	}
+
+	/*
+	 * Start the writer thread
+	 */
+	pthread_mutex_init(&writer->mutex, NULL);
+	pthread_cond_init(&writer->ready, NULL);
+	pthread_cond_init(&writer->space, NULL);
+	io_ret = pthread_create(&writer->thread, NULL, writeStatsTxt, writer);
+	if (io_ret != 0) {
+		errno = io_ret;
+		errp(245, __func__, "error on pthread_create()");
+	}
+	state->stats_txt = writer;
+
+	return;
+}
+
+
+/*
+ * beginStatsTxtRow - start formatting the stats.txt and results.txt text of an iteration of a test
+ *
+ * given:
+ *      thread_state    // state of the thread formatting the row
+ *      test            // test of the row
+ *      iteration       // iteration of the row, counted from the first iteration of this run
+ *
+ * returns:
+ *      The buffer of the thread, whose stats and results streams receive the text of the row.
+ *
+ * NOTE: A row is formatted once the test has recorded its results, and outside of the mutex.
+ *       The row ends with a call to endStatsTxtRow().
+ */
+struct stats_txt_buffer *
+beginStatsTxtRow(struct thread_state *thread_state, int test, long int iteration)
+{
+	struct stats_txt_buffer *buffer;	// Buffer of the thread
+	struct stats_txt_writer *writer;	// Writer of the files
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (thread_state == NULL) {
+		err(246, __func__, "thread_state arg is NULL");
+	}
+	if (thread_state->global_state == NULL) {
+		err(246, __func__, "thread_state->global_state is NULL");
+	}
+	writer = thread_state->global_state->stats_txt;
+	if (writer == NULL) {
+		err(246, __func__, "stats.txt files are not open");
+	}
+	if (thread_state->thread_id < 0 || thread_state->thread_id >= writer->buffers) {
+		err(246, __func__, "thread_id: %ld must be in [0, %ld)", thread_state->thread_id, writer->buffers);
+	}
+	if (test <= 0 || test > NUMOFTESTS || writer->test[test].stats == NULL) {
+		err(246, __func__, "test: %d has no stats.txt file open", test);
+	}
+	if (iteration < 0) {
+		err(246, __func__, "iteration: %ld must be >= 0", iteration);
+	}
+	buffer = &writer->buffer[thread_state->thread_id];
+
+	/*
+	 * Start a new batch if needed
+	 */
+	if (buffer->batch == NULL) {
+		buffer->batch = calloc(1, sizeof(*buffer->batch));
+		if (buffer->batch == NULL) {
+			errp(246, __func__, "cannot calloc a batch of %lu bytes", sizeof(*buffer->batch));
+		}
+		buffer->batch->rows = create_dyn_array(sizeof(struct stats_txt_row), DEFAULT_CHUNK, DEFAULT_CHUNK, false);
+		errno = 0;	// paranoia
+		buffer->stats = open_memstream(&buffer->batch->stats_text, &buffer->batch->stats_size);
+		if (buffer->stats == NULL) {
+			errp(246, __func__, "cannot open the stats.txt memory stream of thread %ld", thread_state->thread_id);
+		}
+		errno = 0;	// paranoia
+		buffer->results = open_memstream(&buffer->batch->results_text, &buffer->batch->results_size);
+		if (buffer->results == NULL) {
+			errp(246, __func__, "cannot open the results.txt memory stream of thread %ld", thread_state->thread_id);
+		}
+	}
+
+	/*
+	 * Note where the row starts
+	 */
+	buffer->test = test;
+	buffer->iteration = iteration;
+	buffer->stats_start = ftell(buffer->stats);
+	buffer->results_start = ftell(buffer->results);
+	if (buffer->stats_start < 0 || buffer->results_start < 0) {
+		errp(246, __func__, "cannot tell the position of the memory streams of thread %ld", thread_state->thread_id);
+	}
+
+	return buffer;
+}
+
+
+/*
+ * endStatsTxtRow - finish formatting a row, and hand the batch over to the writer thread if large enough
+ *
+ * given:
+ *      buffer          // buffer returned by beginStatsTxtRow()
+ */
+void
+endStatsTxtRow(struct stats_txt_buffer *buffer)
+{
+	struct stats_txt_row row;	// Row just formatted
+	long int stats_end;		// Offset in stats of the end of the row
+	long int results_end;		// Offset in results of the end of the row
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (buffer == NULL) {
+		err(246, __func__, "buffer arg is NULL");
+	}
+	if (buffer->batch == NULL) {
+		err(246, __func__, "no row is being formatted");
+	}
+
+	/*
+	 * Record the row in the batch
+	 */
+	stats_end = ftell(buffer->stats);
+	results_end = ftell(buffer->results);
+	if (stats_end < buffer->stats_start || results_end < buffer->results_start) {
+		errp(246, __func__, "cannot tell the position of the memory streams");
+	}
+	row.test = buffer->test;
+	row.iteration = buffer->iteration;
+	row.stats_offset = (size_t) buffer->stats_start;
+	row.stats_len = (size_t) (stats_end - buffer->stats_start);
+	row.results_offset = (size_t) buffer->results_start;
+	row.results_len = (size_t) (results_end - buffer->results_start);
+	row.batch = buffer->batch;
+	append_value(buffer->batch->rows, &row);
+
+	/*
+	 * Hand the batch over once it holds enough text
+	 */
+	if (stats_end + results_end >= STATS_TXT_BATCH_SIZE) {
+		handOver(buffer);
+	}
+
+	return;
+}
+
+
+/*
+ * flushStatsTxt - hand the rows formatted by a thread over to the writer thread
+ *
+ * given:
+ *      thread_state    // state of the thread that has no more iterations to format
+ *
+ * This function is called once by each thread after its last iteration.
+ */
+void
+flushStatsTxt(struct thread_state *thread_state)
+{
+	struct stats_txt_writer *writer;	// Writer of the files
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (thread_state == NULL) {
+		err(247, __func__, "thread_state arg is NULL");
+	}
+	if (thread_state->global_state == NULL) {
+		err(247, __func__, "thread_state->global_state is NULL");
+	}
+	writer = thread_state->global_state->stats_txt;
+	if (writer == NULL) {
+		err(247, __func__, "stats.txt files are not open");
+	}
+	if (thread_state->thread_id < 0 || thread_state->thread_id >= writer->buffers) {
+		err(247, __func__, "thread_id: %ld must be in [0, %ld)", thread_state->thread_id, writer->buffers);
+	}
+
+	/*
+	 * Hand over what is left in the buffer of the thread
+	 */
+	if (writer->buffer[thread_state->thread_id].batch != NULL) {
+		handOver(&writer->buffer[thread_state->thread_id]);
+	}
+
+	return;
+}
+
+
+/*
+ * closeStatsTxt - wait for the writer thread to write all the rows, and close the files
+ *
+ * given:
+ *      state           // run state to test under
+ *
+ * NOTE: This function must be called after all the threads have called flushStatsTxt().
+ */
+void
+closeStatsTxt(struct state *state)
+{
+	struct stats_txt_writer *writer;	// Writer of the files
+	struct stats_txt_test *test;		// Output files of a test
+	void *status;				// Exit status of the writer thread
+	int io_ret;				// I/O return status
+	long int i;
+	int j;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(249, __func__, "state arg is NULL");
+	}
+	writer = state->stats_txt;
+	if (writer == NULL) {
+		err(249, __func__, "stats.txt files are not open");
+	}
+	for (i = 0; i < writer->buffers; i++) {
+		if (writer->buffer[i].batch != NULL) {
+			err(249, __func__, "thread %ld did not hand over its last rows", i);
+		}
+	}
+
+	/*
+	 * Let the writer thread finish
+	 */
+	pthread_mutex_lock(&writer->mutex);
+	writer->closing = true;
+	pthread_cond_signal(&writer->ready);
+	pthread_mutex_unlock(&writer->mutex);
+	io_ret = pthread_join(writer->thread, &status);
+	if (io_ret != 0) {
+		errno = io_ret;
+		errp(249, __func__, "error on pthread_join()");
+	}
+	pthread_cond_destroy(&writer->space);
+	pthread_cond_destroy(&writer->ready);
+	pthread_mutex_destroy(&writer->mutex);
+
+	/*
+	 * Close the files of each test
+	 */
+	for (i = 1; i <= NUMOFTESTS; i++) {
+		test = &writer->test[i];
+		if (test->stats == NULL) {
+			continue;
+		}
+		if (test->next != state->tp.numOfBitStreams) {
+			err(249, __func__, "wrote %ld rows of %s[%ld] instead of %ld", test->next, state->testNames[i], i,
+			    state->tp.numOfBitStreams);
+		}
+
+		/*
+		 * Flush and close stats.txt and results.txt, free pathnames
+		 */
+		errno = 0;	// paranoia
+		io_ret = fclose(test->stats);
+		if (io_ret != 0) {
+			errp(249, __func__, "error closing: %s", test->stats_txt);
+		}
+		errno = 0;	// paranoia
+		io_ret = fclose(test->results);
+		if (io_ret != 0) {
+			errp(249, __func__, "error closing: %s", test->results_txt);
+		}
+		free(test->stats_txt);
+		free(test->results_txt);
+
+		/*
+		 * Write what is left of each data*.txt file, free pathnames
+		 */
+		for (j = 0; j < test->partitions; j++) {
+			flushData(test, j);
+			free(test->data_txt[j]);
+		}
+		free(test->data_txt);
+		free(test->data_len);
+		free(test->data);
+		free(test->pending);
+	}
+
+	/*
+	 * Free the writer
+	 */
+	free(writer->buffer);
+	free(writer);
+	state->stats_txt = NULL;
+
+	return;
+}
+
+
+/*
+ * writeStatsTxt - writer thread, write the batches queued by the threads until closing
+ *
+ * given:
+ *      arg             // struct stats_txt_writer of the files
+ */
+static void *
+writeStatsTxt(void *arg)
+{
+	struct stats_txt_writer *writer = (struct stats_txt_writer *) arg;
+	struct stats_txt_batch *batch;	// Batch dequeued
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (writer == NULL) {
+		err(248, __func__, "arg is NULL");
+	}
+
+	/*
+	 * Write the batches in the order they were queued
+	 */
+	pthread_mutex_lock(&writer->mutex);
+	while (1) {
+		while (writer->head == NULL && writer->closing == false) {
+			pthread_cond_wait(&writer->ready, &writer->mutex);
+		}
+		if (writer->head == NULL) {
+			break;
+		}
+		batch = writer->head;
+		writer->head = batch->next;
+		if (writer->head == NULL) {
+			writer->tail = NULL;
+		}
+		writer->queued--;
+		pthread_cond_broadcast(&writer->space);
+		pthread_mutex_unlock(&writer->mutex);
+
+		writeBatch(writer, batch);
+
+		pthread_mutex_lock(&writer->mutex);
+	}
+	pthread_mutex_unlock(&writer->mutex);
+
+	return NULL;
+}
+
+
+/*
+ * handOver - close the memory streams of the batch of a thread, and queue it for the writer thread
+ *
+ * given:
+ *      buffer          // buffer of the thread
+ *
+ * The thread waits while the writer thread already has max_queued batches to write.
+ */
+static void
+handOver(struct stats_txt_buffer *buffer)
+{
+	struct stats_txt_writer *writer;	// Writer of the files
+	struct stats_txt_batch *batch;		// Batch handed over
+	int io_ret;				// I/O return status
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (buffer == NULL) {
+		err(247, __func__, "buffer arg is NULL");
+	}
+	writer = buffer->writer;
+	batch = buffer->batch;
+	if (writer == NULL || batch == NULL) {
+		err(247, __func__, "buffer has no writer or no batch");
+	}
+
+	/*
+	 * Close the memory streams, setting the text and size of the batch
+	 */
+	errno = 0;	// paranoia
+	io_ret = fclose(buffer->stats);
+	if (io_ret != 0) {
+		errp(247, __func__, "error closing the stats.txt memory stream");
+	}
+	errno = 0;	// paranoia
+	io_ret = fclose(buffer->results);
+	if (io_ret != 0) {
+		errp(247, __func__, "error closing the results.txt memory stream");
+	}
+	buffer->stats = NULL;
+	buffer->results = NULL;
+	buffer->batch = NULL;
+
+	/*
+	 * An empty batch has nothing to write
+	 */
+	if (batch->rows->count == 0) {
+		free_dyn_array(batch->rows);
+		free(batch->rows);
+		free(batch->stats_text);
+		free(batch->results_text);
+		free(batch);
+		return;
+	}
+
+	/*
+	 * Queue the batch
+	 */
+	pthread_mutex_lock(&writer->mutex);
+	while (writer->queued >= writer->max_queued) {
+		pthread_cond_wait(&writer->space, &writer->mutex);
+	}
+	batch->next = NULL;
+	if (writer->tail == NULL) {
+		writer->head = batch;
+	} else {
+		writer->tail->next = batch;
+	}
+	writer->tail = batch;
+	writer->queued++;
+	pthread_cond_signal(&writer->ready);
+	pthread_mutex_unlock(&writer->mutex);
+
+	return;
+}
+
+
+/*
+ * writeBatch - write the rows of a batch whose turn has come, and hold the others
+ *
+ * given:
+ *      writer          // writer of the files
+ *      batch           // batch dequeued
+ *
+ * The rows of a test are written in the order of the iterations.  A row that comes before the rows of
+ * the earlier iterations of its test is held until they are written.
+ */
+static void
+writeBatch(struct stats_txt_writer *writer, struct stats_txt_batch *batch)
+{
+	struct stats_txt_test *test;	// Output files of the test of a row
+	struct stats_txt_row *row;	// Row of the batch
+	long int count;			// Number of rows in the batch
+	long int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (writer == NULL) {
+		err(248, __func__, "writer arg is NULL");
+	}
+	if (batch == NULL) {
+		err(248, __func__, "batch arg is NULL");
+	}
+
+	/*
+	 * Process each row of the batch
+	 *
+	 * NOTE: The batch is freed as soon as its last row is written, which may happen with its last row.
+	 */
+	count = batch->rows->count;
+	batch->unwritten = count;
+	for (i = 0; i < count; i++) {
+		row = addr_value(batch->rows, struct stats_txt_row, i);
+		if (row->test <= 0 || row->test > NUMOFTESTS || writer->test[row->test].stats == NULL) {
+			err(248, __func__, "row has a bogus test: %d", row->test);
+		}
+		test = &writer->test[row->test];
+
+		/*
+		 * Hold a row that comes too early
+		 */
+		if (row->iteration != test->next) {
+			holdRow(test, row);
+			continue;
+		}
+
+		/*
+		 * Write the row, and the rows held that follow it
+		 */
+		writeRow(test, row);
+		while (test->pending_size > 0 && test->pending[test->next & (test->pending_size - 1)] != NULL) {
+			row = test->pending[test->next & (test->pending_size - 1)];
+			test->pending[test->next & (test->pending_size - 1)] = NULL;
+			writeRow(test, row);
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * holdRow - hold a row until the rows of the earlier iterations of its test are written
+ *
+ * given:
+ *      test            // output files of the test of the row
+ *      row             // row to hold
+ */
+static void
+holdRow(struct stats_txt_test *test, struct stats_txt_row *row)
+{
+	struct stats_txt_row **pending;	// Grown pending rows
+	long int distance;		// Number of iterations between the next one to be written and the row
+	long int size;			// Number of entries in the grown pending rows
+	long int i;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (test == NULL) {
+		err(248, __func__, "test arg is NULL");
+	}
+	if (row == NULL) {
+		err(248, __func__, "row arg is NULL");
+	}
+	distance = row->iteration - test->next;
+	if (distance <= 0) {
+		err(248, __func__, "iteration %ld of test %d was already written", row->iteration + 1, row->test);
+	}
+
+	/*
+	 * Grow the pending rows so that they hold the row
+	 */
+	if (distance >= test->pending_size) {
+		size = MAX(test->pending_size, DEFAULT_CHUNK);
+		while (distance >= size) {
+			size *= 2;
+		}
+		pending = calloc((size_t) size, sizeof(*pending));
+		if (pending == NULL) {
+			errp(248, __func__, "cannot calloc for pending: %ld elements of %lu bytes each", size, sizeof(*pending));
+		}
+		for (i = 0; i < test->pending_size; i++) {
+			if (test->pending[i] != NULL) {
+				pending[test->pending[i]->iteration & (size - 1)] = test->pending[i];
+			}
+		}
+		free(test->pending);
+		test->pending = pending;
+		test->pending_size = size;
+	}
+
+	/*
+	 * Hold the row
+	 */
+	if (test->pending[row->iteration & (test->pending_size - 1)] != NULL) {
+		err(248, __func__, "iteration %ld of test %d was formatted twice", row->iteration + 1, row->test);
+	}
+	test->pending[row->iteration & (test->pending_size - 1)] = row;
+
+	return;
+}
+
+
+/*
+ * writeRow - write a row to the stats.txt, results.txt and data*.txt files of its test
+ *
+ * given:
+ *      test            // output files of the test of the row
+ *      row             // row of the next iteration to be written
+ *
+ * The batch of the row is freed once all its rows are written.
+ */
+static void
+writeRow(struct stats_txt_test *test, struct stats_txt_row *row)
+{
+	struct stats_txt_batch *batch;	// Batch of the row
+	const char *line;		// results.txt line of a p_value
+	const char *end;		// End of the results.txt text of the row
+	const char *eol;		// Newline at the end of line
+	size_t len;			// Length of line, including its newline
+	size_t io_ret;			// I/O return status
+	int j;
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (test == NULL) {
+		err(248, __func__, "test arg is NULL");
+	}
+	if (row == NULL) {
+		err(248, __func__, "row arg is NULL");
+	}
+	batch = row->batch;
+	if (row->stats_offset + row->stats_len > batch->stats_size ||
+	    row->results_offset + row->results_len > batch->results_size) {
+		err(248, __func__, "row of iteration %ld of test %d is beyond its batch", row->iteration + 1, row->test);
+	}
+
+	/*
+	 * Write the stats.txt and results.txt text
+	 */
+	errno = 0;	// paranoia
+	io_ret = fwrite(batch->stats_text + row->stats_offset, 1, row->stats_len, test->stats);
+	if (io_ret != row->stats_len) {
+		errp(248, __func__, "error in writing to %s", test->stats_txt);
+	}
+	errno = 0;	// paranoia
+	io_ret = fwrite(batch->results_text + row->results_offset, 1, row->results_len, test->results);
+	if (io_ret != row->results_len) {
+		errp(248, __func__, "error in writing to %s", test->results_txt);
+	}
+
+	/*
+	 * The j-th results.txt line of the row goes to the j-th data*.txt file if we need to partition results
+	 */
+	if (test->partitions > 0) {
+		line = batch->results_text + row->results_offset;
+		end = line + row->results_len;
+		for (j = 0; j < test->partitions; j++) {
+			eol = (line < end) ? memchr(line, '\n', (size_t) (end - line)) : NULL;
+			if (eol == NULL) {
+				err(248, __func__, "row of iteration %ld of test %d has %d p_value lines, expected %d",
+				    row->iteration + 1, row->test, j, test->partitions);
+			}
+			len = (size_t) (eol - line) + 1;
+			if (j >= test->first_partition) {
+				if (test->data_len[j] + len > test->data_size) {
+					flushData(test, j);
+				}
+				memcpy(test->data + j * test->data_size + test->data_len[j], line, len);
+				test->data_len[j] += len;
+			}
+			line = eol + 1;
+		}
+		if (line != end) {
+			err(248, __func__, "row of iteration %ld of test %d has more than %d p_value lines",
+			    row->iteration + 1, row->test, test->partitions);
+		}
+	}
+	test->next++;
+
+	/*
+	 * Free the batch once all its rows are written
+	 */
+	batch->unwritten--;
+	if (batch->unwritten == 0) {
+		free_dyn_array(batch->rows);
+		free(batch->rows);
+		free(batch->stats_text);
+		free(batch->results_text);
+		free(batch);
+	}
+
+	return;
+}
+
+
+/*
+ * flushData - append the buffered lines of a data*.txt file to it
+ *
+ * given:
+ *      test            // output files of a test
+ *      partition       // index of the data*.txt file
+ */
+static void
+flushData(struct stats_txt_test *test, int partition)
+{
+	FILE *data;		// Open data*.txt file
+	size_t io_ret;		// I/O return status
+
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (test == NULL) {
+		err(248, __func__, "test arg is NULL");
+	}
+	if (partition < 0 || partition >= test->partitions) {
+		err(248, __func__, "partition: %d must be in [0, %d)", partition, test->partitions);
+	}
+	if (test->data_len[partition] == 0) {
+		return;
+	}
+
+	/*
+	 * Append the buffered lines
+	 */
+	errno = 0;	// paranoia
+	data = fopen(test->data_txt[partition], "a");
+	if (data == NULL) {
+		errp(248, __func__, "cannot open for appending: %s", test->data_txt[partition]);
+	}
+	errno = 0;	// paranoia
+	io_ret = fwrite(test->data + partition * test->data_size, 1, test->data_len[partition], data);
+	if (io_ret != test->data_len[partition]) {
+		errp(248, __func__, "error in writing to %s", test->data_txt[partition]);
+	}
+	errno = 0;	// paranoia
+	if (fclose(data) != 0) {
+		errp(248, __func__, "error closing: %s", test->data_txt[partition]);
+	}
+	test->data_len[partition] = 0;
+
+	return;
+}
@@ -0,0 +1,56 @@
+/*****************************************************************************
+   S T A T S . T X T   W R I T E R   F U N C T I O N   P R O T O T Y P E S
+ *****************************************************************************/
+
+/*
+ * This code has been heavily modified by the following people:
+ *
+ *      Landon Curt Noll
+ *      Tom Gilgan
+ *      Riccardo Paccagnella
+ *
+ * See the README.md and the initial comment in sts.c for more information.
+ *
+ * WE (THOSE LISTED ABOVE WHO HEAVILY MODIFIED THIS CODE) DISCLAIM ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL WE (THOSE LISTED ABOVE
+ * WHO HEAVILY MODIFIED THIS CODE) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll, http://www.isthe.com/chongo/index.html) /\oo/\
+ *
+ * Share and enjoy! :-)
+ */
+
+#ifndef STATS_TXT_H
+#   define STATS_TXT_H
+
+#include "../utils/defs.h"
+
+/*
+ * Buffer of a thread, in which the stats.txt and results.txt text of an iteration of a test is formatted
+ *
+ * A test prints the stats.txt text of an iteration into stats, and then one results.txt line
+ * per p_value into results, between the calls to beginStatsTxtRow() and endStatsTxtRow().
+ */
+struct stats_txt_buffer {
+	FILE *stats;				// Memory stream of the stats.txt text of the batch, or NULL
+	FILE *results;				// Memory stream of the results.txt text of the batch, or NULL
+	struct stats_txt_batch *batch;		// Batch of rows being formatted by the thread, or NULL
+	struct stats_txt_writer *writer;	// Writer to hand the batch over to
+	int test;				// Test of the row being formatted
+	long int iteration;			// Iteration of the row being formatted
+	long int stats_start;			// Offset in stats of the row being formatted
+	long int results_start;			// Offset in results of the row being formatted
+};
+
+extern void initStatsTxt(struct state *state);
+extern struct stats_txt_buffer *beginStatsTxtRow(struct thread_state *thread_state, int test, long int iteration);
+extern void endStatsTxtRow(struct stats_txt_buffer *buffer);
+extern void flushStatsTxt(struct thread_state *thread_state);
+extern void closeStatsTxt(struct state *state);
+
+#endif				/* STATS_TXT_H */
@@ -52,6 +52,7 @@
 // sts includes
 #include "../utils/externs.h"
 #include "utilities.h"
+#include "stats_txt.h"
 #include "debug.h"
 
 
@@ -65,6 +66,32 @@ static void handleFileBasedBitStreams(struct state *state);
 static void *testBits(void *thread_args);
 static void parseBitsASCIIInput(struct thread_state *thread_state);
 static void parseBitsBinaryInput(struct thread_state *thread_state);
+static long int popcountWordsScalar(const WORD64 *words, long int count);
+static long int popcountChangesScalar(const WORD64 *words, long int count);
+
+/*
+ * Popcount kernels used by countOnes() and countBitChanges()
+ *
+ * These start as the portable scalar kernels and are replaced by setupPopcount()
+ * with the fastest kernels supported by the CPU.
+ */
+static long int (*popcountWords)(const WORD64 *words, long int count) = popcountWordsScalar;
+static long int (*popcountChanges)(const WORD64 *words, long int count) = popcountChangesScalar;
+
+/*
+ * Hardware popcount kernels are compiled for x86 by compilers that support
+ * per-function target attributes and runtime CPU feature detection
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ >= 8)
+#   define HW_POPCOUNT
+static long int popcountWordsPOPCNT(const WORD64 *words, long int count) __attribute__((target("popcnt")));
+static long int popcountChangesPOPCNT(const WORD64 *words, long int count) __attribute__((target("popcnt")));
+static long int popcountWordsVPOPCNT(const WORD64 *words, long int count)
+	__attribute__((target("avx512f,avx512vpopcntdq")));
+static long int popcountChangesVPOPCNT(const WORD64 *words, long int count)
+	__attribute__((target("avx512f,avx512vpopcntdq")));
+#endif				/* HW_POPCOUNT */
 
 
 /*
@@ -1192,6 +1219,10 @@ fixParameters(struct state *state)
 		printf("    [%d] Uniformity Cutoff Level:			%f\n", PARAM_uniformity_level,
 		       state->tp.uniformity_level);
 		printf("    [%d] Alpha - confidence level:       		%f\n", PARAM_alpha, state->tp.alpha);
+		if (state->testVector[TEST_RANK] == true) {
+			printf("    [%d] Rank Test - matrix size(M):			%ld\n", PARAM_rankMatrixSize,
+			       state->tp.rankMatrixSize);
+		}
 		putchar('\n');
 		printf("   Select Test (%d to continue): ", PARAM_continue);
 		fflush(stdout);
@@ -1420,6 +1451,27 @@ fixParameters(struct state *state)
 			} while (state->tp.alpha <= 0.0 || state->tp.alpha > 0.1);
 			break;
 
+		case PARAM_rankMatrixSize:
+			do {
+				// Ask for new value
+				printf("   Enter Rank Test matrix size (try: %d): ", DEFAULT_RANK);
+				fflush(stdout);
+
+				// Read numeric answer
+				state->tp.rankMatrixSize = getNumber(stdin, stdout);
+				putchar('\n');
+
+				// Check error range
+				if (state->tp.rankMatrixSize < MIN_M_RANK) {
+					printf("    Rank Test matrix size(M): %ld must be >= %d, try again\n\n",
+					       state->tp.rankMatrixSize, MIN_M_RANK);
+				} else if (state->tp.rankMatrixSize > MAX_NUMBER_OF_COLS_RANK) {
+					printf("    Rank Test matrix size(M): %ld must be <= %d, try again\n\n",
+					       state->tp.rankMatrixSize, MAX_NUMBER_OF_COLS_RANK);
+				}
+			} while (state->tp.rankMatrixSize < MIN_M_RANK || state->tp.rankMatrixSize > MAX_NUMBER_OF_COLS_RANK);
+			break;
+
 		default:
 			printf("   parameter number must be between 0 and %d, try again\n", MAX_PARAM);
 			fflush(stdout);
@@ -1502,13 +1554,14 @@ handleFileBasedBitStreams(struct state *state)
 	}
 
 	/*
-	 * Compute seek position into the input file according to the jobnum parameter given.
+	 * Compute seek position into the input file according to the first iteration of this process,
+	 * the first one of the -j jobnum job unless testing a -K shard.
 	 *
 	 * The position where to seek depends on the data format. If the input is made of
 	 * ASCII 0 and 1 characters then we can seek by counting 1 position as 1 bit.
 	 */
 	else if (state->dataFormat == FORMAT_ASCII_01) {
-		state->base_seek = state->jobnum * state->tp.n * state->tp.numOfBitStreams;
+		state->base_seek = state->firstIteration * state->tp.n;
 	}
 
 	/*
@@ -1523,7 +1576,7 @@ handleFileBasedBitStreams(struct state *state)
 		 * However if the bit count is a multiple of 8, then we do not increase it.
 		 * We only increase by one in the case of a final partial byte.
 		 */
-		state->base_seek = ((state->jobnum * state->tp.n * state->tp.numOfBitStreams) + BITS_N_BYTE - 1) / BITS_N_BYTE;
+		state->base_seek = ((state->firstIteration * state->tp.n) + BITS_N_BYTE - 1) / BITS_N_BYTE;
 	}
 
 	/*
@@ -1635,6 +1688,18 @@ static void
 		}
 	}
 
+	/*
+	 * Finish any iterations still batched up by this thread
+	 */
+	flush(thread_state);
+
+	/*
+	 * Hand the stats.txt and results.txt rows formatted by this thread over to the writer (if needed)
+	 */
+	if (state->resultstxtFlag == true) {
+		flushStatsTxt(thread_state);
+	}
+
 	pthread_exit((void *) thread_state->thread_id);
 }
 
@@ -1890,298 +1955,384 @@ copyBitsToEpsilon(struct state *state, long int thread_id, BYTE *x, long int xBi
 
 
 /*
- * getTimestamp - get the time and write it as a string into a buffer
+ * packEpsilon - pack the epsilon bit array of a thread into 64 bit words
  *
  * given:
- *      buf             // fixed length buffer
- *      len             // length of the buffer in bytes
- *
- * Determine the time as of "now" and format it as follows:
- *
- *      yyyy-mm-dd hh:mm:ss
+ *      state           // pointer to run state
+ *      thread_id       // thread whose epsilon bit array is to be packed
  *
- * This function does not retun on error.
+ * Bit i of the epsilon bit array becomes bit (i % BITS_N_WORD64) of word i / BITS_N_WORD64
+ * of state->packed_epsilon[thread_id].  The unused bits of the last partial word,
+ * as well as the extra word that follows it, are left as 0.
  */
 void
-getTimestamp(char *buf, size_t len)
+packEpsilon(struct state *state, long int thread_id)
 {
-	time_t seconds;		// seconds since the epoch
-	struct tm *loc_ret;	// return value form localtime_r()
-	struct tm now;		// the time now
-	size_t time_len;	// Length of string produced by strftime() or 0
+	BitSequence *epsilon;	// Bit stream to pack
+	WORD64 *packed;		// Packed bit stream
+	WORD64 word;		// Word being packed
+	long int words;		// Number of full words in the bit stream
+	long int i;
+	long int j;
 
-	// firewall
-	if (buf == NULL) {
-		err(229, __func__, "bug arg is NULL");
+	/*
+	 * Check preconditions (firewall)
+	 */
+	if (state == NULL) {
+		err(233, __func__, "state arg is NULL");
 	}
-	if (len <= 0) {
-		err(229, __func__, "len must be > 0: %lu", len);
+	if (state->epsilon == NULL || state->epsilon[thread_id] == NULL) {
+		err(233, __func__, "state->epsilon[%ld] is NULL", thread_id);
 	}
+	if (state->packed_epsilon == NULL || state->packed_epsilon[thread_id] == NULL) {
+		err(233, __func__, "state->packed_epsilon[%ld] is NULL", thread_id);
+	}
+	epsilon = state->epsilon[thread_id];
+	packed = state->packed_epsilon[thread_id];
 
 	/*
-	 * Determine the time for now
+	 * Pack the full words
 	 */
-	errno = 0;		// paranoia
-	seconds = time(NULL);
-	if (seconds < 0) {
-		errp(229, __func__, "time returned < 0: %ld", seconds);
-	}
-	loc_ret = localtime_r(&seconds, &now);
-	if (loc_ret == NULL) {
-		errp(229, __func__, "localtime_r returned NULL");
+	words = state->tp.n / BITS_N_WORD64;
+	for (i = 0; i < words; i++) {
+		word = 0;
+		for (j = 0; j < BITS_N_WORD64; j++) {
+			word |= (WORD64) (epsilon[i * BITS_N_WORD64 + j] & 1) << j;
+		}
+		packed[i] = word;
 	}
-	errno = 0;		// paranoia
-	time_len = strftime(buf, len - 1, "%F %T", &now);
-	if (time_len == 0) {
-		errp(229, __func__, "strftime failed");
+
+	/*
+	 * Pack the final partial word, if any
+	 */
+	word = 0;
+	for (j = 0; j < state->tp.n - words * (long int) BITS_N_WORD64; j++) {
+		word |= (WORD64) (epsilon[words * BITS_N_WORD64 + j] & 1) << j;
 	}
-	buf[len] = '\0';	// paranoia
+	packed[words] = word;
+	packed[words + 1] = 0;
+
 	return;
 }
 
 
-void write_p_val_to_file(struct state *state)
+/*
+ * popcountWordsScalar - count the 1 bits of an array of words without hardware support
+ *
+ * given:
+ *      words           // array of words
+ *      count           // number of words to count
+ *
+ * returns:
+ *      number of 1 bits in the count words
+ */
+static long int
+popcountWordsScalar(const WORD64 *words, long int count)
 {
-	long int i, j;
-	char *filename, *work_filepath, *final_filepath;
+	WORD64 w;		// Word being counted
+	long int ones;		// Number of 1 bits found
+	long int i;
 
-	/*
-	 * Check preconditions (firewall)
-	 */
-	if (state == NULL) {
-		err(232, __func__, "state arg was NULL");
+	ones = 0;
+	for (i = 0; i < count; i++) {
+		w = words[i];
+		w = w - ((w >> 1) & (WORD64) 0x5555555555555555ULL);
+		w = (w & (WORD64) 0x3333333333333333ULL) + ((w >> 2) & (WORD64) 0x3333333333333333ULL);
+		w = (w + (w >> 4)) & (WORD64) 0x0f0f0f0f0f0f0f0fULL;
+		ones += (long int) ((w * (WORD64) 0x0101010101010101ULL) >> 56);
 	}
+	return ones;
+}
 
-	/*
-	 * Compute the filename of the working file (.work)
-	 */
-	asprintf(&filename, "sts.%04ld.%ld.%ld.work", state->jobnum, state->tp.numOfBitStreams, state->tp.n);
-	work_filepath = filePathName(state->workDir, filename);
-	free(filename);
 
-	/*
-	 * Create and open the working binary file
-	 */
-	FILE *p_val_file;
-	p_val_file = fopen(work_filepath, "wb");
-	size_t ret;		// fwrite return
+/*
+ * popcountChangesScalar - count the changes between adjacent bits of an array of words without hardware support
+ *
+ * given:
+ *      words           // array of count + 1 words
+ *      count           // number of words to count
+ *
+ * returns:
+ *      number of bits i, for 0 <= i < count * BITS_N_WORD64, that differ from bit i + 1
+ */
+static long int
+popcountChangesScalar(const WORD64 *words, long int count)
+{
+	WORD64 w;		// Changes in the word being counted
+	long int changes;	// Number of changes found
+	long int i;
 
-	/*
-	 * Write the p-values of each test in the working file
-	 */
-	for (i = 1; i <= NUMOFTESTS; i++) {
-		if (state->testVector[i] == true) {
+	changes = 0;
+	for (i = 0; i < count; i++) {
+		w = words[i] ^ ((words[i] >> 1) | (words[i + 1] << (BITS_N_WORD64 - 1)));
+		changes += popcountWordsScalar(&w, 1);
+	}
+	return changes;
+}
 
-			/*
-			 * Write the number of the test
-			 */
-			ret = fwrite(&i, sizeof(i), 1, p_val_file);
-			if (ferror(p_val_file)) {
-				warnp(__func__, "error while writing test number to p-value file: %s", filename);
-				break;
-			}
-			if (ret != 1) {
-				warn(__func__, "unable to write test number to p-value file: %s", filename);
-				break;
-			}
 
-			/*
-			 * Write the number of p-values for this test
-			 */
-			ret = fwrite(&(state->p_val[i]->count), sizeof(state->p_val[i]->count), 1, p_val_file);
-			if (ferror(p_val_file)) {
-				warnp(__func__, "error while writing test p-value count to p-value file: %s", filename);
-				break;
-			}
-			if (ret != 1) {
-				warn(__func__, "unable to write p-value count to p-value file: %s", filename);
-				break;
-			}
+#if defined(HW_POPCOUNT)
 
-			/*
-			 * Write the p-values
-			 */
-			for (j = 0; j < state->p_val[i]->count; j++) {
+/*
+ * popcountWordsPOPCNT - count the 1 bits of an array of words with the POPCNT instruction
+ */
+static long int
+popcountWordsPOPCNT(const WORD64 *words, long int count)
+{
+	long int ones;		// Number of 1 bits found
+	long int i;
 
-				double p_val;
+	ones = 0;
+	for (i = 0; i < count; i++) {
+		ones += __builtin_popcountll(words[i]);
+	}
+	return ones;
+}
 
-				/*
-				 * Also when the test is NON_OVERLAPPING, take the p-value only.
-				 */
-				if (i != TEST_NON_OVERLAPPING) {
-					p_val = get_value(state->p_val[i], double, j);
-				} else {
-					struct nonover_stats *nonov = addr_value(state->p_val[i], struct nonover_stats, j);
-					p_val = nonov->p_value;
-				}
 
-				ret = fwrite(&p_val, sizeof(p_val), 1, p_val_file);
-				if (ferror(p_val_file)) {
-					warnp(__func__, "error while writing p-value[%ld] to p-value file: %s", j, filename);
-					break;
-				}
-				if (ret != 1) {
-					warn(__func__, "unable to write p-value[%ld] to p-value file: %s", j, filename);
-					break;
-				}
-			}
-		}
+/*
+ * popcountChangesPOPCNT - count the changes between adjacent bits of an array of words with the POPCNT instruction
+ */
+static long int
+popcountChangesPOPCNT(const WORD64 *words, long int count)
+{
+	long int changes;	// Number of changes found
+	long int i;
+
+	changes = 0;
+	for (i = 0; i < count; i++) {
+		changes += __builtin_popcountll(words[i] ^ ((words[i] >> 1) | (words[i + 1] << (BITS_N_WORD64 - 1))));
 	}
+	return changes;
+}
 
-	/*
-	 * Close the "working" file
-	 */
-	fclose(p_val_file);
+
+/*
+ * popcountWordsVPOPCNT - count the 1 bits of an array of words with the AVX-512 VPOPCNTQ instruction
+ *
+ * NOTE: This is the same loop as popcountWordsPOPCNT(), the compiler vectorizes it
+ *       for the AVX-512 target of this function.
+ */
+static long int
+popcountWordsVPOPCNT(const WORD64 *words, long int count)
+{
+	long int ones;		// Number of 1 bits found
+	long int i;
+
+	ones = 0;
+	for (i = 0; i < count; i++) {
+		ones += __builtin_popcountll(words[i]);
+	}
+	return ones;
+}
+
+
+/*
+ * popcountChangesVPOPCNT - count the changes between adjacent bits of an array of words with the VPOPCNTQ instruction
+ *
+ * NOTE: This is the same loop as popcountChangesPOPCNT(), the compiler vectorizes it
+ *       for the AVX-512 target of this function.
+ */
+static long int
+popcountChangesVPOPCNT(const WORD64 *words, long int count)
+{
+	long int changes;	// Number of changes found
+	long int i;
+
+	changes = 0;
+	for (i = 0; i < count; i++) {
+		changes += __builtin_popcountll(words[i] ^ ((words[i] >> 1) | (words[i + 1] << (BITS_N_WORD64 - 1))));
+	}
+	return changes;
+}
+
+#endif				/* HW_POPCOUNT */
+
+
+/*
+ * setupPopcount - select the fastest popcount kernels supported by the CPU
+ *
+ * NOTE: This function must be called before any thread is started.
+ */
+void
+setupPopcount(void)
+{
+	popcountWords = popcountWordsScalar;
+	popcountChanges = popcountChangesScalar;
+
+#if defined(HW_POPCOUNT)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512vpopcntdq")) {
+		popcountWords = popcountWordsVPOPCNT;
+		popcountChanges = popcountChangesVPOPCNT;
+		dbg(DBG_MED, "using AVX-512 VPOPCNTDQ popcount kernels");
+	} else if (__builtin_cpu_supports("popcnt")) {
+		popcountWords = popcountWordsPOPCNT;
+		popcountChanges = popcountChangesPOPCNT;
+		dbg(DBG_MED, "using POPCNT popcount kernels");
+	} else {
+		dbg(DBG_MED, "using scalar popcount kernels");
+	}
+#else
+	dbg(DBG_MED, "using scalar popcount kernels");
+#endif				/* HW_POPCOUNT */
+
+	return;
+}
+
+
+/*
+ * countOnes - count the 1 bits in a range of a packed bit stream
+ *
+ * given:
+ *      packed          // bit stream packed by packEpsilon()
+ *      start           // index of the first bit of the range
+ *      len             // number of bits in the range
+ *
+ * returns:
+ *      number of 1 bits among bits start thru start + len - 1 of the bit stream
+ */
+long int
+countOnes(const WORD64 *packed, long int start, long int len)
+{
+	WORD64 w;		// Masked edge word
+	long int first;		// Index of the word holding the first bit of the range
+	long int last;		// Index of the word holding the last bit of the range
+	long int ones;		// Number of 1 bits found
+	int head;		// Position of the first bit of the range in its word
+	int tail;		// Position of the last bit of the range in its word
 
 	/*
-	 * Compute the final filename
+	 * Check preconditions (firewall)
 	 */
-	asprintf(&filename, "sts.%04ld.%ld.%ld.pvalues", state->jobnum, state->tp.numOfBitStreams, state->tp.n);
-	final_filepath = filePathName(state->workDir, filename);
+	if (packed == NULL) {
+		err(234, __func__, "packed arg is NULL");
+	}
+	if (start < 0 || len < 0) {
+		err(234, __func__, "start: %ld and len: %ld must be >= 0", start, len);
+	}
+	if (len == 0) {
+		return 0;
+	}
+
+	first = start / BITS_N_WORD64;
+	last = (start + len - 1) / BITS_N_WORD64;
+	head = (int) (start % BITS_N_WORD64);
+	tail = (int) ((start + len - 1) % BITS_N_WORD64);
 
 	/*
-	 * Rename the work file (.work) to have its final filename (.pvalues)
+	 * Range within a single word
 	 */
-	if (rename(work_filepath, final_filepath) < 0) {
-		errp(232, __func__, "error in renaming %s to %s", work_filepath, final_filepath);
+	if (first == last) {
+		w = (packed[first] >> head) & (~(WORD64) 0 >> (BITS_N_WORD64 - 1 - (tail - head)));
+		return popcountWords(&w, 1);
 	}
 
 	/*
-	 * Free allocated memory
+	 * Edge words, then the full words in between
 	 */
-	free(filename);
-	free(work_filepath);
-	free(final_filepath);
+	w = packed[first] >> head;
+	ones = popcountWords(&w, 1);
+	w = packed[last] & (~(WORD64) 0 >> (BITS_N_WORD64 - 1 - tail));
+	ones += popcountWords(&w, 1);
+	ones += popcountWords(packed + first + 1, last - first - 1);
+
+	return ones;
 }
 
 
-void read_from_p_val_file(struct state *state)
+/*
+ * countBitChanges - count the changes between adjacent bits of a packed bit stream
+ *
+ * given:
+ *      packed          // bit stream packed by packEpsilon()
+ *      n               // number of bits in the bit stream
+ *
+ * returns:
+ *      number of bits k, for 1 <= k < n, that differ from bit k - 1
+ */
+long int
+countBitChanges(const WORD64 *packed, long int n)
 {
-	long int test_num;		// test number for the pvalues that follow in the pvalue file
-	long int p_val_index;		// current pvalue number for a given test number in the pvalue file
+	WORD64 w;		// Changes in the last word
+	long int words;		// Number of words whose changes are all counted
+	int tail;		// Number of changes to count in the last word
+	long int changes;	// Number of changes found
 
 	/*
 	 * Check preconditions (firewall)
 	 */
-	if (state == NULL) {
-		err(232, __func__, "state arg was NULL");
+	if (packed == NULL) {
+		err(234, __func__, "packed arg is NULL");
+	}
+	if (n <= 1) {
+		return 0;
 	}
-	dbg(DBG_LOW, "start of reading pvalue file(s) phase");
-
-	struct Node *current = state->filenames;
-	while (current != NULL) {
-		char *filename;		// current pvalues filename
-		FILE *p_val_file;	// open pvalues filename
-		size_t ret;		// fread return
-
-		/*
-		 * Open the file
-		 */
-		filename = current->filename;
-		if (filename == NULL) {
-		    err(232, __func__, "current p-value filename is NULL");
-		}
-
-		dbg(DBG_MED, "parsing p-value file: %s", filename);
-		p_val_file = fopen(filePathName(state->pvalues_dir, filename), "rb");
-		if (p_val_file == NULL) {
-			warnp(__func__, "skipping p-value file due to error in opening p-value file: %s", filename);
-			current = current->next;
-			continue;
-		}
-
-		/*
-		 * Read the content of the file
-		 */
-		do {
-
-			/*
-			 * Read the test number
-			 */
-			ret = fread(&test_num, sizeof(test_num), 1, p_val_file);
-			if (ferror(p_val_file)) {
-				warnp(__func__, "skipping p-value, error while reading test number from p-value file: %s",
-				      filename);
-				break;
-			}
-			if (feof(p_val_file)) {
-				warn(__func__, "skipping p-value file, found EOF while reading test number from p-value file: %s",
-				     filename);
-				break;
-			}
-			if (ret != 1) {
-				warn(__func__, "skipping p-value file, unable to read test number from p-value file: %s",
-				     filename);
-				break;
-			}
 
-			/*
-			 * Read number of p-values for the current testnum
-			 */
-			long int number_of_p_vals;	// number of pvalues that follow in the pvalue file
-			ret = fread(&number_of_p_vals, sizeof(number_of_p_vals), 1, p_val_file);
-			if (ferror(p_val_file)) {
-				warnp(__func__, "skipping p-value file, error while reading number_of_p_vals from p-value file: %s",
-						filename);
-				break;
-			}
-			if (feof(p_val_file)) {
-				warn(__func__, "skipping p-value file, found EOF while reading number of pvals in p-value file: %s",
-						filename);
-				break;
-			}
-			if (ret != 1) {
-				warn(__func__, "skipping p-value file, unable to read number_of_p_vals from p-value file: %s",
-				     filename);
-				break;
-			}
+	/*
+	 * Bit i of the change words is set when bit i differs from bit i + 1, count n - 1 such bits
+	 */
+	words = (n - 1) / BITS_N_WORD64;
+	tail = (int) ((n - 1) % BITS_N_WORD64);
+	changes = popcountChanges(packed, words);
+	if (tail > 0) {
+		w = packed[words] ^ ((packed[words] >> 1) | (packed[words + 1] << (BITS_N_WORD64 - 1)));
+		w &= ((WORD64) 1 << tail) - 1;
+		changes += popcountWords(&w, 1);
+	}
 
-			/*
-			 * Read all the p-values for this test
-			 */
-			for (p_val_index = 0; p_val_index < number_of_p_vals; p_val_index++) {
-				double p_val;		// pvalue read from pvalue file
-
-				/*
-				 * Read one p-value
-				 */
-				ret = fread(&p_val, sizeof(p_val), 1, p_val_file);
-				if (ferror(p_val_file)) {
-					warnp(__func__, "error while reading a pvalue[%d] from file: %s", p_val_index, filename);
-					break;
-				}
-				if (feof(p_val_file)) {
-					warn(__func__, "EOF while reading pvalue[%ld] from file: %s", p_val_index, filename);
-					break;
-				}
-				if (ret != 1) {
-					warn(__func__, "unable to read a pvalue[%d] from file: %s", p_val_index, filename);
-					break;
-				}
+	return changes;
+}
 
-				/*
-				 * Append each read p-value to the p-values of this test
-				 */
-				if (test_num != TEST_NON_OVERLAPPING) {
-					append_value(state->p_val[test_num], &p_val);
-				} else {
-					struct nonover_stats nonov;
-					nonov.p_value = p_val;
-					append_value(state->p_val[test_num], &nonov);
-				}
-			}
 
-		} while (!feof(p_val_file) && !ferror(p_val_file) && ret == 1 && test_num < NUMOFTESTS);
+/*
+ * getTimestamp - get the time and write it as a string into a buffer
+ *
+ * given:
+ *      buf             // fixed length buffer
+ *      len             // length of the buffer in bytes
+ *
+ * Determine the time as of "now" and format it as follows:
+ *
+ *      yyyy-mm-dd hh:mm:ss
+ *
+ * This function does not retun on error.
+ */
+void
+getTimestamp(char *buf, size_t len)
+{
+	time_t seconds;		// seconds since the epoch
+	struct tm *loc_ret;	// return value form localtime_r()
+	struct tm now;		// the time now
+	size_t time_len;	// Length of string produced by strftime() or 0
 
-		/*
-		 * Close the file that has been read
-		 */
-		fclose(p_val_file);
-		dbg(DBG_HIGH, "processed all pvalues from pvalue file: %s", filename);
-		current = current->next;
+	// firewall
+	if (buf == NULL) {
+		err(229, __func__, "bug arg is NULL");
+	}
+	if (len <= 0) {
+		err(229, __func__, "len must be > 0: %lu", len);
 	}
 
-	dbg(DBG_LOW, "end of reading pvalue file(s) phase\n");
+	/*
+	 * Determine the time for now
+	 */
+	errno = 0;		// paranoia
+	seconds = time(NULL);
+	if (seconds < 0) {
+		errp(229, __func__, "time returned < 0: %ld", seconds);
+	}
+	loc_ret = localtime_r(&seconds, &now);
+	if (loc_ret == NULL) {
+		errp(229, __func__, "localtime_r returned NULL");
+	}
+	errno = 0;		// paranoia
+	time_len = strftime(buf, len - 1, "%F %T", &now);
+	if (time_len == 0) {
+		errp(229, __func__, "strftime failed");
+	}
+	buf[len] = '\0';	// paranoia
+	return;
 }
 
 
@@ -42,9 +42,11 @@ extern void chooseTests(struct state *state);
 extern void fixParameters(struct state *state);
 extern bool copyBitsToEpsilon(struct state *state, long int thread_id, BYTE *x, long int xBitLength, long int *num_0s,
 			      long int *num_1s, long int *bitsRead);
+extern void packEpsilon(struct state *state, long int thread_id);
+extern void setupPopcount(void);
+extern long int countOnes(const WORD64 *packed, long int start, long int len);
+extern long int countBitChanges(const WORD64 *packed, long int n);
 extern void invokeTestSuite(struct state *state);
-extern void read_from_p_val_file(struct state *state);
-extern void write_p_val_to_file(struct state *state);
 extern void print_option_summary(struct state *state, char *where);
 extern int sum_will_overflow_long(long int si_a, long int si_b);
 extern int multiplication_will_overflow_long(long int si_a, long int si_b);